@@ -10,10 +10,13 @@
 #include <memory>
 #include <algorithm>
 #include <functional>
+#include <deque>
+#include <cstdint>
 #include <unordered_map>
 #include <imgui.h>
 #include "../src/imgui_bezier_math.h"
 #include "../src/context_wrapper.h"
+#include "../src/spatial_index.h"
 
 //#define ConnectionFilter_None       [](ImFlow::Pin* out, ImFlow::Pin* in){ return true; }
 //#define ConnectionFilter_SameType   [](ImFlow::Pin* out, ImFlow::Pin* in){ return out->getDataType() == in->getDataType(); }
@@ -52,7 +55,7 @@ namespace ImFlow
 
     template<typename T> class InPin;
     template<typename T> class OutPin;
-    class Pin; class BaseNode;
+    class Pin; class BaseNode; class Link;
     class ImNodeFlow; class ConnectionFilter;
 
     // -----------------------------------------------------------------------------------------------------------------
@@ -60,6 +63,15 @@ namespace ImFlow
 
     typedef unsigned long long int PinUID;
 
+    /**
+     * @brief Pins type identifier
+     */
+    enum PinType
+    {
+        PinType_Input,
+        PinType_Output
+    };
+
     /**
      * @brief Extra pin's style setting
      */
@@ -175,11 +187,56 @@ namespace ImFlow
         static std::shared_ptr<NodeStyle> brown() { return std::make_shared<NodeStyle>(IM_COL32(191,134,90,255), ImColor(233,241,244,255), 6.5f); }
     };
 
+    // -----------------------------------------------------------------------------------------------------------------
+    // HANDLES
+
+    /**
+     * @brief Generational reference to a pooled Node or Link
+     * @details The index names a slot of the handler's pool, the generation its occupant. Freeing a slot bumps its
+     *          generation, so a handle to an erased item resolves to nullptr instead of to the item reusing the slot.
+     * @tparam T Type of the referenced item
+     */
+    template<typename T>
+    struct Handle
+    {
+        static constexpr uint32_t Invalid = UINT32_MAX;
+
+        uint32_t index = Invalid;
+        uint32_t generation = 0;
+
+        [[nodiscard]] bool valid() const { return index != Invalid; }
+        bool operator==(const Handle& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const Handle& other) const { return !(*this == other); }
+    };
+
+    typedef Handle<BaseNode> NodeHandle;
+    typedef Handle<Link> LinkHandle;
+
+    /**
+     * @brief Reference to a Pin by position in its Node
+     * @details Versioned through the Node's handle. Dynamic pins (showIN/showOUT) have no position and no handle.
+     */
+    struct PinHandle
+    {
+        static constexpr uint32_t Invalid = UINT32_MAX;
+
+        NodeHandle node;
+        /// @brief Position in the Node's inputs or outputs
+        uint32_t index = Invalid;
+        PinType type = PinType_Input;
+
+        [[nodiscard]] bool valid() const { return node.valid() && index != Invalid; }
+        bool operator==(const PinHandle& other) const { return node == other.node && index == other.index && type == other.type; }
+        bool operator!=(const PinHandle& other) const { return !(*this == other); }
+    };
+
     // -----------------------------------------------------------------------------------------------------------------
     // LINK
 
     /**
      * @brief Link between two Pins of two different Nodes
+     * @details Links live in the handler's pool and are created and destroyed through it (addLink, destroyLink).
+     *          Pins refer to them by LinkHandle.
      */
     class Link
     {
@@ -189,14 +246,9 @@ namespace ImFlow
          * @param left Pointer to the output Pin of the Link
          * @param right Pointer to the input Pin of the Link
          * @param inf Pointer to the Handler that contains the Link
+         * @param handle Slot of the Link in the handler's pool
          */
-        explicit Link(Pin* left, Pin* right, ImNodeFlow* inf) : m_left(left), m_right(right), m_inf(inf) {}
-
-        /**
-         * @brief <BR>Destruction of a link
-         * @details Deletes references of this links form connected pins
-         */
-        ~Link();
+        explicit Link(Pin* left, Pin* right, ImNodeFlow* inf, LinkHandle handle) : m_left(left), m_right(right), m_inf(inf), m_handle(handle) {}
 
         /**
          * @brief <BR>Looping function to update the Link
@@ -227,10 +279,17 @@ namespace ImFlow
          * @return [TRUE] If the link is selected in the current frame
          */
         [[nodiscard]] bool isSelected() const { return m_selected; }
+
+        /**
+         * @brief <BR>Get the Link's handle
+         * @return Handle to the Link in its handler's pool
+         */
+        [[nodiscard]] LinkHandle getHandle() const { return m_handle; }
     private:
         Pin* m_left;
         Pin* m_right;
         ImNodeFlow* m_inf;
+        LinkHandle m_handle;
         bool m_hovered = false;
         bool m_selected = false;
     };
@@ -291,6 +350,19 @@ namespace ImFlow
             m_context.config().color = m_style.colors.background;
         }
 
+        /**
+         * @brief <BR>Destruction of the editor
+         * @details Event callbacks are dropped first so owners are not called back while Nodes and Links are torn down
+         */
+        ~ImNodeFlow()
+        {
+            m_nodeAdded = nullptr;
+            m_nodeRemoved = nullptr;
+            m_linkCreated = nullptr;
+            m_linkDestroyed = nullptr;
+            clear();
+        }
+
         /**
          * @brief <BR>Handler loop
          * @details Main update function. Refreshes all the logic and draws everything. Must be called every frame.
@@ -364,10 +436,56 @@ namespace ImFlow
         std::shared_ptr<T> placeNode(Params&&... args);
 
         /**
-         * @brief <BR>Add link to the handler internal list
-         * @param link Reference to the link
+         * @brief <BR>Create a Link in the handler's pool
+         * @details Registers the Link with both Pins and the adjacency of both Nodes. Connection rules are checked by
+         *          Pin::createLink(), which is the usual way to connect two Pins.
+         * @param left Output Pin
+         * @param right Input Pin
+         * @return Handle to the new Link
+         */
+        LinkHandle addLink(Pin* left, Pin* right);
+
+        /**
+         * @brief <BR>Destroy a Link
+         * @details Unregisters it from its Pins and Nodes, then fires the link destroyed event. Stale handles are ignored.
+         * @param link Handle to the Link
+         */
+        void destroyLink(LinkHandle link);
+
+        /**
+         * @brief <BR>Remove every Node and Link
+         * @details Fires the node removed event for each Node, then destroys every Link. Nodes still referenced elsewhere
+         *          are detached from the handler.
+         */
+        void clear();
+
+        /**
+         * @brief <BR>Reserve space for Nodes
+         * @details Avoids reallocating when creating many Nodes at once (e.g. loading a graph)
+         * @param count Total number of Nodes expected
+         */
+        void reserveNodes(size_t count) { m_nodes.reserve(count); m_nodeSlots.reserve(count); }
+
+        /**
+         * @brief <BR>Enable or disable viewport culling
+         * @details When enabled (default) only the Nodes and Links overlapping the canvas are laid out, drawn and
+         *          hit-tested each frame. Selected Nodes are always updated so they can be dragged or deleted.
+         * @param state New culling state
+         */
+        void setCulling(bool state) { m_culling = state; }
+
+        /**
+         * @brief <BR>Get culling status
+         * @return [TRUE] if viewport culling is enabled
+         */
+        [[nodiscard]] bool getCulling() const { return m_culling; }
+
+        /**
+         * @brief <BR>Re-measure a Node on the next frame
+         * @details Used when a Node is moved programmatically, so it is laid out even if it left the canvas.
+         * @param node Node to update on the next frame
          */
-        void addLink(std::shared_ptr<Link>& link);
+        void invalidateNode(BaseNode* node) { m_unplaced.push_back(node); }
 
         /**
          * @brief <BR>Pop-up when link is "dropped"
@@ -385,6 +503,33 @@ namespace ImFlow
          */
         void rightClickPopUpContent(std::function<void(BaseNode* node)> content) { m_rightClickPopUp = std::move(content); }
 
+        /**
+         * @brief <BR>Node added event
+         * @details Called by addNode() once the Node is registered with the editor
+         * @param callback Function or Lambda receiving the new Node
+         */
+        void onNodeAdded(std::function<void(BaseNode* node)> callback) { m_nodeAdded = std::move(callback); }
+
+        /**
+         * @brief <BR>Node removed event
+         * @details Called right before a destroyed Node is erased. Its Links are destroyed afterwards.
+         * @param callback Function or Lambda receiving the Node being removed
+         */
+        void onNodeRemoved(std::function<void(BaseNode* node)> callback) { m_nodeRemoved = std::move(callback); }
+
+        /**
+         * @brief <BR>Link created event
+         * @param callback Function or Lambda receiving the Nodes of the output (left) and input (right) Pins
+         */
+        void onLinkCreated(std::function<void(BaseNode* left, BaseNode* right)> callback) { m_linkCreated = std::move(callback); }
+
+        /**
+         * @brief <BR>Link destroyed event
+         * @details Links of a removed Node are destroyed after its node removed event, while the Node is still alive.
+         * @param callback Function or Lambda receiving the Nodes of the output (left) and input (right) Pins
+         */
+        void onLinkDestroyed(std::function<void(BaseNode* left, BaseNode* right)> callback) { m_linkDestroyed = std::move(callback); }
+
         /**
          * @brief <BR>Get mouse clicking status
          * @return [TRUE] if mouse is clicked and click hasn't been consumed
@@ -417,9 +562,10 @@ namespace ImFlow
 
         /**
          * @brief <BR>Get editor's list of nodes
+         * @details Contiguous, in creation order. Removing Nodes keeps the order of the others.
          * @return Const reference to editor's internal nodes list
          */
-        std::unordered_map<NodeUID, std::shared_ptr<BaseNode>>& getNodes() { return m_nodes; }
+        const std::vector<std::shared_ptr<BaseNode>>& getNodes() { return m_nodes; }
 
         /**
          * @brief <BR>Get nodes count
@@ -427,11 +573,72 @@ namespace ImFlow
          */
         uint32_t getNodesCount() { return (uint32_t)m_nodes.size(); }
 
+        /**
+         * @brief <BR>Get the number of Node slots
+         * @details Every NodeHandle::index is below it, so arrays of that size can be indexed by Node.
+         * @return Size of the Node slot table
+         */
+        uint32_t getNodeSlotCount() { return (uint32_t)m_nodeSlots.size(); }
+
         /**
          * @brief <BR>Get editor's list of links
+         * @details Contiguous; destroying a Link moves the last one into its place.
          * @return Const reference to editor's internal links list
          */
-        const std::vector<std::weak_ptr<Link>>& getLinks() { return m_links; }
+        const std::vector<Link*>& getLinks() { return m_links; }
+
+        /**
+         * @brief <BR>Resolve a Node handle
+         * @param node Handle to the Node
+         * @return Pointer to the Node, nullptr if it has been removed
+         */
+        BaseNode* getNode(NodeHandle node)
+        {
+            if (node.index >= m_nodeSlots.size() || m_nodeSlots[node.index].generation != node.generation)
+                return nullptr;
+            return m_nodes[m_nodeSlots[node.index].dense].get();
+        }
+
+        /**
+         * @brief <BR>Resolve a Link handle
+         * @param link Handle to the Link
+         * @return Pointer to the Link, nullptr if it has been destroyed
+         */
+        Link* getLink(LinkHandle link)
+        {
+            if (link.index >= m_linkSlots.size() || m_linkSlots[link.index].generation != link.generation)
+                return nullptr;
+            return &m_linkPool[link.index];
+        }
+
+        /**
+         * @brief <BR>Resolve a Pin handle
+         * @param pin Handle to the Pin
+         * @return Pointer to the Pin, nullptr if its Node has been removed or no longer has that many pins
+         */
+        Pin* getPin(PinHandle pin);
+
+        /**
+         * @brief <BR>Get the Links of a Node
+         * @details Adjacency list: every Link with an end on one of the Node's pins, static or dynamic.
+         * @param node Handle to the Node
+         * @return Const reference to the Node's links, empty if the handle is stale
+         */
+        const std::vector<LinkHandle>& getNodeLinks(NodeHandle node);
+
+        /**
+         * @brief <BR>Get the Nodes updated in the last frame
+         * @details With culling enabled these are the Nodes on the canvas plus the selected ones.
+         * @return Const reference to the list of drawn nodes
+         */
+        const std::vector<BaseNode*>& getDrawnNodes() { return m_frameNodes; }
+
+        /**
+         * @brief <BR>Get the Links drawn in the last frame
+         * @details Links destroyed since then are left as null entries.
+         * @return Const reference to the list of drawn links
+         */
+        const std::vector<Link*>& getDrawnLinks() { return m_frameLinks; }
 
         /**
          * @brief <BR>Get zooming viewport
@@ -439,6 +646,20 @@ namespace ImFlow
          */
         ContainedContext& getGrid() { return m_context; }
 
+        /**
+         * @brief <BR>Get graph revision
+         * @details Monotonically increasing counter. It moves whenever a Node or a Link is added or removed and
+         *          whenever a Node reports an edit with markDirty(). Node dragging does not change it.
+         * @return Current revision of the graph
+         */
+        [[nodiscard]] uint64_t getRevision() const { return m_revision; }
+
+        /**
+         * @brief <BR>Flag the graph as modified
+         * @details Bumps the revision returned by getRevision()
+         */
+        void markDirty() { m_revision++; }
+
         /**
          * @brief <BR>Get dragging status
          * @return [TRUE] if a Node is being dragged around the grid
@@ -509,14 +730,94 @@ namespace ImFlow
          */
         std::vector<std::string>& get_recursion_blacklist() { return m_pinRecursionBlacklist; }
     private:
+        /**
+         * @brief <BR>Collect the Nodes to update this frame into m_frameNodes
+         */
+        void collectFrameNodes();
+
+        /**
+         * @brief <BR>Refresh the bounds of a Node in the index
+         * @details Marks its Links for re-indexing when the bounds changed
+         */
+        void indexNode(BaseNode* node);
+
+        /**
+         * @brief <BR>Refresh the bounds of a Link in the index
+         * @details Bounds are the hull of the Bézier control points, in grid coordinates
+         */
+        void indexLink(Link* link);
+
+        /**
+         * @brief <BR>Give a new Node a slot and append it to the dense list
+         */
+        void registerNode(const std::shared_ptr<BaseNode>& node);
+
+        /**
+         * @brief <BR>Detach a destroyed Node: fire its event, destroy its Links and free its slot
+         * @details Its entry in the dense list is dropped afterwards by compactNodes()
+         */
+        void releaseNode(BaseNode* node);
+
+        /**
+         * @brief <BR>Drop released Nodes from the dense list, keeping the order of the others
+         */
+        void compactNodes();
+
+        /**
+         * @brief <BR>Drop every reference to a Node that is about to be erased
+         */
+        void forgetNode(BaseNode* node);
+
         std::string m_name;
         ContainedContext m_context;
 
         bool m_singleUseClick = false;
 
-        std::unordered_map<NodeUID, std::shared_ptr<BaseNode>> m_nodes;
+        // Declared before the Nodes so they outlive every Link destroyed with them
+        std::function<void(BaseNode* node)> m_nodeAdded;
+        std::function<void(BaseNode* node)> m_nodeRemoved;
+        std::function<void(BaseNode* left, BaseNode* right)> m_linkCreated;
+        std::function<void(BaseNode* left, BaseNode* right)> m_linkDestroyed;
+
+        // Spatial lookups
+        SpatialIndex<BaseNode> m_nodeIndex;
+        SpatialIndex<Link> m_linkIndex;
+        std::vector<BaseNode*> m_unplaced;
+        std::vector<BaseNode*> m_selectedNodes;
+        std::vector<BaseNode*> m_frameNodes;
+        std::vector<Link*> m_dirtyLinks;
+        std::vector<Link*> m_frameLinks;
+        bool m_culling = true;
+
+        struct NodeSlot
+        {
+            uint32_t generation = 0;
+            /// @brief Position in m_nodes
+            uint32_t dense = 0;
+            /// @brief Adjacency: Links with an end on the Node
+            std::vector<LinkHandle> links;
+        };
+
+        struct LinkSlot
+        {
+            uint32_t generation = 0;
+            /// @brief Position in m_links
+            uint32_t dense = 0;
+        };
+
+        // Nodes are dense; slots map handles to them and are recycled through the free list
+        std::vector<std::shared_ptr<BaseNode>> m_nodes;
+        std::vector<NodeSlot> m_nodeSlots;
+        std::vector<uint32_t> m_freeNodeSlots;
+
+        // Links are stored by value in the pool (a deque, so addresses are stable) and indexed by slot
+        std::deque<Link> m_linkPool;
+        std::vector<LinkSlot> m_linkSlots;
+        std::vector<uint32_t> m_freeLinkSlots;
+        std::vector<Link*> m_links;
+
         std::vector<std::string> m_pinRecursionBlacklist;
-        std::vector<std::weak_ptr<Link>> m_links;
+        uint64_t m_revision = 0;
 
         std::function<void(Pin* dragged)> m_droppedLinkPopUp;
         ImGuiKey m_droppedLinkPupUpComboKey = ImGuiKey_None;
@@ -558,6 +859,12 @@ namespace ImFlow
          */
         virtual void draw() {}
 
+        /**
+         * @brief <BR>Content below the pins
+         * @details Optional. Drawn on its own row after the inputs, the body and the outputs, inside the node frame.
+         */
+        virtual void drawFooter() {}
+
         /**
          * @brief <BR>Add an Input to the node
          * @details Will add an Input pin to the node with the given name and data type.
@@ -797,6 +1104,12 @@ namespace ImFlow
          */
         [[nodiscard]] NodeUID getUID() const { return m_uid; }
 
+        /**
+         * @brief <BR>Get node's handle
+         * @return Handle to the node in its handler, invalid if it is not in one
+         */
+        [[nodiscard]] NodeHandle getHandle() const { return m_handle; }
+
         /**
          * @brief <BR>Get node name
          * @return Const reference to the node's name
@@ -819,7 +1132,7 @@ namespace ImFlow
          * @brief <BR>Get node position
          * @return Const reference to the node's position
          */
-        const ImVec2& getPos() { return  m_pos; }
+        const ImVec2& getPos() const { return  m_pos; }
 
         /**
          * @brief <BR>Get grid handler bound to node
@@ -851,6 +1164,13 @@ namespace ImFlow
          */
         BaseNode* setUID(NodeUID uid) { m_uid = uid; return this; }
 
+        /**
+         * @brief <BR>Set node's handle
+         * @details Assigned by the handler when the node is added or removed
+         * @param handle Handle to the node's slot
+         */
+        BaseNode* setHandle(NodeHandle handle) { m_handle = handle; return this; }
+
         /**
          * @brief <BR>Set node's name
          * @param name New title
@@ -861,7 +1181,7 @@ namespace ImFlow
          * @brief <BR>Set node's position
          * @param pos Position in grid coordinates
          */
-        BaseNode* setPos(const ImVec2& pos) { m_pos = pos; m_posTarget = pos; return this; }
+        BaseNode* setPos(const ImVec2& pos) { m_pos = pos; m_posTarget = pos; if (m_inf) m_inf->invalidateNode(this); return this; }
 
         /**
          * @brief <BR>Set ImNodeFlow handler
@@ -887,12 +1207,22 @@ namespace ImFlow
          * @brief <BR>Update the isSelected status of the node
          */
         void updatePublicStatus() { m_selected = m_selectedNext; }
+
+        /**
+         * @brief <BR>Get the grid scroll at the last layout
+         * @details Pin positions are stored in canvas coordinates. Nodes that are culled keep the positions of the
+         *          frame they were last drawn, which are off by the scroll since then.
+         * @return Scroll of the grid when the node was last updated
+         */
+        [[nodiscard]] const ImVec2& getLayoutScroll() const { return m_layoutScroll; }
     private:
         NodeUID m_uid = 0;
+        NodeHandle m_handle;
         std::string m_title;
         ImVec2 m_pos, m_posTarget;
         ImVec2 m_size;
         ImVec2 m_fullSize;
+        ImVec2 m_layoutScroll;
         ImNodeFlow* m_inf = nullptr;
         std::shared_ptr<NodeStyle> m_style;
         bool m_selected = false, m_selectedNext = false;
@@ -908,15 +1238,6 @@ namespace ImFlow
     // -----------------------------------------------------------------------------------------------------------------
     // PINS
 
-    /**
-     * @brief Pins type identifier
-     */
-    enum PinType
-    {
-        PinType_Input,
-        PinType_Output
-    };
-
     /**
      * @brief Generic base class for pins
      */
@@ -976,12 +1297,20 @@ namespace ImFlow
 
         /**
          * @brief <BR>Set the reference to a link
-         * @param link Smart pointer to the link
+         * @details Called by the handler when it creates a Link on this pin
+         * @param link Handle to the link
+         */
+        virtual void setLink(LinkHandle link) = 0;
+
+        /**
+         * @brief <BR>Forget a link reference
+         * @details Called by the handler when it destroys a Link on this pin
+         * @param link Handle to the link
          */
-        virtual void setLink(std::shared_ptr<Link>& link) {}
+        virtual void dropLink(LinkHandle link) = 0;
 
         /**
-         * @brief <BR>Delete link reference
+         * @brief <BR>Destroy the pin's link(s)
          */
         virtual void deleteLink() = 0;
 
@@ -993,9 +1322,28 @@ namespace ImFlow
 
         /**
          * @brief <BR>Get pin's link
-         * @return Weak_ptr reference to pin's link
+         * @return Pointer to the input pin's link, nullptr if unconnected or for output pins
+         */
+        virtual Link* getLink() { return nullptr; }
+
+        /**
+         * @brief <BR>Get pin's handle
+         * @return Handle to the pin, invalid for dynamic pins or outside a handler
+         */
+        PinHandle getHandle();
+
+        /**
+         * @brief <BR>Get pin's position in its node
+         * @return Index in the node's inputs or outputs, PinHandle::Invalid for dynamic pins
          */
-        virtual std::weak_ptr<Link> getLink() { return std::weak_ptr<Link>{}; }
+        [[nodiscard]] uint32_t getIndex() const { return m_index; }
+
+        /**
+         * @brief <BR>Set pin's position in its node
+         * @details Kept up to date by the node as pins are added and dropped
+         * @param index Index in the node's inputs or outputs
+         */
+        void setIndex(uint32_t index) { m_index = index; }
 
         /**
          * @brief <BR>Get pin's UID
@@ -1068,6 +1416,7 @@ namespace ImFlow
         ImVec2 m_pos = ImVec2(0.f, 0.f);
         ImVec2 m_size = ImVec2(0.f, 0.f);
         PinType m_type;
+        uint32_t m_index = PinHandle::Invalid;
         BaseNode* m_parent = nullptr;
         ImNodeFlow** m_inf;
         std::shared_ptr<PinStyle> m_style;
@@ -1087,7 +1436,7 @@ namespace ImFlow
 
     /**
      * @brief Input specific pin
-     * @details Derived from the generic class Pin. The input pin owns the link pointer.
+     * @details Derived from the generic class Pin. The input pin owns its link: destroying the pin destroys it.
      * @tparam T Data type handled by the pin
      */
     template<class T> class InPin : public Pin
@@ -1105,16 +1454,33 @@ namespace ImFlow
         explicit InPin(PinUID uid, const std::string& name, T defReturn, std::function<bool(Pin*, Pin*)> filter, std::shared_ptr<PinStyle> style, BaseNode* parent, ImNodeFlow** inf)
             : Pin(uid, name, style, PinType_Input, parent, inf), m_emptyVal(defReturn), m_filter(std::move(filter)) {}
 
+        /**
+         * @brief <BR>When the pin gets deleted, remove the link
+         */
+        ~InPin() override { deleteLink(); }
+
         /**
          * @brief <BR>Create link between pins
          * @param other Pointer to the other pin
          */
         void createLink(Pin* other) override;
 
+        /**
+         * @brief <BR>Set the connected link
+         * @param link Handle to the link
+         */
+        void setLink(LinkHandle link) override { m_link = link; }
+
+        /**
+         * @brief <BR>Forget the connected link
+         * @param link Handle to the link
+         */
+        void dropLink(LinkHandle link) override { if (m_link == link) m_link = LinkHandle{}; }
+
         /**
         * @brief <BR>Delete the link connected to the pin
         */
-        void deleteLink() override { m_link.reset(); }
+        void deleteLink() override { if (m_link.valid() && *m_inf) (*m_inf)->destroyLink(m_link); }
 
         /**
          * @brief Specify if connections from an output on the same node are allowed
@@ -1126,13 +1492,19 @@ namespace ImFlow
          * @brief <BR>Get connected status
          * @return [TRUE] is pin is connected to a link
          */
-        bool isConnected() override { return m_link != nullptr; }
+        bool isConnected() override { return m_link.valid(); }
 
         /**
          * @brief <BR>Get pin's link
-         * @return Weak_ptr reference to the link connected to the pin
+         * @return Pointer to the link connected to the pin, nullptr if unconnected
+         */
+        Link* getLink() override { return m_link.valid() ? (*m_inf)->getLink(m_link) : nullptr; }
+
+        /**
+         * @brief <BR>Get the handle of the pin's link
+         * @return Handle to the connected link, invalid if unconnected
          */
-        std::weak_ptr<Link> getLink() override { return m_link; }
+        [[nodiscard]] LinkHandle getLinkHandle() const { return m_link; }
 
         /**
          * @brief <BR>Get InPin's connection filter
@@ -1158,7 +1530,7 @@ namespace ImFlow
          */
         const T& val();
     private:
-        std::shared_ptr<Link> m_link;
+        LinkHandle m_link;
         T m_emptyVal;
         std::function<bool(Pin*, Pin*)> m_filter;
         bool m_allowSelfConnection = false;
@@ -1186,10 +1558,7 @@ namespace ImFlow
         /**
          * @brief <BR>When parent gets deleted, remove the links
          */
-        ~OutPin() override {
-            std::vector<std::weak_ptr<Link>> links = std::move(m_links);
-            for (auto &l: links) if (!l.expired()) l.lock()->right()->deleteLink();
-        }
+        ~OutPin() override { deleteLink(); }
 
         /**
          * @brief <BR>Create link between pins
@@ -1199,12 +1568,18 @@ namespace ImFlow
 
         /**
          * @brief <BR>Add a connected link to the internal list
-         * @param link Pointer to the link
+         * @param link Handle to the link
          */
-        void setLink(std::shared_ptr<Link>& link) override;
+        void setLink(LinkHandle link) override { m_links.push_back(link); }
 
         /**
-         * @brief <BR>Delete any expired weak pointers to a (now deleted) link
+         * @brief <BR>Remove a link from the internal list
+         * @param link Handle to the link
+         */
+        void dropLink(LinkHandle link) override;
+
+        /**
+         * @brief <BR>Delete every link connected to the pin
          */
         void deleteLink() override;
 
@@ -1214,6 +1589,12 @@ namespace ImFlow
          */
         bool isConnected() override { return !m_links.empty(); }
 
+        /**
+         * @brief <BR>Get the connected links
+         * @return Const reference to the handles of the links leaving the pin
+         */
+        [[nodiscard]] const std::vector<LinkHandle>& getLinks() const { return m_links; }
+
         /**
          * @brief <BR>Get pin's link attachment point (socket)
          * @return Grid coordinates to the attachment point between the link and the pin's socket
@@ -1239,7 +1620,7 @@ namespace ImFlow
          */
         [[nodiscard]] const std::type_info& getDataType() const override { return typeid(T); };
     private:
-        std::vector<std::weak_ptr<Link>> m_links;
+        std::vector<LinkHandle> m_links;
         std::function<T()> m_behaviour;
         T m_val;
     };
@@ -5,8 +5,10 @@ namespace ImFlow {
     // LINK
 
     void Link::update() {
-        ImVec2 start = m_left->pinPoint();
-        ImVec2 end = m_right->pinPoint();
+        // Pins of culled Nodes were placed with the scroll of their last layout
+        ImVec2 scroll = m_inf->getGrid().scroll();
+        ImVec2 start = m_left->pinPoint() + scroll - m_left->getParent()->getLayoutScroll();
+        ImVec2 end = m_right->pinPoint() + scroll - m_right->getParent()->getLayoutScroll();
         float thickness = m_left->getStyle()->extra.link_thickness;
         bool mouseClickState = m_inf->getSingleUseClick();
 
@@ -31,10 +33,6 @@ namespace ImFlow {
             m_right->deleteLink();
     }
 
-    Link::~Link() {
-        m_left->deleteLink();
-    }
-
     // -----------------------------------------------------------------------------------------------------------------
     // BASE NODE
 
@@ -52,6 +50,7 @@ namespace ImFlow {
         ImVec2 offset = m_inf->grid2screen({0.f, 0.f});
         ImVec2 paddingTL = {m_style->padding.x, m_style->padding.y};
         ImVec2 paddingBR = {m_style->padding.z, m_style->padding.w};
+        m_layoutScroll = m_inf->getGrid().scroll();
 
         draw_list->ChannelsSetCurrent(1); // Foreground
         ImGui::SetCursorScreenPos(offset + m_pos);
@@ -130,6 +129,9 @@ namespace ImFlow {
 
         ImGui::EndGroup();
 
+        // Footer
+        drawFooter();
+
         ImGui::EndGroup();
         m_size = ImGui::GetItemRectSize();
         ImVec2 headerSize = ImVec2(m_size.x + paddingBR.x, headerH);
@@ -210,15 +212,16 @@ namespace ImFlow {
     int ImNodeFlow::m_instances = 0;
 
     bool ImNodeFlow::on_selected_node() {
-        return std::any_of(m_nodes.begin(), m_nodes.end(),
-                           [](const auto &n) { return n.second->isSelected() && n.second->isHovered(); });
+        return std::any_of(m_selectedNodes.begin(), m_selectedNodes.end(),
+                           [](BaseNode* n) { return n->isSelected() && n->isHovered(); });
     }
 
     bool ImNodeFlow::on_free_space() {
-        return std::all_of(m_nodes.begin(), m_nodes.end(),
-                           [](const auto &n) { return !n.second->isHovered(); })
-               && std::all_of(m_links.begin(), m_links.end(),
-                              [](const auto &l) { return !l.lock()->isHovered(); });
+        // Only the Nodes and Links on the canvas can be under the mouse
+        return std::all_of(m_frameNodes.begin(), m_frameNodes.end(),
+                           [](BaseNode* n) { return !n->isHovered(); })
+               && std::all_of(m_frameLinks.begin(), m_frameLinks.end(),
+                              [](Link* l) { return !l || !l->isHovered(); });
     }
 
     ImVec2 ImNodeFlow::screen2grid( const ImVec2 & p )
@@ -235,8 +238,209 @@ namespace ImFlow {
         return ( p + m_context.scroll() ) * m_context.scale() + m_context.origin();
     }
 
-    void ImNodeFlow::addLink(std::shared_ptr<Link> &link) {
+    LinkHandle ImNodeFlow::addLink(Pin* left, Pin* right) {
+        LinkHandle handle;
+        if (!m_freeLinkSlots.empty()) {
+            handle.index = m_freeLinkSlots.back();
+            handle.generation = m_linkSlots[handle.index].generation;
+            m_freeLinkSlots.pop_back();
+            m_linkPool[handle.index] = Link(left, right, this, handle);
+        } else {
+            handle.index = static_cast<uint32_t>(m_linkSlots.size());
+            m_linkSlots.emplace_back();
+            m_linkPool.emplace_back(left, right, this, handle);
+        }
+        m_linkSlots[handle.index].dense = static_cast<uint32_t>(m_links.size());
+        Link* link = &m_linkPool[handle.index];
         m_links.push_back(link);
+
+        left->setLink(handle);
+        right->setLink(handle);
+        BaseNode* leftNode = left->getParent();
+        BaseNode* rightNode = right->getParent();
+        m_nodeSlots[leftNode->getHandle().index].links.push_back(handle);
+        if (rightNode != leftNode) m_nodeSlots[rightNode->getHandle().index].links.push_back(handle);
+        m_dirtyLinks.push_back(link);
+        markDirty();
+        if (m_linkCreated) m_linkCreated(leftNode, rightNode);
+        return handle;
+    }
+
+    void ImNodeFlow::destroyLink(LinkHandle handle) {
+        Link* link = getLink(handle);
+        if (!link)
+            return;
+        BaseNode* left = link->left()->getParent();
+        BaseNode* right = link->right()->getParent();
+        link->left()->dropLink(handle);
+        link->right()->dropLink(handle);
+        for (BaseNode* node : {left, right}) {
+            auto& links = m_nodeSlots[node->getHandle().index].links;
+            links.erase(std::remove(links.begin(), links.end(), handle), links.end());
+        }
+        m_dirtyLinks.erase(std::remove(m_dirtyLinks.begin(), m_dirtyLinks.end(), link), m_dirtyLinks.end());
+        // Links can delete themselves while the drawn list is walked
+        std::replace(m_frameLinks.begin(), m_frameLinks.end(), link, static_cast<Link*>(nullptr));
+        m_linkIndex.remove(link);
+
+        // Move the last Link into the hole and retire the slot
+        LinkSlot& slot = m_linkSlots[handle.index];
+        Link* last = m_links.back();
+        m_links[slot.dense] = last;
+        m_linkSlots[last->getHandle().index].dense = slot.dense;
+        m_links.pop_back();
+        slot.generation++;
+        m_freeLinkSlots.push_back(handle.index);
+        markDirty();
+        if (m_linkDestroyed) m_linkDestroyed(left, right);
+    }
+
+    Pin* ImNodeFlow::getPin(PinHandle pin) {
+        BaseNode* node = getNode(pin.node);
+        if (!node)
+            return nullptr;
+        const auto& pins = pin.type == PinType_Input ? node->getIns() : node->getOuts();
+        return pin.index < pins.size() ? pins[pin.index].get() : nullptr;
+    }
+
+    const std::vector<LinkHandle>& ImNodeFlow::getNodeLinks(NodeHandle node) {
+        static const std::vector<LinkHandle> none;
+        if (!getNode(node))
+            return none;
+        return m_nodeSlots[node.index].links;
+    }
+
+    void ImNodeFlow::registerNode(const std::shared_ptr<BaseNode>& node) {
+        NodeHandle handle;
+        if (!m_freeNodeSlots.empty()) {
+            handle.index = m_freeNodeSlots.back();
+            m_freeNodeSlots.pop_back();
+        } else {
+            handle.index = static_cast<uint32_t>(m_nodeSlots.size());
+            m_nodeSlots.emplace_back();
+        }
+        NodeSlot& slot = m_nodeSlots[handle.index];
+        handle.generation = slot.generation;
+        slot.dense = static_cast<uint32_t>(m_nodes.size());
+        node->setHandle(handle);
+        m_nodes.push_back(node);
+        m_unplaced.push_back(node.get());
+        markDirty();
+        if (m_nodeAdded) m_nodeAdded(node.get());
+    }
+
+    void ImNodeFlow::releaseNode(BaseNode* node) {
+        if (m_nodeRemoved) m_nodeRemoved(node);
+        NodeHandle handle = node->getHandle();
+        // Links go first, while both of their Nodes are alive
+        std::vector<LinkHandle> links = m_nodeSlots[handle.index].links;
+        for (LinkHandle link : links) destroyLink(link);
+        forgetNode(node);
+
+        NodeSlot& slot = m_nodeSlots[handle.index];
+        slot.generation++;
+        slot.links.clear();
+        m_freeNodeSlots.push_back(handle.index);
+        // Owners that keep the Node alive must not reach back into the handler
+        node->setHandle(NodeHandle{});
+        node->setHandler(nullptr);
+        markDirty();
+    }
+
+    void ImNodeFlow::compactNodes() {
+        m_nodes.erase(std::remove_if(m_nodes.begin(), m_nodes.end(),
+                                     [](const std::shared_ptr<BaseNode>& node) { return !node->getHandle().valid(); }),
+                      m_nodes.end());
+        for (size_t i = 0; i < m_nodes.size(); i++)
+            m_nodeSlots[m_nodes[i]->getHandle().index].dense = static_cast<uint32_t>(i);
+    }
+
+    void ImNodeFlow::clear() {
+        if (m_nodeRemoved)
+            for (auto& node : m_nodes) m_nodeRemoved(node.get());
+        while (!m_links.empty())
+            destroyLink(m_links.back()->getHandle());
+        for (auto& node : m_nodes) {
+            NodeSlot& slot = m_nodeSlots[node->getHandle().index];
+            slot.generation++;
+            slot.links.clear();
+            m_freeNodeSlots.push_back(node->getHandle().index);
+            node->setHandle(NodeHandle{});
+            node->setHandler(nullptr);
+        }
+        m_nodes.clear();
+        m_nodeIndex.clear();
+        m_linkIndex.clear();
+        m_unplaced.clear();
+        m_selectedNodes.clear();
+        m_frameNodes.clear();
+        m_dirtyLinks.clear();
+        m_frameLinks.clear();
+        m_hovering = nullptr;
+        m_hoveredNode = nullptr;
+        m_hoveredNodeAux = nullptr;
+        m_draggingNode = false;
+        m_draggingNodeNext = false;
+        m_dragOut = nullptr;
+        markDirty();
+    }
+
+    void ImNodeFlow::collectFrameNodes() {
+        m_frameNodes.clear();
+        if (!m_culling) {
+            for (auto& node : m_nodes) m_frameNodes.push_back(node.get());
+            return;
+        }
+        // Visible area of the canvas in grid coordinates (the canvas context is current)
+        ImVec2 viewMin = screen2grid({0.f, 0.f});
+        ImVec2 viewMax = screen2grid(ImGui::GetIO().DisplaySize);
+        m_nodeIndex.query(viewMin, viewMax, m_frameNodes);
+        // Selected Nodes can be dragged or deleted while off screen; new or moved ones need measuring
+        m_frameNodes.insert(m_frameNodes.end(), m_selectedNodes.begin(), m_selectedNodes.end());
+        m_frameNodes.insert(m_frameNodes.end(), m_unplaced.begin(), m_unplaced.end());
+        std::sort(m_frameNodes.begin(), m_frameNodes.end());
+        m_frameNodes.erase(std::unique(m_frameNodes.begin(), m_frameNodes.end()), m_frameNodes.end());
+    }
+
+    void ImNodeFlow::indexNode(BaseNode* node) {
+        const ImVec4& padding = node->getStyle()->padding;
+        ImVec2 min = node->getPos() - ImVec2(padding.x, padding.y);
+        ImVec2 max = node->getPos() + node->getSize() + ImVec2(padding.z, padding.w);
+        if (!m_nodeIndex.update(node, min, max))
+            return;
+        for (LinkHandle link : m_nodeSlots[node->getHandle().index].links)
+            m_dirtyLinks.push_back(getLink(link));
+    }
+
+    void ImNodeFlow::indexLink(Link* link) {
+        BaseNode* leftNode = link->left()->getParent();
+        BaseNode* rightNode = link->right()->getParent();
+        // Wait until both ends have been laid out once
+        if (!m_nodeIndex.contains(leftNode) || !m_nodeIndex.contains(rightNode))
+            return;
+        ImVec2 p1 = link->left()->pinPoint() - leftNode->getLayoutScroll();
+        ImVec2 p2 = link->right()->pinPoint() - rightNode->getLayoutScroll();
+
+        // Same control points as smart_bezier(): the curve never leaves their hull
+        float distance = sqrtf(powf((p2.x - p1.x), 2.f) + powf((p2.y - p1.y), 2.f));
+        float delta = distance * 0.45f;
+        if (p2.x < p1.x) delta += 0.2f * (p1.x - p2.x);
+        ImVec2 p22 = p2 - ImVec2(delta, 0.f);
+        if (p2.x < p1.x - 50.f) delta *= -1.f;
+        ImVec2 p11 = p1 + ImVec2(delta, 0.f);
+
+        // Room for the thickest outline and the hover collider
+        const auto& extra = link->left()->getStyle()->extra;
+        float margin = extra.link_hovered_thickness + extra.link_selected_outline_thickness + 2.5f;
+        ImVec2 min = ImMin(ImMin(p1, p2), ImMin(p11, p22)) - ImVec2(margin, margin);
+        ImVec2 max = ImMax(ImMax(p1, p2), ImMax(p11, p22)) + ImVec2(margin, margin);
+        m_linkIndex.update(link, min, max);
+    }
+
+    void ImNodeFlow::forgetNode(BaseNode* node) {
+        m_nodeIndex.remove(node);
+        m_unplaced.erase(std::remove(m_unplaced.begin(), m_unplaced.end(), node), m_unplaced.end());
+        m_frameNodes.erase(std::remove(m_frameNodes.begin(), m_frameNodes.end(), node), m_frameNodes.end());
     }
 
     void ImNodeFlow::update() {
@@ -266,22 +470,41 @@ namespace ImFlow {
                 draw_list->AddLine(ImVec2(0.0f, y), ImVec2(gridSize.x, y), m_style.colors.subGrid);
         }
 
-        // Update and draw nodes
-        // TODO: I don't like this
+        // Update and draw the nodes on the canvas
         draw_list->ChannelsSplit(2);
-        for (auto &node: m_nodes) { node.second->update(); }
-        // Remove "toDelete" nodes
-        for (auto iter = m_nodes.begin(); iter != m_nodes.end();) {
-            if (iter->second->toDestroy())
-                iter = m_nodes.erase(iter);
-            else
-                ++iter;
+        collectFrameNodes();
+        for (BaseNode* node : m_frameNodes) {
+            node->update();
+            indexNode(node);
         }
+        m_unplaced.clear();
         draw_list->ChannelsMerge();
-        for (auto &node: m_nodes) { node.second->updatePublicStatus(); }
 
-        // Update and draw links
-        for (auto &l: m_links) { if (!l.expired()) l.lock()->update(); }
+        // Remove "toDelete" nodes
+        m_selectedNodes.clear();
+        bool released = false;
+        for (size_t i = 0; i < m_nodes.size(); i++) {
+            BaseNode* node = m_nodes[i].get();
+            if (node->toDestroy()) {
+                releaseNode(node);
+                released = true;
+                continue;
+            }
+            node->updatePublicStatus();
+            if (node->isSelected()) m_selectedNodes.push_back(node);
+        }
+        if (released) compactNodes();
+
+        // Update and draw the links on the canvas
+        for (Link* link : m_dirtyLinks) indexLink(link);
+        m_dirtyLinks.clear();
+        m_frameLinks.clear();
+        if (m_culling)
+            m_linkIndex.query(screen2grid({0.f, 0.f}), screen2grid(ImGui::GetIO().DisplaySize), m_frameLinks);
+        else
+            m_frameLinks.assign(m_links.begin(), m_links.end());
+        for (size_t i = 0; i < m_frameLinks.size(); i++)
+            if (m_frameLinks[i]) m_frameLinks[i]->update();
 
         // Links drop-off
         if (m_dragOut && ImGui::IsMouseReleased(ImGuiMouseButton_Left)) {
@@ -327,10 +550,6 @@ namespace ImFlow {
             ImGui::EndPopup();
         }
 
-        // Removing dead Links
-        m_links.erase(std::remove_if(m_links.begin(), m_links.end(),
-                                     [](const std::weak_ptr<Link> &l) { return l.expired(); }), m_links.end());
-
         // Clearing recursion blacklist
         m_pinRecursionBlacklist.clear();
 
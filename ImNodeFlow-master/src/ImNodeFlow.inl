@@ -45,9 +45,8 @@ namespace ImFlow
         if (!n->getStyle())
             n->setStyle(NodeStyle::cyan());
 
-        auto uid = reinterpret_cast<uintptr_t>(n.get());
-        n->setUID(uid);
-        m_nodes[uid] = n;
+        n->setUID(reinterpret_cast<uintptr_t>(n.get()));
+        registerNode(n);
         return n;
     }
 
@@ -77,6 +76,7 @@ namespace ImFlow
     {
         PinUID h = std::hash<U>{}(uid);
         auto p = std::make_shared<InPin<T>>(h, name, defReturn, std::move(filter), std::move(style), this, &m_inf);
+        p->setIndex(static_cast<uint32_t>(m_ins.size()));
         m_ins.emplace_back(p);
         return p;
     }
@@ -89,7 +89,9 @@ namespace ImFlow
         {
             if (it->get()->getUid() == h)
             {
-                m_ins.erase(it);
+                it = m_ins.erase(it);
+                for (; it != m_ins.end(); it++)
+                    it->get()->setIndex(static_cast<uint32_t>(it - m_ins.begin()));
                 return;
             }
         }
@@ -134,6 +136,7 @@ namespace ImFlow
     {
         PinUID h = std::hash<U>{}(uid);
         auto p = std::make_shared<OutPin<T>>(h, name, std::move(style), this, &m_inf);
+        p->setIndex(static_cast<uint32_t>(m_outs.size()));
         m_outs.emplace_back(p);
         return p;
     }
@@ -146,7 +149,9 @@ namespace ImFlow
         {
             if (it->get()->getUid() == h)
             {
-                m_outs.erase(it);
+                it = m_outs.erase(it);
+                for (; it != m_outs.end(); it++)
+                    it->get()->setIndex(static_cast<uint32_t>(it - m_outs.begin()));
                 return;
             }
         }
@@ -230,6 +235,13 @@ namespace ImFlow
     // -----------------------------------------------------------------------------------------------------------------
     // PIN
 
+    inline PinHandle Pin::getHandle()
+    {
+        if (m_index == PinHandle::Invalid)
+            return PinHandle{};
+        return PinHandle{m_parent->getHandle(), m_index, m_type};
+    }
+
     inline void Pin::drawSocket()
     {
         ImDrawList* draw_list = ImGui::GetWindowDrawList();
@@ -292,10 +304,11 @@ namespace ImFlow
     template<class T>
     const T& InPin<T>::val()
     {
-        if(!m_link)
+        Link* link = getLink();
+        if(!link)
             return m_emptyVal;
 
-        return reinterpret_cast<OutPin<T>*>(m_link->left())->val();
+        return reinterpret_cast<OutPin<T>*>(link->left())->val();
     }
 
     template<class T>
@@ -307,18 +320,18 @@ namespace ImFlow
         if (m_parent == other->getParent() && !m_allowSelfConnection)
             return;
 
-        if (m_link && m_link->left() == other)
+        Link* link = getLink();
+        if (link && link->left() == other)
         {
-            m_link.reset();
+            deleteLink();
             return;
         }
 
         if (!m_filter(other, this)) // Check Filter
             return;
 
-        m_link = std::make_shared<Link>(other, this, (*m_inf));
-        other->setLink(m_link);
-        (*m_inf)->addLink(m_link);
+        deleteLink();
+        (*m_inf)->addLink(other, this);
     }
 
     // -----------------------------------------------------------------------------------------------------------------
@@ -347,15 +360,21 @@ namespace ImFlow
     }
 
     template<class T>
-    void OutPin<T>::setLink(std::shared_ptr<Link>& link)
+    void OutPin<T>::dropLink(LinkHandle link)
     {
-        m_links.emplace_back(link);
+        auto it = std::find(m_links.begin(), m_links.end(), link);
+        if (it != m_links.end())
+            m_links.erase(it);
     }
 
     template<class T>
     void OutPin<T>::deleteLink()
     {
-        m_links.erase(std::remove_if(m_links.begin(), m_links.end(),
-                                     [](const std::weak_ptr<Link>& l) { return l.expired(); }), m_links.end());
+        if (m_links.empty() || !*m_inf)
+            return;
+        std::vector<LinkHandle> links = std::move(m_links);
+        m_links.clear();
+        for (LinkHandle link : links)
+            (*m_inf)->destroyLink(link);
     }
 }
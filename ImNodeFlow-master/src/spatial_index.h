@@ -0,0 +1,182 @@
+#pragma once
+
+#include <imgui.h>
+#include <vector>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+
+namespace ImFlow
+{
+    /**
+     * @brief Uniform grid over axis-aligned rectangles
+     * @details Items are bucketed into every cell their rectangle overlaps. Moving an item only touches the cells it
+     *          leaves and enters, so it is cheap to keep up to date while Nodes are dragged. Queries return each
+     *          overlapping item once.
+     * @tparam T Type of the indexed items (stored by pointer, not owned)
+     */
+    template<typename T>
+    class SpatialIndex
+    {
+    public:
+        /**
+         * @brief <BR>Create an index
+         * @param cellSize Side of a cell in grid units
+         */
+        explicit SpatialIndex(float cellSize = 256.f) : m_cellSize(cellSize) {}
+
+        /**
+         * @brief <BR>Insert an item or move it to a new rectangle
+         * @param item Item to index
+         * @param min Top-left corner
+         * @param max Bottom-right corner
+         * @return TRUE if the item is new or its rectangle changed
+         */
+        bool update(T* item, const ImVec2& min, const ImVec2& max)
+        {
+            int x0 = cell(min.x), y0 = cell(min.y), x1 = cell(max.x), y1 = cell(max.y);
+            auto it = m_items.find(item);
+            if (it == m_items.end())
+            {
+                it = m_items.emplace(item, Item{}).first;
+            }
+            else
+            {
+                Item& old = it->second;
+                if (old.min.x == min.x && old.min.y == min.y && old.max.x == max.x && old.max.y == max.y)
+                    return false;
+                if (old.x0 == x0 && old.y0 == y0 && old.x1 == x1 && old.y1 == y1)
+                {
+                    old.min = min;
+                    old.max = max;
+                    return true;
+                }
+                forEachCell(old, [&](uint64_t key) { eraseFromCell(key, item); });
+            }
+            Item& entry = it->second;
+            entry.min = min;
+            entry.max = max;
+            entry.x0 = x0; entry.y0 = y0; entry.x1 = x1; entry.y1 = y1;
+            forEachCell(entry, [&](uint64_t key) { m_cells[key].push_back(item); });
+            return true;
+        }
+
+        /**
+         * @brief <BR>Remove an item
+         * @param item Item to remove, ignored if not indexed
+         */
+        void remove(T* item)
+        {
+            auto it = m_items.find(item);
+            if (it == m_items.end())
+                return;
+            forEachCell(it->second, [&](uint64_t key) { eraseFromCell(key, item); });
+            m_items.erase(it);
+        }
+
+        /**
+         * @brief <BR>Check if an item is indexed
+         */
+        [[nodiscard]] bool contains(T* item) const { return m_items.count(item) != 0; }
+
+        /**
+         * @brief <BR>Remove everything
+         */
+        void clear()
+        {
+            m_items.clear();
+            m_cells.clear();
+        }
+
+        /**
+         * @brief <BR>Collect the items overlapping a rectangle
+         * @param min Top-left corner
+         * @param max Bottom-right corner
+         * @param out Receives the items (appended, each once)
+         */
+        void query(const ImVec2& min, const ImVec2& max, std::vector<T*>& out)
+        {
+            m_stamp++;
+            auto visit = [&](const std::vector<T*>& items)
+            {
+                for (T* item : items)
+                {
+                    Item& entry = m_items.find(item)->second;
+                    if (entry.stamp == m_stamp)
+                        continue;
+                    entry.stamp = m_stamp;
+                    if (entry.max.x < min.x || entry.min.x > max.x || entry.max.y < min.y || entry.min.y > max.y)
+                        continue;
+                    out.push_back(item);
+                }
+            };
+
+            // Zoomed far out the range can hold more cells than are occupied; walk the occupied ones then
+            int x0 = cell(min.x), y0 = cell(min.y), x1 = cell(max.x), y1 = cell(max.y);
+            double range = (double(x1) - x0 + 1) * (double(y1) - y0 + 1);
+            if (range > double(m_cells.size()))
+            {
+                for (auto& c : m_cells)
+                {
+                    int cx = int(int32_t(uint32_t(c.first >> 32))), cy = int(int32_t(uint32_t(c.first)));
+                    if (cx >= x0 && cx <= x1 && cy >= y0 && cy <= y1)
+                        visit(c.second);
+                }
+                return;
+            }
+            for (int y = y0; y <= y1; y++)
+                for (int x = x0; x <= x1; x++)
+                {
+                    auto c = m_cells.find(key(x, y));
+                    if (c != m_cells.end())
+                        visit(c->second);
+                }
+        }
+
+        /**
+         * @brief <BR>Number of indexed items
+         */
+        [[nodiscard]] size_t size() const { return m_items.size(); }
+    private:
+        struct Item
+        {
+            ImVec2 min, max;
+            int x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+            uint64_t stamp = 0;
+        };
+
+        [[nodiscard]] int cell(float v) const { return (int)std::floor(v / m_cellSize); }
+
+        static uint64_t key(int x, int y) { return (uint64_t(uint32_t(x)) << 32) | uint32_t(y); }
+
+        template<typename F>
+        static void forEachCell(const Item& item, F&& f)
+        {
+            for (int y = item.y0; y <= item.y1; y++)
+                for (int x = item.x0; x <= item.x1; x++)
+                    f(key(x, y));
+        }
+
+        void eraseFromCell(uint64_t k, T* item)
+        {
+            auto c = m_cells.find(k);
+            if (c == m_cells.end())
+                return;
+            auto& items = c->second;
+            for (size_t i = 0; i < items.size(); i++)
+                if (items[i] == item)
+                {
+                    items[i] = items.back();
+                    items.pop_back();
+                    break;
+                }
+            if (items.empty())
+                m_cells.erase(c);
+        }
+
+        float m_cellSize;
+        std::unordered_map<T*, Item> m_items;
+        std::unordered_map<uint64_t, std::vector<T*>> m_cells;
+        uint64_t m_stamp = 0;
+    };
+}
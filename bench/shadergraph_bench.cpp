@@ -0,0 +1,587 @@
+// Benchmarks for the generation core and the GL paths behind each graph edit.
+//
+//   shadergraph_bench [--benchmark_filter=<regex>] [--benchmark_format=json] ...
+//
+// Every case runs over synthetic graphs of four shapes (fan-out, deep chain, many
+// textures, many parameters) at 10/100/1k/10k nodes. Besides time per iteration each
+// case reports heap allocations and allocated bytes per iteration. The GL cases need
+// an offscreen context and are skipped when none can be created.
+
+#include "graph_desc.h"
+#include "graph_io.h"
+#include "graph_binary.h"
+#include "material_generator.h"
+#include "dependency_graph.h"
+#include "parameter_registry.h"
+#include "shader_lang.h"
+#include "shader_bake.h"
+#include "shader_compiler.h"
+#include "uniform_reflection.h"
+#include "gl_platform.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Allocation counting for every case; relaxed atomics keep the overhead to a few cycles
+namespace {
+std::atomic<uint64_t> g_allocations{0};
+std::atomic<uint64_t> g_allocatedBytes{0};
+}
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using namespace ShaderGraph;
+
+constexpr int MinNodes = 10;
+constexpr int MaxNodes = 10000;
+
+class AllocationCounter {
+public:
+    AllocationCounter()
+        : m_allocations(g_allocations.load(std::memory_order_relaxed)),
+          m_bytes(g_allocatedBytes.load(std::memory_order_relaxed)) {}
+
+    void report(benchmark::State& state) const {
+        double allocations = static_cast<double>(g_allocations.load(std::memory_order_relaxed) - m_allocations);
+        double bytes = static_cast<double>(g_allocatedBytes.load(std::memory_order_relaxed) - m_bytes);
+        state.counters["allocs"] = benchmark::Counter(allocations, benchmark::Counter::kAvgIterations);
+        state.counters["bytes"] = benchmark::Counter(bytes, benchmark::Counter::kAvgIterations,
+                                                     benchmark::Counter::OneK::kIs1024);
+    }
+
+private:
+    uint64_t m_allocations;
+    uint64_t m_bytes;
+};
+
+// ---------------------------------------------------------------------------
+// Synthetic graphs
+// ---------------------------------------------------------------------------
+
+enum class Shape { FanOut, DeepChain, Textures, Parameters, Count };
+
+const char* shapeName(Shape shape) {
+    switch (shape) {
+        case Shape::FanOut: return "fanout";
+        case Shape::DeepChain: return "chain";
+        case Shape::Textures: return "textures";
+        case Shape::Parameters: return "params";
+        default: return "unknown";
+    }
+}
+
+struct PinRef {
+    uint32_t node;
+    uint32_t pin;
+};
+
+class GraphBuilder {
+public:
+    uint32_t add(NodeKind kind) {
+        NodeDesc node;
+        node.kind = kind;
+        node.id = m_graph.nodes.size() + 1;
+        node.pos[0] = static_cast<float>(m_graph.nodes.size() % 64) * 160.0f;
+        node.pos[1] = static_cast<float>(m_graph.nodes.size() / 64) * 120.0f;
+        m_graph.nodes.push_back(std::move(node));
+        return static_cast<uint32_t>(m_graph.nodes.size() - 1);
+    }
+
+    NodeDesc& node(uint32_t index) { return m_graph.nodes[index]; }
+
+    void link(PinRef from, uint32_t to, uint32_t toPin) {
+        m_graph.links.push_back({from.node, from.pin, to, toPin});
+    }
+
+    // Sum values pairwise, so the reduction only adds log2(n) depth
+    PinRef reduce(std::vector<PinRef> values) {
+        while (values.size() > 1) {
+            std::vector<PinRef> next;
+            next.reserve((values.size() + 1) / 2);
+            for (size_t i = 0; i + 1 < values.size(); i += 2) {
+                uint32_t sum = add(NodeKind::Add);
+                link(values[i], sum, 0);
+                link(values[i + 1], sum, 1);
+                next.push_back({sum, 0});
+            }
+            if (values.size() & 1) next.push_back(values.back());
+            values = std::move(next);
+        }
+        return values.front();
+    }
+
+    GraphDesc finish(PinRef color) {
+        uint32_t output = add(NodeKind::Output);
+        link(color, output, 0);
+        return std::move(m_graph);
+    }
+
+private:
+    GraphDesc m_graph;
+};
+
+// Graphs of roughly `nodes` nodes
+GraphDesc makeGraph(Shape shape, int nodes) {
+    GraphBuilder builder;
+    const int leaves = std::max(1, (nodes - 2) / 2);
+    std::vector<PinRef> values;
+    values.reserve(leaves);
+
+    switch (shape) {
+        case Shape::FanOut: {
+            // One source read by every leaf
+            uint32_t time = builder.add(NodeKind::Time);
+            for (int i = 0; i < leaves; ++i) {
+                uint32_t sin = builder.add(NodeKind::Sin);
+                builder.link({time, 0}, sin, 0);
+                values.push_back({sin, 0});
+            }
+            break;
+        }
+        case Shape::DeepChain: {
+            uint32_t previous = builder.add(NodeKind::Float);
+            builder.node(previous).value[0] = 0.5f;
+            for (int i = 0; i < nodes - 2; ++i) {
+                uint32_t next = builder.add(i & 1 ? NodeKind::Cos : NodeKind::Sin);
+                builder.link({previous, 0}, next, 0);
+                previous = next;
+            }
+            values.push_back({previous, 0});
+            break;
+        }
+        case Shape::Textures: {
+            uint32_t uv = builder.add(NodeKind::TexCoord);
+            for (int i = 0; i < leaves; ++i) {
+                uint32_t texture = builder.add(NodeKind::Texture);
+                builder.node(texture).textureUnit = i % 16;
+                builder.node(texture).name = "Texture " + std::to_string(i);
+                builder.link({uv, 0}, texture, 0);
+                values.push_back({texture, 1});
+            }
+            break;
+        }
+        case Shape::Parameters: {
+            for (int i = 0; i < leaves + 1; ++i) {
+                uint32_t param = builder.add(NodeKind::FloatParameter);
+                NodeDesc& node = builder.node(param);
+                node.name = "Param " + std::to_string(i);
+                node.value[0] = 0.5f;
+                node.value[2] = 1.0f;
+                values.push_back({param, 0});
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return builder.finish(builder.reduce(std::move(values)));
+}
+
+// Editor-like insertion order: nodes and links arrive shuffled, not topologically
+void shuffledOrder(const GraphDesc& graph, std::vector<uint32_t>& nodes, std::vector<uint32_t>& links) {
+    std::mt19937 rng(1234);
+    nodes.resize(graph.nodes.size());
+    links.resize(graph.links.size());
+    for (uint32_t i = 0; i < nodes.size(); ++i) nodes[i] = i;
+    for (uint32_t i = 0; i < links.size(); ++i) links[i] = i;
+    std::shuffle(nodes.begin(), nodes.end(), rng);
+    std::shuffle(links.begin(), links.end(), rng);
+}
+
+using NodeDependencies = DependencyGraph<NodeDesc, NodeDesc>;
+
+void buildDependencies(const GraphDesc& graph, const std::vector<uint32_t>& nodes, const std::vector<uint32_t>& links,
+                       NodeDependencies& deps) {
+    deps.clear();
+    for (uint32_t n : nodes) {
+        NodeDesc* node = const_cast<NodeDesc*>(&graph.nodes[n]);
+        deps.addNode(node, node);
+    }
+    for (uint32_t l : links) {
+        deps.addEdge(&graph.nodes[graph.links[l].fromNode], &graph.nodes[graph.links[l].toNode]);
+    }
+}
+
+std::vector<ParameterHandle> fillRegistry(const GraphDesc& graph, ParameterRegistry& registry) {
+    std::vector<ParameterHandle> handles;
+    for (const auto& param : parametersOf(graph)) handles.push_back(registry.add(nullptr, param));
+    registry.clearDirty();
+    return handles;
+}
+
+// ---------------------------------------------------------------------------
+// Generation core
+// ---------------------------------------------------------------------------
+
+void BM_LowerGraph(benchmark::State& state, Shape shape) {
+    GraphDesc graph = makeGraph(shape, static_cast<int>(state.range(0)));
+    IRModule module;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        lowerGraph(graph, module);
+        benchmark::DoNotOptimize(module.instrs.data());
+    }
+    allocations.report(state);
+    state.counters["instrs"] = static_cast<double>(module.instrs.size());
+}
+
+void BM_GenerateMaterial(benchmark::State& state, Shape shape) {
+    GraphDesc graph = makeGraph(shape, static_cast<int>(state.range(0)));
+    MaterialOptions options;
+    MaterialSources sources;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        generateMaterial(graph, options, sources);
+        benchmark::DoNotOptimize(sources.glsl.data());
+    }
+    allocations.report(state);
+    state.counters["glslBytes"] = static_cast<double>(sources.glsl.size());
+}
+
+// Re-emission of an unchanged module through a long-lived emitter and writer, as the
+// editor does on every edit: the fragment cache and buffers are warm after one pass
+void BM_EmitGLSL(benchmark::State& state, Shape shape) {
+    GraphDesc graph = makeGraph(shape, static_cast<int>(state.range(0)));
+    IRModule module;
+    lowerGraph(graph, module);
+    std::vector<UniformParameter> parameters = parametersOf(graph);
+    CrossPlatformShaderGenerator generator;
+    IREmitter emitter(IREmitter::Language::GLSL);
+    CodeWriter writer;
+    generator.writeGLSL(writer, emitter, module, parameters, false);
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        writer.clear();
+        generator.writeGLSL(writer, emitter, module, parameters, false);
+        benchmark::DoNotOptimize(writer.hash());
+    }
+    allocations.report(state);
+    state.counters["glslBytes"] = static_cast<double>(writer.size());
+}
+
+void BM_HLSLtoGLSL(benchmark::State& state, Shape shape) {
+    GraphDesc graph = makeGraph(shape, static_cast<int>(state.range(0)));
+    MaterialOptions options;
+    options.glsl = false;
+    MaterialSources sources;
+    generateMaterial(graph, options, sources);
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        std::string glsl = HLSLtoGLSLConverter::convert(sources.hlsl);
+        benchmark::DoNotOptimize(glsl.data());
+    }
+    allocations.report(state);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * sources.hlsl.size()));
+}
+
+// Dependency order maintained while a graph is built up in the editor
+void BM_DependencyBuild(benchmark::State& state, Shape shape) {
+    GraphDesc graph = makeGraph(shape, static_cast<int>(state.range(0)));
+    std::vector<uint32_t> nodes, links;
+    shuffledOrder(graph, nodes, links);
+    NodeDependencies deps;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        buildDependencies(graph, nodes, links, deps);
+        benchmark::DoNotOptimize(deps.nodeCount());
+    }
+    allocations.report(state);
+}
+
+// Per-regeneration query: everything upstream of the output, in order
+void BM_DependencyCollect(benchmark::State& state, Shape shape) {
+    GraphDesc graph = makeGraph(shape, static_cast<int>(state.range(0)));
+    std::vector<uint32_t> nodes, links;
+    shuffledOrder(graph, nodes, links);
+    NodeDependencies deps;
+    buildDependencies(graph, nodes, links, deps);
+    const NodeDesc* output = &graph.nodes[findOutputNode(graph)];
+    std::vector<NodeDesc*> sorted;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        deps.collectUpstream(output, sorted);
+        benchmark::DoNotOptimize(sorted.data());
+    }
+    allocations.report(state);
+}
+
+// One link edit followed by the query a regeneration makes
+void BM_DependencyRelink(benchmark::State& state, Shape shape) {
+    GraphDesc graph = makeGraph(shape, static_cast<int>(state.range(0)));
+    std::vector<uint32_t> nodes, links;
+    shuffledOrder(graph, nodes, links);
+    NodeDependencies deps;
+    buildDependencies(graph, nodes, links, deps);
+    const LinkDesc& link = graph.links.front();
+    const NodeDesc* from = &graph.nodes[link.fromNode];
+    const NodeDesc* to = &graph.nodes[link.toNode];
+    const NodeDesc* output = &graph.nodes[findOutputNode(graph)];
+    std::vector<NodeDesc*> sorted;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        deps.removeEdge(from, to);
+        deps.addEdge(from, to);
+        deps.collectUpstream(output, sorted);
+        benchmark::DoNotOptimize(sorted.data());
+    }
+    allocations.report(state);
+}
+
+void BM_ParseGraphText(benchmark::State& state, Shape shape) {
+    const std::string text = writeGraphText(makeGraph(shape, static_cast<int>(state.range(0))));
+    GraphDesc graph;
+    std::string error;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        if (!parseGraphText(text, graph, error)) {
+            state.SkipWithError(error.c_str());
+            break;
+        }
+    }
+    allocations.report(state);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+}
+
+void BM_LoadGraphBinary(benchmark::State& state, Shape shape) {
+    std::vector<char> data;
+    GraphDesc graph;
+    std::string error;
+    if (!writeGraphBinary(makeGraph(shape, static_cast<int>(state.range(0))), data, error)) {
+        state.SkipWithError(error.c_str());
+        return;
+    }
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        GraphFileView view;
+        if (!view.openMemory(data.data(), data.size(), error)) {
+            state.SkipWithError(error.c_str());
+            break;
+        }
+        view.toDesc(graph);
+    }
+    allocations.report(state);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * data.size()));
+}
+
+// CPU side of a uniform refresh: push edits into the registry and walk the dirty list
+void BM_ParameterEdit(benchmark::State& state) {
+    GraphDesc graph = makeGraph(Shape::Parameters, static_cast<int>(state.range(0)));
+    ParameterRegistry registry;
+    std::vector<ParameterHandle> handles = fillRegistry(graph, registry);
+    const size_t edited = state.range(1) ? handles.size() : 1;
+    float value = 0.0f;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        value = value < 1.0f ? value + 0.001f : 0.0f;
+        for (size_t i = 0; i < edited; ++i) registry.setFloat(handles[i], value);
+        float sum = 0.0f;
+        for (uint32_t i : registry.getDirty()) sum += registry.parameters()[i].floatValue;
+        benchmark::DoNotOptimize(sum);
+        registry.clearDirty();
+    }
+    allocations.report(state);
+}
+
+// CPU bake of level 0 at 256x256; items are pixels
+void BM_Bake(benchmark::State& state, Shape shape) {
+    GraphDesc graph = makeGraph(shape, static_cast<int>(state.range(0)));
+    BakeOptions options;
+    options.width = options.height = 256;
+    options.mipmaps = false;
+    options.threads = static_cast<unsigned>(state.range(1));
+    TextureImage image;
+    std::string error;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        if (!bakeGraph(graph, options, image, error)) {
+            state.SkipWithError(error.c_str());
+            break;
+        }
+        benchmark::DoNotOptimize(image.pixels.data());
+    }
+    allocations.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * options.width * options.height);
+}
+
+// ---------------------------------------------------------------------------
+// GL (offscreen context)
+// ---------------------------------------------------------------------------
+
+bool g_hasContext = false;
+
+GLFWwindow* createOffscreenContext() {
+    if (!glfwInit()) return nullptr;
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    GLFWwindow* window = glfwCreateWindow(1, 1, "shadergraph_bench", nullptr, nullptr);
+    if (!window) {
+        glfwTerminate();
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+#ifdef _WIN32
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return nullptr;
+    }
+#endif
+    return window;
+}
+
+// Compile + link of a generated material. Large texture/parameter graphs exceed the
+// driver's sampler and uniform limits and are reported as errors.
+void BM_CompileLink(benchmark::State& state, Shape shape) {
+    if (!g_hasContext) {
+        state.SkipWithError("no OpenGL context");
+        return;
+    }
+    GraphDesc graph = makeGraph(shape, static_cast<int>(state.range(0)));
+    MaterialOptions options;
+    options.hlsl = false;
+    MaterialSources sources;
+    generateMaterial(graph, options, sources);
+    const std::string vertexSource = buildVertexShader(options.useUniformBlock);
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        ShaderCompiler::Result result = ShaderCompiler::buildProgram(vertexSource, sources.glsl);
+        if (result.program) glDeleteProgram(result.program);
+        if (!result.success) {
+            state.SkipWithError(result.errorLog.c_str());
+            break;
+        }
+    }
+    allocations.report(state);
+}
+
+// Same path as App::setShaderUniforms: edit values, upload the dirty list, finish
+void BM_UniformUpload(benchmark::State& state) {
+    if (!g_hasContext) {
+        state.SkipWithError("no OpenGL context");
+        return;
+    }
+    GraphDesc graph = makeGraph(Shape::Parameters, static_cast<int>(state.range(0)));
+    MaterialOptions options;
+    options.hlsl = false;
+    MaterialSources sources;
+    generateMaterial(graph, options, sources);
+    ShaderCompiler::Result result = ShaderCompiler::buildProgram(buildVertexShader(false), sources.glsl);
+    if (!result.success) {
+        if (result.program) glDeleteProgram(result.program);
+        state.SkipWithError(result.errorLog.c_str());
+        return;
+    }
+
+    ParameterRegistry registry;
+    std::vector<ParameterHandle> handles = fillRegistry(graph, registry);
+    UniformReflection uniforms;
+    glUseProgram(result.program);
+    uniforms.reflect(result.program);
+    uniforms.resolveParameters(registry.parameters(), registry.getLayoutRevision());
+    const auto& locations = uniforms.getParameterLocations();
+
+    const size_t edited = state.range(1) ? handles.size() : 1;
+    float value = 0.0f;
+    AllocationCounter allocations;
+    for (auto _ : state) {
+        value = value < 1.0f ? value + 0.001f : 0.0f;
+        for (size_t i = 0; i < edited; ++i) registry.setFloat(handles[i], value);
+        for (uint32_t i : registry.getDirty()) UniformReflection::upload(registry.parameters()[i], locations[i]);
+        registry.clearDirty();
+        glFinish();
+    }
+    allocations.report(state);
+
+    glUseProgram(0);
+    glDeleteProgram(result.program);
+}
+
+// ---------------------------------------------------------------------------
+
+using ShapeBenchmark = void (*)(benchmark::State&, Shape);
+
+void registerShapes(const char* name, ShapeBenchmark fn, benchmark::TimeUnit unit) {
+    for (int s = 0; s < static_cast<int>(Shape::Count); ++s) {
+        Shape shape = static_cast<Shape>(s);
+        std::string fullName = std::string(name) + "/" + shapeName(shape);
+        benchmark::RegisterBenchmark(fullName.c_str(), fn, shape)
+            ->RangeMultiplier(10)
+            ->Range(MinNodes, MaxNodes)
+            ->ArgName("nodes")
+            ->Unit(unit);
+    }
+}
+
+void registerBenchmarks() {
+    registerShapes("LowerGraph", BM_LowerGraph, benchmark::kMicrosecond);
+    registerShapes("GenerateMaterial", BM_GenerateMaterial, benchmark::kMicrosecond);
+    registerShapes("EmitGLSL", BM_EmitGLSL, benchmark::kMicrosecond);
+    registerShapes("HLSLtoGLSL", BM_HLSLtoGLSL, benchmark::kMicrosecond);
+    registerShapes("DependencyBuild", BM_DependencyBuild, benchmark::kMicrosecond);
+    registerShapes("DependencyCollect", BM_DependencyCollect, benchmark::kMicrosecond);
+    registerShapes("DependencyRelink", BM_DependencyRelink, benchmark::kMicrosecond);
+    registerShapes("ParseGraphText", BM_ParseGraphText, benchmark::kMicrosecond);
+    registerShapes("LoadGraphBinary", BM_LoadGraphBinary, benchmark::kMicrosecond);
+    benchmark::RegisterBenchmark("ParameterEdit", BM_ParameterEdit)
+        ->ArgsProduct({benchmark::CreateRange(MinNodes, MaxNodes, 10), {0, 1}})
+        ->ArgNames({"nodes", "all"})
+        ->Unit(benchmark::kMicrosecond);
+    // Up to 1k nodes; a 10k node chain is seconds per bake. Single thread and all cores
+    for (int s = 0; s < static_cast<int>(Shape::Count); ++s) {
+        Shape shape = static_cast<Shape>(s);
+        const int64_t cores = std::max(1u, std::thread::hardware_concurrency());
+        benchmark::RegisterBenchmark((std::string("Bake/") + shapeName(shape)).c_str(), BM_Bake, shape)
+            ->ArgsProduct({benchmark::CreateRange(MinNodes, 1000, 10), {1, cores}})
+            ->ArgNames({"nodes", "threads"})
+            ->Unit(benchmark::kMillisecond);
+    }
+
+    registerShapes("CompileLink", BM_CompileLink, benchmark::kMillisecond);
+    benchmark::RegisterBenchmark("UniformUpload", BM_UniformUpload)
+        ->ArgsProduct({benchmark::CreateRange(MinNodes, MaxNodes, 10), {0, 1}})
+        ->ArgNames({"nodes", "all"})
+        ->Unit(benchmark::kMicrosecond);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+    GLFWwindow* window = createOffscreenContext();
+    g_hasContext = window != nullptr;
+
+    registerBenchmarks();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+
+    if (window) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+    }
+    return 0;
+}
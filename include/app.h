@@ -4,13 +4,26 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <deque>
 #include <unordered_map>
+#include <cstdint>
 
 struct GLFWwindow;
+class CompileScheduler;
+class ProgramCache;
+class UniformReflection;
+class FrameProfiler;
+class NodePreviewRenderer;
+class ShaderVariantManager;
+class TextureStreamer;
+class ParameterSweep;
+class PreviewMesh;
 
 namespace ShaderGraph {
     class ShaderGraphEditor;
+    class SubgraphBakeCache;
     struct UniformParameter;
+    struct CostBudget;
 }
 
 class App {
@@ -20,22 +33,76 @@ public:
     
     void init(int width, int height, const std::string& name);
     void run();
+    
+    // Open a graph file in a new tab. Before init() the first file becomes the focused
+    // document; the rest are opened one per frame so startup doesn't wait for them.
+    void open(const std::string& path);
 
 private:
+    struct FragmentWriter;
+    
+    // An open graph. Each keeps its own program, so switching tabs shows the last build
+    // at once; only the focused one is drawn and edited.
+    struct Document {
+        std::unique_ptr<ShaderGraph::ShaderGraphEditor> graph;
+        std::string name;                   // Tab label: the file name, or "Untitled <n>"
+        uint32_t id = 0;                    // CompileScheduler document, also the ImGui id
+        std::shared_ptr<FragmentWriter> writer;     // Used by this document's generators on the pool
+        unsigned int program = 0;           // Last good program
+        std::unique_ptr<UniformReflection> uniforms;    // Locations for program, refreshed on swap
+        
+        // Sources of the last build (read only in the editor)
+        std::string vertexSource;
+        std::string fragmentSource;
+        bool compileError = false;
+        std::string errorLog;
+        
+        uint64_t lastGraphRevision = 0;     // Graph revision last submitted
+        bool hasGraphRevision = false;
+        
+        // Texture files its samplers name, retained in the streamer
+        std::vector<std::string> texturePaths;
+        uint64_t textureRevision = 0;       // Graph plus parameter value revision they were read at
+        bool hasTextureRevision = false;
+        char path[256] = "graph.sgraphb";   // .sgraphb saves binary, anything else text
+        std::string fileStatus;
+    };
+    
+    Document& addDocument(const std::string& name);
+    bool openDocument(const std::string& path, std::string& error);
+    void openPendingDocuments();
+    void closeDocument(size_t index);
+    void focusDocument(size_t index);
+    Document* findDocument(uint32_t id);
+    void updateDocuments();
+    void submitBuild(Document& document);
+    void updateTextureReferences(Document& document);
+    void renderSchedulerStats();
+
     void initWindow();
     void initImGui();
     void initCubeRenderer();
     void initFramebuffer(int width, int height);
     void initShaderGraph();
-    void compileShaders();
+    void pollCompileScheduler();
     void shutdown();
     void render();
     void renderCubeToTexture();
+    void renderNodePreviews();
+    bool previewNeedsRender();
+    double idleWaitTimeout();
     void renderPreviewWindow();
     void renderShaderEditorWindow();
+    void renderCostSummary();
+    void renderVariantsSummary();
+    void renderSubgraphBakeOptions();
     void renderNodeGraphWindow();
     void renderParametersWindow();
-    void updateShaderFromGraph();
+    void renderSweepControls();
+    void renderMeshControls();
+    void setPreviewMesh(int shape);
+    void loadPreviewMesh();
+    void renderProfilerWindow();
     void setShaderUniforms();
 
     GLFWwindow* m_window = nullptr;
@@ -50,27 +117,78 @@ private:
     int m_fbWidth = 512;
     int m_fbHeight = 512;
     
-    // Cube rendering
-    unsigned int m_cubeVAO = 0;
-    unsigned int m_cubeVBO = 0;
-    unsigned int m_shaderProgram = 0;
+    // Preview rendering: a built-in shape or a loaded mesh, indexed and cache-optimized
+    std::unique_ptr<PreviewMesh> m_mesh;
+    int m_meshShape = 0;                // ShaderGraph::MeshShape, or -1 for a loaded file
+    char m_meshPath[256] = "";
+    std::string m_meshStatus;
+    unsigned int m_perFrameUBO = 0;
+    
+    // Generation and program builds of every document; a document's program stays the
+    // last good one until a new one is ready
+    std::unique_ptr<CompileScheduler> m_scheduler;
+    std::unique_ptr<ProgramCache> m_programCache;   // Linked program binaries, keyed by source hash
     
-    // Shader source code (generated from graph - read only in editor)
-    std::string m_vertexShaderSource;
-    std::string m_fragmentShaderSource;
+    // Per-node thumbnails, batched into one atlas
+    std::unique_ptr<NodePreviewRenderer> m_nodePreviews;
+    bool m_showNodePreviews = true;
     
-    // Shader compilation status
-    bool m_shaderCompileError = false;
-    std::string m_shaderErrorLog;
+    // Programs for every permutation of the graph's static switches
+    std::unique_ptr<ShaderVariantManager> m_variants;
+    std::string m_variantStatus;
+    
+    // Sampler textures, decoded on workers and streamed in over several frames
+    std::unique_ptr<TextureStreamer> m_textures;
+    
+    // Subgraph bakes of every document, rendered on a worker
+    std::unique_ptr<ShaderGraph::SubgraphBakeCache> m_bakeCache;
+    
+    // Grid of parameter variations in one instanced draw (the program reads its parameters per instance)
+    std::unique_ptr<ParameterSweep> m_sweep;
+    bool m_sweepPreview = false;
     
     // Animation
     float m_rotationAngle = 0.0f;
     float m_time = 0.0f;
+    float m_frameDelta = 0.0f;
+    bool m_rotatePreview = true;
     
-    // Node Graph Editor
-    std::unique_ptr<ShaderGraph::ShaderGraphEditor> m_shaderGraph;
+    // On-demand rendering: the preview is only redrawn when its inputs change, and the
+    // loop waits for events while nothing animates
+    bool m_renderOnDemand = true;
+    bool m_previewDirty = true;             // Program swap, resize or option change
+    uint64_t m_previewValueRevision = 0;    // Parameter values the preview was drawn with
+    uint64_t m_previewTextureRevision = 0;  // Resident textures the preview was drawn with
+    int m_activeFrames = 0;                 // Frames to run at full rate after an event
+    size_t m_previewRenders = 0;
+    bool m_idle = false;
+    
+    // Open documents, one tab each. m_document is the focused one and m_shaderGraph its
+    // editor; every window but the tab bar works on those.
+    std::vector<std::unique_ptr<Document>> m_documents;
+    Document* m_document = nullptr;
+    ShaderGraph::ShaderGraphEditor* m_shaderGraph = nullptr;
+    std::deque<std::string> m_pendingOpens;     // Files still to open, one per frame
+    uint32_t m_selectDocument = 0;              // Tab to select on the next frame, 0 = none
+    int m_untitledCount = 0;
     bool m_autoCompile = true;
-    std::string m_lastGeneratedCode;
+    std::vector<ShaderGraph::CostBudget> m_costBudgets;   // Built-in targets or cost_budgets.txt
+    int m_costBudget = 2;
+    
+    // Frame profiler: CPU scopes and GPU timer queries per pass
+    std::unique_ptr<FrameProfiler> m_profiler;
+    struct ProfilerPasses {
+        uint32_t graphUpdate = 0;
+        uint32_t generate = 0;
+        uint32_t compile = 0;
+        uint32_t uniforms = 0;
+        uint32_t previewGpu = 0;
+        uint32_t nodePreviews = 0;
+        uint32_t nodePreviewsGpu = 0;
+        uint32_t imguiGpu = 0;
+    } m_passes;
+    char m_tracePath[256] = "frame_trace.json";
+    std::string m_traceStatus;
     
     // Layout reset flag (when no imgui.ini exists)
     bool m_resetLayout = false;
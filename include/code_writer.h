@@ -0,0 +1,132 @@
+#ifndef CODE_WRITER_H
+#define CODE_WRITER_H
+
+#include "hash_util.h"
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Append-only text buffer for code generation. clear() keeps the capacity, so a
+// writer that lives as long as its generator stops allocating once it has seen the
+// largest shader. The FNV-1a hash of the text is kept up to date while appending,
+// which lets callers compare generated sources with one 64-bit compare.
+
+namespace ShaderGraph {
+
+// Span of text inside a CodeWriter (offsets stay valid when the buffer grows)
+struct CodeSpan {
+    uint32_t offset = 0;
+    uint32_t length = 0;
+};
+
+class CodeWriter {
+public:
+    void clear() {
+        m_size = 0;
+        m_hash = Fnv1a64::OffsetBasis;
+    }
+
+    void reserve(size_t capacity) {
+        if (capacity > m_buffer.size()) m_buffer.resize(capacity);
+    }
+
+    CodeWriter& append(std::string_view text) {
+        char* out = grow(text.size());
+        std::memcpy(out, text.data(), text.size());
+        hashBytes(out, text.size());
+        return *this;
+    }
+
+    CodeWriter& append(char c) {
+        char* out = grow(1);
+        *out = c;
+        hashBytes(out, 1);
+        return *this;
+    }
+
+    CodeWriter& append(const CodeSpan& span) {
+        // The source may be this buffer, so grow before taking its address
+        char* out = grow(span.length);
+        std::memcpy(out, m_buffer.data() + span.offset, span.length);
+        hashBytes(out, span.length);
+        return *this;
+    }
+
+    CodeWriter& appendInt(long long value) {
+        char buffer[24];
+        auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+        return append(std::string_view(buffer, static_cast<size_t>(result.ptr - buffer)));
+    }
+
+    // Shortest text that reads back as the same float, always with a '.' or exponent
+    // so it parses as a float literal in GLSL and HLSL
+    CodeWriter& appendFloat(float value) {
+        char buffer[32];
+        return append(std::string_view(buffer, formatShortest(value, buffer)));
+    }
+
+    CodeWriter& operator<<(std::string_view text) { return append(text); }
+    CodeWriter& operator<<(const char* text) { return append(std::string_view(text)); }
+    CodeWriter& operator<<(const std::string& text) { return append(std::string_view(text)); }
+    CodeWriter& operator<<(char c) { return append(c); }
+    CodeWriter& operator<<(int value) { return appendInt(value); }
+
+    // Mark the current end, then take the span of everything written since
+    uint32_t mark() const { return static_cast<uint32_t>(m_size); }
+    CodeSpan spanFrom(uint32_t start) const { return {start, static_cast<uint32_t>(m_size - start)}; }
+    std::string_view text(const CodeSpan& span) const { return std::string_view(m_buffer.data() + span.offset, span.length); }
+
+    std::string_view view() const { return std::string_view(m_buffer.data(), m_size); }
+    size_t size() const { return m_size; }
+    uint64_t hash() const { return m_hash; }
+
+    // Copy out, reusing the capacity of target
+    void copyTo(std::string& target) const { target.assign(m_buffer.data(), m_size); }
+    std::string str() const { return std::string(m_buffer.data(), m_size); }
+
+    static size_t formatShortest(float value, char* buffer) {
+        auto result = std::to_chars(buffer, buffer + 24, value);
+        size_t length = static_cast<size_t>(result.ptr - buffer);
+        if (std::memchr(buffer, '.', length) == nullptr && std::memchr(buffer, 'e', length) == nullptr &&
+            std::memchr(buffer, 'n', length) == nullptr) {  // inf / nan stay as they are
+            buffer[length++] = '.';
+            buffer[length++] = '0';
+        }
+        return length;
+    }
+
+private:
+    char* grow(size_t count) {
+        if (m_size + count > m_buffer.size()) m_buffer.resize(std::max<size_t>(m_size + count, m_buffer.size() * 2 + 256));
+        char* out = m_buffer.data() + m_size;
+        m_size += count;
+        return out;
+    }
+
+    void hashBytes(const char* data, size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            m_hash ^= static_cast<unsigned char>(data[i]);
+            m_hash *= Fnv1a64::Prime;
+        }
+    }
+
+    std::vector<char> m_buffer;
+    size_t m_size = 0;
+    uint64_t m_hash = Fnv1a64::OffsetBasis;
+};
+
+// Fixed-point text of a float with the given number of decimals (the legacy node code)
+inline std::string formatFixed(float value, int decimals) {
+    char buffer[64];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed, decimals);
+    if (result.ec != std::errc()) return "0.0";
+    return std::string(buffer, static_cast<size_t>(result.ptr - buffer));
+}
+
+} // namespace ShaderGraph
+
+#endif // CODE_WRITER_H
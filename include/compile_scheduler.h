@@ -0,0 +1,163 @@
+#ifndef COMPILE_SCHEDULER_H
+#define COMPILE_SCHEDULER_H
+
+#include "shader_compiler.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct GLFWwindow;
+class ProgramCache;
+
+// Program builds for every open document, shared so that many materials don't compete
+// for the driver.
+//
+// A request is a generator: a function that writes the vertex and fragment source from
+// inputs it captured on the render thread. Generators run on a worker pool; each document
+// has at most one running and one queued, and a newer request replaces the queued one.
+// Finished sources that hash the same as the document's last build are dropped. The rest
+// wait for one of a fixed number of compile slots (a ShaderCompiler each), so only that
+// many programs are with the driver at once; a synchronous backend gets one slot, which
+// update() fills at most once per frame. Both queues hand out work to the focused
+// document first, then oldest first.
+class CompileScheduler {
+public:
+    using DocumentId = uint32_t;
+
+    enum class Priority : uint8_t {
+        Focused,        // The graph being edited
+        Background,     // Open in another tab
+        Count
+    };
+
+    struct Sources {
+        std::string vertex;
+        std::string fragment;
+        uint64_t hash = 0;          // Of both, filled by the scheduler
+    };
+    using Generator = std::function<void(Sources&)>;
+
+    struct Result {
+        DocumentId document = 0;
+        ShaderCompiler::Result build;   // The caller owns build.program
+        Sources sources;                // What was built
+        double latency = 0.0;           // Seconds from the submit() the sources came from
+    };
+
+    struct Stats {
+        size_t documents = 0;
+        size_t queuedGenerations = 0;   // Waiting for a worker
+        size_t generating = 0;
+        size_t queuedCompiles = 0;      // Generated, waiting for a slot
+        size_t compiling = 0;
+        size_t slots = 0;
+        uint64_t delivered = 0;         // Builds handed out by poll()
+        uint64_t unchanged = 0;         // Generated the last build's sources again, not compiled
+        uint64_t superseded = 0;        // Replaced by a newer request before they were built
+        // Per Priority, in milliseconds
+        double lastLatency[static_cast<size_t>(Priority::Count)] = {};
+        double averageLatency[static_cast<size_t>(Priority::Count)] = {};
+        double maxLatency[static_cast<size_t>(Priority::Count)] = {};
+        uint64_t latencySamples[static_cast<size_t>(Priority::Count)] = {};
+    };
+
+    // workerCount 0 = hardware concurrency less the render thread
+    explicit CompileScheduler(unsigned workerCount = 0, unsigned maxCompiles = 2);
+    ~CompileScheduler();
+    CompileScheduler(const CompileScheduler&) = delete;
+    CompileScheduler& operator=(const CompileScheduler&) = delete;
+
+    // Render thread, main context current
+    void init(GLFWwindow* mainWindow);
+    void shutdown();
+
+    // Optional binary cache (not owned) for every slot; call after init()
+    void setProgramCache(ProgramCache* cache);
+
+    DocumentId addDocument(Priority priority);
+    // Drops the document's queued work; builds in flight are deleted when they finish
+    void removeDocument(DocumentId document);
+    void setPriority(DocumentId document, Priority priority);
+
+    // Queue a build of what generate writes. Any thread may call this.
+    void submit(DocumentId document, Generator generate);
+
+    // Collect finished builds and move generated sources into free slots. Render thread,
+    // once per frame.
+    void update();
+
+    // Fetch a finished build (render thread)
+    bool poll(Result& result);
+
+    // True while any document, or the given one, has work queued, in flight or undelivered
+    bool isBusy() const;
+    bool isBusy(DocumentId document) const;
+
+    Stats getStats() const;
+    const char* getBackendName() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Document {
+        DocumentId id = 0;
+        Priority priority = Priority::Background;
+        bool removed = false;
+
+        // Guarded by m_mutex
+        bool hasQueued = false;
+        Generator queued;
+        Clock::time_point queuedAt;
+        bool generating = false;
+        bool hasGenerated = false;
+        Sources generated;
+        Clock::time_point generatedAt;  // Submit time of the request
+
+        // Render thread
+        bool hasReady = false;
+        Sources ready;
+        Clock::time_point readyAt;
+        int slot = -1;                  // Compile slot building it, -1 = none
+        Sources compiling;
+        Clock::time_point compilingAt;
+        bool hasLastHash = false;
+        uint64_t lastHash = 0;          // Newest sources that went to, or wait for, a slot
+    };
+
+    struct Slot {
+        std::unique_ptr<ShaderCompiler> compiler;
+        DocumentId document = 0;
+        bool busy = false;
+    };
+
+    void workerLoop();
+    Document* nextGeneration();
+    Document* nextCompile();
+    Document* find(DocumentId document) const;
+    void recordLatency(Priority priority, double seconds);
+
+    unsigned m_workerCount;
+    unsigned m_maxCompiles;
+
+    // Render thread
+    std::vector<Slot> m_slots;
+    std::deque<Result> m_results;
+    DocumentId m_nextDocument = 1;
+
+    // Shared with the workers
+    std::vector<std::unique_ptr<Document>> m_documents;
+    std::vector<std::thread> m_workers;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_quit = false;
+    Stats m_stats;
+};
+
+#endif // COMPILE_SCHEDULER_H
@@ -0,0 +1,333 @@
+#ifndef DEPENDENCY_GRAPH_H
+#define DEPENDENCY_GRAPH_H
+
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+
+namespace ShaderGraph {
+
+// Fixed-size bitset over dense indices
+class DenseBitset {
+public:
+    void resize(size_t bits) { m_words.assign((bits + 63) / 64, 0); }
+    size_t size() const { return m_words.size() * 64; }
+    bool test(uint32_t i) const { return (m_words[i >> 6] >> (i & 63)) & 1u; }
+    void set(uint32_t i) { m_words[i >> 6] |= uint64_t(1) << (i & 63); }
+    void reset(uint32_t i) { m_words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+
+private:
+    std::vector<uint64_t> m_words;
+};
+
+// Dependency order of a node graph, maintained incrementally as edges come and go.
+// Nodes get dense indices on registration; edges point from a producer to its consumer.
+// The order is updated with the Pearce-Kelly dynamic topological sort, so an edge
+// insertion only reorders the nodes between its endpoints. While the graph contains a
+// cycle the order is rebuilt lazily by an iterative DFS that skips back edges.
+// Key is the node identity, Value the payload handed back by queries (may be null).
+template <typename Key, typename Value>
+class DependencyGraph {
+public:
+    void addNode(const Key* key, Value* value) {
+        if (m_index.count(key)) return;
+        uint32_t idx;
+        if (!m_free.empty()) {
+            idx = m_free.back();
+            m_free.pop_back();
+        } else {
+            idx = static_cast<uint32_t>(m_entries.size());
+            m_entries.emplace_back();
+        }
+        Entry& e = m_entries[idx];
+        e.key = key;
+        e.value = value;
+        e.alive = true;
+        // No edges yet, so the end of the order is always valid
+        e.ord = static_cast<uint32_t>(m_order.size());
+        m_order.push_back(idx);
+        m_index.emplace(key, idx);
+    }
+
+    void removeNode(const Key* key) {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) return;
+        uint32_t idx = it->second;
+        m_index.erase(it);
+
+        Entry& e = m_entries[idx];
+        for (uint32_t p : e.preds) eraseOne(m_entries[p].succs, idx);
+        for (uint32_t s : e.succs) eraseOne(m_entries[s].preds, idx);
+        e.preds.clear();
+        e.succs.clear();
+        e.key = nullptr;
+        e.value = nullptr;
+        e.alive = false;
+        m_order[e.ord] = Tombstone;
+        m_free.push_back(idx);
+
+        if (++m_tombstones > 32 && m_tombstones * 2 > m_order.size()) compact();
+    }
+
+    // Producer from feeds consumer to. Edges touching unregistered nodes are ignored.
+    void addEdge(const Key* from, const Key* to) {
+        uint32_t x, y;
+        if (!lookup(from, x) || !lookup(to, y)) return;
+        m_entries[x].succs.push_back(y);
+        m_entries[y].preds.push_back(x);
+        if (!m_orderValid) return;
+        if (x == y) {
+            m_orderValid = false;
+            return;
+        }
+        if (m_entries[x].ord < m_entries[y].ord) return;
+        reorder(x, y);
+    }
+
+    void removeEdge(const Key* from, const Key* to) {
+        uint32_t x, y;
+        if (!lookup(from, x) || !lookup(to, y)) return;
+        eraseOne(m_entries[x].succs, y);
+        eraseOne(m_entries[y].preds, x);
+        // Removing an edge never invalidates a topological order; a cyclic graph
+        // may have become acyclic, which the next rebuild finds out
+    }
+
+    void clear() {
+        m_entries.clear();
+        m_free.clear();
+        m_order.clear();
+        m_index.clear();
+        m_tombstones = 0;
+        m_orderValid = true;
+        m_backEdges = 0;
+    }
+
+    // Values of root and everything it depends on, dependencies first
+    void collectUpstream(const Key* root, std::vector<Value*>& out) {
+        out.clear();
+        uint32_t r;
+        if (!lookup(root, r)) return;
+        if (!m_orderValid) rebuild();
+
+        prepareVisited();
+        m_stack.clear();
+        m_delta.clear();
+        m_stack.push_back(r);
+        m_visited.set(r);
+        while (!m_stack.empty()) {
+            uint32_t n = m_stack.back();
+            m_stack.pop_back();
+            m_delta.push_back(n);
+            for (uint32_t p : m_entries[n].preds) {
+                if (!m_visited.test(p)) {
+                    m_visited.set(p);
+                    m_stack.push_back(p);
+                }
+            }
+        }
+        for (uint32_t n : m_delta) m_visited.reset(n);
+
+        sortByOrd(m_delta);
+        out.reserve(m_delta.size());
+        for (uint32_t n : m_delta) {
+            if (m_entries[n].value) out.push_back(m_entries[n].value);
+        }
+    }
+
+    // Every value, dependencies first
+    void collectAll(std::vector<Value*>& out) {
+        out.clear();
+        if (!m_orderValid) rebuild();
+        out.reserve(m_index.size());
+        for (uint32_t n : m_order) {
+            if (n != Tombstone && m_entries[n].value) out.push_back(m_entries[n].value);
+        }
+    }
+
+    size_t nodeCount() const { return m_index.size(); }
+
+    // Number of edges closing a cycle as of the last rebuild (0 while the order is incremental)
+    size_t cycleEdgeCount() const { return m_orderValid ? 0 : m_backEdges; }
+
+private:
+    static constexpr uint32_t Tombstone = UINT32_MAX;
+
+    struct Entry {
+        const Key* key = nullptr;
+        Value* value = nullptr;
+        uint32_t ord = 0;              // Slot in m_order
+        std::vector<uint32_t> preds;   // Producers (one entry per edge)
+        std::vector<uint32_t> succs;   // Consumers (one entry per edge)
+        bool alive = false;
+    };
+
+    bool lookup(const Key* key, uint32_t& idx) const {
+        auto it = m_index.find(key);
+        if (it == m_index.end()) return false;
+        idx = it->second;
+        return true;
+    }
+
+    static void eraseOne(std::vector<uint32_t>& list, uint32_t value) {
+        auto it = std::find(list.begin(), list.end(), value);
+        if (it != list.end()) {
+            *it = list.back();
+            list.pop_back();
+        }
+    }
+
+    void prepareVisited() {
+        if (m_visited.size() < m_entries.size()) m_visited.resize(m_entries.size() * 2);
+    }
+
+    void sortByOrd(std::vector<uint32_t>& nodes) const {
+        std::sort(nodes.begin(), nodes.end(), [this](uint32_t a, uint32_t b) {
+            return m_entries[a].ord < m_entries[b].ord;
+        });
+    }
+
+    // Pearce-Kelly: the new edge x -> y has ord[y] < ord[x]. Collect the nodes reachable
+    // from y that sit before x and the nodes reaching x that sit after y, then hand their
+    // slots back with the backward set first.
+    void reorder(uint32_t x, uint32_t y) {
+        const uint32_t lb = m_entries[y].ord;
+        const uint32_t ub = m_entries[x].ord;
+        prepareVisited();
+
+        // Forward from y, bounded by ub
+        m_forward.clear();
+        m_stack.clear();
+        m_stack.push_back(y);
+        m_visited.set(y);
+        bool cycle = false;
+        while (!m_stack.empty() && !cycle) {
+            uint32_t n = m_stack.back();
+            m_stack.pop_back();
+            m_forward.push_back(n);
+            for (uint32_t s : m_entries[n].succs) {
+                if (s == x) {
+                    cycle = true;
+                    break;
+                }
+                if (!m_visited.test(s) && m_entries[s].ord < ub) {
+                    m_visited.set(s);
+                    m_stack.push_back(s);
+                }
+            }
+        }
+        for (uint32_t n : m_stack) m_visited.reset(n);
+        for (uint32_t n : m_forward) m_visited.reset(n);
+        if (cycle) {
+            m_orderValid = false;
+            return;
+        }
+
+        // Backward from x, bounded by lb
+        m_backward.clear();
+        m_stack.push_back(x);
+        m_visited.set(x);
+        while (!m_stack.empty()) {
+            uint32_t n = m_stack.back();
+            m_stack.pop_back();
+            m_backward.push_back(n);
+            for (uint32_t p : m_entries[n].preds) {
+                if (!m_visited.test(p) && m_entries[p].ord > lb) {
+                    m_visited.set(p);
+                    m_stack.push_back(p);
+                }
+            }
+        }
+        for (uint32_t n : m_backward) m_visited.reset(n);
+
+        sortByOrd(m_forward);
+        sortByOrd(m_backward);
+
+        m_slots.clear();
+        for (uint32_t n : m_backward) m_slots.push_back(m_entries[n].ord);
+        for (uint32_t n : m_forward) m_slots.push_back(m_entries[n].ord);
+        std::sort(m_slots.begin(), m_slots.end());
+
+        size_t i = 0;
+        for (uint32_t n : m_backward) assignSlot(n, m_slots[i++]);
+        for (uint32_t n : m_forward) assignSlot(n, m_slots[i++]);
+    }
+
+    void assignSlot(uint32_t n, uint32_t slot) {
+        m_entries[n].ord = slot;
+        m_order[slot] = n;
+    }
+
+    // Drop tombstones while keeping the relative order
+    void compact() {
+        size_t w = 0;
+        for (uint32_t n : m_order) {
+            if (n == Tombstone) continue;
+            m_entries[n].ord = static_cast<uint32_t>(w);
+            m_order[w++] = n;
+        }
+        m_order.resize(w);
+        m_tombstones = 0;
+    }
+
+    // Full iterative postorder over producers. Back edges (cycles) are counted and skipped;
+    // when none remain the order becomes incremental again.
+    void rebuild() {
+        const size_t count = m_entries.size();
+        std::vector<uint8_t> state(count, 0);   // 0 new, 1 on stack, 2 done
+        std::vector<uint32_t> order;
+        order.reserve(m_index.size());
+        std::vector<std::pair<uint32_t, uint32_t>> stack;  // node, next pred
+        m_backEdges = 0;
+
+        // Start from the previous order so unrelated nodes keep their relative positions
+        for (uint32_t start : m_order) {
+            if (start == Tombstone || state[start]) continue;
+            stack.emplace_back(start, 0);
+            state[start] = 1;
+            while (!stack.empty()) {
+                auto& top = stack.back();
+                const auto& preds = m_entries[top.first].preds;
+                if (top.second < preds.size()) {
+                    uint32_t p = preds[top.second++];
+                    if (state[p] == 0) {
+                        state[p] = 1;
+                        stack.emplace_back(p, 0);
+                    } else if (state[p] == 1) {
+                        m_backEdges++;
+                    }
+                    continue;
+                }
+                state[top.first] = 2;
+                order.push_back(top.first);
+                stack.pop_back();
+            }
+        }
+
+        m_order = std::move(order);
+        for (uint32_t i = 0; i < m_order.size(); ++i) m_entries[m_order[i]].ord = i;
+        m_tombstones = 0;
+        m_orderValid = m_backEdges == 0;
+    }
+
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_free;
+    std::vector<uint32_t> m_order;   // Slot -> entry index, Tombstone for removed nodes
+    std::unordered_map<const Key*, uint32_t> m_index;
+    size_t m_tombstones = 0;
+    bool m_orderValid = true;
+    size_t m_backEdges = 0;
+
+    // Scratch reused across updates
+    DenseBitset m_visited;
+    std::vector<uint32_t> m_stack;
+    std::vector<uint32_t> m_forward;
+    std::vector<uint32_t> m_backward;
+    std::vector<uint32_t> m_delta;
+    std::vector<uint32_t> m_slots;
+};
+
+} // namespace ShaderGraph
+
+#endif // DEPENDENCY_GRAPH_H
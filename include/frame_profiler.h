@@ -0,0 +1,138 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+
+// Per-pass frame timings. CPU passes are timed with scoped steady_clock timers; GPU
+// passes with GL_TIME_ELAPSED queries kept in a small ring per pass, so results are read
+// a few frames later without stalling the pipeline (a slot that is still pending drops
+// that frame's sample instead of waiting).
+//
+// Every pass keeps a rolling history for the overlay; the most recent events are also
+// kept for export as a Chrome trace (chrome://tracing, Perfetto). GPU events are placed
+// at the CPU time the pass was submitted, on their own track.
+class FrameProfiler {
+public:
+    enum class PassType { Cpu, Gpu };
+
+    struct Stats {
+        float last = 0.0f;   // Milliseconds
+        float min = 0.0f;
+        float avg = 0.0f;
+        float p99 = 0.0f;
+        size_t samples = 0;
+    };
+
+    explicit FrameProfiler(size_t historySize = 240, size_t maxTraceEvents = 16384);
+    ~FrameProfiler();
+
+    // Render thread, context current. GPU passes are ignored when timer queries are missing.
+    void init();
+    void shutdown();
+
+    uint32_t addPass(const std::string& name, PassType type);
+
+    // CPU pass timed between beginFrame() and endFrame()
+    uint32_t getFramePass() const { return m_framePass; }
+
+    // Frame boundaries; endFrame() collects GPU results that have become available
+    void beginFrame();
+    void endFrame();
+
+    void beginCpu(uint32_t pass);
+    void endCpu(uint32_t pass);
+
+    // GPU passes must not overlap (one GL_TIME_ELAPSED query can be active at a time)
+    void beginGpu(uint32_t pass);
+    void endGpu(uint32_t pass);
+
+    // Scoped CPU timer
+    class Scope {
+    public:
+        Scope(FrameProfiler* profiler, uint32_t pass) : m_profiler(profiler), m_pass(pass) {
+            if (m_profiler) m_profiler->beginCpu(m_pass);
+        }
+        ~Scope() {
+            if (m_profiler) m_profiler->endCpu(m_pass);
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        FrameProfiler* m_profiler;
+        uint32_t m_pass;
+    };
+
+    // While paused nothing is recorded, so the history and trace can be inspected
+    void setPaused(bool paused) { m_paused = paused; }
+    bool isPaused() const { return m_paused; }
+    bool hasGpuTimers() const { return m_gpuTimers; }
+
+    size_t getPassCount() const { return m_passes.size(); }
+    const std::string& getPassName(uint32_t pass) const { return m_passes[pass].name; }
+    PassType getPassType(uint32_t pass) const { return m_passes[pass].type; }
+    Stats getStats(uint32_t pass) const;
+
+    // Rolling history in milliseconds, oldest first starting at getHistoryOffset()
+    const std::vector<float>& getHistory(uint32_t pass) const { return m_passes[pass].history; }
+    size_t getHistoryOffset(uint32_t pass) const { return m_passes[pass].historyNext; }
+
+    bool writeChromeTrace(const std::string& path, std::string& error) const;
+
+private:
+    static constexpr size_t QueryRingSize = 4;
+
+    struct PendingQuery {
+        uint64_t frame = 0;
+        double startUs = 0.0;
+        bool pending = false;
+    };
+
+    struct Pass {
+        std::string name;
+        PassType type = PassType::Cpu;
+        std::vector<float> history;
+        size_t historyNext = 0;
+        size_t historyCount = 0;
+
+        // Cpu: start of the open scope
+        double cpuStartUs = 0.0;
+        bool cpuOpen = false;
+
+        // Gpu: query ring
+        unsigned int queries[QueryRingSize] = {};
+        PendingQuery pending[QueryRingSize];
+        size_t nextQuery = 0;
+        bool gpuOpen = false;
+    };
+
+    struct TraceEvent {
+        uint32_t pass;
+        uint64_t frame;
+        double startUs;
+        double durationUs;
+    };
+
+    double nowUs() const;
+    void record(uint32_t pass, uint64_t frame, double startUs, double durationUs);
+    void collectGpu(Pass& pass, uint32_t index);
+
+    size_t m_historySize;
+    size_t m_maxTraceEvents;
+    std::vector<Pass> m_passes;
+    std::chrono::steady_clock::time_point m_origin;
+
+    std::vector<TraceEvent> m_trace;   // Ring of the most recent events
+    size_t m_traceNext = 0;
+
+    uint64_t m_frame = 0;
+    uint32_t m_framePass = 0;          // Whole-frame CPU time
+    bool m_gpuTimers = false;
+    bool m_initialized = false;
+    bool m_paused = false;
+};
+
+#endif // FRAME_PROFILER_H
@@ -0,0 +1,20 @@
+#ifndef GL_PLATFORM_H
+#define GL_PLATFORM_H
+
+// Platform OpenGL headers, shared by every translation unit that talks to GL
+
+#ifdef __APPLE__
+#define GL_SILENCE_DEPRECATION
+#include <OpenGL/gl3.h>
+#elif defined(_WIN32)
+#include <GL/glew.h>
+#endif
+
+#include <GLFW/glfw3.h>
+
+// GL_KHR_parallel_shader_compile / GL_ARB_parallel_shader_compile
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+#endif // GL_PLATFORM_H
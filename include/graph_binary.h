@@ -0,0 +1,129 @@
+#ifndef GRAPH_BINARY_H
+#define GRAPH_BINARY_H
+
+#include "graph_desc.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Binary graph files (.sgraphb): a fixed header followed by flat tables, all 8-byte
+// aligned and little-endian, so a mapped file is used in place:
+//
+//   GraphFileHeader
+//   GraphFileNode[nodeCount]
+//   GraphFileLink[linkCount]
+//   char strings[stringBytes]   (node names, each followed by its texture path; not NUL-terminated)
+//
+// GraphFileView maps a file and checks bounds once; after that every access is a
+// pointer offset. Scanning a library for parameters never builds a GraphDesc.
+//
+// GraphBinaryVersion changes whenever the bytes of a table change meaning, and files of
+// any other version are refused rather than misread:
+//   1  nodes and links
+//   2  texture paths after the node names (pathLength)
+//   3  per node precision overrides
+//   4  per node bake settings
+
+namespace ShaderGraph {
+
+constexpr const char* GraphBinaryExtension = ".sgraphb";
+constexpr uint32_t GraphBinaryVersion = 4;
+
+struct GraphFileHeader {
+    char magic[4];          // "SGRB"
+    uint32_t version;
+    uint32_t nodeCount;
+    uint32_t linkCount;
+    uint32_t stringBytes;
+    uint32_t reserved;
+    uint64_t nodeOffset;
+    uint64_t linkOffset;
+    uint64_t stringOffset;
+};
+static_assert(sizeof(GraphFileHeader) == 48, "GraphFileHeader layout");
+
+struct GraphFileNode {
+    uint64_t id;
+    float pos[2];
+    float value[4];
+    uint32_t nameOffset;    // Into the string table
+    uint32_t nameLength;
+    uint8_t kind;           // NodeKind
+    uint8_t bake;           // BakeFormat << 4 | log2(bake size), 0 for defaults
+    uint8_t textureUnit;    // Below TextureUnitCount
+    uint8_t precision;      // ShaderPrecision override
+    uint32_t pathLength;    // Texture path, right after the name in the string table
+};
+static_assert(sizeof(GraphFileNode) == 48, "GraphFileNode layout");
+
+struct GraphFileLink {
+    uint32_t fromNode;
+    uint32_t fromPin;
+    uint32_t toNode;
+    uint32_t toPin;
+};
+static_assert(sizeof(GraphFileLink) == 16, "GraphFileLink layout");
+
+// Read-only view over a binary graph, either memory-mapped from disk or over a caller buffer
+class GraphFileView {
+public:
+    GraphFileView() = default;
+    ~GraphFileView();
+    GraphFileView(const GraphFileView&) = delete;
+    GraphFileView& operator=(const GraphFileView&) = delete;
+    GraphFileView(GraphFileView&& other) noexcept;
+    GraphFileView& operator=(GraphFileView&& other) noexcept;
+
+    // Map a file and validate it
+    bool open(const std::string& path, std::string& error);
+
+    // Validate a buffer that outlives the view
+    bool openMemory(const void* data, size_t size, std::string& error);
+
+    void close();
+
+    uint32_t nodeCount() const { return m_header ? m_header->nodeCount : 0; }
+    uint32_t linkCount() const { return m_header ? m_header->linkCount : 0; }
+    const GraphFileNode& node(uint32_t index) const { return m_nodes[index]; }
+    const GraphFileLink& link(uint32_t index) const { return m_links[index]; }
+    NodeKind nodeKind(uint32_t index) const { return static_cast<NodeKind>(m_nodes[index].kind); }
+    std::string_view nodeName(uint32_t index) const {
+        return std::string_view(m_strings + m_nodes[index].nameOffset, m_nodes[index].nameLength);
+    }
+    std::string_view nodePath(uint32_t index) const {
+        const GraphFileNode& node = m_nodes[index];
+        return std::string_view(m_strings + node.nameOffset + node.nameLength, node.pathLength);
+    }
+
+    // Copy one node, or the whole graph, into an editable description
+    NodeDesc toNodeDesc(uint32_t index) const;
+    void toDesc(GraphDesc& graph) const;
+
+private:
+    bool validate(std::string& error);
+
+    const GraphFileHeader* m_header = nullptr;
+    const GraphFileNode* m_nodes = nullptr;
+    const GraphFileLink* m_links = nullptr;
+    const char* m_strings = nullptr;
+
+    // Mapping owned by the view (unset for openMemory)
+    const void* m_mapping = nullptr;
+    size_t m_mappingSize = 0;
+    void* m_mappingHandle = nullptr;   // Windows file mapping object
+};
+
+// False for graphs the format can't hold (texture units outside [0, TextureUnitCount))
+bool writeGraphBinary(const GraphDesc& graph, std::vector<char>& out, std::string& error);
+
+bool loadGraphBinary(const std::string& path, GraphDesc& graph, std::string& error);
+bool saveGraphBinary(const std::string& path, const GraphDesc& graph, std::string& error);
+
+// True when data starts with the binary graph magic
+bool isGraphBinary(const void* data, size_t size);
+bool isGraphBinaryFile(const std::string& path);
+
+} // namespace ShaderGraph
+
+#endif // GRAPH_BINARY_H
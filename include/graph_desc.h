@@ -0,0 +1,454 @@
+#ifndef GRAPH_DESC_H
+#define GRAPH_DESC_H
+
+#include "shader_types.h"
+#include "shader_ir.h"
+#include "shader_precision.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cctype>
+#include <algorithm>
+
+// Plain description of a shader graph: node kinds, their values and the links between
+// pins. This is the UI-free generation core - the editor nodes describe themselves
+// with it and headless tools build it from files. Everything here is free functions
+// over const data, so graphs can be lowered on any number of threads at once.
+
+namespace ShaderGraph {
+
+enum class NodeKind : uint8_t {
+    Float,
+    Color,
+    FloatParameter,
+    Vec3Parameter,
+    Time,
+    Position,
+    Normal,
+    TexCoord,
+    Add,
+    Multiply,
+    Subtract,
+    Divide,
+    Sin,
+    Cos,
+    Abs,
+    Mix,
+    Clamp,
+    MakeVec3,
+    SplitVec3,
+    Fresnel,
+    Texture,
+    Output,
+    StaticSwitch,
+    Count
+};
+
+// Values carried by a node. Which fields are used depends on the kind:
+//   Float           value[0]
+//   Color           value[0..2]
+//   FloatParameter  value[0] = value, value[1] = min, value[2] = max, name
+//   Vec3Parameter   value[0..2], name
+//   Clamp           value[0] = min, value[1] = max
+//   Texture         textureUnit, name, path
+//   StaticSwitch    name = keyword, value[0] != 0 when on without a variant keyword set
+// Any node can override the precision policy for the values it computes, and how a baked
+// subgraph rooted at it is stored.
+struct NodeDesc {
+    NodeKind kind = NodeKind::Float;
+    uint64_t id = 0;              // Unique within the graph; parameter uniform names use it
+    float pos[2] = {0.0f, 0.0f};  // Editor position
+    float value[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    int textureUnit = 0;          // Below TextureUnitCount
+    std::string name;             // Parameter display name or keyword
+    std::string path;             // Texture file
+    ShaderPrecision precision = ShaderPrecision::Default;
+    BakeFormat bakeFormat = BakeFormat::Default;
+    uint16_t bakeSize = 0;        // Baked texture size, a power of two in [16, 4096]; 0 = material default
+};
+
+// Per node bake overrides as written in graph files
+inline const char* bakeFormatName(BakeFormat format) {
+    switch (format) {
+        case BakeFormat::UNorm8: return "8bit";
+        case BakeFormat::Half: return "half";
+        case BakeFormat::Off: return "off";
+        default: return "default";
+    }
+}
+
+inline bool bakeFormatFromName(std::string_view name, BakeFormat& format) {
+    for (BakeFormat f : {BakeFormat::Default, BakeFormat::UNorm8, BakeFormat::Half, BakeFormat::Off}) {
+        if (name == bakeFormatName(f)) {
+            format = f;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sampler units a Texture node may bind
+constexpr int TextureUnitCount = 16;
+
+inline bool validBakeSize(uint64_t size) {
+    return size == 0 || (size >= 16 && size <= 4096 && (size & (size - 1)) == 0);
+}
+
+// Output pin fromPin of node fromNode feeds input pin toPin of node toNode (node indices)
+struct LinkDesc {
+    uint32_t fromNode = 0;
+    uint32_t fromPin = 0;
+    uint32_t toNode = 0;
+    uint32_t toPin = 0;
+};
+
+struct GraphDesc {
+    std::vector<NodeDesc> nodes;
+    std::vector<LinkDesc> links;
+
+    void clear() {
+        nodes.clear();
+        links.clear();
+    }
+};
+
+// Static description of a node kind's pins
+struct NodeKindInfo {
+    const char* name;
+    const char* const* inputs;
+    uint8_t inputCount;
+    const char* const* outputs;
+    uint8_t outputCount;
+    bool isParameter;
+};
+
+inline const NodeKindInfo& nodeKindInfo(NodeKind kind) {
+    static constexpr const char* none[] = {nullptr};
+    static constexpr const char* value[] = {"Value"};
+    static constexpr const char* rgb[] = {"RGB"};
+    static constexpr const char* rgbSplit[] = {"RGB", "R", "G", "B"};
+    static constexpr const char* time[] = {"Time"};
+    static constexpr const char* xyzSplit[] = {"XYZ", "X", "Y", "Z"};
+    static constexpr const char* normal[] = {"Normal"};
+    static constexpr const char* uvSplit[] = {"UV", "U", "V"};
+    static constexpr const char* ab[] = {"A", "B"};
+    static constexpr const char* abt[] = {"A", "B", "T"};
+    static constexpr const char* x[] = {"X"};
+    static constexpr const char* xyz[] = {"X", "Y", "Z"};
+    static constexpr const char* result[] = {"Result"};
+    static constexpr const char* vec3[] = {"Vec3"};
+    static constexpr const char* power[] = {"Power"};
+    static constexpr const char* factor[] = {"Factor"};
+    static constexpr const char* uv[] = {"UV"};
+    static constexpr const char* rgbaSplit[] = {"RGBA", "RGB", "R", "G", "B", "A"};
+    static constexpr const char* colorAlpha[] = {"Color", "Alpha"};
+    static constexpr const char* onOff[] = {"On", "Off"};
+
+    static constexpr NodeKindInfo table[] = {
+        {"Float", none, 0, value, 1, false},
+        {"Color", none, 0, rgb, 1, false},
+        {"FloatParameter", none, 0, value, 1, true},
+        {"Vec3Parameter", none, 0, rgbSplit, 4, true},
+        {"Time", none, 0, time, 1, false},
+        {"Position", none, 0, xyzSplit, 4, false},
+        {"Normal", none, 0, normal, 1, false},
+        {"TexCoord", none, 0, uvSplit, 3, false},
+        {"Add", ab, 2, result, 1, false},
+        {"Multiply", ab, 2, result, 1, false},
+        {"Subtract", ab, 2, result, 1, false},
+        {"Divide", ab, 2, result, 1, false},
+        {"Sin", x, 1, result, 1, false},
+        {"Cos", x, 1, result, 1, false},
+        {"Abs", x, 1, result, 1, false},
+        {"Mix", abt, 3, result, 1, false},
+        {"Clamp", x, 1, result, 1, false},
+        {"MakeVec3", xyz, 3, vec3, 1, false},
+        {"SplitVec3", vec3, 1, xyz, 3, false},
+        {"Fresnel", power, 1, factor, 1, false},
+        {"Texture", uv, 1, rgbaSplit, 6, true},
+        {"Output", colorAlpha, 2, none, 0, false},
+        {"StaticSwitch", onOff, 2, result, 1, false},
+    };
+    static_assert(sizeof(table) / sizeof(table[0]) == static_cast<size_t>(NodeKind::Count),
+                  "Node kind table out of date");
+    return table[static_cast<size_t>(kind)];
+}
+
+inline bool nodeKindFromName(std::string_view name, NodeKind& kind) {
+    for (size_t i = 0; i < static_cast<size_t>(NodeKind::Count); ++i) {
+        if (name == nodeKindInfo(static_cast<NodeKind>(i)).name) {
+            kind = static_cast<NodeKind>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Pin index by name, -1 when the kind has no such pin
+inline int findPin(const char* const* pins, uint8_t count, std::string_view name) {
+    for (uint8_t i = 0; i < count; ++i) {
+        if (name == pins[i]) return i;
+    }
+    return -1;
+}
+
+// Uniform name of a parameter node: u_<display name>_<id>, keeping alphanumerics
+// and turning spaces into underscores
+inline std::string parameterUniformName(const std::string& displayName, const char* fallback, uint64_t id) {
+    const std::string& name = displayName.empty() ? std::string(fallback) : displayName;
+    std::string clean = "u_";
+    for (char c : name) {
+        if (std::isalnum(static_cast<unsigned char>(c))) clean += c;
+        else if (c == ' ') clean += '_';
+    }
+    clean += "_" + std::to_string(id);
+    return clean;
+}
+
+inline std::string parameterUniformName(const NodeDesc& node) {
+    switch (node.kind) {
+        case NodeKind::FloatParameter: return parameterUniformName(node.name, "param", node.id);
+        case NodeKind::Vec3Parameter: return parameterUniformName(node.name, "color", node.id);
+        case NodeKind::Texture: return parameterUniformName(node.name, "texture", node.id);
+        default: return std::string();
+    }
+}
+
+// Uniform description of a parameter node (default-constructed for other kinds)
+inline UniformParameter parameterOf(const NodeDesc& node) {
+    switch (node.kind) {
+        case NodeKind::FloatParameter:
+            return UniformParameter::Float(parameterUniformName(node), node.name.empty() ? "Float Parameter" : node.name,
+                                           node.value[0], node.value[1], node.value[2]);
+        case NodeKind::Vec3Parameter:
+            return UniformParameter::Vec3(parameterUniformName(node), node.name.empty() ? "Vec3 Parameter" : node.name,
+                                          node.value[0], node.value[1], node.value[2]);
+        case NodeKind::Texture:
+            return UniformParameter::Sampler2D(parameterUniformName(node), node.name.empty() ? "Texture" : node.name,
+                                               node.textureUnit, node.path);
+        default:
+            return UniformParameter();
+    }
+}
+
+// Parameters of every parameter node, in node order
+inline std::vector<UniformParameter> parametersOf(const GraphDesc& graph) {
+    std::vector<UniformParameter> params;
+    for (const auto& node : graph.nodes) {
+        if (nodeKindInfo(node.kind).isParameter) params.push_back(parameterOf(node));
+    }
+    return params;
+}
+
+// Lower one node. in/out are parallel to the kind's input/output pins; unconnected
+// inputs are IRNone and take the node's default.
+inline void lowerNode(const NodeDesc& node, IRBuilder& ir, const IRValue* in, IRValue* out) {
+    auto inputOr = [in](int index, IRValue fallback) { return in[index] != IRNone ? in[index] : fallback; };
+
+    switch (node.kind) {
+        case NodeKind::Float:
+            out[0] = ir.constant(node.value[0]);
+            break;
+        case NodeKind::Color:
+            out[0] = ir.constant(node.value[0], node.value[1], node.value[2]);
+            break;
+        case NodeKind::FloatParameter:
+            out[0] = ir.uniform(parameterUniformName(node), ShaderDataType::Float);
+            break;
+        case NodeKind::Vec3Parameter: {
+            IRValue rgb = ir.uniform(parameterUniformName(node), ShaderDataType::Vec3);
+            out[0] = rgb;
+            out[1] = ir.swizzle(rgb, "r");
+            out[2] = ir.swizzle(rgb, "g");
+            out[3] = ir.swizzle(rgb, "b");
+            break;
+        }
+        case NodeKind::Time:
+            out[0] = ir.uniform("time", ShaderDataType::Float);
+            break;
+        case NodeKind::Position: {
+            IRValue pos = ir.input("FragPos", ShaderDataType::Vec3);
+            out[0] = pos;
+            out[1] = ir.swizzle(pos, "x");
+            out[2] = ir.swizzle(pos, "y");
+            out[3] = ir.swizzle(pos, "z");
+            break;
+        }
+        case NodeKind::Normal:
+            out[0] = ir.unary(IROp::Normalize, ir.input("Normal", ShaderDataType::Vec3));
+            break;
+        case NodeKind::TexCoord: {
+            IRValue uv = ir.input("TexCoord", ShaderDataType::Vec2);
+            out[0] = uv;
+            out[1] = ir.swizzle(uv, "x");
+            out[2] = ir.swizzle(uv, "y");
+            break;
+        }
+        case NodeKind::Add:
+            out[0] = ir.add(inputOr(0, ir.constant(0.0f)), inputOr(1, ir.constant(0.0f)));
+            break;
+        case NodeKind::Multiply:
+            out[0] = ir.mul(inputOr(0, ir.constant(1.0f)), inputOr(1, ir.constant(1.0f)));
+            break;
+        case NodeKind::Subtract:
+            out[0] = ir.sub(inputOr(0, ir.constant(0.0f)), inputOr(1, ir.constant(0.0f)));
+            break;
+        case NodeKind::Divide:
+            out[0] = ir.div(inputOr(0, ir.constant(1.0f)), inputOr(1, ir.constant(1.0f)));
+            break;
+        case NodeKind::Sin:
+            out[0] = ir.unary(IROp::Sin, inputOr(0, ir.constant(0.0f)));
+            break;
+        case NodeKind::Cos:
+            out[0] = ir.unary(IROp::Cos, inputOr(0, ir.constant(0.0f)));
+            break;
+        case NodeKind::Abs:
+            out[0] = ir.unary(IROp::Abs, inputOr(0, ir.constant(0.0f)));
+            break;
+        case NodeKind::Mix:
+            out[0] = ir.mix(inputOr(0, ir.constant(0.0f)), inputOr(1, ir.constant(1.0f)),
+                            inputOr(2, ir.constant(0.5f)));
+            break;
+        case NodeKind::Clamp:
+            out[0] = ir.clamp(inputOr(0, ir.constant(0.0f)), ir.constant(node.value[0]), ir.constant(node.value[1]));
+            break;
+        case NodeKind::MakeVec3:
+            out[0] = ir.makeVec3(inputOr(0, ir.constant(0.0f)), inputOr(1, ir.constant(0.0f)),
+                                 inputOr(2, ir.constant(0.0f)));
+            break;
+        case NodeKind::SplitVec3: {
+            IRValue v = inputOr(0, ir.constant(0.0f, 0.0f, 0.0f));
+            out[0] = ir.swizzle(v, "x");
+            out[1] = ir.swizzle(v, "y");
+            out[2] = ir.swizzle(v, "z");
+            break;
+        }
+        case NodeKind::Fresnel: {
+            // pow(1.0 - max(dot(normalize(Normal), normalize(viewPos - FragPos)), 0.0), power)
+            IRValue normal = ir.unary(IROp::Normalize, ir.input("Normal", ShaderDataType::Vec3));
+            IRValue toView = ir.sub(ir.uniform("viewPos", ShaderDataType::Vec3), ir.input("FragPos", ShaderDataType::Vec3));
+            IRValue facing = ir.max(ir.dot(normal, ir.unary(IROp::Normalize, toView)), ir.constant(0.0f));
+            out[0] = ir.pow(ir.sub(ir.constant(1.0f), facing), inputOr(0, ir.constant(2.0f)));
+            break;
+        }
+        case NodeKind::Texture: {
+            IRValue uv = inputOr(0, ir.swizzle(ir.input("FragPos", ShaderDataType::Vec3), "xy"));
+            // Sample once; the other pins swizzle the RGBA value
+            IRValue rgba = ir.texture(parameterUniformName(node), uv);
+            out[0] = rgba;
+            out[1] = ir.swizzle(rgba, "rgb");
+            out[2] = ir.swizzle(rgba, "r");
+            out[3] = ir.swizzle(rgba, "g");
+            out[4] = ir.swizzle(rgba, "b");
+            out[5] = ir.swizzle(rgba, "a");
+            break;
+        }
+        case NodeKind::Output:
+            ir.setOutput(inputOr(0, ir.constant(1.0f, 0.5f, 0.2f)), inputOr(1, ir.constant(1.0f)));
+            break;
+        case NodeKind::StaticSwitch: {
+            // Resolved while lowering: the other branch is dead code and never emitted
+            const bool enabled = ir.keywordEnabled(node.name, node.value[0] != 0.0f);
+            out[0] = in[enabled ? 0 : 1];
+            if (out[0] == IRNone) {
+                // Unconnected branch: 1 or 0, as wide as the connected one
+                IRValue other = in[enabled ? 1 : 0];
+                int width = other != IRNone ? componentCount(ir.typeOf(other)) : 1;
+                static const char* masks[] = {"x", "x", "xx", "xxx", "xxxx"};
+                out[0] = ir.swizzle(ir.constant(enabled ? 1.0f : 0.0f), masks[std::min(std::max(width, 1), 4)]);
+            }
+            break;
+        }
+        case NodeKind::Count:
+            break;
+    }
+}
+
+// Keywords of every static switch, sorted and unique
+inline std::vector<std::string> keywordsOf(const GraphDesc& graph) {
+    std::vector<std::string> keywords;
+    for (const auto& node : graph.nodes) {
+        if (node.kind == NodeKind::StaticSwitch && !node.name.empty()) keywords.push_back(node.name);
+    }
+    std::sort(keywords.begin(), keywords.end());
+    keywords.erase(std::unique(keywords.begin(), keywords.end()), keywords.end());
+    return keywords;
+}
+
+// Index of the first Output node, -1 when there is none
+inline int findOutputNode(const GraphDesc& graph) {
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        if (graph.nodes[i].kind == NodeKind::Output) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// Lower everything the Output node depends on into module. Iterative postorder over
+// the links, so depth is bounded by memory rather than the stack; links closing a
+// cycle are dropped (the input falls back to its default). Instruction origins are
+// node indices. keywords (sorted) selects the variant; null uses the switch defaults.
+inline void lowerGraph(const GraphDesc& graph, IRModule& module, const std::vector<std::string>* keywords = nullptr) {
+    module.clear();
+    int output = findOutputNode(graph);
+    if (output < 0) return;
+
+    const size_t count = graph.nodes.size();
+
+    // Per-node input slot ranges, then the link feeding each slot
+    std::vector<uint32_t> inputBase(count + 1, 0);
+    std::vector<uint32_t> outputBase(count + 1, 0);
+    for (size_t i = 0; i < count; ++i) {
+        const NodeKindInfo& info = nodeKindInfo(graph.nodes[i].kind);
+        inputBase[i + 1] = inputBase[i] + info.inputCount;
+        outputBase[i + 1] = outputBase[i] + info.outputCount;
+    }
+    constexpr uint32_t NoLink = UINT32_MAX;
+    std::vector<uint32_t> feeding(inputBase[count], NoLink);
+    for (uint32_t l = 0; l < graph.links.size(); ++l) {
+        const LinkDesc& link = graph.links[l];
+        if (link.fromNode >= count || link.toNode >= count) continue;
+        if (link.toPin >= nodeKindInfo(graph.nodes[link.toNode].kind).inputCount) continue;
+        if (link.fromPin >= nodeKindInfo(graph.nodes[link.fromNode].kind).outputCount) continue;
+        feeding[inputBase[link.toNode] + link.toPin] = l;  // Last link wins, as in the editor
+    }
+
+    IRBuilder ir(module);
+    ir.setKeywords(keywords);
+    std::vector<IRValue> values(outputBase[count], IRNone);
+    std::vector<uint8_t> state(count, 0);  // 0 new, 1 on stack, 2 lowered
+    std::vector<std::pair<uint32_t, uint32_t>> stack;  // node, next input slot
+    std::vector<IRValue> inputs;
+
+    stack.emplace_back(static_cast<uint32_t>(output), 0);
+    state[output] = 1;
+    while (!stack.empty()) {
+        auto& top = stack.back();
+        const uint32_t node = top.first;
+        const uint32_t inputCount = inputBase[node + 1] - inputBase[node];
+        if (top.second < inputCount) {
+            uint32_t l = feeding[inputBase[node] + top.second++];
+            if (l != NoLink && state[graph.links[l].fromNode] == 0) {
+                state[graph.links[l].fromNode] = 1;
+                stack.emplace_back(graph.links[l].fromNode, 0);
+            }
+            continue;
+        }
+
+        inputs.assign(inputCount, IRNone);
+        for (uint32_t i = 0; i < inputCount; ++i) {
+            uint32_t l = feeding[inputBase[node] + i];
+            if (l == NoLink || state[graph.links[l].fromNode] != 2) continue;  // Unlinked or cycle
+            inputs[i] = values[outputBase[graph.links[l].fromNode] + graph.links[l].fromPin];
+        }
+        ir.setOrigin(static_cast<int32_t>(node));
+        ir.setPrecision(graph.nodes[node].precision);
+        lowerNode(graph.nodes[node], ir, inputs.data(), values.data() + outputBase[node]);
+        state[node] = 2;
+        stack.pop_back();
+    }
+}
+
+} // namespace ShaderGraph
+
+#endif // GRAPH_DESC_H
@@ -0,0 +1,34 @@
+#ifndef GRAPH_IO_H
+#define GRAPH_IO_H
+
+#include "graph_desc.h"
+#include <string>
+#include <string_view>
+
+// Text graph files (.sgraph), one record per line:
+//
+//   shadergraph 1
+//   node <id> <Kind> [pos=x,y] [value=a,b,c,d] [unit=n] [name="..."] [path="..."] [precision=full|half]
+//        [bake=8bit|half|off] [bakesize=n]
+//   link <from id> <from pin> <to id> <to pin>
+//
+// Pins are referred to by name (or index). Blank lines and lines starting with '#'
+// are ignored. The functions keep no state and can run on any thread.
+
+namespace ShaderGraph {
+
+constexpr const char* GraphTextExtension = ".sgraph";
+
+// Parse text into graph. On failure returns false and describes the first error.
+bool parseGraphText(std::string_view text, GraphDesc& graph, std::string& error);
+
+std::string writeGraphText(const GraphDesc& graph);
+
+// Load either format (binary files are recognised by their magic); save picks the
+// binary format for the .sgraphb extension and text otherwise
+bool loadGraphFile(const std::string& path, GraphDesc& graph, std::string& error);
+bool saveGraphFile(const std::string& path, const GraphDesc& graph, std::string& error);
+
+} // namespace ShaderGraph
+
+#endif // GRAPH_IO_H
@@ -0,0 +1,41 @@
+#ifndef HASH_UTIL_H
+#define HASH_UTIL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// 64-bit FNV-1a, usable incrementally
+class Fnv1a64 {
+public:
+    static constexpr uint64_t OffsetBasis = 14695981039346656037ull;
+    static constexpr uint64_t Prime = 1099511628211ull;
+    
+    void update(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            m_hash ^= bytes[i];
+            m_hash *= Prime;
+        }
+    }
+    
+    void update(const std::string& text) {
+        update(text.data(), text.size());
+        // Length terminator so ("ab","c") and ("a","bc") differ
+        uint64_t length = text.size();
+        update(&length, sizeof(length));
+    }
+    
+    uint64_t value() const { return m_hash; }
+    
+    static uint64_t hash(const std::string& text) {
+        Fnv1a64 h;
+        h.update(text);
+        return h.value();
+    }
+
+private:
+    uint64_t m_hash = OffsetBasis;
+};
+
+#endif // HASH_UTIL_H
@@ -0,0 +1,68 @@
+#ifndef MATERIAL_GENERATOR_H
+#define MATERIAL_GENERATOR_H
+
+#include "graph_desc.h"
+#include "shader_cost.h"
+#include "subgraph_bake.h"
+#include <string>
+#include <vector>
+
+// Headless material generation: graph description in, shader sources out. No ImGui,
+// no GL and no shared state, so one call per graph can run on every worker thread.
+
+namespace ShaderGraph {
+
+struct MaterialOptions {
+    bool glsl = true;
+    bool hlsl = true;
+    bool useUniformBlock = false;   // Built-ins from the std140 PerFrame block
+    bool instancedParameters = false;   // User parameters per instance from the SweepParameters block
+    PrecisionPolicy precision;      // Target and default precision of the generated code
+    bool estimateCost = false;      // Fill MaterialSources::cost
+    const std::vector<std::string>* keywords = nullptr;  // Variant to generate (sorted); null = switch defaults
+    const SubgraphBakeOptions* subgraphBake = nullptr;  // Bake expensive UV-only subgraphs; null = none
+};
+
+struct MaterialSources {
+    std::string glsl;               // GLSL 330 fragment shader (GLSL ES 3.00 for the mobile target)
+    std::string hlsl;               // SM 5.0 pixel shader
+    std::vector<UniformParameter> parameters;   // Only those the shader reads
+    ShaderCostReport cost;          // perNode is indexed by graph node
+    std::vector<SubgraphBake> bakes;    // Textures the shaders sample instead of the subgraphs, to be written to their paths
+};
+
+void generateMaterial(const GraphDesc& graph, const MaterialOptions& options, MaterialSources& sources);
+
+// Variants: one material per set of enabled static switch keywords. Each variant is
+// lowered with its switches resolved, so unused branches are never emitted.
+constexpr size_t MaxVariantKeywords = 10;   // 1024 permutations
+
+struct MaterialVariant {
+    std::vector<std::string> keywords;  // Enabled keywords, sorted
+    std::string name;                   // Keywords joined with '+', "default" when none
+    size_t source = 0;                  // Index into MaterialVariants::sources
+};
+
+struct MaterialVariants {
+    std::vector<MaterialVariant> variants;
+    std::vector<MaterialSources> sources;   // Distinct outputs only
+    std::vector<uint64_t> hashes;           // Per source, over the GLSL and HLSL text
+};
+
+// Every subset of keywords, the empty one first; empty when there are more than MaxVariantKeywords
+std::vector<std::vector<std::string>> enumerateVariants(const std::vector<std::string>& keywords);
+
+std::string variantName(const std::vector<std::string>& keywords);
+
+// Generate the given keyword sets, sharing one source between variants that produce the same text
+void generateVariants(const GraphDesc& graph, const MaterialOptions& options,
+                      const std::vector<std::vector<std::string>>& keywordSets, MaterialVariants& out);
+
+// Default vertex shader matching the generated fragment shaders. The instanced one
+// shrinks each instance into its cell of a sweepGrid (columns, rows) laid out left to
+// right, top to bottom, and hands the fragment shader its SweepInstance.
+std::string buildVertexShader(bool useUniformBlock, bool instancedParameters = false);
+
+} // namespace ShaderGraph
+
+#endif // MATERIAL_GENERATOR_H
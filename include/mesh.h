@@ -0,0 +1,82 @@
+#ifndef MESH_H
+#define MESH_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Preview meshes on the CPU: built-in shapes, index reordering for the post-transform
+// cache and overdraw, and packing into the compact interleaved GPU layout. No GL here;
+// loading and optimizing can run on any thread.
+
+namespace ShaderGraph {
+
+struct MeshData {
+    std::vector<float> positions;   // xyz per vertex
+    std::vector<float> normals;     // xyz per vertex
+    std::vector<float> uvs;         // uv per vertex; v = 0 is the top row of a texture
+    std::vector<uint32_t> indices;  // Triangle list
+
+    size_t vertexCount() const { return positions.size() / 3; }
+    size_t triangleCount() const { return indices.size() / 3; }
+    void clear();
+};
+
+enum class MeshShape {
+    Cube,
+    Sphere,
+    Plane,
+    Torus,
+    Teapot,
+    Count
+};
+
+const char* meshShapeName(MeshShape shape);
+
+// Built-in shapes, sized like the unit cube (within a radius of about 0.87)
+void makeMeshShape(MeshShape shape, MeshData& mesh);
+
+// Fill in missing normals (area weighted) and texture coordinates (zero)
+void completeMesh(MeshData& mesh);
+
+// Center a mesh on the origin and scale it to the unit cube's bounding radius
+void normalizeMesh(MeshData& mesh);
+
+// Reorder indices for the post-transform vertex cache (Forsyth's linear-speed
+// optimizer), then sort clusters of triangles outside-facing first to cut overdraw,
+// then renumber vertices by first use for fetch locality
+void optimizeMesh(MeshData& mesh);
+
+// Average post-transform cache misses per triangle for a FIFO cache of cacheSize
+// (1.0 or below is good, 3.0 means no reuse)
+float averageCacheMissRatio(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize = 16);
+
+// Interleaved vertex: position as 3 floats, normal as signed-normalized
+// INT_2_10_10_10_REV, uv as 2 half floats. 20 bytes instead of 32.
+struct PackedVertex {
+    float position[3];
+    uint32_t normal;
+    uint16_t uv[2];
+};
+static_assert(sizeof(PackedVertex) == 20, "PackedVertex layout");
+
+struct PackedMesh {
+    std::vector<PackedVertex> vertices;
+    std::vector<uint8_t> indices;   // uint16_t per index up to 65536 vertices, uint32_t otherwise
+    bool index32 = false;
+    uint32_t indexCount = 0;
+};
+
+void packMesh(const MeshData& mesh, PackedMesh& packed);
+
+// Read a packed mesh back, normals and uvs at their packed precision. False when the
+// index buffer doesn't hold indexCount indices of its width, the count isn't whole
+// triangles, or an index is past the vertices.
+bool unpackMesh(const PackedMesh& packed, MeshData& mesh, std::string& error);
+
+uint32_t packNormal(float x, float y, float z);
+
+} // namespace ShaderGraph
+
+#endif // MESH_H
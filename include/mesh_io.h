@@ -0,0 +1,33 @@
+#ifndef MESH_IO_H
+#define MESH_IO_H
+
+#include "mesh.h"
+#include <string>
+#include <string_view>
+
+// Mesh files for the preview, picked by extension:
+//
+//   .obj          positions, texture coordinates and normals; polygons are fanned into
+//                 triangles, materials and groups are ignored
+//   .gltf / .glb  glTF 2.0 triangle primitives of the default scene, with node transforms
+//                 applied; buffers may be embedded (data: URIs, the GLB binary chunk) or
+//                 files next to the model. Skins, morph targets and compression
+//                 extensions are not supported.
+//
+// Loaded meshes are completed, normalized to the preview's size and optimized (see
+// mesh.h). The functions keep no state and can run on any thread.
+
+namespace ShaderGraph {
+
+// On failure returns false and describes the first error
+bool loadMesh(const std::string& path, MeshData& mesh, std::string& error);
+
+bool parseOBJ(std::string_view text, MeshData& mesh, std::string& error);
+
+// baseDirectory resolves relative buffer URIs; data is the .gltf text or the whole .glb
+bool parseGLTF(const uint8_t* data, size_t size, const std::string& baseDirectory, MeshData& mesh,
+               std::string& error);
+
+} // namespace ShaderGraph
+
+#endif // MESH_IO_H
@@ -0,0 +1,118 @@
+#ifndef NODE_PREVIEW_H
+#define NODE_PREVIEW_H
+
+#include "uniform_reflection.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+class ProgramCache;
+class TextureStreamer;
+
+namespace ShaderGraph {
+    class ShaderGraphEditor;
+    class ShaderNodeBase;
+}
+
+// Thumbnails of the intermediate result at each node, drawn on a flat quad.
+//
+// Every visible node gets a tile in one shared atlas texture, and all tiles that need a
+// redraw are rendered in a single framebuffer pass with a scissored viewport per tile.
+// Preview programs are keyed by the hash of their fragment source, so nodes that lower
+// to the same shader share one program. Tiles are only redrawn when their shader or the
+// parameter values change; tiles that read `time` are redrawn at the animation interval.
+// Nodes culled by the canvas are skipped, and their tiles are reused by nodes that
+// scroll into view.
+class NodePreviewRenderer {
+public:
+    struct Stats {
+        size_t visible = 0;      // Thumbnails on screen
+        size_t drawn = 0;        // Tiles rendered this frame
+        size_t compiled = 0;     // Programs built this frame
+        size_t pending = 0;      // Tiles waiting for the compile budget
+        size_t animated = 0;     // Visible tiles that read time
+        size_t programs = 0;     // Live preview programs
+    };
+
+    explicit NodePreviewRenderer(int tileSize = 96, int atlasSize = 1024);
+    ~NodePreviewRenderer();
+    NodePreviewRenderer(const NodePreviewRenderer&) = delete;
+    NodePreviewRenderer& operator=(const NodePreviewRenderer&) = delete;
+
+    // Render thread, context current
+    void init();
+    void shutdown();
+
+    // Optional binary cache (not owned) for preview programs
+    void setProgramCache(ProgramCache* cache) { m_cache = cache; }
+
+    // Optional texture source (not owned) for sampler parameters; tiles redraw as textures arrive
+    void setTextureStreamer(TextureStreamer* textures) { m_textures = textures; }
+
+    // Programs built per frame; tiles over the budget keep their old image until the next frame
+    void setCompileBudget(int budget) { m_compileBudget = budget; }
+
+    // Minimum seconds between redraws of thumbnails that depend on time
+    void setAnimationInterval(float seconds) { m_animationInterval = seconds; }
+    float getAnimationInterval() const { return m_animationInterval; }
+
+    // Bring the atlas up to date for the thumbnails that were visible in the last frame
+    // and hand each node its tile. Call outside the ImGui frame, before the editor is drawn.
+    void render(ShaderGraph::ShaderGraphEditor& editor, float time);
+
+    int getTileSize() const { return m_tileSize; }
+    unsigned int getAtlasTexture() const { return m_atlasTexture; }
+    const Stats& getStats() const { return m_stats; }
+
+private:
+    struct Program {
+        unsigned int program = 0;   // 0 when the build failed
+        UniformReflection uniforms;
+        uint32_t users = 0;
+    };
+
+    struct Entry {
+        uint64_t graphRevision = 0;
+        bool hasGraphRevision = false;
+        uint64_t sourceHash = 0;
+        Program* program = nullptr;
+        bool timeDependent = false;
+        int tile = -1;
+        uint64_t valueRevision = 0;
+        bool drawn = false;
+        float drawTime = 0.0f;
+        uint64_t lastSeen = 0;      // Frame the node was last visible
+    };
+
+    Program* acquire(uint64_t hash, const std::string& fragmentSource);
+    void release(Program* program);
+    int allocateTile(uintptr_t owner);
+    void tileUVs(int tile, float uv0[2], float uv1[2]) const;
+    void drawTiles(ShaderGraph::ShaderGraphEditor& editor, float time);
+
+    int m_tileSize;
+    int m_atlasSize;
+    int m_tilesPerRow;
+    int m_compileBudget = 2;
+    float m_animationInterval = 1.0f / 30.0f;
+    ProgramCache* m_cache = nullptr;
+    TextureStreamer* m_textures = nullptr;
+
+    unsigned int m_framebuffer = 0;
+    unsigned int m_atlasTexture = 0;
+    unsigned int m_quadVAO = 0;
+    unsigned int m_quadVBO = 0;
+    bool m_initialized = false;
+
+    std::unordered_map<uint64_t, Program> m_programs;   // By fragment source hash
+    std::unordered_map<uintptr_t, Entry> m_entries;     // By node UID
+    std::vector<uintptr_t> m_tileOwners;                // Node UID per tile, 0 when free
+    std::vector<ShaderGraph::ShaderNodeBase*> m_visible;
+    std::vector<Entry*> m_draws;
+    uint64_t m_frame = 0;
+    int m_compilesLeft = 0;
+    Stats m_stats;
+};
+
+#endif // NODE_PREVIEW_H
@@ -0,0 +1,212 @@
+#ifndef PARAMETER_REGISTRY_H
+#define PARAMETER_REGISTRY_H
+
+#include "shader_types.h"
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+namespace ShaderGraph {
+
+class ShaderNodeBase;
+
+using ParameterHandle = uint32_t;
+constexpr ParameterHandle InvalidParameterHandle = UINT32_MAX;
+
+// Live uniform parameters of a graph. Parameter nodes are registered when they are
+// added to the editor and removed when they are destroyed; after that, edits are pushed
+// in by handle, so nothing scans the graph per frame.
+//
+// Parameters are stored densely (parameters() is what the UI and the uniform
+// reflection iterate). Value edits mark the parameter dirty; adding, removing or
+// renaming moves the layout revision and marks everything dirty.
+class ParameterRegistry {
+public:
+    ParameterHandle add(ShaderNodeBase* owner, const UniformParameter& param) {
+        ParameterHandle handle;
+        if (!m_freeHandles.empty()) {
+            handle = m_freeHandles.back();
+            m_freeHandles.pop_back();
+        } else {
+            handle = static_cast<ParameterHandle>(m_handleToDense.size());
+            m_handleToDense.push_back(0);
+        }
+        m_handleToDense[handle] = static_cast<uint32_t>(m_params.size());
+        m_params.push_back(param);
+        m_owners.push_back(owner);
+        m_handles.push_back(handle);
+        m_byName[param.name] = handle;
+        layoutChanged();
+        return handle;
+    }
+
+    void remove(ParameterHandle handle) {
+        if (!valid(handle)) return;
+        uint32_t dense = m_handleToDense[handle];
+        std::string name = std::move(m_params[dense].name);
+
+        // Swap-remove keeps the storage dense
+        uint32_t last = static_cast<uint32_t>(m_params.size() - 1);
+        if (dense != last) {
+            m_params[dense] = std::move(m_params[last]);
+            m_owners[dense] = m_owners[last];
+            m_handles[dense] = m_handles[last];
+            m_handleToDense[m_handles[dense]] = dense;
+        }
+        m_params.pop_back();
+        m_owners.pop_back();
+        m_handles.pop_back();
+        m_handleToDense[handle] = Unused;
+        m_freeHandles.push_back(handle);
+        unbindName(name, handle);
+        layoutChanged();
+    }
+
+    void clear() {
+        m_params.clear();
+        m_owners.clear();
+        m_handles.clear();
+        m_handleToDense.clear();
+        m_freeHandles.clear();
+        m_byName.clear();
+        layoutChanged();
+    }
+
+    ParameterHandle find(const std::string& name) const {
+        auto it = m_byName.find(name);
+        return it != m_byName.end() ? it->second : InvalidParameterHandle;
+    }
+
+    bool valid(ParameterHandle handle) const {
+        return handle < m_handleToDense.size() && m_handleToDense[handle] != Unused;
+    }
+
+    const UniformParameter& get(ParameterHandle handle) const { return m_params[m_handleToDense[handle]]; }
+    ShaderNodeBase* owner(ParameterHandle handle) const { return m_owners[m_handleToDense[handle]]; }
+
+    // Value edits - only mark dirty when the value actually moved
+    void setFloat(ParameterHandle handle, float value) {
+        if (!valid(handle)) return;
+        uint32_t dense = m_handleToDense[handle];
+        if (m_params[dense].floatValue == value) return;
+        m_params[dense].floatValue = value;
+        markDirty(dense);
+    }
+
+    void setVec3(ParameterHandle handle, const float value[3]) {
+        if (!valid(handle)) return;
+        uint32_t dense = m_handleToDense[handle];
+        float* v = m_params[dense].vec3Value;
+        if (v[0] == value[0] && v[1] == value[1] && v[2] == value[2]) return;
+        v[0] = value[0]; v[1] = value[1]; v[2] = value[2];
+        markDirty(dense);
+    }
+
+    void setTextureUnit(ParameterHandle handle, int unit) {
+        if (!valid(handle)) return;
+        uint32_t dense = m_handleToDense[handle];
+        if (m_params[dense].textureUnit == unit) return;
+        m_params[dense].textureUnit = unit;
+        markDirty(dense);
+    }
+
+    void setTexturePath(ParameterHandle handle, const std::string& path) {
+        if (!valid(handle)) return;
+        uint32_t dense = m_handleToDense[handle];
+        if (m_params[dense].texturePath == path) return;
+        m_params[dense].texturePath = path;
+        markDirty(dense);
+    }
+
+    // Full refresh from the owning node (rename, range or type edits)
+    void update(ParameterHandle handle, const UniformParameter& param) {
+        if (!valid(handle)) return;
+        uint32_t dense = m_handleToDense[handle];
+        UniformParameter& current = m_params[dense];
+        if (current.name != param.name || current.type != param.type) {
+            std::string oldName = current.name;
+            current = param;
+            unbindName(oldName, handle);
+            m_byName[param.name] = handle;
+            layoutChanged();
+            return;
+        }
+        current.displayName = param.displayName;
+        current.minValue = param.minValue;
+        current.maxValue = param.maxValue;
+        setFloat(handle, param.floatValue);
+        setVec3(handle, param.vec3Value);
+        setTextureUnit(handle, param.textureUnit);
+        setTexturePath(handle, param.texturePath);
+    }
+
+    // Dense storage, in a stable order between layout changes
+    const std::vector<UniformParameter>& parameters() const { return m_params; }
+    const std::vector<ParameterHandle>& handles() const { return m_handles; }
+    size_t size() const { return m_params.size(); }
+
+    // Moves whenever parameters are added, removed or renamed (dense indices change)
+    uint64_t getLayoutRevision() const { return m_layoutRevision; }
+
+    // Moves on every value edit and layout change; for consumers that don't own the dirty list
+    uint64_t getValueRevision() const { return m_valueRevision; }
+
+    // Dense indices of parameters whose value changed since the last clearDirty()
+    const std::vector<uint32_t>& getDirty() const { return m_dirty; }
+    void clearDirty() {
+        for (uint32_t i : m_dirty) {
+            if (i < m_isDirty.size()) m_isDirty[i] = 0;
+        }
+        m_dirty.clear();
+    }
+
+private:
+    static constexpr uint32_t Unused = UINT32_MAX;
+
+    // Drop name's lookup if it points at handle. Names can be shared for a while (e.g.
+    // mid-rename), so the lookup falls back to another parameter that still has it.
+    void unbindName(const std::string& name, ParameterHandle handle) {
+        auto it = m_byName.find(name);
+        if (it == m_byName.end() || it->second != handle) return;
+        m_byName.erase(it);
+        for (size_t i = 0; i < m_params.size(); ++i) {
+            if (m_params[i].name == name) {
+                m_byName.emplace(name, m_handles[i]);
+                return;
+            }
+        }
+    }
+
+    void markDirty(uint32_t dense) {
+        m_valueRevision++;
+        if (m_isDirty.size() < m_params.size()) m_isDirty.resize(m_params.size(), 0);
+        if (m_isDirty[dense]) return;
+        m_isDirty[dense] = 1;
+        m_dirty.push_back(dense);
+    }
+
+    void layoutChanged() {
+        m_layoutRevision++;
+        m_valueRevision++;
+        m_isDirty.assign(m_params.size(), 1);
+        m_dirty.resize(m_params.size());
+        for (uint32_t i = 0; i < m_dirty.size(); ++i) m_dirty[i] = i;
+    }
+
+    std::vector<UniformParameter> m_params;
+    std::vector<ShaderNodeBase*> m_owners;
+    std::vector<ParameterHandle> m_handles;   // Dense index -> handle
+    std::vector<uint32_t> m_handleToDense;    // Handle -> dense index, Unused when free
+    std::vector<ParameterHandle> m_freeHandles;
+    std::unordered_map<std::string, ParameterHandle> m_byName;
+
+    std::vector<uint8_t> m_isDirty;
+    std::vector<uint32_t> m_dirty;
+    uint64_t m_layoutRevision = 0;
+    uint64_t m_valueRevision = 0;
+};
+
+} // namespace ShaderGraph
+
+#endif // PARAMETER_REGISTRY_H
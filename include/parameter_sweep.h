@@ -0,0 +1,62 @@
+#ifndef PARAMETER_SWEEP_H
+#define PARAMETER_SWEEP_H
+
+#include "shader_types.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Grid preview of one material at many parameter values, drawn as a single instanced
+// draw call. The program reads its user parameters per instance from the std140
+// SweepParameters block (see SweepBlockGLSL); this fills that block: every instance
+// starts from the current parameter values, and the column and row axes each
+// interpolate one parameter across the grid (e.g. roughness across columns, tint
+// across rows).
+class ParameterSweep {
+public:
+    struct Axis {
+        std::string parameter;      // Uniform name; empty leaves the values alone
+        int steps = 5;
+        float from[3] = {0.0f, 0.0f, 0.0f};   // Float parameters use the first component
+        float to[3] = {1.0f, 1.0f, 1.0f};
+    };
+
+    ParameterSweep() = default;
+    ~ParameterSweep();
+    ParameterSweep(const ParameterSweep&) = delete;
+    ParameterSweep& operator=(const ParameterSweep&) = delete;
+
+    // Render thread, context current
+    void init();
+    void shutdown();
+
+    void setColumns(const Axis& axis);
+    void setRows(const Axis& axis);
+    const Axis& getColumns() const { return m_columns; }
+    const Axis& getRows() const { return m_rows; }
+
+    // Axis over a parameter's range: a Float from its min to its max, a Vec3 from black to its value
+    static Axis axisFor(const ShaderGraph::UniformParameter& param, int steps);
+
+    // Refill and upload the block when the values, the layout or an axis changed, and
+    // bind it to SweepBlockBinding
+    void update(const std::vector<ShaderGraph::UniformParameter>& params, uint64_t valueRevision);
+
+    // Grid of the last update(), clamped so every instance's slots fit the block
+    int getGridColumns() const { return m_gridColumns; }
+    int getGridRows() const { return m_gridRows; }
+    int getInstanceCount() const { return m_gridColumns * m_gridRows; }
+
+private:
+    Axis m_columns;
+    Axis m_rows;
+    int m_gridColumns = 1;
+    int m_gridRows = 1;
+
+    unsigned int m_buffer = 0;
+    std::vector<float> m_data;
+    uint64_t m_valueRevision = 0;
+    bool m_dirty = true;
+};
+
+#endif // PARAMETER_SWEEP_H
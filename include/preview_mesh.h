@@ -0,0 +1,42 @@
+#ifndef PREVIEW_MESH_H
+#define PREVIEW_MESH_H
+
+#include "mesh.h"
+#include <cstddef>
+
+// The preview's mesh on the GPU: one interleaved vertex buffer in the PackedVertex
+// layout (position at location 0, packed normal at 1, half-float uv at 2) and an index
+// buffer of 16-bit indices, or 32-bit ones for meshes past 65536 vertices.
+class PreviewMesh {
+public:
+    struct Stats {
+        size_t vertices = 0;
+        size_t triangles = 0;
+        size_t bytes = 0;           // Vertex and index buffers
+        float acmr = 0.0f;          // Cache misses per triangle, FIFO of 16
+    };
+
+    PreviewMesh() = default;
+    ~PreviewMesh();
+    PreviewMesh(const PreviewMesh&) = delete;
+    PreviewMesh& operator=(const PreviewMesh&) = delete;
+
+    // Render thread, context current. The mesh should already be optimized.
+    void upload(const ShaderGraph::MeshData& mesh);
+    void shutdown();
+
+    // Draw with the current program; more than one instance draws instanced
+    void draw(int instances = 1) const;
+
+    const Stats& getStats() const { return m_stats; }
+
+private:
+    unsigned int m_vao = 0;
+    unsigned int m_vertexBuffer = 0;
+    unsigned int m_indexBuffer = 0;
+    unsigned int m_indexType = 0;
+    int m_indexCount = 0;
+    Stats m_stats;
+};
+
+#endif // PREVIEW_MESH_H
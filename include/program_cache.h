@@ -0,0 +1,63 @@
+#ifndef PROGRAM_CACHE_H
+#define PROGRAM_CACHE_H
+
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// Cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+// Keys hash the vertex source, fragment source and the driver vendor/renderer/version.
+// Recently used binaries live in an in-memory LRU that is backed by one file per key
+// in the cache directory, so hits survive restarts.
+class ProgramCache {
+public:
+    explicit ProgramCache(std::string directory = "shader_cache", size_t maxMemoryEntries = 128);
+    
+    // Render thread, context current. Disables the cache when the driver exposes no binary formats.
+    void init();
+    bool isEnabled() const { return m_enabled; }
+    
+    uint64_t makeKey(const std::string& vertexSource, const std::string& fragmentSource) const;
+    
+    // Create a program from a cached binary. Returns 0 on a miss or when the driver rejects the binary.
+    unsigned int load(uint64_t key);
+    
+    // Store the binary of a freshly linked program (linked with the retrievable hint)
+    void store(uint64_t key, unsigned int program);
+    
+    size_t getHits() const { return m_hits; }
+    size_t getMisses() const { return m_misses; }
+    size_t getRejected() const { return m_rejected; }
+    size_t getMemoryEntries() const { return m_lru.size(); }
+
+private:
+    struct Entry {
+        uint64_t key = 0;
+        uint32_t format = 0;
+        std::vector<unsigned char> data;
+    };
+    
+    const Entry* find(uint64_t key);
+    void insert(Entry entry);
+    void evict(uint64_t key);
+    std::string pathFor(uint64_t key) const;
+    bool readFile(uint64_t key, Entry& entry) const;
+    void writeFile(const Entry& entry) const;
+    
+    std::string m_directory;
+    size_t m_maxMemoryEntries;
+    bool m_enabled = false;
+    std::string m_driverId;   // vendor/renderer/version, part of every key
+    
+    std::list<Entry> m_lru;   // Front = most recently used
+    std::unordered_map<uint64_t, std::list<Entry>::iterator> m_index;
+    
+    size_t m_hits = 0;
+    size_t m_misses = 0;
+    size_t m_rejected = 0;
+};
+
+#endif // PROGRAM_CACHE_H
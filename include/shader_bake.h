@@ -0,0 +1,70 @@
+#ifndef SHADER_BAKE_H
+#define SHADER_BAKE_H
+
+#include "graph_desc.h"
+#include "shader_ir.h"
+#include "texture_image.h"
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// CPU evaluation of a material into an RGBA8 or RGBA16F texture, for targets that can't afford the
+// procedural graph at runtime and for build machines without a GPU.
+//
+// The IR is compiled into a flat program over slots of BakeTileSize floats (one
+// component of one value for a span of pixels), run by SIMD kernels (AVX, SSE2 or NEON,
+// whichever the build targets, with a scalar fallback). Rows are spread over a
+// work-stealing pool. Level 0 is evaluated; the rest of the mip chain is box filtered in float.
+//
+// Pixels are shaded as the preview plane would see them facing the camera: TexCoord is
+// the pixel center (v = 0 on the top row), FragPos the matching point on the plane and
+// Normal +Z. Textures are sampled bilinear with repeat from level 0; only uncompressed
+// images can be read on the CPU (RGBA16F ones clamped to 8 bits), and samplers without
+// a file read the grey placeholder.
+
+namespace ShaderGraph {
+
+struct BakeOptions {
+    uint32_t width = 512;
+    uint32_t height = 512;
+    bool mipmaps = true;
+    unsigned threads = 0;           // 0 = hardware concurrency
+    TextureFormat format = TextureFormat::RGBA8;    // Or RGBA16F, unclamped
+    // RGBA8 only: store each channel remapped from the range level 0 actually covers
+    // (see BakeRange) rather than clamped to [0, 1]
+    bool fitRange = false;
+
+    // Built-in uniforms, the preview's values by default
+    float time = 0.0f;
+    float lightPos[3] = {2.0f, 2.0f, 2.0f};
+    float viewPos[3] = {0.0f, 0.0f, 3.0f};
+    float lightColor[3] = {1.0f, 1.0f, 1.0f};
+    float objectColor[3] = {0.3f, 0.6f, 0.9f};
+};
+
+// Per channel, stored = (value - bias) / scale; a shader reads texel * scale + bias.
+// Identity unless the bake was asked to fit the range.
+struct BakeRange {
+    float scale[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+    float bias[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+};
+
+// Pixels per slot, and pixels per span a kernel processes in one call
+constexpr uint32_t BakeTileSize = 16;
+
+// Bake a lowered module; parameters supply the values of user uniforms and the files of
+// samplers. range (optional) receives how the channels were stored. On failure returns
+// false and describes the first error.
+bool bakeModule(const IRModule& module, const std::vector<UniformParameter>& parameters, const BakeOptions& options,
+                TextureImage& image, std::string& error, BakeRange* range = nullptr);
+
+// Lower a graph (keywords as in lowerGraph) and bake it
+bool bakeGraph(const GraphDesc& graph, const BakeOptions& options, TextureImage& image, std::string& error,
+               const std::vector<std::string>* keywords = nullptr);
+
+// Name of the SIMD kernels this build uses ("AVX", "SSE2", "NEON" or "scalar")
+const char* bakeKernelName();
+
+} // namespace ShaderGraph
+
+#endif // SHADER_BAKE_H
@@ -0,0 +1,123 @@
+#ifndef SHADER_COMPILER_H
+#define SHADER_COMPILER_H
+
+#include <string>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+struct GLFWwindow;
+class ProgramCache;
+
+// Builds GL programs without stalling the frame.
+// The backend is picked in init():
+//  - ParallelKHR:   GL_KHR/ARB_parallel_shader_compile. Compile and link are kicked on the
+//                   render thread and polled with GL_COMPLETION_STATUS_KHR.
+//  - SharedContext: a worker thread owning a hidden context in the main context's share group.
+//  - Synchronous:   fallback when neither is available.
+// Requests submitted while a build is in flight are coalesced: only the newest one waits.
+// With a ProgramCache attached, cache hits are ready on the next poll() and successful
+// builds are stored back into the cache.
+class ShaderCompiler {
+public:
+    enum class Backend {
+        Synchronous,
+        ParallelKHR,
+        SharedContext
+    };
+    
+    struct Result {
+        uint64_t ticket = 0;
+        unsigned int program = 0;   // Linked program, 0 when the build failed
+        bool success = false;
+        bool fromCache = false;     // Loaded from a program binary instead of compiled
+        std::string errorLog;
+        uint64_t cacheKey = 0;
+    };
+    
+    ShaderCompiler() = default;
+    ~ShaderCompiler();
+    ShaderCompiler(const ShaderCompiler&) = delete;
+    ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+    
+    // Render thread, main context current
+    void init(GLFWwindow* mainWindow);
+    void shutdown();
+    
+    // Optional binary cache (not owned); must outlive the compiler
+    void setProgramCache(ProgramCache* cache) { m_cache = cache; }
+    
+    // Queue a program build; replaces any request that hasn't started yet.
+    // Returns the ticket identifying the request.
+    uint64_t submit(const std::string& vertexSource, const std::string& fragmentSource);
+    
+    // Fetch a finished build (render thread). The caller owns result.program.
+    bool poll(Result& result);
+    
+    // True while a build is queued or in flight
+    bool isBusy() const;
+    
+    Backend getBackend() const { return m_backend; }
+    const char* getBackendName() const;
+    
+    // Blocking compile + link on the calling thread's current context
+    static Result buildProgram(const std::string& vertexSource, const std::string& fragmentSource,
+                               bool retrievableBinary = false);
+
+private:
+    struct Job {
+        uint64_t ticket = 0;
+        std::string vertexSource;
+        std::string fragmentSource;
+        uint64_t cacheKey = 0;
+        bool retrievableBinary = false;
+    };
+    
+    // ParallelKHR build in flight
+    struct InFlight {
+        uint64_t ticket = 0;
+        unsigned int vertexShader = 0;
+        unsigned int fragmentShader = 0;
+        unsigned int program = 0;
+        uint64_t cacheKey = 0;
+    };
+    
+    bool pollBackend(Result& result);
+    void startParallel(const Job& job);
+    bool finishParallel(Result& result);
+    void workerLoop();
+    void releaseResult(Result& result);
+    
+    Backend m_backend = Backend::Synchronous;
+    uint64_t m_nextTicket = 1;
+    uint64_t m_lastDeliveredTicket = 0;
+    ProgramCache* m_cache = nullptr;
+    
+    // Program loaded from the binary cache, delivered on the next poll()
+    bool m_hasCacheHit = false;
+    Result m_cacheHit;
+    
+    // Newest request that hasn't started yet
+    bool m_hasPending = false;
+    Job m_pending;
+    
+    // ParallelKHR state
+    bool m_hasInFlight = false;
+    InFlight m_inFlight;
+    
+    // Finished build waiting for poll() (Synchronous / SharedContext)
+    bool m_hasFinished = false;
+    Result m_finished;
+    void* m_finishedFence = nullptr;  // GLsync guarding a worker-built program
+    
+    // SharedContext worker
+    GLFWwindow* m_workerWindow = nullptr;
+    std::thread m_worker;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_workerBusy = false;
+    bool m_quit = false;
+};
+
+#endif // SHADER_COMPILER_H
@@ -0,0 +1,286 @@
+#ifndef SHADER_COST_H
+#define SHADER_COST_H
+
+#include "shader_ir.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cctype>
+
+// Static cost estimate of a lowered shader. Counts are per fragment and per scalar
+// lane, over the live part of the IR only (what the emitters print):
+//   alu              adds, muls, min/max, mix, clamp, dot, ...
+//   transcendentals  sin, cos, pow (exp2 + log2), rcp for divides, rsqrt for normalize
+//   textureFetches   texture samples
+//   registers        peak scalar temporaries live at once, in emission order
+// Instruction origins attribute every cost to the node that created it. The numbers
+// are a model, not a measurement; they exist to compare materials against a budget
+// before they reach a device.
+
+namespace ShaderGraph {
+
+struct ShaderCost {
+    float alu = 0.0f;
+    int transcendentals = 0;
+    int textureFetches = 0;
+    int instructions = 0;         // Statements the emitter prints
+
+    void add(const ShaderCost& other) {
+        alu += other.alu;
+        transcendentals += other.transcendentals;
+        textureFetches += other.textureFetches;
+        instructions += other.instructions;
+    }
+};
+
+// Rough relative weights for ranking nodes (the heat map); budgets use the raw counts
+inline float costScore(const ShaderCost& cost) {
+    return cost.alu + 4.0f * static_cast<float>(cost.transcendentals) + 8.0f * static_cast<float>(cost.textureFetches);
+}
+
+struct ShaderCostReport {
+    ShaderCost total;
+    ShaderCost color;             // What the color output depends on
+    ShaderCost alpha;             // What the alpha output depends on
+    int registers = 0;
+    std::vector<ShaderCost> perNode;  // Indexed by IR origin
+    float maxNodeScore = 0.0f;
+
+    void clear() { *this = ShaderCostReport(); }
+};
+
+struct CostBudget {
+    std::string name;
+    float alu = 0.0f;
+    int transcendentals = 0;
+    int textureFetches = 0;
+    int registers = 0;
+};
+
+// Fragment budgets of the built-in targets
+inline const std::vector<CostBudget>& defaultCostBudgets() {
+    static const std::vector<CostBudget> budgets = {
+        {"Desktop", 2000.0f, 256, 32, 512},
+        {"Console", 1000.0f, 128, 16, 256},
+        {"Mobile (high)", 200.0f, 24, 8, 128},
+        {"Mobile (low)", 80.0f, 8, 4, 64},
+    };
+    return budgets;
+}
+
+// Estimated cost of one instruction, per lane of its type
+inline ShaderCost instructionCost(const IRModule& module, const IRInstr& instr) {
+    ShaderCost cost;
+    const int lanes = std::max(componentCount(instr.type), 1);
+    switch (instr.op) {
+        case IROp::Const:
+        case IROp::Input:
+        case IROp::Uniform:
+        case IROp::Swizzle:
+            return cost;                      // Inlined into their users
+        case IROp::MakeVec3:
+            break;                            // Register moves
+        case IROp::Add:
+        case IROp::Sub:
+        case IROp::Mul:
+        case IROp::Min:
+        case IROp::Max:
+        case IROp::Abs:
+            cost.alu = static_cast<float>(lanes);
+            break;
+        case IROp::Div:
+            cost.alu = static_cast<float>(lanes);
+            cost.transcendentals = lanes;     // rcp + mul
+            break;
+        case IROp::Sin:
+        case IROp::Cos:
+            cost.transcendentals = lanes;
+            break;
+        case IROp::Pow:
+            cost.alu = static_cast<float>(lanes);
+            cost.transcendentals = 2 * lanes; // exp2(log2(x) * y)
+            break;
+        case IROp::Mix:
+        case IROp::Clamp:
+            cost.alu = static_cast<float>(2 * lanes);
+            break;
+        case IROp::Dot: {
+            int n = componentCount(module.at(instr.operands[0]).type);
+            n = std::max(n, componentCount(module.at(instr.operands[1]).type));
+            cost.alu = static_cast<float>(2 * n - 1);
+            break;
+        }
+        case IROp::Normalize:
+            cost.alu = static_cast<float>(3 * lanes - 1);  // dot, then scale
+            cost.transcendentals = 1;                       // rsqrt
+            break;
+        case IROp::Texture:
+            cost.textureFetches = 1;
+            break;
+    }
+    cost.instructions = 1;
+    return cost;
+}
+
+inline void estimateCost(const IRModule& module, ShaderCostReport& report) {
+    report.clear();
+    const size_t count = module.instrs.size();
+    if (module.color == IRNone || module.alpha == IRNone || count == 0) return;
+
+    // Liveness per output (operands always precede their users)
+    auto markLive = [&](IRValue root, std::vector<uint8_t>& live) {
+        live.assign(count, 0);
+        live[root] = 1;
+        for (size_t i = count; i-- > 0;) {
+            if (!live[i]) continue;
+            for (IRValue operand : module.instrs[i].operands) {
+                if (operand != IRNone) live[operand] = 1;
+            }
+        }
+    };
+    std::vector<uint8_t> colorLive, alphaLive;
+    markLive(module.color, colorLive);
+    markLive(module.alpha, alphaLive);
+
+    int32_t maxOrigin = -1;
+    for (int32_t origin : module.origins) maxOrigin = std::max(maxOrigin, origin);
+    report.perNode.assign(static_cast<size_t>(maxOrigin + 1), ShaderCost());
+
+    // Swizzles are inlined, so a use of one is a use of the value underneath
+    auto base = [&](IRValue value) {
+        while (module.at(value).op == IROp::Swizzle) value = module.at(value).operands[0];
+        return value;
+    };
+    auto occupiesRegister = [&](const IRInstr& instr) { return instructionCost(module, instr).instructions > 0; };
+
+    std::vector<size_t> lastUse(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (!colorLive[i] && !alphaLive[i]) continue;
+        const IRInstr& instr = module.instrs[i];
+        if (!occupiesRegister(instr)) continue;
+        for (IRValue operand : instr.operands) {
+            if (operand != IRNone) lastUse[base(operand)] = i;
+        }
+    }
+    lastUse[base(module.color)] = count;   // Outputs live to the end
+    lastUse[base(module.alpha)] = count;
+
+    int liveLanes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (!colorLive[i] && !alphaLive[i]) continue;
+        const IRInstr& instr = module.instrs[i];
+        const ShaderCost cost = instructionCost(module, instr);
+        report.total.add(cost);
+        if (colorLive[i]) report.color.add(cost);
+        if (alphaLive[i]) report.alpha.add(cost);
+        int32_t origin = i < module.origins.size() ? module.origins[i] : -1;
+        if (origin >= 0) report.perNode[origin].add(cost);
+
+        if (!cost.instructions) continue;
+        liveLanes += componentCount(instr.type);
+        report.registers = std::max(report.registers, liveLanes);
+        // Operands read for the last time free their registers (each value once)
+        for (int k = 0; k < 3; ++k) {
+            IRValue operand = instr.operands[k];
+            if (operand == IRNone) continue;
+            IRValue b = base(operand);
+            bool seen = false;
+            for (int j = 0; j < k; ++j) seen |= instr.operands[j] != IRNone && base(instr.operands[j]) == b;
+            if (!seen && lastUse[b] == i && occupiesRegister(module.at(b))) liveLanes -= componentCount(module.at(b).type);
+        }
+    }
+
+    for (const auto& node : report.perNode) report.maxNodeScore = std::max(report.maxNodeScore, costScore(node));
+}
+
+// Lines describing every limit the report exceeds (empty when within budget)
+inline std::vector<std::string> checkBudget(const ShaderCostReport& report, const CostBudget& budget) {
+    std::vector<std::string> warnings;
+    char buffer[128];
+    auto over = [&](const char* what, double value, double limit) {
+        if (limit <= 0.0 || value <= limit) return;
+        std::snprintf(buffer, sizeof(buffer), "%s: %.0f exceeds the %s budget of %.0f", what, value,
+                      budget.name.c_str(), limit);
+        warnings.push_back(buffer);
+    };
+    over("ALU ops", report.total.alu, budget.alu);
+    over("Transcendentals", report.total.transcendentals, budget.transcendentals);
+    over("Texture fetches", report.total.textureFetches, budget.textureFetches);
+    over("Registers", report.registers, budget.registers);
+    return warnings;
+}
+
+// Budget files, one target per line ('#' starts a comment):
+//   budget "Mobile (low)" alu=80 trans=8 tex=4 regs=64
+// Fields left out (or 0) are not checked.
+inline bool parseCostBudgets(std::string_view text, std::vector<CostBudget>& budgets, std::string& error) {
+    budgets.clear();
+    size_t lineNumber = 0;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) end = text.size();
+        std::string_view line = text.substr(start, end - start);
+        start = end + 1;
+        lineNumber++;
+
+        size_t pos = line.find_first_not_of(" \t\r");
+        if (pos == std::string_view::npos || line[pos] == '#') continue;
+        auto fail = [&](const char* message) {
+            error = "line " + std::to_string(lineNumber) + ": " + message;
+            return false;
+        };
+        if (line.compare(pos, 6, "budget") != 0) return fail("expected 'budget \"<name>\" ...'");
+        pos = line.find('"', pos + 6);
+        size_t close = pos == std::string_view::npos ? pos : line.find('"', pos + 1);
+        if (close == std::string_view::npos) return fail("expected a quoted budget name");
+
+        CostBudget budget;
+        budget.name = std::string(line.substr(pos + 1, close - pos - 1));
+        pos = close + 1;
+        while (pos < line.size()) {
+            pos = line.find_first_not_of(" \t\r", pos);
+            if (pos == std::string_view::npos) break;
+            size_t fieldEnd = line.find_first_of(" \t\r", pos);
+            if (fieldEnd == std::string_view::npos) fieldEnd = line.size();
+            std::string field(line.substr(pos, fieldEnd - pos));
+            pos = fieldEnd;
+
+            size_t eq = field.find('=');
+            if (eq == std::string::npos) return fail("expected key=value");
+            std::string key = field.substr(0, eq);
+            char* parsedEnd = nullptr;
+            double value = std::strtod(field.c_str() + eq + 1, &parsedEnd);
+            if (parsedEnd == field.c_str() + eq + 1 || *parsedEnd) return fail("bad number");
+            if (key == "alu") budget.alu = static_cast<float>(value);
+            else if (key == "trans") budget.transcendentals = static_cast<int>(value);
+            else if (key == "tex") budget.textureFetches = static_cast<int>(value);
+            else if (key == "regs") budget.registers = static_cast<int>(value);
+            else return fail("unknown budget field");
+        }
+        budgets.push_back(std::move(budget));
+    }
+    return true;
+}
+
+// Find a budget by name, ignoring case; null when there is none
+inline const CostBudget* findCostBudget(const std::vector<CostBudget>& budgets, std::string_view name) {
+    for (const auto& budget : budgets) {
+        if (budget.name.size() != name.size()) continue;
+        bool match = true;
+        for (size_t i = 0; i < name.size() && match; ++i) {
+            match = std::tolower(static_cast<unsigned char>(budget.name[i])) ==
+                    std::tolower(static_cast<unsigned char>(name[i]));
+        }
+        if (match) return &budget;
+    }
+    return nullptr;
+}
+
+} // namespace ShaderGraph
+
+#endif // SHADER_COST_H
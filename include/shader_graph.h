@@ -3,115 +3,58 @@
 
 #include "ImNodeFlow.h"
 #include "shader_nodes.h"
+#include "shader_ir.h"
+#include "shader_lang.h"
+#include "uniform_reflection.h"
+#include "dependency_graph.h"
+#include "graph_desc.h"
+#include "graph_io.h"
+#include "shader_cost.h"
+#include "subgraph_bake.h"
 #include <string>
 #include <sstream>
 #include <memory>
 #include <unordered_map>
-#include <unordered_set>
 #include <vector>
-#include <queue>
 #include <algorithm>
 
 namespace ShaderGraph {
 
-// Graph traversal helper class
-class GraphTraverser {
-public:
-    // Topologically sort nodes starting from the output node
-    // Returns nodes in order of dependency (sources first, output last)
-    static std::vector<ShaderNodeBase*> topologicalSort(OutputNode* outputNode, ImFlow::ImNodeFlow& nodeFlow) {
-        std::vector<ShaderNodeBase*> result;
-        std::unordered_set<ImFlow::NodeUID> visited;
-        std::unordered_set<ImFlow::NodeUID> inStack;
-        
-        // Collect all connected nodes via DFS
-        std::vector<ShaderNodeBase*> connectedNodes;
-        collectConnectedNodes(outputNode, connectedNodes, visited);
-        
-        // Reset visited for topological sort
-        visited.clear();
-        
-        // Perform topological sort using DFS
-        for (auto* node : connectedNodes) {
-            if (visited.find(node->getUID()) == visited.end()) {
-                topologicalSortDFS(node, visited, inStack, result);
-            }
-        }
-        
-        return result;
-    }
-    
-private:
-    // DFS to collect all nodes connected to the output
-    static void collectConnectedNodes(ImFlow::BaseNode* node, 
-                                     std::vector<ShaderNodeBase*>& nodes,
-                                     std::unordered_set<ImFlow::NodeUID>& visited) {
-        if (!node || visited.find(node->getUID()) != visited.end()) return;
-        visited.insert(node->getUID());
-        
-        ShaderNodeBase* shaderNode = dynamic_cast<ShaderNodeBase*>(node);
-        if (shaderNode) {
-            nodes.push_back(shaderNode);
-        }
-        
-        // Visit all input connections
-        for (auto& pin : node->getIns()) {
-            if (pin && pin->isConnected()) {
-                auto linkWeak = pin->getLink();
-                if (auto link = linkWeak.lock()) {
-                    auto* leftPin = link->left();
-                    if (leftPin && leftPin->getParent()) {
-                        collectConnectedNodes(leftPin->getParent(), nodes, visited);
-                    }
-                }
-            }
-        }
-    }
-    
-    // DFS for topological sorting
-    static void topologicalSortDFS(ShaderNodeBase* node,
-                                   std::unordered_set<ImFlow::NodeUID>& visited,
-                                   std::unordered_set<ImFlow::NodeUID>& inStack,
-                                   std::vector<ShaderNodeBase*>& result) {
-        if (!node) return;
-        
-        ImFlow::NodeUID nodeId = node->getUID();
-        if (inStack.find(nodeId) != inStack.end()) {
-            // Cycle detected - skip
-            return;
-        }
-        if (visited.find(nodeId) != visited.end()) {
-            return;
-        }
-        
-        inStack.insert(nodeId);
-        
-        // Visit all nodes this one depends on (input connections)
-        for (auto& pin : node->getIns()) {
-            if (pin && pin->isConnected()) {
-                auto linkWeak = pin->getLink();
-                if (auto link = linkWeak.lock()) {
-                    auto* leftPin = link->left();
-                    if (leftPin && leftPin->getParent()) {
-                        ShaderNodeBase* parentNode = dynamic_cast<ShaderNodeBase*>(leftPin->getParent());
-                        if (parentNode) {
-                            topologicalSortDFS(parentNode, visited, inStack, result);
-                        }
-                    }
-                }
-            }
-        }
-        
-        inStack.erase(nodeId);
-        visited.insert(nodeId);
-        result.push_back(node);
-    }
-};
-
 class ShaderGraphEditor {
 public:
-    ShaderGraphEditor() : m_nodeFlow("Shader Graph") {
+    static constexpr const char* BakeCacheDirectory = "bake_cache/";
+    
+    // The name identifies the canvas to ImGui, so open editors need distinct ones
+    explicit ShaderGraphEditor(const std::string& name = "Shader Graph") : m_nodeFlow(name) {
         m_nodeFlow.setSize(ImVec2(0, 0)); // Auto-fit
+        m_bakeOptions.pathPrefix = BakeCacheDirectory;
+        
+        // Keep the dependency order and the parameter registry in step with the editor
+        m_nodeFlow.onNodeAdded([this](ImFlow::BaseNode* node) {
+            auto* shaderNode = dynamic_cast<ShaderNodeBase*>(node);
+            m_dependencies.addNode(node, shaderNode);
+            if (!shaderNode) return;
+            shaderNode->setPreviewSize(m_previewSize);
+            shaderNode->setLiveTweak(m_liveTweak);
+            // Constants get the registry too, for live tweaking
+            shaderNode->bindParameter(&m_parameters, shaderNode->isParameterNode()
+                                                         ? m_parameters.add(shaderNode, shaderNode->getUniformParameter())
+                                                         : InvalidParameterHandle);
+        });
+        m_nodeFlow.onNodeRemoved([this](ImFlow::BaseNode* node) {
+            m_dependencies.removeNode(node);
+            auto* shaderNode = dynamic_cast<ShaderNodeBase*>(node);
+            if (shaderNode && shaderNode->getParameterHandle() != InvalidParameterHandle) {
+                m_parameters.remove(shaderNode->getParameterHandle());
+                shaderNode->bindParameter(nullptr, InvalidParameterHandle);
+            }
+        });
+        m_nodeFlow.onLinkCreated([this](ImFlow::BaseNode* left, ImFlow::BaseNode* right) {
+            m_dependencies.addEdge(left, right);
+        });
+        m_nodeFlow.onLinkDestroyed([this](ImFlow::BaseNode* left, ImFlow::BaseNode* right) {
+            m_dependencies.removeEdge(left, right);
+        });
         
         // Set up right-click popup for adding nodes
         m_nodeFlow.rightClickPopUpContent([this](ImFlow::BaseNode* node) {
@@ -120,6 +63,31 @@ public:
                 if (ImGui::MenuItem("Delete Node")) {
                     node->destroy();
                 }
+                if (auto* shaderNode = dynamic_cast<ShaderNodeBase*>(node)) {
+                    if (ImGui::BeginMenu("Precision")) {
+                        for (ShaderPrecision precision : {ShaderPrecision::Default, ShaderPrecision::Full, ShaderPrecision::Half}) {
+                            if (ImGui::MenuItem(precisionLabel(precision), nullptr, shaderNode->getPrecision() == precision)) {
+                                shaderNode->setPrecision(precision);
+                            }
+                        }
+                        ImGui::EndMenu();
+                    }
+                    if (ImGui::BeginMenu("Bake")) {
+                        for (BakeFormat format : {BakeFormat::Default, BakeFormat::UNorm8, BakeFormat::Half, BakeFormat::Off}) {
+                            if (ImGui::MenuItem(bakeFormatLabel(format), nullptr, shaderNode->getBakeFormat() == format)) {
+                                shaderNode->setBakeSettings(format, shaderNode->getBakeSize());
+                            }
+                        }
+                        ImGui::Separator();
+                        for (uint16_t size : {0, 64, 128, 256, 512, 1024, 2048}) {
+                            const std::string label = size ? std::to_string(size) + " x " + std::to_string(size) : "Default size";
+                            if (ImGui::MenuItem(label.c_str(), nullptr, shaderNode->getBakeSize() == size)) {
+                                shaderNode->setBakeSettings(shaderNode->getBakeFormat(), size);
+                            }
+                        }
+                        ImGui::EndMenu();
+                    }
+                }
             } else {
                 // Right-clicked on empty space - show add node menu
                 showAddNodeMenu();
@@ -135,158 +103,598 @@ public:
     }
     
     void update() {
+        if (m_liveTweak) foldLiveConstants(false);
+        if (m_costHeatMap) applyCostHeat();
         m_nodeFlow.update();
-        // Collect parameters from graph
-        collectParameters();
     }
     
     void setSize(const ImVec2& size) {
         m_nodeFlow.setSize(size);
     }
     
+    // Monotonic graph revision - moves on link create/destroy, node add/remove,
+    // node edits and generator option changes that affect the generated code
+    uint64_t getRevision() const { return m_nodeFlow.getRevision() + m_optionsRevision; }
+    
+    // Emit the built-in uniforms as the std140 PerFrame block instead of loose uniforms
+    void setUseUniformBlock(bool enabled) {
+        if (enabled == m_useUniformBlock) return;
+        m_useUniformBlock = enabled;
+        m_optionsRevision++;
+    }
+    bool getUseUniformBlock() const { return m_useUniformBlock; }
+    
+    // Read user parameters per instance from the SweepParameters block, for the
+    // instanced parameter sweep preview
+    void setInstancedParameters(bool enabled) {
+        if (enabled == m_instancedParameters) return;
+        m_instancedParameters = enabled;
+        m_optionsRevision++;
+    }
+    bool getInstancedParameters() const { return m_instancedParameters; }
+    
+    // Precision policy of the generated code. The GLSL preview always compiles as
+    // desktop GLSL, where mediump is accepted and ignored, so it still shows which
+    // values go to half; the HLSL view follows the target.
+    void setPrecisionPolicy(const PrecisionPolicy& policy) {
+        if (policy.target == m_precision.target && policy.defaultPrecision == m_precision.defaultPrecision) return;
+        m_precision = policy;
+        m_optionsRevision++;
+    }
+    const PrecisionPolicy& getPrecisionPolicy() const { return m_precision; }
+    
+    // Replace expensive UV-only subgraphs with texture fetches (see subgraph_bake.h).
+    // Textures are rendered into bake_cache by the bake cache's worker and shared by
+    // subgraph content, so an edit only renders the subgraphs it changed; until one lands
+    // its subgraph stays procedural. Nodes override the format and size.
+    void setSubgraphBaking(bool enabled) {
+        if (enabled == m_subgraphBaking) return;
+        m_subgraphBaking = enabled;
+        m_bakedSamplers.clear();
+        m_hasBakedIR = false;
+        m_optionsRevision++;
+    }
+    bool getSubgraphBaking() const { return m_subgraphBaking; }
+    void setSubgraphBakeOptions(const SubgraphBakeOptions& options) {
+        if (options.minCost == m_bakeOptions.minCost && options.size == m_bakeOptions.size &&
+            options.format == m_bakeOptions.format && options.mipmaps == m_bakeOptions.mipmaps) {
+            return;
+        }
+        m_bakeOptions = options;
+        m_bakeOptions.pathPrefix = BakeCacheDirectory;
+        if (m_subgraphBaking) m_optionsRevision++;
+    }
+    const SubgraphBakeOptions& getSubgraphBakeOptions() const { return m_bakeOptions; }
+    
+    // Not owned and shared between editors; without one every subgraph stays procedural
+    void setBakeCache(SubgraphBakeCache* cache) {
+        if (cache == m_bakeCache) return;
+        m_bakeCache = cache;
+        if (m_subgraphBaking) m_optionsRevision++;
+    }
+    
+    // Keep the bakes the shader samples in the cache, and rebuild once any it was waiting
+    // for has finished. Once per frame, after the cache's update().
+    void updateBakes() {
+        if (!m_bakeCache || !m_subgraphBaking) return;
+        for (uint64_t key : m_bakeKeys) m_bakeCache->keep(key);
+        if (m_bakesPending && m_bakeCache->getRevision() != m_bakeCacheRevision) m_optionsRevision++;
+    }
+    
+    // Samplers of the subgraphs the current shader reads from textures, for binding
+    const std::vector<UniformParameter>& getBakedSamplers() {
+        getShaderIR();
+        return m_bakedSamplers;
+    }
+    size_t getBakeRenderCount() const { return m_bakeCache ? m_bakeCache->getRenderCount() : 0; }
+    size_t getBakePendingCount() const { return m_bakeCache ? m_bakeCache->getPendingCount() : 0; }
+    const std::string& getBakeError() const { return m_bakeError; }
+    
+    // Live tweaking: a Float or Color constant being dragged is emitted as a generated
+    // uniform, so each edit is a uniform upload rather than a recompile. Once it has been
+    // left alone for the settle delay it is folded back into a literal.
+    void setLiveTweak(bool enabled) {
+        if (enabled == m_liveTweak) return;
+        m_liveTweak = enabled;
+        for (auto& node : m_nodeFlow.getNodes()) {
+            if (auto* shaderNode = dynamic_cast<ShaderNodeBase*>(node.get())) shaderNode->setLiveTweak(enabled);
+        }
+        if (!enabled) foldLiveConstants(true);
+    }
+    bool getLiveTweak() const { return m_liveTweak; }
+    void setLiveSettleDelay(double seconds) { m_liveSettleDelay = seconds; }
+    
+    // Fold live constants back into literals: the settled ones, or all of them when
+    // force is set (before saving or exporting)
+    void foldLiveConstants(bool force) {
+        m_liveFold.clear();
+        const double now = ShaderNodeBase::liveClock();
+        for (ParameterHandle handle : m_parameters.handles()) {
+            ShaderNodeBase* node = m_parameters.owner(handle);
+            if (!node->isLiveConstant()) continue;
+            if (force || (!node->isConstantEditActive() && now - node->getLastConstantEdit() >= m_liveSettleDelay)) {
+                m_liveFold.push_back(node);
+            }
+        }
+        // Folding removes registry entries, so not while walking them
+        for (ShaderNodeBase* node : m_liveFold) node->foldLiveConstant();
+    }
+    
+    // Check whether a shader generated at the given revision is out of date
+    bool isShaderStale(uint64_t revision) const { return revision != getRevision(); }
+    
     // Get all parameters in the graph
-    const std::vector<UniformParameter>& getParameters() const { return m_parameters; }
+    const std::vector<UniformParameter>& getParameters() const { return m_parameters.parameters(); }
+    
+    // Per parameter (parallel to getParameters()): 1 when the output reads it. The others
+    // belong to disconnected nodes or dead branches; they are not declared in the shader,
+    // so they need no upload.
+    const std::vector<uint8_t>& getActiveParameters() {
+        const IRModule& module = getIR();
+        if (!m_hasActive || m_activeRevision != m_irRevision || m_activeLayout != m_parameters.getLayoutRevision()) {
+            activeParameters(module, m_parameters.parameters(), m_activeParameters);
+            m_activeRevision = m_irRevision;
+            m_activeLayout = m_parameters.getLayoutRevision();
+            m_hasActive = true;
+        }
+        return m_activeParameters;
+    }
+    
+    // Registry of parameter nodes (dense storage, dirty set and layout revision)
+    ParameterRegistry& getParameterRegistry() { return m_parameters; }
+    const ParameterRegistry& getParameterRegistry() const { return m_parameters; }
     
     // Update parameter value in a node
     void setParameterValue(const std::string& uniformName, const UniformParameter& param) {
-        for (auto& nodePair : m_nodeFlow.getNodes()) {
-            ShaderNodeBase* shaderNode = dynamic_cast<ShaderNodeBase*>(nodePair.second.get());
-            if (shaderNode && shaderNode->isParameterNode()) {
-                UniformParameter nodeParam = shaderNode->getUniformParameter();
-                if (nodeParam.name == uniformName) {
-                    shaderNode->setUniformValue(param);
-                    break;
-                }
-            }
-        }
+        setParameterValue(m_parameters.find(uniformName), param);
+    }
+    
+    void setParameterValue(ParameterHandle handle, const UniformParameter& param) {
+        if (!m_parameters.valid(handle)) return;
+        m_parameters.owner(handle)->setUniformValue(param);
+        m_parameters.setFloat(handle, param.floatValue);
+        m_parameters.setVec3(handle, param.vec3Value);
+        m_parameters.setTextureUnit(handle, param.textureUnit);
+        m_parameters.setTexturePath(handle, param.texturePath);
+    }
+    
+    // Everything the fragment shader is emitted from, copied out of the editor so the
+    // text can be written on another thread (see CompileScheduler)
+    struct FragmentShaderInputs {
+        IRModule module;
+        std::vector<UniformParameter> parameters;
+        bool useUniformBlock = false;
+        bool instancedParameters = false;
+        PrecisionPolicy precision;
+        uint64_t revision = 0;          // Graph revision the inputs were taken at
+    };
+    
+    void captureFragmentShader(FragmentShaderInputs& inputs) {
+        inputs.module = getShaderIR();
+        inputs.parameters = shaderParameters();
+        inputs.useUniformBlock = m_useUniformBlock;
+        inputs.instancedParameters = m_instancedParameters;
+        inputs.precision = m_precision;
+        inputs.revision = getRevision();
+    }
+    
+    // The text generateFragmentShader() returns for the same inputs. Touches nothing but
+    // its arguments, so any thread that owns the emitter and writer may call it.
+    static void writeFragmentShader(CodeWriter& out, IREmitter& emitter, const IRModule& module,
+                                    const std::vector<UniformParameter>& parameters, bool useUniformBlock,
+                                    bool instancedParameters, PrecisionPolicy precision) {
+        // The preview compiles as desktop GLSL whatever the target; an empty IR (no
+        // output node) emits the magenta fallback
+        precision.target = ShaderTarget::Desktop;
+        CrossPlatformShaderGenerator().writeGLSL(out, emitter, module, parameters, useUniformBlock,
+                                                 instancedParameters, precision);
+    }
+    static void writeFragmentShader(CodeWriter& out, IREmitter& emitter, const FragmentShaderInputs& inputs) {
+        writeFragmentShader(out, emitter, inputs.module, inputs.parameters, inputs.useUniformBlock,
+                            inputs.instancedParameters, inputs.precision);
     }
     
     // Generate fragment shader code using graph traversal
-    std::string generateFragmentShader() {
-        std::stringstream ss;
-        
-        // Shader header
-        ss << R"(#version 330 core
-out vec4 FragColor;
-
-in vec3 FragPos;
-in vec3 Normal;
-in vec2 TexCoord;
-
-// Built-in uniforms
-uniform float time;
-uniform vec3 lightPos;
-uniform vec3 viewPos;
-uniform vec3 lightColor;
-uniform vec3 objectColor;
-
-)";
-        
-        // Generate user parameter uniforms
-        for (const auto& param : m_parameters) {
-            ss << "// User parameter: " << param.displayName << "\n";
-            ss << "uniform " << ShaderNodeBase::typeToGLSL(param.type) << " " << param.name << ";\n";
-        }
-        
-        ss << R"(
-void main()
-{
-)";
-        
-        // Generate the main shader code using graph traversal
-        if (m_outputNode) {
-            ss << generateShaderBody();
-        } else {
-            ss << "    FragColor = vec4(1.0, 0.0, 1.0, 1.0); // Error: No output node\n";
+    // The result is cached and only rebuilt when the graph revision moves
+    const std::string& generateFragmentShader() {
+        if (m_hasGeneratedShader && m_generatedRevision == getRevision()) {
+            return m_generatedShader;
         }
         
-        ss << "}\n";
-        
-        return ss.str();
+        const IRModule& module = getShaderIR();
+        m_shaderWriter.clear();
+        writeFragmentShader(m_shaderWriter, m_glslEmitter, module, shaderParameters(), m_useUniformBlock,
+                            m_instancedParameters, m_precision);
+        m_shaderWriter.copyTo(m_generatedShader);
+        m_generatedShaderHash = m_shaderWriter.hash();
+        m_generatedRevision = getRevision();
+        m_hasGeneratedShader = true;
+        return m_generatedShader;
     }
     
-    // Generate shader body using topological traversal
+    // Hash of the text generateFragmentShader() last returned, so callers can tell
+    // whether it changed without comparing the text
+    uint64_t getGeneratedShaderHash() const { return m_generatedShaderHash; }
+    
+    // Generate shader body from the IR (CSE and constant folding happen while lowering)
     std::string generateShaderBody() {
-        std::stringstream ss;
-        
-        // Get topologically sorted nodes
-        auto sortedNodes = GraphTraverser::topologicalSort(m_outputNode.get(), m_nodeFlow);
-        
-        // Map: nodeUID -> (pinName -> varName/expression)
-        std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>> varMap;
-        
-        // Track which nodes have multiple outgoing connections (need variables)
-        std::unordered_map<ImFlow::NodeUID, int> outConnectionCount;
-        countOutputConnections(sortedNodes, outConnectionCount);
-        
-        int varCounter = 0;
-        
-        // Process nodes in topological order
-        for (auto* node : sortedNodes) {
-            // Skip the output node - handle it specially at the end
-            if (node == m_outputNode.get()) continue;
-            
-            ImFlow::NodeUID nodeId = node->getUID();
-            
-            // Check if this node needs a variable (has multiple outputs or complex expression)
-            bool needsVariable = outConnectionCount[nodeId] > 1 || !node->isSourceNode();
-            (void)needsVariable; // Suppress unused warning
-            
-            // Get all output pins
-            for (auto& pin : node->getOuts()) {
-                std::string pinName = pin->getName();
-                std::string expr = node->generateExpression(pinName, varMap);
-                
-                // Source nodes with single output use inline expression
-                if (node->isSourceNode() && outConnectionCount[nodeId] <= 1) {
-                    varMap[nodeId][pinName] = expr;
-                } else {
-                    // Generate a variable for this output
-                    std::string varName = "v" + std::to_string(varCounter++);
-                    ShaderDataType type = node->getOutputType(pinName);
-                    std::string typeStr = ShaderNodeBase::typeToGLSL(type);
-                    
-                    ss << "    " << typeStr << " " << varName << " = " << expr << ";\n";
-                    varMap[nodeId][pinName] = varName;
-                }
+        return m_glslEmitter.emitBody(getIR());
+    }
+    
+    // Native HLSL pixel shader for the same graph
+    const std::string& generateHLSLShader() {
+        if (m_hasGeneratedHLSL && m_generatedHLSLRevision == getRevision()) {
+            return m_generatedHLSL;
+        }
+        const IRModule& module = getShaderIR();
+        m_shaderWriter.clear();
+        CrossPlatformShaderGenerator().writeHLSL(m_shaderWriter, m_hlslEmitter, module, shaderParameters(), m_precision);
+        m_shaderWriter.copyTo(m_generatedHLSL);
+        m_generatedHLSLRevision = getRevision();
+        m_hasGeneratedHLSL = true;
+        return m_generatedHLSL;
+    }
+    
+    // Typed IR of the nodes reachable from the output, rebuilt when the revision moves
+    const IRModule& getIR() {
+        if (!m_hasIR || m_irRevision != getRevision()) {
+            buildIR();
+            m_irRevision = getRevision();
+            m_hasIR = true;
+        }
+        return m_ir;
+    }
+    
+    // The IR the material shaders are emitted from: getIR() with baked subgraphs
+    // replaced by texture fetches when baking is on
+    const IRModule& getShaderIR() {
+        const IRModule& module = getIR();
+        if (!m_subgraphBaking) return module;
+        if (!m_hasBakedIR || m_bakedRevision != m_irRevision) {
+            bakeSubgraphs(module);
+            m_bakedRevision = m_irRevision;
+            m_hasBakedIR = true;
+        }
+        return m_bakedIR;
+    }
+    
+    // Static cost of the current shader (after baking); perNode is parallel to getCostNodes()
+    const ShaderCostReport& getCostReport() {
+        const IRModule& module = getShaderIR();
+        if (!m_hasCost || m_costRevision != m_irRevision) {
+            estimateCost(module, m_cost);
+            m_costRevision = m_irRevision;
+            m_hasCost = true;
+        }
+        return m_cost;
+    }
+    // Whether the current shader reads time (a Time node reaches the output),
+    // i.e. whether the preview changes from frame to frame on its own
+    bool isTimeDependent() {
+        const IRModule& module = getIR();
+        if (!m_hasTimeDependence || m_timeDependenceRevision != m_irRevision) {
+            m_timeDependent = readsUniform(module, module.color, "time") || readsUniform(module, module.alpha, "time");
+            m_timeDependenceRevision = m_irRevision;
+            m_hasTimeDependence = true;
+        }
+        return m_timeDependent;
+    }
+    
+    const std::vector<ShaderNodeBase*>& getCostNodes() {
+        getIR();
+        return m_sortedNodes;
+    }
+    
+    // Tint node headers by their share of the shader cost
+    void setCostHeatMap(bool enabled) {
+        if (enabled == m_costHeatMap) return;
+        m_costHeatMap = enabled;
+        m_hasHeat = false;
+        if (!enabled) {
+            for (auto& node : m_nodeFlow.getNodes()) {
+                if (auto* shaderNode = dynamic_cast<ShaderNodeBase*>(node.get())) shaderNode->setCostHeat(-1.0f);
             }
         }
-        
-        // Add spacing before final output if we generated variables
-        if (varCounter > 0) {
-            ss << "\n";
+    }
+    bool getCostHeatMap() const { return m_costHeatMap; }
+    
+    // Per-node thumbnails (see NodePreviewRenderer); size 0 turns them off
+    void setNodePreviewSize(float size) {
+        if (size == m_previewSize) return;
+        m_previewSize = size;
+        for (auto& node : m_nodeFlow.getNodes()) {
+            if (auto* shaderNode = dynamic_cast<ShaderNodeBase*>(node.get())) shaderNode->setPreviewSize(size);
         }
-        
-        // Generate final output
-        ss << m_outputNode->generateCodeFromVarMap(varMap);
-        
-        return ss.str();
+    }
+    float getNodePreviewSize() const { return m_previewSize; }
+    
+    // Nodes whose thumbnail was on screen in the last drawn frame
+    void collectVisiblePreviews(std::vector<ShaderNodeBase*>& out) {
+        out.clear();
+        if (m_previewSize <= 0.0f) return;
+        // Culled nodes are not drawn, so their visibility flag is stale
+        for (ImFlow::BaseNode* node : m_nodeFlow.getDrawnNodes()) {
+            auto* shaderNode = dynamic_cast<ShaderNodeBase*>(node);
+            if (shaderNode && shaderNode->hasPreview() && shaderNode->isPreviewVisible()) out.push_back(shaderNode);
+        }
+    }
+    
+    // Fragment shader showing the first output of a node, with the same inputs and
+    // uniforms as the material. timeDependent tells whether it animates. False for
+    // nodes without a previewable output.
+    bool generatePreviewShader(const ShaderNodeBase* node, std::string& fragment, bool& timeDependent) {
+        if (!m_hasPreviewIR || m_previewRevision != getRevision()) {
+            buildPreviewIR();
+            m_previewRevision = getRevision();
+            m_hasPreviewIR = true;
+        }
+        auto it = m_previewRoots.find(node);
+        if (it == m_previewRoots.end()) return false;
+        m_previewIR.color = it->second;
+        m_previewIR.alpha = m_previewAlpha;
+        m_shaderWriter.clear();
+        CrossPlatformShaderGenerator().writeGLSL(m_shaderWriter, m_previewEmitter, m_previewIR, m_parameters.parameters(), false);
+        m_shaderWriter.copyTo(fragment);
+        timeDependent = readsUniform(m_previewIR, it->second, "time");
+        return true;
     }
     
     ImFlow::ImNodeFlow& getNodeFlow() { return m_nodeFlow; }
     
+    // Replace the graph with a description. Nodes are created in one pass, then links
+    // by index, so loading is linear in the size of the graph.
+    void loadGraph(const GraphDesc& graph) {
+        m_outputNode.reset();
+        m_nodeFlow.clear();
+        m_nodeFlow.reserveNodes(graph.nodes.size() + 1);
+        
+        std::vector<std::shared_ptr<ShaderNodeBase>> created(graph.nodes.size());
+        for (size_t i = 0; i < graph.nodes.size(); ++i) {
+            const NodeDesc& desc = graph.nodes[i];
+            created[i] = createNode(desc.kind, ImVec2(desc.pos[0], desc.pos[1]));
+            if (!created[i]) continue;
+            created[i]->applyDesc(desc);
+            created[i]->setPrecision(desc.precision);
+            created[i]->setBakeSettings(desc.bakeFormat, desc.bakeSize);
+            if (desc.kind == NodeKind::Output && !m_outputNode) {
+                m_outputNode = std::static_pointer_cast<OutputNode>(created[i]);
+            }
+        }
+        if (!m_outputNode) m_outputNode = m_nodeFlow.addNode<OutputNode>(ImVec2(600, 200));
+        
+        for (const LinkDesc& link : graph.links) {
+            if (link.fromNode >= created.size() || link.toNode >= created.size()) continue;
+            const auto& from = created[link.fromNode];
+            const auto& to = created[link.toNode];
+            if (!from || !to || link.fromPin >= from->getOuts().size() || link.toPin >= to->getIns().size()) continue;
+            to->getIns()[link.toPin]->createLink(from->getOuts()[link.fromPin].get());
+        }
+    }
+    
+    bool loadFromFile(const std::string& path, std::string& error) {
+        GraphDesc graph;
+        if (!loadGraphFile(path, graph, error)) return false;
+        loadGraph(graph);
+        return true;
+    }
+    
+    bool saveToFile(const std::string& path, std::string& error) {
+        foldLiveConstants(true);
+        return saveGraphFile(path, describe(), error);
+    }
+    
+    // Plain-data snapshot of the graph for saving and headless generation
+    GraphDesc describe() {
+        GraphDesc graph;
+        // Position in graph.nodes by node slot; links come straight from pin indices
+        std::vector<uint32_t> index(m_nodeFlow.getNodeSlotCount(), NoGraphIndex);
+        for (auto& node : m_nodeFlow.getNodes()) {
+            auto* shaderNode = dynamic_cast<ShaderNodeBase*>(node.get());
+            if (!shaderNode) continue;
+            index[node->getHandle().index] = static_cast<uint32_t>(graph.nodes.size());
+            graph.nodes.push_back(shaderNode->describe());
+        }
+        
+        for (auto& node : m_nodeFlow.getNodes()) {
+            uint32_t target = index[node->getHandle().index];
+            if (target == NoGraphIndex) continue;
+            const auto& ins = node->getIns();
+            for (size_t i = 0; i < ins.size(); ++i) {
+                ImFlow::Link* link = ins[i] ? ins[i]->getLink() : nullptr;
+                if (!link) continue;
+                ImFlow::Pin* source = link->left();
+                if (source->getIndex() == ImFlow::PinHandle::Invalid) continue;  // Dynamic pin
+                uint32_t from = index[source->getParent()->getHandle().index];
+                if (from == NoGraphIndex) continue;
+                graph.links.push_back({from, source->getIndex(), target, static_cast<uint32_t>(i)});
+            }
+        }
+        return graph;
+    }
+    
 private:
-    // Count how many connections each node's output has
-    void countOutputConnections(const std::vector<ShaderNodeBase*>& nodes,
-                                std::unordered_map<ImFlow::NodeUID, int>& outCount) {
-        for (auto* node : nodes) {
-            outCount[node->getUID()] = 0;
+    // Unset entries of the per-slot arrays in describe() and lowerNodes()
+    static constexpr uint32_t NoGraphIndex = UINT32_MAX;
+    static constexpr size_t NoOutputOffset = SIZE_MAX;
+    
+    void applyCostHeat() {
+        const ShaderCostReport& report = getCostReport();
+        if (m_hasHeat && m_heatRevision == m_costRevision) return;
+        m_heatRevision = m_costRevision;
+        m_hasHeat = true;
+        
+        // Nodes the output doesn't reach keep their own style
+        for (auto& node : m_nodeFlow.getNodes()) {
+            if (auto* shaderNode = dynamic_cast<ShaderNodeBase*>(node.get())) shaderNode->setCostHeat(-1.0f);
+        }
+        for (size_t i = 0; i < m_sortedNodes.size(); ++i) {
+            float score = i < report.perNode.size() ? costScore(report.perNode[i]) : 0.0f;
+            m_sortedNodes[i]->setCostHeat(report.maxNodeScore > 0.0f ? score / report.maxNodeScore : 0.0f);
+        }
+    }
+    
+    // Find the subgraphs worth baking and substitute the ones the cache has ready; the
+    // others are queued and stay procedural for now (see updateBakes)
+    void bakeSubgraphs(const IRModule& module) {
+        m_bakedIR = module;
+        m_bakedSamplers.clear();
+        m_bakeKeys.clear();
+        m_bakeError.clear();
+        m_bakesPending = false;
+        if (!m_bakeCache) return;
+        std::vector<SubgraphBakeSettings> settings(m_sortedNodes.size());
+        for (size_t i = 0; i < m_sortedNodes.size(); ++i) {
+            settings[i].format = m_sortedNodes[i]->getBakeFormat();
+            settings[i].size = m_sortedNodes[i]->getBakeSize();
+        }
+        std::vector<SubgraphBake> bakes;
+        findSubgraphBakes(module, m_bakeOptions, &settings, bakes);
+        m_bakeCacheRevision = m_bakeCache->getRevision();
+        for (SubgraphBake& bake : bakes) {
+            m_bakeKeys.push_back(bake.key);
+            switch (m_bakeCache->request(module, m_bakeOptions, bake, m_bakeError)) {
+                case SubgraphBakeCache::Status::Ready:
+                    break;
+                case SubgraphBakeCache::Status::Pending:
+                    m_bakesPending = true;
+                    bake.root = IRNone;
+                    break;
+                case SubgraphBakeCache::Status::Failed:
+                    bake.root = IRNone;
+                    break;
+            }
         }
         
-        // Count incoming connections (which represent output usages)
-        for (auto* node : nodes) {
-            for (auto& pin : node->getIns()) {
-                if (pin && pin->isConnected()) {
-                    auto linkWeak = pin->getLink();
-                    if (auto link = linkWeak.lock()) {
-                        auto* leftPin = link->left();
-                        if (leftPin && leftPin->getParent()) {
-                            ImFlow::NodeUID srcId = leftPin->getParent()->getUID();
-                            outCount[srcId]++;
-                        }
-                    }
-                }
+        // Units are picked around the material's own samplers, which stay first
+        std::vector<UniformParameter> parameters = m_parameters.parameters();
+        const size_t materialCount = parameters.size();
+        applySubgraphBakes(m_bakedIR, bakes, parameters);
+        m_bakedSamplers.assign(parameters.begin() + static_cast<std::ptrdiff_t>(materialCount), parameters.end());
+    }
+    
+    // Material parameters followed by the baked samplers
+    const std::vector<UniformParameter>& shaderParameters() {
+        if (!m_subgraphBaking || m_bakedSamplers.empty()) return m_parameters.parameters();
+        m_shaderParameters = m_parameters.parameters();
+        m_shaderParameters.insert(m_shaderParameters.end(), m_bakedSamplers.begin(), m_bakedSamplers.end());
+        return m_shaderParameters;
+    }
+    
+    void buildIR() {
+        m_ir.clear();
+        if (!m_outputNode) return;
+        IRBuilder ir(m_ir);
+        m_dependencies.collectUpstream(m_outputNode.get(), m_sortedNodes);
+        std::vector<IRValue> values;
+        std::vector<size_t> outputOffset;
+        lowerNodes(ir, m_sortedNodes, values, outputOffset);
+    }
+    
+    // Every node lowered into one module, with a vec3 root per node for its first output
+    void buildPreviewIR() {
+        m_previewIR.clear();
+        m_previewRoots.clear();
+        IRBuilder ir(m_previewIR);
+        m_dependencies.collectAll(m_previewNodes);
+        std::vector<IRValue> values;
+        std::vector<size_t> outputOffset;
+        lowerNodes(ir, m_previewNodes, values, outputOffset);
+        
+        ir.setOrigin(-1);
+        ir.setPrecision(ShaderPrecision::Default);
+        m_previewAlpha = ir.constant(1.0f);
+        m_previewRoots.reserve(m_previewNodes.size());
+        for (ShaderNodeBase* node : m_previewNodes) {
+            if (node->getOuts().empty()) continue;
+            IRValue value = values[outputOffset[node->getHandle().index]];
+            if (value == IRNone) continue;
+            switch (m_previewIR.at(value).type) {
+                case ShaderDataType::Float: value = ir.makeVec3(value, value, value); break;
+                case ShaderDataType::Vec2: value = ir.makeVec3(ir.swizzle(value, "x"), ir.swizzle(value, "y"), ir.constant(0.0f)); break;
+                case ShaderDataType::Vec4: value = ir.swizzle(value, "xyz"); break;
+                case ShaderDataType::Vec3: break;
+                case ShaderDataType::Sampler2D: continue;
+            }
+            m_previewRoots.emplace(node, value);
+        }
+    }
+    
+    // Lower nodes (dependencies first) into the builder. Each node sees its input values
+    // by pin index, so no names are looked up while building; values holds the outputs of
+    // every node contiguously, at outputOffset[node slot].
+    void lowerNodes(IRBuilder& ir, const std::vector<ShaderNodeBase*>& sortedNodes, std::vector<IRValue>& values,
+                    std::vector<size_t>& outputOffset) {
+        outputOffset.assign(m_nodeFlow.getNodeSlotCount(), NoOutputOffset);
+        std::vector<IRValue> inputs;
+        
+        for (size_t n = 0; n < sortedNodes.size(); ++n) {
+            ShaderNodeBase* node = sortedNodes[n];
+            const auto& ins = node->getIns();
+            inputs.assign(ins.size(), IRNone);
+            for (size_t i = 0; i < ins.size(); ++i) {
+                ImFlow::Link* link = ins[i] ? ins[i]->getLink() : nullptr;
+                if (!link) continue;
+                
+                ImFlow::Pin* source = link->left();
+                size_t sourceOffset = outputOffset[source->getParent()->getHandle().index];
+                if (sourceOffset == NoOutputOffset) continue;  // Cycle or non-shader node
+                if (source->getIndex() >= source->getParent()->getOuts().size()) continue;  // Dynamic pin
+                inputs[i] = values[sourceOffset + source->getIndex()];
             }
+            
+            size_t offset = values.size();
+            values.resize(offset + node->getOuts().size(), IRNone);
+            // Origins index sortedNodes; the node's slot names its variables across edits
+            ir.setOrigin(static_cast<int32_t>(n), static_cast<int32_t>(node->getHandle().index));
+            node->lower(ir, inputs.data(), values.data() + offset);
+            outputOffset[node->getHandle().index] = offset;
+        }
+    }
+    
+    std::shared_ptr<ShaderNodeBase> createNode(NodeKind kind, const ImVec2& pos) {
+        switch (kind) {
+            case NodeKind::Float: return m_nodeFlow.addNode<FloatNode>(pos);
+            case NodeKind::Color: return m_nodeFlow.addNode<ColorNode>(pos);
+            case NodeKind::FloatParameter: return m_nodeFlow.addNode<FloatParameterNode>(pos);
+            case NodeKind::Vec3Parameter: return m_nodeFlow.addNode<Vec3ParameterNode>(pos);
+            case NodeKind::Time: return m_nodeFlow.addNode<TimeNode>(pos);
+            case NodeKind::Position: return m_nodeFlow.addNode<UVNode>(pos);
+            case NodeKind::Normal: return m_nodeFlow.addNode<NormalNode>(pos);
+            case NodeKind::TexCoord: return m_nodeFlow.addNode<TexCoordNode>(pos);
+            case NodeKind::Add: return m_nodeFlow.addNode<AddNode>(pos);
+            case NodeKind::Multiply: return m_nodeFlow.addNode<MultiplyNode>(pos);
+            case NodeKind::Subtract: return m_nodeFlow.addNode<SubtractNode>(pos);
+            case NodeKind::Divide: return m_nodeFlow.addNode<DivideNode>(pos);
+            case NodeKind::Sin: return m_nodeFlow.addNode<SinNode>(pos);
+            case NodeKind::Cos: return m_nodeFlow.addNode<CosNode>(pos);
+            case NodeKind::Abs: return m_nodeFlow.addNode<AbsNode>(pos);
+            case NodeKind::Mix: return m_nodeFlow.addNode<MixNode>(pos);
+            case NodeKind::Clamp: return m_nodeFlow.addNode<ClampNode>(pos);
+            case NodeKind::MakeVec3: return m_nodeFlow.addNode<MakeVec3Node>(pos);
+            case NodeKind::SplitVec3: return m_nodeFlow.addNode<SplitVec3Node>(pos);
+            case NodeKind::Fresnel: return m_nodeFlow.addNode<FresnelNode>(pos);
+            case NodeKind::Texture: return m_nodeFlow.addNode<TextureNode>(pos);
+            case NodeKind::Output: return m_nodeFlow.addNode<OutputNode>(pos);
+            case NodeKind::StaticSwitch: return m_nodeFlow.addNode<StaticSwitchNode>(pos);
+            case NodeKind::Count: break;
+        }
+        return nullptr;
+    }
+    
+    static const char* bakeFormatLabel(BakeFormat format) {
+        switch (format) {
+            case BakeFormat::UNorm8: return "8-bit (range fitted)";
+            case BakeFormat::Half: return "Half float";
+            case BakeFormat::Off: return "Never bake";
+            default: return "Editor default";
+        }
+    }
+    
+    static const char* precisionLabel(ShaderPrecision precision) {
+        switch (precision) {
+            case ShaderPrecision::Full: return "Full";
+            case ShaderPrecision::Half: return "Half";
+            default: return "Target default";
         }
     }
     
@@ -379,22 +787,91 @@ private:
             }
             ImGui::EndMenu();
         }
+        
+        if (ImGui::BeginMenu("Variants")) {
+            if (ImGui::MenuItem("Static Switch")) {
+                m_nodeFlow.placeNode<StaticSwitchNode>();
+            }
+            ImGui::EndMenu();
+        }
     }
     
+    // Declared before the editor so they are still alive while the editor tears down
+    DependencyGraph<ImFlow::BaseNode, ShaderNodeBase> m_dependencies;
+    ParameterRegistry m_parameters;  // Parameter nodes, registered on add/remove
+    std::vector<ShaderNodeBase*> m_sortedNodes;
+    
     ImFlow::ImNodeFlow m_nodeFlow;
     std::shared_ptr<OutputNode> m_outputNode;
-    std::vector<UniformParameter> m_parameters;  // Collected user parameters
-    
-    // Collect all parameter nodes from the graph
-    void collectParameters() {
-        m_parameters.clear();
-        for (auto& nodePair : m_nodeFlow.getNodes()) {
-            ShaderNodeBase* shaderNode = dynamic_cast<ShaderNodeBase*>(nodePair.second.get());
-            if (shaderNode && shaderNode->isParameterNode()) {
-                m_parameters.push_back(shaderNode->getUniformParameter());
-            }
-        }
-    }
+    
+    // Generated shader cache (keyed by graph revision). The writer and emitters persist
+    // so regeneration reuses their buffers and unchanged statements.
+    std::string m_generatedShader;
+    uint64_t m_generatedShaderHash = 0;
+    uint64_t m_generatedRevision = 0;
+    bool m_hasGeneratedShader = false;
+    CodeWriter m_shaderWriter;
+    IREmitter m_glslEmitter{IREmitter::Language::GLSL};
+    IREmitter m_hlslEmitter{IREmitter::Language::HLSL};
+    IREmitter m_previewEmitter{IREmitter::Language::GLSL};     // Thumbnails share most of their statements
+    std::vector<UniformParameter> m_shaderParameters;
+    
+    // Lowered graph and native HLSL (keyed by graph revision)
+    IRModule m_ir;
+    uint64_t m_irRevision = 0;
+    bool m_hasIR = false;
+    std::string m_generatedHLSL;
+    uint64_t m_generatedHLSLRevision = 0;
+    bool m_hasGeneratedHLSL = false;
+    std::vector<uint8_t> m_activeParameters;
+    uint64_t m_activeRevision = 0;
+    uint64_t m_activeLayout = 0;
+    bool m_hasActive = false;
+    bool m_timeDependent = false;
+    uint64_t m_timeDependenceRevision = 0;
+    bool m_hasTimeDependence = false;
+    
+    // Cost estimate of m_ir and the heat map applied from it
+    ShaderCostReport m_cost;
+    uint64_t m_costRevision = 0;
+    bool m_hasCost = false;
+    bool m_costHeatMap = false;
+    uint64_t m_heatRevision = 0;
+    bool m_hasHeat = false;
+    
+    // Subgraph baking: the substituted IR (keyed by IR revision), the keys of its
+    // candidates and whether any were still rendering when it was built
+    bool m_subgraphBaking = false;
+    SubgraphBakeOptions m_bakeOptions;
+    IRModule m_bakedIR;
+    uint64_t m_bakedRevision = 0;
+    bool m_hasBakedIR = false;
+    std::vector<UniformParameter> m_bakedSamplers;
+    SubgraphBakeCache* m_bakeCache = nullptr;
+    std::vector<uint64_t> m_bakeKeys;
+    bool m_bakesPending = false;
+    uint64_t m_bakeCacheRevision = 0;
+    std::string m_bakeError;
+    
+    // Every node lowered for thumbnails (keyed by graph revision)
+    IRModule m_previewIR;
+    std::vector<ShaderNodeBase*> m_previewNodes;
+    std::unordered_map<const ShaderNodeBase*, IRValue> m_previewRoots;
+    IRValue m_previewAlpha = IRNone;
+    uint64_t m_previewRevision = 0;
+    bool m_hasPreviewIR = false;
+    float m_previewSize = 0.0f;
+    
+    // Live tweaking of constants
+    bool m_liveTweak = true;
+    double m_liveSettleDelay = 0.5;
+    std::vector<ShaderNodeBase*> m_liveFold;
+    
+    // Generator options (folded into getRevision())
+    bool m_useUniformBlock = false;
+    bool m_instancedParameters = false;
+    PrecisionPolicy m_precision;
+    uint64_t m_optionsRevision = 0;
 };
 
 } // namespace ShaderGraph
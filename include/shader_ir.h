@@ -0,0 +1,792 @@
+#ifndef SHADER_IR_H
+#define SHADER_IR_H
+
+#include "shader_types.h"
+#include "code_writer.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+
+// Typed intermediate representation between the node graph and text emission.
+// Nodes lower into a flat SSA instruction array; every value is the index of the
+// instruction that produced it and operands always refer to earlier instructions.
+// The builder hash-conses instructions (CSE) and folds constants as they are
+// created, so emitters only have to print what is live.
+
+namespace ShaderGraph {
+
+using IRValue = int32_t;
+constexpr IRValue IRNone = -1;
+
+enum class IROp : uint8_t {
+    Const,      // Literal, components in constant[]
+    Input,      // Varying from the vertex stage, name in aux
+    Uniform,    // Built-in or user uniform, name in aux
+    Swizzle,    // operands[0] swizzled by the xyzw mask in aux
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Sin,
+    Cos,
+    Abs,
+    Normalize,
+    Min,
+    Max,
+    Pow,
+    Dot,
+    Mix,        // mix(a, b, t)
+    Clamp,      // clamp(x, lo, hi)
+    MakeVec3,
+    Texture     // Sample sampler aux at operands[0]
+};
+
+struct IRInstr {
+    IROp op = IROp::Const;
+    ShaderPrecision precision = ShaderPrecision::Default;   // Requested by the creating node
+    ShaderDataType type = ShaderDataType::Float;
+    IRValue operands[3] = {IRNone, IRNone, IRNone};
+    uint32_t aux = 0;               // String table index (names, swizzle masks)
+    float constant[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+};
+
+struct IRModule {
+    std::vector<IRInstr> instrs;
+    std::vector<int32_t> origins;   // Per instruction: the node that first created it (-1 unknown)
+    std::vector<int32_t> nodeIds;   // Per instruction: a stable id of that node, which names its variables (-1 unknown)
+    std::vector<std::string> strings;
+    IRValue color = IRNone;         // vec3 fragment color
+    IRValue alpha = IRNone;         // float fragment alpha
+
+    const IRInstr& at(IRValue value) const { return instrs[static_cast<size_t>(value)]; }
+    const std::string& str(uint32_t index) const { return strings[index]; }
+
+    void clear() {
+        instrs.clear();
+        origins.clear();
+        nodeIds.clear();
+        strings.clear();
+        color = IRNone;
+        alpha = IRNone;
+    }
+};
+
+inline int componentCount(ShaderDataType type) {
+    switch (type) {
+        case ShaderDataType::Float: return 1;
+        case ShaderDataType::Vec2: return 2;
+        case ShaderDataType::Vec3: return 3;
+        case ShaderDataType::Vec4: return 4;
+        case ShaderDataType::Sampler2D: return 0;
+    }
+    return 1;
+}
+
+inline ShaderDataType vectorType(int components) {
+    switch (components) {
+        case 2: return ShaderDataType::Vec2;
+        case 3: return ShaderDataType::Vec3;
+        case 4: return ShaderDataType::Vec4;
+        default: return ShaderDataType::Float;
+    }
+}
+
+// True when root depends on the named uniform
+inline bool readsUniform(const IRModule& module, IRValue root, const std::string& name) {
+    if (root == IRNone) return false;
+    std::vector<bool> live(static_cast<size_t>(root) + 1, false);
+    live[root] = true;
+    for (size_t i = live.size(); i-- > 0;) {
+        if (!live[i]) continue;
+        const IRInstr& instr = module.instrs[i];
+        if (instr.op == IROp::Uniform && module.str(instr.aux) == name) return true;
+        for (IRValue operand : instr.operands) {
+            if (operand != IRNone) live[operand] = true;
+        }
+    }
+    return false;
+}
+
+// Instructions the fragment outputs depend on (operands always precede their users)
+inline void markLive(const IRModule& module, std::vector<bool>& live) {
+    live.assign(module.instrs.size(), false);
+    if (module.color != IRNone) live[module.color] = true;
+    if (module.alpha != IRNone) live[module.alpha] = true;
+    for (size_t i = live.size(); i-- > 0;) {
+        if (!live[i]) continue;
+        for (IRValue operand : module.instrs[i].operands) {
+            if (operand != IRNone) live[operand] = true;
+        }
+    }
+}
+
+// Per parameter (parallel to params): 1 when the live code reads it, as a uniform or a
+// sampler. Parameter nodes the output doesn't reach are never lowered, and values that
+// end up only in dead code (the other side of a static switch) are not live either.
+inline void activeParameters(const IRModule& module, const std::vector<UniformParameter>& params,
+                             std::vector<uint8_t>& active) {
+    active.assign(params.size(), 0);
+    if (params.empty()) return;
+    std::vector<bool> live;
+    markLive(module, live);
+    std::unordered_map<std::string, size_t> byName;
+    byName.reserve(params.size());
+    for (size_t i = 0; i < params.size(); ++i) byName.emplace(params[i].name, i);
+    for (size_t i = 0; i < live.size(); ++i) {
+        const IRInstr& instr = module.instrs[i];
+        if (!live[i] || (instr.op != IROp::Uniform && instr.op != IROp::Texture)) continue;
+        auto it = byName.find(module.str(instr.aux));
+        if (it != byName.end()) active[it->second] = 1;
+    }
+}
+
+// Shortest literal that reads back as the same float, always with a '.' or exponent
+inline std::string formatFloat(float value) {
+    char buffer[32];
+    return std::string(buffer, CodeWriter::formatShortest(value, buffer));
+}
+
+// ============================================================================
+// IR BUILDER - Creates instructions with CSE and constant folding
+// ============================================================================
+class IRBuilder {
+public:
+    explicit IRBuilder(IRModule& module) : m_module(module) {}
+
+    IRValue constant(float x) {
+        IRInstr instr;
+        instr.type = ShaderDataType::Float;
+        instr.constant[0] = x;
+        return emit(instr);
+    }
+
+    IRValue constant(float x, float y, float z) {
+        IRInstr instr;
+        instr.type = ShaderDataType::Vec3;
+        instr.constant[0] = x;
+        instr.constant[1] = y;
+        instr.constant[2] = z;
+        return emit(instr);
+    }
+
+    IRValue input(const std::string& name, ShaderDataType type) { return named(IROp::Input, name, type); }
+    IRValue uniform(const std::string& name, ShaderDataType type) { return named(IROp::Uniform, name, type); }
+
+    // mask uses xyzw or rgba letters
+    IRValue swizzle(IRValue value, const char* mask) {
+        int source = componentCount(typeOf(value));
+        int indices[4];
+        int count = 0;
+        for (const char* c = mask; *c && count < 4; ++c) {
+            int index = swizzleIndex(*c);
+            if (index < 0 || index >= source) return value;  // Invalid mask - leave the value alone
+            indices[count++] = index;
+        }
+        if (count == 0) return value;
+
+        // Identity swizzle
+        if (count == source) {
+            bool identity = true;
+            for (int i = 0; i < count; ++i) identity = identity && indices[i] == i;
+            if (identity) return value;
+        }
+
+        const IRInstr& src = at(value);
+        if (src.op == IROp::Const) {
+            IRInstr instr;
+            instr.type = vectorType(count);
+            for (int i = 0; i < count; ++i) instr.constant[i] = src.constant[src.type == ShaderDataType::Float ? 0 : indices[i]];
+            return emit(instr);
+        }
+        if (src.op == IROp::Swizzle) {
+            // Compose with the inner mask
+            const std::string& inner = m_module.str(src.aux);
+            IRValue base = src.operands[0];
+            char composed[5] = {};
+            for (int i = 0; i < count; ++i) composed[i] = inner[indices[i]];
+            return swizzle(base, composed);
+        }
+
+        char canonical[5] = {};
+        for (int i = 0; i < count; ++i) canonical[i] = "xyzw"[indices[i]];
+        IRInstr instr;
+        instr.op = IROp::Swizzle;
+        instr.type = vectorType(count);
+        instr.operands[0] = value;
+        instr.aux = intern(canonical);
+        return emit(instr);
+    }
+
+    IRValue add(IRValue a, IRValue b) { return binary(IROp::Add, a, b); }
+    IRValue sub(IRValue a, IRValue b) { return binary(IROp::Sub, a, b); }
+    IRValue mul(IRValue a, IRValue b) { return binary(IROp::Mul, a, b); }
+    IRValue div(IRValue a, IRValue b) { return binary(IROp::Div, a, b); }
+    IRValue min(IRValue a, IRValue b) { return binary(IROp::Min, a, b); }
+    IRValue max(IRValue a, IRValue b) { return binary(IROp::Max, a, b); }
+    IRValue pow(IRValue a, IRValue b) { return binary(IROp::Pow, a, b); }
+
+    IRValue dot(IRValue a, IRValue b) {
+        if (b < a) std::swap(a, b);
+        IRInstr instr;
+        instr.op = IROp::Dot;
+        instr.type = ShaderDataType::Float;
+        instr.operands[0] = a;
+        instr.operands[1] = b;
+        return emit(instr);
+    }
+
+    // Sin, Cos, Abs, Normalize
+    IRValue unary(IROp op, IRValue x) {
+        IRInstr instr;
+        instr.op = op;
+        instr.type = typeOf(x);
+        instr.operands[0] = x;
+        if (op != IROp::Normalize && isConst(x)) {
+            const IRInstr& c = at(x);
+            IRInstr folded;
+            folded.type = c.type;
+            for (int i = 0; i < componentCount(c.type); ++i) {
+                float v = c.constant[i];
+                folded.constant[i] = op == IROp::Sin ? std::sin(v) : op == IROp::Cos ? std::cos(v) : std::fabs(v);
+            }
+            if (isFinite(folded)) return emit(folded);
+        }
+        return emit(instr);
+    }
+
+    IRValue mix(IRValue a, IRValue b, IRValue t) {
+        ShaderDataType type = widerType(typeOf(a), typeOf(b));
+        if (a == b) return a;
+        if (isConst(t) && typeOf(t) == ShaderDataType::Float) {
+            float tv = at(t).constant[0];
+            if (tv == 0.0f && typeOf(a) == type) return a;
+            if (tv == 1.0f && typeOf(b) == type) return b;
+        }
+        if (isConst(a) && isConst(b) && isConst(t)) {
+            // mix(a, b, t) = a * (1 - t) + b * t
+            IRInstr folded;
+            folded.type = widerType(type, typeOf(t));
+            for (int i = 0; i < componentCount(folded.type); ++i) {
+                float av = lane(a, i), bv = lane(b, i), tv = lane(t, i);
+                folded.constant[i] = av * (1.0f - tv) + bv * tv;
+            }
+            if (isFinite(folded)) return emit(folded);
+        }
+        IRInstr instr;
+        instr.op = IROp::Mix;
+        instr.type = type;
+        instr.operands[0] = a;
+        instr.operands[1] = b;
+        instr.operands[2] = t;
+        return emit(instr);
+    }
+
+    IRValue clamp(IRValue x, IRValue lo, IRValue hi) {
+        if (isConst(x) && isConst(lo) && isConst(hi)) {
+            // clamp(x, lo, hi) = min(max(x, lo), hi)
+            IRInstr folded;
+            folded.type = typeOf(x);
+            for (int i = 0; i < componentCount(folded.type); ++i) {
+                folded.constant[i] = std::min(std::max(lane(x, i), lane(lo, i)), lane(hi, i));
+            }
+            if (isFinite(folded)) return emit(folded);
+        }
+        IRInstr instr;
+        instr.op = IROp::Clamp;
+        instr.type = typeOf(x);
+        instr.operands[0] = x;
+        instr.operands[1] = lo;
+        instr.operands[2] = hi;
+        return emit(instr);
+    }
+
+    IRValue makeVec3(IRValue x, IRValue y, IRValue z) {
+        if (isConst(x) && isConst(y) && isConst(z) &&
+            typeOf(x) == ShaderDataType::Float && typeOf(y) == ShaderDataType::Float && typeOf(z) == ShaderDataType::Float) {
+            return constant(at(x).constant[0], at(y).constant[0], at(z).constant[0]);
+        }
+        IRInstr instr;
+        instr.op = IROp::MakeVec3;
+        instr.type = ShaderDataType::Vec3;
+        instr.operands[0] = x;
+        instr.operands[1] = y;
+        instr.operands[2] = z;
+        return emit(instr);
+    }
+
+    IRValue texture(const std::string& sampler, IRValue uv) {
+        IRInstr instr;
+        instr.op = IROp::Texture;
+        instr.type = ShaderDataType::Vec4;
+        instr.operands[0] = uv;
+        instr.aux = intern(sampler);
+        return emit(instr);
+    }
+
+    // Node recorded as the origin of instructions created from now on (cost attribution).
+    // nodeId identifies the same node across rebuilds, while origins may be positions
+    // that shift when nodes are inserted; it defaults to the origin.
+    void setOrigin(int32_t origin) { setOrigin(origin, origin); }
+    void setOrigin(int32_t origin, int32_t nodeId) {
+        m_origin = origin;
+        m_nodeId = nodeId;
+    }
+
+    // Precision requested for instructions created from now on (the node's override).
+    // Instructions shared by nodes that disagree fall back to Default, or Full when
+    // either asked for it.
+    void setPrecision(ShaderPrecision precision) { m_precision = precision; }
+
+    // Keywords enabled for the variant being lowered (sorted). Without a set, every
+    // static switch takes its own default.
+    void setKeywords(const std::vector<std::string>* keywords) { m_keywords = keywords; }
+    bool keywordEnabled(const std::string& keyword, bool fallback) const {
+        if (!m_keywords) return fallback;
+        return std::binary_search(m_keywords->begin(), m_keywords->end(), keyword);
+    }
+
+    void setOutput(IRValue color, IRValue alpha) {
+        m_module.color = color;
+        m_module.alpha = alpha;
+    }
+
+    const IRInstr& at(IRValue value) const { return m_module.at(value); }
+    ShaderDataType typeOf(IRValue value) const { return at(value).type; }
+    bool isConst(IRValue value) const { return at(value).op == IROp::Const; }
+
+private:
+    // Hash-consing key: everything that identifies an instruction
+    struct InstrKey {
+        IRInstr instr;
+        bool operator==(const InstrKey& other) const {
+            const IRInstr& a = instr;
+            const IRInstr& b = other.instr;
+            return a.op == b.op && a.type == b.type && a.aux == b.aux &&
+                   a.operands[0] == b.operands[0] && a.operands[1] == b.operands[1] && a.operands[2] == b.operands[2] &&
+                   std::memcmp(a.constant, b.constant, sizeof(a.constant)) == 0;
+        }
+    };
+
+    struct InstrKeyHash {
+        size_t operator()(const InstrKey& key) const {
+            const IRInstr& i = key.instr;
+            uint64_t h = 1469598103934665603ull;
+            auto mix = [&h](uint64_t v) { h = (h ^ v) * 1099511628211ull; };
+            mix(static_cast<uint64_t>(i.op));
+            mix(static_cast<uint64_t>(i.type));
+            mix(i.aux);
+            for (IRValue operand : i.operands) mix(static_cast<uint32_t>(operand));
+            for (float c : i.constant) {
+                uint32_t bits;
+                std::memcpy(&bits, &c, sizeof(bits));
+                mix(bits);
+            }
+            return static_cast<size_t>(h);
+        }
+    };
+
+    static int swizzleIndex(char c) {
+        switch (c) {
+            case 'x': case 'r': return 0;
+            case 'y': case 'g': return 1;
+            case 'z': case 'b': return 2;
+            case 'w': case 'a': return 3;
+        }
+        return -1;
+    }
+
+    static ShaderDataType widerType(ShaderDataType a, ShaderDataType b) {
+        return componentCount(a) >= componentCount(b) ? a : b;
+    }
+
+    static bool isFinite(const IRInstr& instr) {
+        for (int i = 0; i < componentCount(instr.type); ++i) {
+            if (!std::isfinite(instr.constant[i])) return false;
+        }
+        return true;
+    }
+
+    // Component i of a constant with scalar broadcast
+    float lane(IRValue value, int i) const {
+        const IRInstr& c = at(value);
+        return c.type == ShaderDataType::Float ? c.constant[0] : c.constant[i];
+    }
+
+    bool isScalarConst(IRValue value, float x) const {
+        const IRInstr& c = at(value);
+        return c.op == IROp::Const && c.type == ShaderDataType::Float && c.constant[0] == x;
+    }
+
+    IRValue named(IROp op, const std::string& name, ShaderDataType type) {
+        IRInstr instr;
+        instr.op = op;
+        instr.type = type;
+        instr.aux = intern(name);
+        return emit(instr);
+    }
+
+    // Arithmetic and min/max/pow with folding, identities and commutative canonicalization
+    IRValue binary(IROp op, IRValue a, IRValue b) {
+        bool commutative = op == IROp::Add || op == IROp::Mul || op == IROp::Min || op == IROp::Max;
+        if (commutative && b < a) std::swap(a, b);
+        ShaderDataType type = widerType(typeOf(a), typeOf(b));
+
+        if (isConst(a) && isConst(b)) {
+            IRInstr folded;
+            folded.type = type;
+            for (int i = 0; i < componentCount(type); ++i) {
+                float x = lane(a, i), y = lane(b, i);
+                switch (op) {
+                    case IROp::Add: folded.constant[i] = x + y; break;
+                    case IROp::Sub: folded.constant[i] = x - y; break;
+                    case IROp::Mul: folded.constant[i] = x * y; break;
+                    case IROp::Div: folded.constant[i] = x / y; break;
+                    case IROp::Min: folded.constant[i] = std::min(x, y); break;
+                    case IROp::Max: folded.constant[i] = std::max(x, y); break;
+                    default: folded.constant[i] = std::pow(x, y); break;
+                }
+            }
+            if (isFinite(folded)) return emit(folded);
+        }
+
+        // Identities, only where the surviving operand already has the result type
+        auto keeps = [&](IRValue v) { return typeOf(v) == type; };
+        switch (op) {
+            case IROp::Add:
+                if (isScalarConst(a, 0.0f) && keeps(b)) return b;
+                if (isScalarConst(b, 0.0f) && keeps(a)) return a;
+                break;
+            case IROp::Sub:
+                if (isScalarConst(b, 0.0f) && keeps(a)) return a;
+                break;
+            case IROp::Mul:
+                if (isScalarConst(a, 1.0f) && keeps(b)) return b;
+                if (isScalarConst(b, 1.0f) && keeps(a)) return a;
+                break;
+            case IROp::Div:
+            case IROp::Pow:
+                if (isScalarConst(b, 1.0f) && keeps(a)) return a;
+                break;
+            default:
+                break;
+        }
+
+        IRInstr instr;
+        instr.op = op;
+        instr.type = type;
+        instr.operands[0] = a;
+        instr.operands[1] = b;
+        return emit(instr);
+    }
+
+    IRValue emit(const IRInstr& instr) {
+        InstrKey key{instr};
+        auto it = m_cse.find(key);
+        if (it != m_cse.end()) {
+            ShaderPrecision& shared = m_module.instrs[static_cast<size_t>(it->second)].precision;
+            if (shared != m_precision) {
+                shared = shared == ShaderPrecision::Full || m_precision == ShaderPrecision::Full ? ShaderPrecision::Full
+                                                                                              : ShaderPrecision::Default;
+            }
+            return it->second;
+        }
+        IRValue value = static_cast<IRValue>(m_module.instrs.size());
+        m_module.instrs.push_back(instr);
+        m_module.instrs.back().precision = m_precision;
+        m_module.origins.push_back(m_origin);
+        m_module.nodeIds.push_back(m_nodeId);
+        m_cse.emplace(key, value);
+        return value;
+    }
+
+    uint32_t intern(const std::string& text) {
+        auto it = m_strings.find(text);
+        if (it != m_strings.end()) return it->second;
+        uint32_t index = static_cast<uint32_t>(m_module.strings.size());
+        m_module.strings.push_back(text);
+        m_strings.emplace(text, index);
+        return index;
+    }
+
+    IRModule& m_module;
+    int32_t m_origin = -1;
+    int32_t m_nodeId = -1;
+    ShaderPrecision m_precision = ShaderPrecision::Default;
+    const std::vector<std::string>* m_keywords = nullptr;
+    std::unordered_map<InstrKey, IRValue, InstrKeyHash> m_cse;
+    std::unordered_map<std::string, uint32_t> m_strings;
+};
+
+// ============================================================================
+// IR EMITTER - Prints the live part of a module as GLSL or HLSL statements
+// ============================================================================
+class IREmitter {
+public:
+    enum class Language { GLSL, HLSL };
+
+    explicit IREmitter(Language language) : m_language(language) {}
+
+    // Declare the values marked in half (parallel to the module's instructions, see
+    // resolvePrecision) at reduced precision: mediump in GLSL, min16float in HLSL, or
+    // HLSL's native 16-bit half with nativeHalf. Null declares everything at full.
+    void setHalfPrecision(const std::vector<uint8_t>* half, bool nativeHalf = false) {
+        m_half = half;
+        m_nativeHalf = nativeHalf;
+    }
+
+    const char* typeName(ShaderDataType type) const {
+        bool hlsl = m_language == Language::HLSL;
+        switch (type) {
+            case ShaderDataType::Float: return "float";
+            case ShaderDataType::Vec2: return hlsl ? "float2" : "vec2";
+            case ShaderDataType::Vec3: return hlsl ? "float3" : "vec3";
+            case ShaderDataType::Vec4: return hlsl ? "float4" : "vec4";
+            case ShaderDataType::Sampler2D: return hlsl ? "Texture2D" : "sampler2D";
+        }
+        return "float";
+    }
+
+    // Type of a reduced-precision declaration
+    const char* halfTypeName(ShaderDataType type) const {
+        static const char* const glsl[] = {"mediump float", "mediump vec2", "mediump vec3", "mediump vec4"};
+        static const char* const min16[] = {"min16float", "min16float2", "min16float3", "min16float4"};
+        static const char* const native[] = {"half", "half2", "half3", "half4"};
+        const int index = std::max(1, std::min(componentCount(type), 4)) - 1;
+        if (m_language == Language::GLSL) return glsl[index];
+        return m_nativeHalf ? native[index] : min16[index];
+    }
+
+    // Statements for the body of main() / PSMain(), ending with the color output
+    std::string emitBody(const IRModule& module) {
+        CodeWriter out;
+        emitBody(module, out);
+        return out.str();
+    }
+
+    // The same, appended to out. Every live instruction's text is cached on this emitter
+    // by what it is printed from (the instruction, its operands' text, its variable and
+    // declared type), so re-emitting after an edit only formats the values whose text
+    // changes; the rest is copied. Variables are named after the node that created them
+    // (v<nodeId>_<n>, or v<n> without an id), so an inserted node doesn't rename the
+    // values after it. Keep one emitter per generator to benefit.
+    void emitBody(const IRModule& module, CodeWriter& out) {
+        if (module.color == IRNone || module.alpha == IRNone) {
+            out << (m_language == Language::HLSL ? "    return float4(1.0, 0.0, 1.0, 1.0); // Error: No output\n"
+                                                 : "    FragColor = vec4(1.0, 0.0, 1.0, 1.0); // Error: No output\n");
+            return;
+        }
+
+        // Fragments of modules long gone are dropped once they outweigh the current ones
+        if (m_fragments.size() > (uint64_t(1) << 20) || m_fragmentText.size() > 8 * m_lastBodySize + (64u << 10)) {
+            m_fragments.clear();
+            m_fragmentText.clear();
+        }
+
+        const size_t count = module.instrs.size();
+        markLive(module, m_live);
+        const uint32_t bodyStart = out.mark();
+
+        // Every computed value gets a variable; names, literals and swizzles are inlined
+        m_names.clear();
+        m_nameSpans.assign(count, CodeSpan());
+        m_nodeVars.clear();
+        int varCounter = 0;
+        for (size_t i = 0; i < count; ++i) {
+            if (!m_live[i]) continue;
+            const IRInstr& instr = module.instrs[i];
+            const bool inlined = isInline(instr.op);
+            const bool half = m_half && i < m_half->size() && (*m_half)[i] && instr.type != ShaderDataType::Sampler2D;
+
+            CodeSpan variable;
+            if (!inlined) {
+                const int32_t nodeId = i < module.nodeIds.size() ? module.nodeIds[i] : -1;
+                const uint32_t nameStart = m_names.mark();
+                m_names << 'v';
+                if (nodeId >= 0) {
+                    m_names.appendInt(nodeId);
+                    m_names << '_';
+                    m_names.appendInt(m_nodeVars[nodeId]++);
+                } else {
+                    m_names.appendInt(m_nodeVars[-1]++);
+                }
+                variable = m_names.spanFrom(nameStart);
+                varCounter++;
+            }
+
+            const uint64_t key = fragmentKey(module, instr, half, m_names.text(variable));
+            auto cached = m_fragments.find(key);
+            CodeSpan fragment;
+            if (cached != m_fragments.end()) {
+                fragment = cached->second;
+                m_stats.hits++;
+            } else {
+                const uint32_t start = m_fragmentText.mark();
+                if (inlined) {
+                    writeExpression(module, instr, m_fragmentText);
+                } else {
+                    m_fragmentText << "    " << (half ? halfTypeName(instr.type) : typeName(instr.type)) << ' '
+                                   << m_names.text(variable) << " = ";
+                    writeExpression(module, instr, m_fragmentText);
+                    m_fragmentText << ";\n";
+                }
+                fragment = m_fragmentText.spanFrom(start);
+                m_fragments.emplace(key, fragment);
+                m_stats.misses++;
+            }
+
+            if (inlined) {
+                const uint32_t nameStart = m_names.mark();
+                m_names.append(m_fragmentText.text(fragment));
+                m_nameSpans[i] = m_names.spanFrom(nameStart);
+            } else {
+                out.append(m_fragmentText.text(fragment));
+                m_nameSpans[i] = variable;
+            }
+        }
+
+        // Add spacing before final output if we generated variables
+        if (varCounter > 0) out << '\n';
+
+        out << "    " << typeName(ShaderDataType::Vec3) << " finalColor = " << name(module.color) << ";\n";
+        out << "    float finalAlpha = " << name(module.alpha) << ";\n";
+        out << (m_language == Language::HLSL ? "    return float4(finalColor, finalAlpha);\n"
+                                             : "    FragColor = vec4(finalColor, finalAlpha);\n");
+        m_lastBodySize = out.size() - bodyStart;
+    }
+
+    struct CacheStats {
+        size_t hits = 0;        // Instructions copied from an earlier call
+        size_t misses = 0;      // Instructions formatted
+    };
+    const CacheStats& getCacheStats() const { return m_stats; }
+
+private:
+    static bool isInline(IROp op) {
+        return op == IROp::Const || op == IROp::Input || op == IROp::Uniform || op == IROp::Swizzle;
+    }
+
+    std::string_view name(IRValue value) const { return m_names.text(m_nameSpans[value]); }
+
+    // Everything the text of an instruction depends on
+    uint64_t fragmentKey(const IRModule& module, const IRInstr& instr, bool half, std::string_view variable) const {
+        Fnv1a64 hash;
+        // Reduced precision is spelled differently with native half
+        const uint8_t precision = !half ? 0 : m_nativeHalf ? 2 : 1;
+        const uint8_t header[3] = {static_cast<uint8_t>(instr.op), static_cast<uint8_t>(instr.type), precision};
+        auto update = [&hash](std::string_view text) {
+            const uint64_t length = text.size();
+            hash.update(text.data(), text.size());
+            hash.update(&length, sizeof(length));
+        };
+        hash.update(header, sizeof(header));
+        update(variable);
+        if (instr.op == IROp::Const) {
+            hash.update(instr.constant, sizeof(float) * static_cast<size_t>(std::max(componentCount(instr.type), 1)));
+        } else if (instr.op == IROp::Input || instr.op == IROp::Uniform || instr.op == IROp::Swizzle ||
+                   instr.op == IROp::Texture) {
+            hash.update(module.str(instr.aux));
+        }
+        for (IRValue operand : instr.operands) {
+            if (operand != IRNone) update(name(operand));
+        }
+        return hash.value();
+    }
+
+    void writeLiteral(const IRInstr& instr, CodeWriter& out) const {
+        int components = componentCount(instr.type);
+        if (components == 1) {
+            out.appendFloat(instr.constant[0]);
+            return;
+        }
+
+        bool uniform = true;
+        for (int i = 1; i < components; ++i) uniform = uniform && instr.constant[i] == instr.constant[0];
+        out << typeName(instr.type) << '(';
+        // GLSL vector constructors broadcast a single scalar; HLSL needs every component
+        int printed = uniform && m_language == Language::GLSL ? 1 : components;
+        for (int i = 0; i < printed; ++i) {
+            if (i > 0) out << ", ";
+            out.appendFloat(instr.constant[i]);
+        }
+        out << ')';
+    }
+
+    void writeExpression(const IRModule& module, const IRInstr& instr, CodeWriter& out) const {
+        auto arg = [&](int i) { return name(instr.operands[i]); };
+        auto call = [&](const char* fn, int argc) {
+            out << fn << '(';
+            for (int i = 0; i < argc; ++i) {
+                if (i > 0) out << ", ";
+                out << arg(i);
+            }
+            out << ')';
+        };
+        auto binary = [&](const char* op) { out << '(' << arg(0) << op << arg(1) << ')'; };
+        bool hlsl = m_language == Language::HLSL;
+
+        switch (instr.op) {
+            case IROp::Const: writeLiteral(instr, out); return;
+            case IROp::Input:
+            case IROp::Uniform: out << module.str(instr.aux); return;
+            case IROp::Swizzle: {
+                const std::string_view base = arg(0);
+                bool simple = std::all_of(base.begin(), base.end(), [](char c) {
+                    return std::isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '.';
+                });
+                if (simple) out << base;
+                else out << '(' << base << ')';
+                out << '.' << module.str(instr.aux);
+                return;
+            }
+            case IROp::Add: binary(" + "); return;
+            case IROp::Sub: binary(" - "); return;
+            case IROp::Mul: binary(" * "); return;
+            case IROp::Div: binary(" / "); return;
+            case IROp::Sin: call("sin", 1); return;
+            case IROp::Cos: call("cos", 1); return;
+            case IROp::Abs: call("abs", 1); return;
+            case IROp::Normalize: call("normalize", 1); return;
+            case IROp::Min: call("min", 2); return;
+            case IROp::Max: call("max", 2); return;
+            case IROp::Pow: call("pow", 2); return;
+            case IROp::Dot: call("dot", 2); return;
+            case IROp::Mix: call(hlsl ? "lerp" : "mix", 3); return;
+            case IROp::Clamp: call("clamp", 3); return;
+            case IROp::MakeVec3: call(hlsl ? "float3" : "vec3", 3); return;
+            case IROp::Texture: {
+                const std::string& sampler = module.str(instr.aux);
+                if (hlsl) out << sampler << ".Sample(" << sampler << "_sampler, " << arg(0) << ')';
+                else out << "texture(" << sampler << ", " << arg(0) << ')';
+                return;
+            }
+        }
+        out << "0.0";
+    }
+
+    Language m_language;
+    const std::vector<uint8_t>* m_half = nullptr;
+    bool m_nativeHalf = false;
+
+    // Scratch of the current call: the text each live value is referred to by
+    std::vector<bool> m_live;
+    CodeWriter m_names;
+    std::vector<CodeSpan> m_nameSpans;
+    std::unordered_map<int32_t, int> m_nodeVars;    // Variables named so far per node id
+
+    // Fragments kept between calls, by fragmentKey
+    CodeWriter m_fragmentText;
+    std::unordered_map<uint64_t, CodeSpan> m_fragments;
+    size_t m_lastBodySize = 0;
+    CacheStats m_stats;
+};
+
+} // namespace ShaderGraph
+
+#endif // SHADER_IR_H
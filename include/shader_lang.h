@@ -5,8 +5,12 @@
 #include <sstream>
 #include <unordered_map>
 #include <vector>
-#include <regex>
+#include <string_view>
+#include <cctype>
 #include <algorithm>
+#include "shader_ir.h"
+#include "shader_precision.h"
+#include "uniform_reflection.h"
 
 namespace ShaderGraph {
 
@@ -112,36 +116,71 @@ public:
     static std::string Refract() { return "refract"; }
 };
 
+// Single-pass identifier scanning shared by the language converters. Identifiers are
+// maximal [A-Za-z0-9_] runs - the same boundaries std::regex "\b" used - so a rename
+// table lookup per token replaces one regex pass per table entry.
+class IdentifierScanner {
+public:
+    using RenameTable = std::unordered_map<std::string_view, std::string_view>;
+    
+    static bool isIdentChar(char c) {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+    }
+    
+    // Length of the identifier starting at pos (0 if none)
+    static size_t identLength(std::string_view src, size_t pos) {
+        size_t end = pos;
+        while (end < src.size() && isIdentChar(src[end])) ++end;
+        return end - pos;
+    }
+    
+    static size_t skipSpace(std::string_view src, size_t pos) {
+        while (pos < src.size() && std::isspace(static_cast<unsigned char>(src[pos]))) ++pos;
+        return pos;
+    }
+    
+    // Index of the ')' matching the '(' at open, or npos when unbalanced
+    static size_t matchParen(std::string_view src, size_t open) {
+        int depth = 0;
+        for (size_t i = open; i < src.size(); ++i) {
+            if (src[i] == '(') depth++;
+            else if (src[i] == ')' && --depth == 0) return i;
+        }
+        return std::string_view::npos;
+    }
+    
+    static std::string_view trim(std::string_view text) {
+        size_t begin = skipSpace(text, 0);
+        size_t end = text.size();
+        while (end > begin && std::isspace(static_cast<unsigned char>(text[end - 1]))) --end;
+        return text.substr(begin, end - begin);
+    }
+    
+    static void trimTrailingSpace(std::string& out) {
+        while (!out.empty() && std::isspace(static_cast<unsigned char>(out.back()))) out.pop_back();
+    }
+    
+    static std::string_view rename(const RenameTable& table, std::string_view token) {
+        auto it = table.find(token);
+        return it != table.end() ? it->second : token;
+    }
+};
+
 // HLSL to GLSL converter
 class HLSLtoGLSLConverter {
 public:
     static std::string convert(const std::string& hlslCode) {
-        std::string result = hlslCode;
-        
-        // Convert types
-        result = convertTypes(result);
-        
-        // Convert functions
-        result = convertFunctions(result);
-        
-        // Convert semantics and structure
-        result = convertSemantics(result);
-        
-        // Convert texture sampling
-        result = convertTextureSampling(result);
-        
-        // Convert swizzle patterns (if needed)
-        result = convertSwizzle(result);
-        
+        std::string result;
+        result.reserve(hlslCode.size() + hlslCode.size() / 8);
+        convertInto(hlslCode, result);
         return result;
     }
     
 private:
-    static std::string convertTypes(const std::string& code) {
-        std::string result = code;
-        
-        // Type conversions (order matters - longer names first)
-        static const std::vector<std::pair<std::string, std::string>> typeMap = {
+    // Type and function renames (types first in the old pass order; no entry maps onto another key)
+    static const IdentifierScanner::RenameTable& renames() {
+        static const IdentifierScanner::RenameTable table = {
+            // Types
             {"float4x4", "mat4"},
             {"float3x3", "mat3"},
             {"float2x2", "mat2"},
@@ -161,20 +200,7 @@ private:
             {"bool4", "bvec4"},
             {"bool3", "bvec3"},
             {"bool2", "bvec2"},
-        };
-        
-        for (const auto& [hlsl, glsl] : typeMap) {
-            result = replaceWord(result, hlsl, glsl);
-        }
-        
-        return result;
-    }
-    
-    static std::string convertFunctions(const std::string& code) {
-        std::string result = code;
-        
-        // Function conversions
-        static const std::vector<std::pair<std::string, std::string>> funcMap = {
+            // Functions
             {"lerp", "mix"},
             {"frac", "fract"},
             {"ddx", "dFdx"},
@@ -189,60 +215,71 @@ private:
             {"clip", "discard"},  // Special handling needed
             {"mul", "matrixCompMult"},  // Simplified - actual mul needs special handling
         };
-        
-        for (const auto& [hlsl, glsl] : funcMap) {
-            result = replaceWord(result, hlsl, glsl);
-        }
-        
-        // Handle saturate -> clamp(x, 0.0, 1.0)
-        result = convertSaturate(result);
-        
-        return result;
-    }
-    
-    static std::string convertSaturate(const std::string& code) {
-        std::string result = code;
-        std::regex saturateRegex(R"(saturate\s*\(\s*([^)]+)\s*\))");
-        result = std::regex_replace(result, saturateRegex, "clamp($1, 0.0, 1.0)");
-        return result;
-    }
-    
-    static std::string convertSemantics(const std::string& code) {
-        std::string result = code;
-        
-        // Remove HLSL semantics like : POSITION, : TEXCOORD0, : SV_Target, etc.
-        // This is a simplified version - full conversion needs more context
-        std::regex semanticRegex(R"(\s*:\s*(SV_\w+|POSITION\d*|TEXCOORD\d*|NORMAL\d*|COLOR\d*|TANGENT\d*|BINORMAL\d*))");
-        result = std::regex_replace(result, semanticRegex, "");
-        
-        return result;
-    }
-    
-    static std::string convertTextureSampling(const std::string& code) {
-        std::string result = code;
-        
-        // tex2D(sampler, uv) -> texture(sampler, uv)
-        std::regex tex2DRegex(R"(tex2D\s*\()");
-        result = std::regex_replace(result, tex2DRegex, "texture(");
-        
-        // Sample(sampler, uv) -> texture(sampler, uv) for Texture2D
-        // This is simplified - full conversion needs texture/sampler pairs
-        
-        return result;
+        return table;
     }
     
-    static std::string convertSwizzle(const std::string& code) {
-        // HLSL and GLSL use the same swizzle syntax (xyzw, rgba)
-        // No conversion needed for basic cases
-        return code;
-    }
-    
-    // Replace whole words only (not partial matches)
-    static std::string replaceWord(const std::string& text, const std::string& from, const std::string& to) {
-        std::string result = text;
-        std::regex wordRegex("\\b" + from + "\\b");
-        result = std::regex_replace(result, wordRegex, to);
-        return result;
+    // Semantics like POSITION, TEXCOORD0, SV_Target (HLSL-only, stripped with their ':')
+    static bool isSemantic(std::string_view token) {
+        if (token.size() > 3 && token.compare(0, 3, "SV_") == 0) return true;
+        static const std::string_view prefixes[] = {"POSITION", "TEXCOORD", "NORMAL", "COLOR", "TANGENT", "BINORMAL"};
+        for (std::string_view prefix : prefixes) {
+            if (token.compare(0, prefix.size(), prefix) != 0) continue;
+            std::string_view index = token.substr(prefix.size());
+            if (std::all_of(index.begin(), index.end(), [](char c) { return c >= '0' && c <= '9'; })) return true;
+        }
+        return false;
+    }
+    
+    static void convertInto(std::string_view src, std::string& out) {
+        const auto& table = renames();
+        size_t pos = 0;
+        while (pos < src.size()) {
+            char c = src[pos];
+            
+            // ": SEMANTIC" -> removed along with the whitespace before it
+            if (c == ':') {
+                size_t at = IdentifierScanner::skipSpace(src, pos + 1);
+                size_t length = IdentifierScanner::identLength(src, at);
+                if (length > 0 && isSemantic(src.substr(at, length))) {
+                    IdentifierScanner::trimTrailingSpace(out);
+                    pos = at + length;
+                    continue;
+                }
+            }
+            
+            size_t length = IdentifierScanner::identLength(src, pos);
+            if (length == 0) {
+                out += c;
+                pos++;
+                continue;
+            }
+            std::string_view token = src.substr(pos, length);
+            pos += length;
+            
+            if (token == "saturate" || token == "tex2D") {
+                size_t open = IdentifierScanner::skipSpace(src, pos);
+                size_t close = open < src.size() && src[open] == '(' ? IdentifierScanner::matchParen(src, open)
+                                                                       : std::string_view::npos;
+                if (close != std::string_view::npos) {
+                    std::string_view args = IdentifierScanner::trim(src.substr(open + 1, close - open - 1));
+                    if (token == "saturate") {
+                        // saturate(x) -> clamp(x, 0.0, 1.0)
+                        out += "clamp(";
+                        convertInto(args, out);
+                        out += ", 0.0, 1.0)";
+                    } else {
+                        // tex2D(sampler, uv) -> texture(sampler, uv)
+                        out += "texture(";
+                        convertInto(args, out);
+                        out += ')';
+                    }
+                    pos = close + 1;
+                    continue;
+                }
+            }
+            
+            out += IdentifierScanner::rename(table, token);
+        }
     }
 };
 
@@ -250,22 +287,8 @@ private:
 class GLSLtoHLSLConverter {
 public:
     static std::string convert(const std::string& glslCode) {
-        std::string result = glslCode;
-        
-        // Convert types
-        result = convertTypes(result);
-        
-        // Convert functions  
-        result = convertFunctions(result);
-        
-        return result;
-    }
-    
-private:
-    static std::string convertTypes(const std::string& code) {
-        std::string result = code;
-        
-        static const std::vector<std::pair<std::string, std::string>> typeMap = {
+        static const IdentifierScanner::RenameTable table = {
+            // Types
             {"mat4", "float4x4"},
             {"mat3", "float3x3"},
             {"mat2", "float2x2"},
@@ -281,19 +304,7 @@ private:
             {"bvec4", "bool4"},
             {"bvec3", "bool3"},
             {"bvec2", "bool2"},
-        };
-        
-        for (const auto& [glsl, hlsl] : typeMap) {
-            result = replaceWord(result, glsl, hlsl);
-        }
-        
-        return result;
-    }
-    
-    static std::string convertFunctions(const std::string& code) {
-        std::string result = code;
-        
-        static const std::vector<std::pair<std::string, std::string>> funcMap = {
+            // Functions
             {"mix", "lerp"},
             {"fract", "frac"},
             {"dFdx", "ddx"},
@@ -302,20 +313,19 @@ private:
             {"mod", "fmod"},
         };
         
-        for (const auto& [glsl, hlsl] : funcMap) {
-            result = replaceWord(result, glsl, hlsl);
+        std::string result;
+        result.reserve(glslCode.size() + glslCode.size() / 4);
+        std::string_view src = glslCode;
+        size_t pos = 0;
+        while (pos < src.size()) {
+            size_t length = IdentifierScanner::identLength(src, pos);
+            if (length == 0) {
+                result += src[pos++];
+                continue;
+            }
+            result += IdentifierScanner::rename(table, src.substr(pos, length));
+            pos += length;
         }
-        
-        // Handle clamp(x, 0.0, 1.0) -> saturate(x) where applicable
-        // This is optional optimization
-        
-        return result;
-    }
-    
-    static std::string replaceWord(const std::string& text, const std::string& from, const std::string& to) {
-        std::string result = text;
-        std::regex wordRegex("\\b" + from + "\\b");
-        result = std::regex_replace(result, wordRegex, to);
         return result;
     }
 };
@@ -385,10 +395,13 @@ public:
         ss << "// Generated HLSL Shader\n";
         ss << "// Shader Model 5.0\n\n";
         
-        // Constant buffer for uniforms
+        // Constant buffer for uniforms (same packing as the GLSL std140 PerFrame block)
         ss << "cbuffer PerFrame : register(b0)\n{\n";
-        ss << "    float time;\n";
+        ss << "    float4x4 model;\n";
+        ss << "    float4x4 view;\n";
+        ss << "    float4x4 projection;\n";
         ss << "    float3 lightPos;\n";
+        ss << "    float time;\n";
         ss << "    float3 viewPos;\n";
         ss << "    float3 lightColor;\n";
         ss << "    float3 objectColor;\n";
@@ -420,6 +433,161 @@ public:
         return ss.str();
     }
     
+    // Generate HLSL natively from the IR (no text conversion). Only parameters the live
+    // code reads are declared. Values the precision policy resolves to half are declared
+    // min16float, or half on targets with native 16-bit types (which then need SM 6.2
+    // and -enable-16bit-types).
+    std::string generateHLSL(const IRModule& module, const std::vector<UniformParameter>& parameters,
+                             const PrecisionPolicy& precision = PrecisionPolicy()) {
+        CodeWriter out;
+        IREmitter emitter(IREmitter::Language::HLSL);
+        writeHLSL(out, emitter, module, parameters, precision);
+        return out.str();
+    }
+    
+    // Append the HLSL shader to out. emitter (HLSL) keeps its fragment cache between
+    // calls, so a generator that reuses both only formats what changed.
+    void writeHLSL(CodeWriter& out, IREmitter& emitter, const IRModule& module,
+                   const std::vector<UniformParameter>& parameters, const PrecisionPolicy& precision = PrecisionPolicy()) {
+        std::vector<uint8_t> active;
+        activeParameters(module, parameters, active);
+        const std::vector<uint8_t> half = resolvePrecision(module, precision);
+        emitter.setHalfPrecision(&half, precision.nativeHalf());
+        
+        out << "// Generated HLSL Shader\n";
+        out << (precision.nativeHalf() ? "// Shader Model 6.2, 16-bit types\n\n" : "// Shader Model 5.0\n\n");
+        
+        // Constant buffer for uniforms (same packing as the GLSL std140 PerFrame block)
+        out << "cbuffer PerFrame : register(b0)\n{\n";
+        out << "    float4x4 model;\n";
+        out << "    float4x4 view;\n";
+        out << "    float4x4 projection;\n";
+        out << "    float3 lightPos;\n";
+        out << "    float time;\n";
+        out << "    float3 viewPos;\n";
+        out << "    float3 lightColor;\n";
+        out << "    float3 objectColor;\n";
+        out << "};\n\n";
+        
+        // User uniforms; textures get a register and a matching sampler state
+        bool hasMaterialValues = false;
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            if (active[i] && parameters[i].type != ShaderDataType::Sampler2D) hasMaterialValues = true;
+        }
+        if (hasMaterialValues) {
+            out << "cbuffer PerMaterial : register(b1)\n{\n";
+            for (size_t i = 0; i < parameters.size(); ++i) {
+                const UniformParameter& param = parameters[i];
+                if (!active[i] || param.type == ShaderDataType::Sampler2D) continue;
+                out << "    " << emitter.typeName(param.type) << " " << param.name << ";\n";
+            }
+            out << "};\n\n";
+        }
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            const UniformParameter& param = parameters[i];
+            if (!active[i] || param.type != ShaderDataType::Sampler2D) continue;
+            out << "Texture2D " << param.name << " : register(t" << param.textureUnit << ");\n";
+            out << "SamplerState " << param.name << "_sampler : register(s" << param.textureUnit << ");\n\n";
+        }
+        
+        // Input structure
+        out << "struct PSInput\n{\n";
+        out << "    float4 position : SV_POSITION;\n";
+        out << "    float3 fragPos : TEXCOORD0;\n";
+        out << "    float3 normal : NORMAL;\n";
+        out << "    float2 texCoord : TEXCOORD1;\n";
+        out << "};\n\n";
+        
+        // Pixel shader
+        out << "float4 PSMain(PSInput input) : SV_TARGET\n{\n";
+        out << "    float3 FragPos = input.fragPos;\n";
+        out << "    float3 Normal = input.normal;\n";
+        out << "    float2 TexCoord = input.texCoord;\n\n";
+        emitter.emitBody(module, out);
+        out << "}\n";
+        emitter.setHalfPrecision(nullptr);
+    }
+    
+    // Generate the GLSL 330 fragment shader natively from the IR. Only parameters the
+    // live code reads are declared. With useUniformBlock the built-ins come from the
+    // std140 PerFrame block instead of loose uniforms. With instancedParameters the user
+    // parameters (samplers aside) are read from the SweepParameters block at the slots of
+    // the current instance; slots follow the parameter list, unread ones included, so
+    // they match the sweep buffer. Pair it with the instanced vertex shader. Values the precision policy resolves to half are
+    // declared mediump; the mobile target emits GLSL ES 3.00 instead of 330.
+    std::string generateGLSL(const IRModule& module, const std::vector<UniformParameter>& parameters,
+                             bool useUniformBlock, bool instancedParameters = false,
+                             const PrecisionPolicy& precision = PrecisionPolicy()) {
+        CodeWriter out;
+        IREmitter emitter(IREmitter::Language::GLSL);
+        writeGLSL(out, emitter, module, parameters, useUniformBlock, instancedParameters, precision);
+        return out.str();
+    }
+    
+    // Append the GLSL shader to out, reusing emitter (GLSL) as writeHLSL does
+    void writeGLSL(CodeWriter& out, IREmitter& emitter, const IRModule& module,
+                   const std::vector<UniformParameter>& parameters, bool useUniformBlock,
+                   bool instancedParameters = false, const PrecisionPolicy& precision = PrecisionPolicy()) {
+        
+        // Shader header; ES has no default float precision in fragment shaders
+        out << (precision.glslES() ? "#version 300 es\nprecision highp float;\nprecision highp int;\n" : "#version 330 core\n");
+        out << R"(out vec4 FragColor;
+
+in vec3 FragPos;
+in vec3 Normal;
+in vec2 TexCoord;
+
+// Built-in uniforms
+)";
+        if (useUniformBlock) {
+            out << PerFrameBlockGLSL << "\n";
+        } else {
+            out << R"(uniform float time;
+uniform vec3 lightPos;
+uniform vec3 viewPos;
+uniform vec3 lightColor;
+uniform vec3 objectColor;
+
+)";
+        }
+        
+        // User parameter uniforms
+        const std::vector<uint8_t> half = resolvePrecision(module, precision);
+        emitter.setHalfPrecision(&half);
+        std::vector<uint8_t> active;
+        activeParameters(module, parameters, active);
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            const UniformParameter& param = parameters[i];
+            if (!active[i] || (instancedParameters && isSweepParameter(param))) continue;
+            out << "// User parameter: " << param.displayName << "\n";
+            out << "uniform " << emitter.typeName(param.type) << " " << param.name << ";\n";
+        }
+        const int slots = instancedParameters ? sweepSlotCount(parameters) : 0;
+        if (slots > 0) out << "\n// Per-instance user parameters\n" << SweepBlockGLSL << "flat in int SweepInstance;\n";
+        
+        out << "\nvoid main()\n{\n";
+        if (slots > 0) {
+            out << "    int sweepBase = SweepInstance * " << slots << ";\n";
+            int slot = 0;
+            for (size_t i = 0; i < parameters.size(); ++i) {
+                const UniformParameter& param = parameters[i];
+                if (!isSweepParameter(param)) continue;
+                if (!active[i]) {
+                    slot++;
+                    continue;
+                }
+                const char* swizzle = param.type == ShaderDataType::Float ? ".x" : param.type == ShaderDataType::Vec2 ? ".xy"
+                                    : param.type == ShaderDataType::Vec3 ? ".xyz" : "";
+                out << "    " << emitter.typeName(param.type) << " " << param.name << " = sweep[sweepBase + " << slot++
+                    << "]" << swizzle << ";   // " << param.displayName << "\n";
+            }
+            out << "\n";
+        }
+        emitter.emitBody(module, out);
+        out << "}\n";
+        emitter.setHalfPrecision(nullptr);
+    }
+    
     // Generate shader in GLSL (converted from HLSL or directly)
     std::string generateGLSL(const std::string& shaderBody,
                              const std::vector<std::pair<std::string, std::string>>& uniforms) {
@@ -2,77 +2,22 @@
 #define SHADER_NODES_H
 
 #include "ImNodeFlow.h"
+#include "shader_types.h"
+#include "shader_ir.h"
+#include "graph_desc.h"
+#include "parameter_registry.h"
 #include <string>
-#include <sstream>
-#include <iomanip>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <algorithm>
+#include <chrono>
 
 namespace ShaderGraph {
 
 // Forward declarations
 class ShaderNode;
 
-// Data type enumeration for shader variables
-enum class ShaderDataType {
-    Float,
-    Vec2,
-    Vec3,
-    Vec4,
-    Sampler2D
-};
-
-// Structure to hold uniform parameter info for CPU-controlled values
-struct UniformParameter {
-    std::string name;           // Uniform name in shader
-    std::string displayName;    // User-friendly display name
-    ShaderDataType type = ShaderDataType::Float;
-    float floatValue = 0.0f;    // For float uniforms
-    float vec3Value[3] = {0.0f, 0.0f, 0.0f};  // For vec3 uniforms
-    float minValue = 0.0f;      // Range for UI
-    float maxValue = 1.0f;
-    
-    UniformParameter() = default;
-    
-    // Float parameter constructor
-    static UniformParameter Float(const std::string& n, const std::string& display, float val, float minV = 0.0f, float maxV = 1.0f) {
-        UniformParameter p;
-        p.name = n;
-        p.displayName = display;
-        p.type = ShaderDataType::Float;
-        p.floatValue = val;
-        p.minValue = minV;
-        p.maxValue = maxV;
-        return p;
-    }
-    
-    // Vec3 parameter constructor
-    static UniformParameter Vec3(const std::string& n, const std::string& display, float r, float g, float b) {
-        UniformParameter p;
-        p.name = n;
-        p.displayName = display;
-        p.type = ShaderDataType::Vec3;
-        p.vec3Value[0] = r;
-        p.vec3Value[1] = g;
-        p.vec3Value[2] = b;
-        return p;
-    }
-    
-    // Sampler2D parameter constructor (for texture nodes)
-    static UniformParameter Sampler2D(const std::string& n, const std::string& display, int texUnit = 0) {
-        UniformParameter p;
-        p.name = n;
-        p.displayName = display;
-        p.type = ShaderDataType::Sampler2D;
-        p.textureUnit = texUnit;
-        return p;
-    }
-    
-    int textureUnit = 0;        // Texture unit for sampler2D uniforms
-};
-
 // Custom node styles with proper padding
 inline std::shared_ptr<ImFlow::NodeStyle> InputNodeStyle() {
     auto style = std::make_shared<ImFlow::NodeStyle>(IM_COL32(90,191,93,255), ImColor(233,241,244,255), 6.5f);
@@ -168,22 +113,200 @@ public:
     // Check if this node is a parameter node (generates uniforms)
     virtual bool isParameterNode() const { return false; }
     
+    // Report an edit that changes the generated shader (bumps the graph revision)
+    void markDirty() {
+        if (auto* handler = getHandler()) handler->markDirty();
+    }
+    
     // Get the uniform parameter info (for parameter nodes)
     virtual UniformParameter getUniformParameter() const { return UniformParameter(); }
     
     // Set the uniform parameter value (for parameter nodes)
     virtual void setUniformValue(const UniformParameter& param) {}
     
+    // Registry slot of a parameter node, bound by the editor when the node is added
+    void bindParameter(ParameterRegistry* registry, ParameterHandle handle) {
+        m_parameterRegistry = registry;
+        m_parameterHandle = handle;
+    }
+    ParameterHandle getParameterHandle() const { return m_parameterHandle; }
+    
     // Get the output data type for a specific pin
     virtual ShaderDataType getOutputType(const std::string& pinName) const {
         return ShaderDataType::Float;
     }
     
-    // Generate the expression for an output pin (used during traversal)
-    virtual std::string generateExpression(const std::string& pinName,
-                                           const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const {
-        return "0.0";
+    // Kind and values of this node, shared with headless generation (see graph_desc.h)
+    virtual NodeDesc describe() const = 0;
+    
+    // Restore the values of a description of the same kind (used when loading a graph)
+    virtual void applyDesc(const NodeDesc& desc) {}
+    
+    // Precision override for the values this node computes (see shader_precision.h)
+    void setPrecision(ShaderPrecision precision) {
+        if (precision == m_precision) return;
+        m_precision = precision;
+        markDirty();
+    }
+    ShaderPrecision getPrecision() const { return m_precision; }
+    
+    // How a baked UV-only subgraph rooted at this node is stored (see subgraph_bake.h);
+    // size 0 follows the editor's default
+    void setBakeSettings(BakeFormat format, uint16_t size) {
+        if (format == m_bakeFormat && size == m_bakeSize) return;
+        m_bakeFormat = format;
+        m_bakeSize = size;
+        markDirty();
+    }
+    BakeFormat getBakeFormat() const { return m_bakeFormat; }
+    uint16_t getBakeSize() const { return m_bakeSize; }
+    
+    // Lower this node into IR. in/out are parallel to getIns()/getOuts();
+    // unconnected inputs are IRNone
+    void lower(IRBuilder& ir, const IRValue* in, IRValue* out) const {
+        ir.setPrecision(m_precision);
+        if (isLiveConstant()) {
+            const UniformParameter& param = m_parameterRegistry->get(m_parameterHandle);
+            out[0] = ir.uniform(param.name, param.type);
+            return;
+        }
+        lowerNode(describe(), ir, in, out);
+    }
+    
+    // Live tweaking (see ShaderGraphEditor::setLiveTweak): while its value is dragged, a
+    // constant is emitted as a generated uniform and edits go through the registry, so
+    // they upload a value instead of recompiling. The editor folds it back into a
+    // literal once the edits settle.
+    void setLiveTweak(bool enabled) { m_liveTweak = enabled; }
+    bool isLiveConstant() const {
+        return !isParameterNode() && m_parameterRegistry && m_parameterHandle != InvalidParameterHandle;
+    }
+    bool isConstantEditActive() const { return m_constantEditActive; }
+    double getLastConstantEdit() const { return m_lastConstantEdit; }
+    
+    // Turn a live constant back into a literal (one more rebuild, constant folded)
+    void foldLiveConstant() {
+        if (!isLiveConstant()) return;
+        m_parameterRegistry->remove(m_parameterHandle);
+        m_parameterHandle = InvalidParameterHandle;
+        m_constantEditActive = false;
+        markDirty();
+    }
+    
+    // Seconds on a monotonic clock, for the live tweak settle delay
+    static double liveClock() {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+    
+    // Cost heat map tint: 0 is free, 1 the most expensive node of the graph;
+    // a negative heat restores the node's own style
+    void setCostHeat(float heat) {
+        if (heat < 0.0f) {
+            if (m_baseStyle) setStyle(std::move(m_baseStyle));
+            m_baseStyle.reset();
+            return;
+        }
+        if (!m_baseStyle) {
+            m_baseStyle = getStyle();
+            m_heatStyle = std::make_shared<ImFlow::NodeStyle>(*m_baseStyle);
+            setStyle(m_heatStyle);
+        }
+        heat = std::min(heat, 1.0f);
+        // Green -> yellow -> red
+        int r = static_cast<int>(255.0f * std::min(1.0f, heat * 2.0f));
+        int g = static_cast<int>(255.0f * std::min(1.0f, 2.0f - heat * 2.0f));
+        m_heatStyle->header_bg = IM_COL32(r * 3 / 4, g * 3 / 4, 40, 255);
+    }
+    
+    // Thumbnail of the first output, drawn below the pins. Size 0 hides it; until a
+    // texture is set the space is reserved so visibility can still be tested.
+    void setPreviewSize(float size) {
+        m_previewSize = getOuts().empty() ? 0.0f : size;
+        m_previewVisible = false;
+    }
+    void setPreview(ImTextureID texture, const ImVec2& uv0, const ImVec2& uv1) {
+        m_previewTexture = texture;
+        m_previewUV0 = uv0;
+        m_previewUV1 = uv1;
+    }
+    void clearPreview() { m_previewTexture = ImTextureID(); }
+    bool hasPreview() const { return m_previewSize > 0.0f; }
+    
+    // Whether the thumbnail was inside the canvas the last time the node was drawn
+    bool isPreviewVisible() const { return m_previewVisible; }
+    
+    void drawFooter() override {
+        if (m_previewSize <= 0.0f) return;
+        ImVec2 size(m_previewSize, m_previewSize);
+        if (m_previewTexture) ImGui::Image(m_previewTexture, size, m_previewUV0, m_previewUV1);
+        else ImGui::Dummy(size);
+        m_previewVisible = ImGui::IsItemVisible();
+    }
+    
+protected:
+    NodeDesc makeDesc(NodeKind kind) const {
+        NodeDesc desc;
+        desc.kind = kind;
+        desc.id = getUID();
+        desc.pos[0] = getPos().x;
+        desc.pos[1] = getPos().y;
+        desc.precision = m_precision;
+        desc.bakeFormat = m_bakeFormat;
+        desc.bakeSize = m_bakeSize;
+        return desc;
+    }
+    
+    // Copy a display name into a fixed widget buffer, truncating if needed
+    static void copyName(char* buffer, size_t size, const std::string& name) {
+        size_t length = std::min(size - 1, name.size());
+        name.copy(buffer, length);
+        buffer[length] = '\0';
+    }
+    
+    // Registry of the owning editor, null until the node is bound
+    ParameterRegistry* getParameterRegistry() const { return m_parameterRegistry; }
+    
+    // Push the full parameter description after a rename or range edit
+    void syncParameter() {
+        if (m_parameterRegistry) m_parameterRegistry->update(m_parameterHandle, getUniformParameter());
+    }
+    
+    // Uniform standing in for a constant node's value while it is live
+    virtual UniformParameter getLiveParameter() const { return UniformParameter(); }
+    
+    // Constant nodes call this right after their value widget with its return value.
+    // The first edit in live mode swaps the literal for a uniform (one rebuild); the
+    // ones after only update the uniform.
+    void constantEdited(bool changed) {
+        m_constantEditActive = ImGui::IsItemActive();
+        if (!changed) return;
+        m_lastConstantEdit = liveClock();
+        if (!m_liveTweak || !m_parameterRegistry) {
+            markDirty();
+        } else if (!isLiveConstant()) {
+            m_parameterHandle = m_parameterRegistry->add(this, getLiveParameter());
+            markDirty();
+        } else {
+            m_parameterRegistry->update(m_parameterHandle, getLiveParameter());
+        }
     }
+    
+private:
+    ParameterRegistry* m_parameterRegistry = nullptr;
+    ParameterHandle m_parameterHandle = InvalidParameterHandle;
+    bool m_liveTweak = false;
+    ShaderPrecision m_precision = ShaderPrecision::Default;
+    BakeFormat m_bakeFormat = BakeFormat::Default;
+    uint16_t m_bakeSize = 0;
+    bool m_constantEditActive = false;
+    double m_lastConstantEdit = 0.0;
+    std::shared_ptr<ImFlow::NodeStyle> m_baseStyle;   // Own style while the heat map is shown
+    std::shared_ptr<ImFlow::NodeStyle> m_heatStyle;
+    float m_previewSize = 0.0f;
+    bool m_previewVisible = false;
+    ImTextureID m_previewTexture = ImTextureID();
+    ImVec2 m_previewUV0;
+    ImVec2 m_previewUV1;
 };
 
 // ============================================================================
@@ -195,29 +318,35 @@ public:
         setTitle("Float");
         setStyle(MathNodeStyle());
         addOUT<ShaderCode>("Value", FloatPinStyle())->behaviour([this]() {
-            std::ostringstream ss;
-            ss << std::fixed << std::setprecision(3) << m_value;
-            return ShaderCode(ss.str());
+            return ShaderCode(formatFixed(m_value, 3));
         });
     }
 
     void draw() override {
         ImGui::SetNextItemWidth(80.f);
-        ImGui::DragFloat("##value", &m_value, 0.01f, -100.0f, 100.0f, "%.3f");
+        constantEdited(ImGui::DragFloat("##value", &m_value, 0.01f, -100.0f, 100.0f, "%.3f"));
     }
     
     bool isSourceNode() const override { return true; }
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::ostringstream ss;
-        ss << std::fixed << std::setprecision(3) << m_value;
-        return ss.str();
+    NodeDesc describe() const override {
+        NodeDesc desc = makeDesc(NodeKind::Float);
+        desc.value[0] = m_value;
+        return desc;
+    }
+    
+    void applyDesc(const NodeDesc& desc) override {
+        m_value = desc.value[0];
     }
     
     float getValue() const { return m_value; }
 
+protected:
+    UniformParameter getLiveParameter() const override {
+        return UniformParameter::Float("u_live_" + std::to_string(getUID()), "Float", m_value, -100.0f, 100.0f);
+    }
+
 private:
     float m_value = 0.0f;
 };
@@ -231,27 +360,34 @@ public:
         setTitle("Color");
         setStyle(VectorNodeStyle());
         addOUT<ShaderCode>("RGB", Vec3PinStyle())->behaviour([this]() {
-            std::ostringstream ss;
-            ss << std::fixed << std::setprecision(3);
-            ss << "vec3(" << m_color[0] << ", " << m_color[1] << ", " << m_color[2] << ")";
-            return ShaderCode(ss.str());
+            return ShaderCode("vec3(" + formatFixed(m_color[0], 3) + ", " + formatFixed(m_color[1], 3) + ", " +
+                              formatFixed(m_color[2], 3) + ")");
         });
     }
 
     void draw() override {
         ImGui::SetNextItemWidth(150.f);
-        ImGui::ColorEdit3("##color", m_color, ImGuiColorEditFlags_NoInputs);
+        constantEdited(ImGui::ColorEdit3("##color", m_color, ImGuiColorEditFlags_NoInputs));
     }
     
     bool isSourceNode() const override { return true; }
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Vec3; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::ostringstream ss;
-        ss << std::fixed << std::setprecision(3);
-        ss << "vec3(" << m_color[0] << ", " << m_color[1] << ", " << m_color[2] << ")";
-        return ss.str();
+    NodeDesc describe() const override {
+        NodeDesc desc = makeDesc(NodeKind::Color);
+        desc.value[0] = m_color[0];
+        desc.value[1] = m_color[1];
+        desc.value[2] = m_color[2];
+        return desc;
+    }
+    
+    void applyDesc(const NodeDesc& desc) override {
+        for (int i = 0; i < 3; ++i) m_color[i] = desc.value[i];
+    }
+
+protected:
+    UniformParameter getLiveParameter() const override {
+        return UniformParameter::Vec3("u_live_" + std::to_string(getUID()), "Color", m_color[0], m_color[1], m_color[2]);
     }
 
 private:
@@ -275,41 +411,48 @@ public:
 
     void draw() override {
         ImGui::SetNextItemWidth(100.f);
-        ImGui::InputText("##name", m_displayName, sizeof(m_displayName));
+        if (ImGui::InputText("##name", m_displayName, sizeof(m_displayName))) {
+            markDirty();
+            syncParameter();
+        }
         ImGui::SetNextItemWidth(80.f);
-        ImGui::DragFloat("##value", &m_value, 0.01f, m_min, m_max, "%.3f");
+        if (ImGui::DragFloat("##value", &m_value, 0.01f, m_min, m_max, "%.3f")) {
+            if (auto* registry = getParameterRegistry()) registry->setFloat(getParameterHandle(), m_value);
+        }
         ImGui::SetNextItemWidth(60.f);
-        ImGui::DragFloat("Min", &m_min, 0.1f, -100.0f, m_max - 0.1f);
+        bool rangeChanged = ImGui::DragFloat("Min", &m_min, 0.1f, -100.0f, m_max - 0.1f);
         ImGui::SetNextItemWidth(60.f);
-        ImGui::DragFloat("Max", &m_max, 0.1f, m_min + 0.1f, 100.0f);
+        rangeChanged |= ImGui::DragFloat("Max", &m_max, 0.1f, m_min + 0.1f, 100.0f);
+        if (rangeChanged) syncParameter();
     }
     
     bool isSourceNode() const override { return true; }
     bool isParameterNode() const override { return true; }
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        return getUniformName();
+    NodeDesc describe() const override {
+        NodeDesc desc = makeDesc(NodeKind::FloatParameter);
+        desc.value[0] = m_value;
+        desc.value[1] = m_min;
+        desc.value[2] = m_max;
+        desc.name = m_displayName;
+        return desc;
+    }
+    
+    void applyDesc(const NodeDesc& desc) override {
+        m_value = desc.value[0];
+        m_min = desc.value[1];
+        m_max = desc.value[2];
+        copyName(m_displayName, sizeof(m_displayName), desc.name);
+        syncParameter();
     }
     
     std::string getUniformName() const {
-        // Create a clean uniform name from display name or use default
-        std::string name = m_displayName;
-        if (name.empty()) name = "param";
-        // Replace spaces with underscores and remove special chars
-        std::string clean = "u_";
-        for (char c : name) {
-            if (std::isalnum(c)) clean += c;
-            else if (c == ' ') clean += '_';
-        }
-        clean += "_" + std::to_string(getUID());
-        return clean;
+        return parameterUniformName(m_displayName, "param", getUID());
     }
     
     UniformParameter getUniformParameter() const override {
-        return UniformParameter::Float(getUniformName(), m_displayName[0] ? m_displayName : "Float Parameter", 
-                               m_value, m_min, m_max);
+        return parameterOf(describe());
     }
     
     void setUniformValue(const UniformParameter& param) override {
@@ -317,7 +460,10 @@ public:
     }
     
     float getValue() const { return m_value; }
-    void setValue(float v) { m_value = v; }
+    void setValue(float v) {
+        m_value = v;
+        if (auto* registry = getParameterRegistry()) registry->setFloat(getParameterHandle(), m_value);
+    }
 
 private:
     char m_displayName[64] = "MyFloat";
@@ -351,9 +497,14 @@ public:
 
     void draw() override {
         ImGui::SetNextItemWidth(100.f);
-        ImGui::InputText("##name", m_displayName, sizeof(m_displayName));
+        if (ImGui::InputText("##name", m_displayName, sizeof(m_displayName))) {
+            markDirty();
+            syncParameter();
+        }
         ImGui::SetNextItemWidth(150.f);
-        ImGui::ColorEdit3("##color", m_value, ImGuiColorEditFlags_NoInputs);
+        if (ImGui::ColorEdit3("##color", m_value, ImGuiColorEditFlags_NoInputs)) {
+            if (auto* registry = getParameterRegistry()) registry->setVec3(getParameterHandle(), m_value);
+        }
     }
     
     bool isSourceNode() const override { return true; }
@@ -364,30 +515,27 @@ public:
         return ShaderDataType::Float;
     }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        if (pinName == "RGB") return getUniformName();
-        if (pinName == "R") return getUniformName() + ".r";
-        if (pinName == "G") return getUniformName() + ".g";
-        if (pinName == "B") return getUniformName() + ".b";
-        return getUniformName();
+    NodeDesc describe() const override {
+        NodeDesc desc = makeDesc(NodeKind::Vec3Parameter);
+        desc.value[0] = m_value[0];
+        desc.value[1] = m_value[1];
+        desc.value[2] = m_value[2];
+        desc.name = m_displayName;
+        return desc;
+    }
+    
+    void applyDesc(const NodeDesc& desc) override {
+        for (int i = 0; i < 3; ++i) m_value[i] = desc.value[i];
+        copyName(m_displayName, sizeof(m_displayName), desc.name);
+        syncParameter();
     }
     
     std::string getUniformName() const {
-        std::string name = m_displayName;
-        if (name.empty()) name = "color";
-        std::string clean = "u_";
-        for (char c : name) {
-            if (std::isalnum(c)) clean += c;
-            else if (c == ' ') clean += '_';
-        }
-        clean += "_" + std::to_string(getUID());
-        return clean;
+        return parameterUniformName(m_displayName, "color", getUID());
     }
     
     UniformParameter getUniformParameter() const override {
-        return UniformParameter::Vec3(getUniformName(), m_displayName[0] ? m_displayName : "Vec3 Parameter", 
-                              m_value[0], m_value[1], m_value[2]);
+        return parameterOf(describe());
     }
     
     void setUniformValue(const UniformParameter& param) override {
@@ -397,7 +545,10 @@ public:
     }
     
     const float* getValue() const { return m_value; }
-    void setValue(float r, float g, float b) { m_value[0] = r; m_value[1] = g; m_value[2] = b; }
+    void setValue(float r, float g, float b) {
+        m_value[0] = r; m_value[1] = g; m_value[2] = b;
+        if (auto* registry = getParameterRegistry()) registry->setVec3(getParameterHandle(), m_value);
+    }
 
 private:
     char m_displayName[64] = "MyColor";
@@ -424,9 +575,8 @@ public:
     bool isSourceNode() const override { return true; }
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        return "time";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Time);
     }
 };
 
@@ -463,13 +613,8 @@ public:
         return ShaderDataType::Float;
     }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        if (pinName == "XYZ") return "FragPos";
-        if (pinName == "X") return "FragPos.x";
-        if (pinName == "Y") return "FragPos.y";
-        if (pinName == "Z") return "FragPos.z";
-        return "FragPos";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Position);
     }
 };
 
@@ -493,9 +638,8 @@ public:
     bool isSourceNode() const override { return true; }
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Vec3; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        return "normalize(Normal)";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Normal);
     }
 };
 
@@ -529,42 +673,11 @@ public:
         return ShaderDataType::Float;
     }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        if (pinName == "UV") return "TexCoord";
-        if (pinName == "U") return "TexCoord.x";
-        if (pinName == "V") return "TexCoord.y";
-        return "TexCoord";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::TexCoord);
     }
 };
 
-// Helper function to get input variable from the varMap or default
-inline std::string getInputVar(const ImFlow::BaseNode* node, const std::string& pinName,
-                               const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap,
-                               const std::string& defaultVal) {
-    // Need to cast away const since ImNodeFlow doesn't have const methods
-    auto* mutableNode = const_cast<ImFlow::BaseNode*>(node);
-    auto* pin = mutableNode->inPin(pinName);
-    if (pin && pin->isConnected()) {
-        auto linkWeak = pin->getLink();
-        if (auto link = linkWeak.lock()) {
-            auto* leftPin = link->left();
-            if (leftPin && leftPin->getParent()) {
-                ImFlow::NodeUID srcNodeId = leftPin->getParent()->getUID();
-                std::string srcPinName = leftPin->getName();
-                auto nodeIt = varMap.find(srcNodeId);
-                if (nodeIt != varMap.end()) {
-                    auto pinIt = nodeIt->second.find(srcPinName);
-                    if (pinIt != nodeIt->second.end()) {
-                        return pinIt->second;
-                    }
-                }
-            }
-        }
-    }
-    return defaultVal;
-}
-
 // ============================================================================
 // ADD NODE - Adds two values
 // ============================================================================
@@ -588,11 +701,8 @@ public:
     
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string a = getInputVar(this, "A", varMap, "0.0");
-        std::string b = getInputVar(this, "B", varMap, "0.0");
-        return "(" + a + " + " + b + ")";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Add);
     }
 };
 
@@ -627,8 +737,7 @@ public:
         bool aIsVec3 = false, bIsVec3 = false;
         
         if (pinA && pinA->isConnected()) {
-            auto linkWeak = pinA->getLink();
-            if (auto link = linkWeak.lock()) {
+            if (auto* link = pinA->getLink()) {
                 auto* leftPin = link->left();
                 if (leftPin && leftPin->getParent()) {
                     ShaderNodeBase* srcNode = dynamic_cast<ShaderNodeBase*>(leftPin->getParent());
@@ -640,8 +749,7 @@ public:
         }
         
         if (pinB && pinB->isConnected()) {
-            auto linkWeak = pinB->getLink();
-            if (auto link = linkWeak.lock()) {
+            if (auto* link = pinB->getLink()) {
                 auto* leftPin = link->left();
                 if (leftPin && leftPin->getParent()) {
                     ShaderNodeBase* srcNode = dynamic_cast<ShaderNodeBase*>(leftPin->getParent());
@@ -657,11 +765,8 @@ public:
         return ShaderDataType::Float;
     }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string a = getInputVar(this, "A", varMap, "1.0");
-        std::string b = getInputVar(this, "B", varMap, "1.0");
-        return "(" + a + " * " + b + ")";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Multiply);
     }
 };
 
@@ -688,11 +793,8 @@ public:
     
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string a = getInputVar(this, "A", varMap, "0.0");
-        std::string b = getInputVar(this, "B", varMap, "0.0");
-        return "(" + a + " - " + b + ")";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Subtract);
     }
 };
 
@@ -719,11 +821,8 @@ public:
     
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string a = getInputVar(this, "A", varMap, "1.0");
-        std::string b = getInputVar(this, "B", varMap, "1.0");
-        return "(" + a + " / " + b + ")";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Divide);
     }
 };
 
@@ -748,10 +847,8 @@ public:
     
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string x = getInputVar(this, "X", varMap, "0.0");
-        return "sin(" + x + ")";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Sin);
     }
 };
 
@@ -776,10 +873,8 @@ public:
     
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string x = getInputVar(this, "X", varMap, "0.0");
-        return "cos(" + x + ")";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Cos);
     }
 };
 
@@ -804,10 +899,8 @@ public:
     
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string x = getInputVar(this, "X", varMap, "0.0");
-        return "abs(" + x + ")";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Abs);
     }
 };
 
@@ -836,12 +929,8 @@ public:
     
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string a = getInputVar(this, "A", varMap, "0.0");
-        std::string b = getInputVar(this, "B", varMap, "1.0");
-        std::string t = getInputVar(this, "T", varMap, "0.5");
-        return "mix(" + a + ", " + b + ", " + t + ")";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Mix);
     }
 };
 
@@ -856,29 +945,33 @@ public:
         addIN<ShaderCode>("X", ShaderCode("0.0"), ImFlow::ConnectionFilter::SameType(), FloatPinStyle());
         addOUT<ShaderCode>("Result", FloatPinStyle())->behaviour([this]() {
             auto x = getInVal<ShaderCode>("X");
-            std::ostringstream ss;
-            ss << std::fixed << std::setprecision(3);
-            ss << "clamp(" << x.code << ", " << m_min << ", " << m_max << ")";
-            return ShaderCode(ss.str());
+            return ShaderCode("clamp(" + x.code + ", " + formatFixed(m_min, 3) + ", " + formatFixed(m_max, 3) + ")");
         });
     }
 
     void draw() override {
         ImGui::SetNextItemWidth(60.f);
-        ImGui::DragFloat("Min", &m_min, 0.01f);
+        if (ImGui::DragFloat("Min", &m_min, 0.01f)) {
+            markDirty();
+        }
         ImGui::SetNextItemWidth(60.f);
-        ImGui::DragFloat("Max", &m_max, 0.01f);
+        if (ImGui::DragFloat("Max", &m_max, 0.01f)) {
+            markDirty();
+        }
     }
     
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string x = getInputVar(this, "X", varMap, "0.0");
-        std::ostringstream ss;
-        ss << std::fixed << std::setprecision(3);
-        ss << "clamp(" << x << ", " << m_min << ", " << m_max << ")";
-        return ss.str();
+    NodeDesc describe() const override {
+        NodeDesc desc = makeDesc(NodeKind::Clamp);
+        desc.value[0] = m_min;
+        desc.value[1] = m_max;
+        return desc;
+    }
+    
+    void applyDesc(const NodeDesc& desc) override {
+        m_min = desc.value[0];
+        m_max = desc.value[1];
     }
 
 private:
@@ -911,12 +1004,8 @@ public:
     
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Vec3; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string x = getInputVar(this, "X", varMap, "0.0");
-        std::string y = getInputVar(this, "Y", varMap, "0.0");
-        std::string z = getInputVar(this, "Z", varMap, "0.0");
-        return "vec3(" + x + ", " + y + ", " + z + ")";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::MakeVec3);
     }
 };
 
@@ -949,13 +1038,8 @@ public:
     
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string v = getInputVar(this, "Vec3", varMap, "vec3(0.0)");
-        if (pinName == "X") return "(" + v + ").x";
-        if (pinName == "Y") return "(" + v + ").y";
-        if (pinName == "Z") return "(" + v + ").z";
-        return "(" + v + ").x";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::SplitVec3);
     }
 };
 
@@ -980,10 +1064,8 @@ public:
     
     ShaderDataType getOutputType(const std::string& pinName) const override { return ShaderDataType::Float; }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string power = getInputVar(this, "Power", varMap, "2.0");
-        return "pow(1.0 - max(dot(normalize(Normal), normalize(viewPos - FragPos)), 0.0), " + power + ")";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Fresnel);
     }
 };
 
@@ -1028,11 +1110,20 @@ public:
 
     void draw() override {
         ImGui::SetNextItemWidth(100.f);
-        ImGui::InputText("##name", m_displayName, sizeof(m_displayName));
+        if (ImGui::InputText("##name", m_displayName, sizeof(m_displayName))) {
+            markDirty();
+            syncParameter();
+        }
         ImGui::Text("Unit: %d", m_textureUnit);
         ImGui::SetNextItemWidth(60.f);
         if (ImGui::DragInt("##unit", &m_textureUnit, 1.0f, 0, 15)) {
             m_textureUnit = std::max(0, std::min(15, m_textureUnit));
+            if (auto* registry = getParameterRegistry()) registry->setTextureUnit(getParameterHandle(), m_textureUnit);
+        }
+        // Image file (.tga, .ppm, .dds, .ktx2); only the binding changes with it, not the shader
+        ImGui::SetNextItemWidth(160.f);
+        if (ImGui::InputText("##path", m_path, sizeof(m_path))) {
+            if (auto* registry = getParameterRegistry()) registry->setTexturePath(getParameterHandle(), m_path);
         }
     }
     
@@ -1045,50 +1136,89 @@ public:
         return ShaderDataType::Float;
     }
     
-    std::string generateExpression(const std::string& pinName,
-                                   const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const override {
-        std::string uv = getInputVar(this, "UV", varMap, "FragPos.xy");
-        std::string sampleExpr = "texture(" + getSamplerName() + ", " + uv + ")";
-        
-        if (pinName == "RGBA") return sampleExpr;
-        if (pinName == "RGB") return sampleExpr + ".rgb";
-        if (pinName == "R") return sampleExpr + ".r";
-        if (pinName == "G") return sampleExpr + ".g";
-        if (pinName == "B") return sampleExpr + ".b";
-        if (pinName == "A") return sampleExpr + ".a";
-        return sampleExpr;
+    NodeDesc describe() const override {
+        NodeDesc desc = makeDesc(NodeKind::Texture);
+        desc.textureUnit = m_textureUnit;
+        desc.name = m_displayName;
+        desc.path = m_path;
+        return desc;
+    }
+    
+    void applyDesc(const NodeDesc& desc) override {
+        m_textureUnit = std::max(0, std::min(15, desc.textureUnit));
+        copyName(m_displayName, sizeof(m_displayName), desc.name);
+        copyName(m_path, sizeof(m_path), desc.path);
+        syncParameter();
     }
     
     std::string getSamplerName() const {
-        std::string name = m_displayName;
-        if (name.empty()) name = "texture";
-        std::string clean = "u_";
-        for (char c : name) {
-            if (std::isalnum(c)) clean += c;
-            else if (c == ' ') clean += '_';
-        }
-        clean += "_" + std::to_string(getUID());
-        return clean;
+        return parameterUniformName(m_displayName, "texture", getUID());
     }
     
     UniformParameter getUniformParameter() const override {
-        return UniformParameter::Sampler2D(getSamplerName(), 
-                                           m_displayName[0] ? m_displayName : "Texture", 
-                                           m_textureUnit);
+        return parameterOf(describe());
     }
     
     void setUniformValue(const UniformParameter& param) override {
         m_textureUnit = param.textureUnit;
+        copyName(m_path, sizeof(m_path), param.texturePath);
     }
     
     int getTextureUnit() const { return m_textureUnit; }
-    void setTextureUnit(int unit) { m_textureUnit = std::max(0, std::min(15, unit)); }
+    void setTextureUnit(int unit) {
+        m_textureUnit = std::max(0, std::min(15, unit));
+        if (auto* registry = getParameterRegistry()) registry->setTextureUnit(getParameterHandle(), m_textureUnit);
+    }
 
 private:
     char m_displayName[64] = "MyTexture";
+    char m_path[260] = "";
     int m_textureUnit = 0;
 };
 
+// ============================================================================
+// STATIC SWITCH NODE - Picks a branch by keyword when the shader is generated
+// ============================================================================
+class StaticSwitchNode : public ShaderNodeBase {
+public:
+    StaticSwitchNode() {
+        setTitle("Static Switch");
+        setStyle(MathNodeStyle());
+        addIN<ShaderCode>("On", ShaderCode("1.0"), ImFlow::ConnectionFilter::None(), FloatPinStyle());
+        addIN<ShaderCode>("Off", ShaderCode("0.0"), ImFlow::ConnectionFilter::None(), FloatPinStyle());
+        addOUT<ShaderCode>("Result", FloatPinStyle())->behaviour([this]() {
+            return getInVal<ShaderCode>(m_enabled ? "On" : "Off");
+        });
+    }
+
+    void draw() override {
+        ImGui::SetNextItemWidth(100.f);
+        if (ImGui::InputText("##keyword", m_keyword, sizeof(m_keyword))) {
+            markDirty();
+        }
+        // Branch used by the editor preview; variants set it from their keyword set
+        if (ImGui::Checkbox("On", &m_enabled)) {
+            markDirty();
+        }
+    }
+    
+    NodeDesc describe() const override {
+        NodeDesc desc = makeDesc(NodeKind::StaticSwitch);
+        desc.value[0] = m_enabled ? 1.0f : 0.0f;
+        desc.name = m_keyword;
+        return desc;
+    }
+    
+    void applyDesc(const NodeDesc& desc) override {
+        m_enabled = desc.value[0] != 0.0f;
+        copyName(m_keyword, sizeof(m_keyword), desc.name);
+    }
+
+private:
+    char m_keyword[64] = "FEATURE";
+    bool m_enabled = true;
+};
+
 // ============================================================================
 // OUTPUT NODE - Final shader output (always needed)
 // ============================================================================
@@ -1114,13 +1244,8 @@ public:
                "    FragColor = vec4(finalColor, finalAlpha);\n";
     }
     
-    // New method using variable map from graph traversal
-    std::string generateCodeFromVarMap(const std::unordered_map<ImFlow::NodeUID, std::unordered_map<std::string, std::string>>& varMap) const {
-        std::string color = getInputVar(this, "Color", varMap, "vec3(1.0, 0.5, 0.2)");
-        std::string alpha = getInputVar(this, "Alpha", varMap, "1.0");
-        return "    vec3 finalColor = " + color + ";\n"
-               "    float finalAlpha = " + alpha + ";\n"
-               "    FragColor = vec4(finalColor, finalAlpha);\n";
+    NodeDesc describe() const override {
+        return makeDesc(NodeKind::Output);
     }
 };
 
@@ -0,0 +1,134 @@
+#ifndef SHADER_PRECISION_H
+#define SHADER_PRECISION_H
+
+#include "shader_ir.h"
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+// Reduced-precision emission. A policy gives every target a default precision; nodes
+// can override it (IRInstr::precision), and resolvePrecision then decides per value
+// whether it is declared at half precision. Values that need the range or resolution
+// of full floats are promoted automatically:
+//   - world positions (FragPos, lightPos, viewPos) and time, and arithmetic on them up
+//     to a range-reducing op (sin, cos, normalize, clamp)
+//   - texture coordinates and everything that computes them, since the sampler's
+//     derivatives and texel addressing come from them
+// Uniform declarations stay at full precision either way, so the constant buffer
+// layout doesn't depend on the target.
+
+namespace ShaderGraph {
+
+enum class ShaderTarget : uint8_t {
+    Desktop,    // GLSL 330 / SM 5.0, full precision
+    Mobile,     // GLSL ES 3.00 with mediump, min16float in HLSL
+    Console,    // Desktop GLSL, native 16-bit half in HLSL (SM 6.2 with -enable-16bit-types)
+    Count
+};
+
+struct PrecisionPolicy {
+    ShaderTarget target = ShaderTarget::Desktop;
+    ShaderPrecision defaultPrecision = ShaderPrecision::Full;   // For nodes without an override
+
+    static PrecisionPolicy forTarget(ShaderTarget target) {
+        PrecisionPolicy policy;
+        policy.target = target;
+        policy.defaultPrecision = target == ShaderTarget::Desktop ? ShaderPrecision::Full : ShaderPrecision::Half;
+        return policy;
+    }
+
+    bool glslES() const { return target == ShaderTarget::Mobile; }
+    bool nativeHalf() const { return target == ShaderTarget::Console; }
+};
+
+inline const char* shaderTargetName(ShaderTarget target) {
+    switch (target) {
+        case ShaderTarget::Desktop: return "desktop";
+        case ShaderTarget::Mobile: return "mobile";
+        case ShaderTarget::Console: return "console";
+        default: return "";
+    }
+}
+
+inline bool shaderTargetFromName(std::string_view name, ShaderTarget& target) {
+    for (int i = 0; i < static_cast<int>(ShaderTarget::Count); ++i) {
+        if (name == shaderTargetName(static_cast<ShaderTarget>(i))) {
+            target = static_cast<ShaderTarget>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Per node override as written in graph files
+inline const char* precisionName(ShaderPrecision precision) {
+    switch (precision) {
+        case ShaderPrecision::Full: return "full";
+        case ShaderPrecision::Half: return "half";
+        default: return "default";
+    }
+}
+
+inline bool precisionFromName(std::string_view name, ShaderPrecision& precision) {
+    for (ShaderPrecision p : {ShaderPrecision::Default, ShaderPrecision::Full, ShaderPrecision::Half}) {
+        if (name == precisionName(p)) {
+            precision = p;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Inputs and built-ins whose values are only meaningful at full precision
+inline bool needsFullPrecision(const IRModule& module, const IRInstr& instr) {
+    if (instr.op != IROp::Input && instr.op != IROp::Uniform) return false;
+    const std::string& name = module.str(instr.aux);
+    return name == "FragPos" || name == "TexCoord" || name == "time" || name == "lightPos" || name == "viewPos";
+}
+
+// 1 for every instruction declared at half precision, parallel to module.instrs
+inline std::vector<uint8_t> resolvePrecision(const IRModule& module, const PrecisionPolicy& policy) {
+    const size_t count = module.instrs.size();
+    std::vector<uint8_t> half(count, 0);
+    std::vector<uint8_t> full(count, 0);
+
+    // Forward: range-sensitive values taint what is computed from them
+    for (size_t i = 0; i < count; ++i) {
+        const IRInstr& instr = module.instrs[i];
+        if (needsFullPrecision(module, instr)) {
+            full[i] = 1;
+            continue;
+        }
+        const bool reducesRange = instr.op == IROp::Sin || instr.op == IROp::Cos || instr.op == IROp::Normalize ||
+                                  instr.op == IROp::Clamp || instr.op == IROp::Texture;
+        if (reducesRange) continue;
+        for (IRValue operand : instr.operands) {
+            if (operand != IRNone && full[operand]) full[i] = 1;
+        }
+    }
+
+    // Backward: texture coordinates and their inputs (operands precede their users)
+    std::vector<uint8_t> coordinate(count, 0);
+    for (size_t i = count; i-- > 0;) {
+        const IRInstr& instr = module.instrs[i];
+        if (instr.op == IROp::Texture && instr.operands[0] != IRNone) coordinate[instr.operands[0]] = 1;
+        if (!coordinate[i]) continue;
+        full[i] = 1;
+        if (instr.op == IROp::Texture) continue;
+        for (IRValue operand : instr.operands) {
+            if (operand != IRNone) coordinate[operand] = 1;
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const ShaderPrecision requested = module.instrs[i].precision == ShaderPrecision::Default
+                                              ? policy.defaultPrecision
+                                              : module.instrs[i].precision;
+        half[i] = requested == ShaderPrecision::Half && !full[i] ? 1 : 0;
+    }
+    return half;
+}
+
+} // namespace ShaderGraph
+
+#endif // SHADER_PRECISION_H
@@ -0,0 +1,103 @@
+#ifndef SHADER_TYPES_H
+#define SHADER_TYPES_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Value types and uniform parameter descriptions shared by the node graph, the IR
+// and the renderer. Kept free of ImGui/ImNodeFlow so non-UI code can include it.
+
+namespace ShaderGraph {
+
+// Data type enumeration for shader variables
+enum class ShaderDataType {
+    Float,
+    Vec2,
+    Vec3,
+    Vec4,
+    Sampler2D
+};
+
+// Arithmetic precision of a value. Default follows the target's precision policy
+// (see shader_precision.h); Full and Half are per-node overrides.
+enum class ShaderPrecision : uint8_t {
+    Default,
+    Full,
+    Half
+};
+
+// Storage of a baked UV-only subgraph (see subgraph_bake.h). Default follows the
+// material's bake options; the others are per-node overrides, Off keeps it procedural.
+enum class BakeFormat : uint8_t {
+    Default,
+    UNorm8,     // RGBA8, each channel remapped to the range it covers
+    Half,       // RGBA16F
+    Off
+};
+
+// Structure to hold uniform parameter info for CPU-controlled values
+struct UniformParameter {
+    std::string name;           // Uniform name in shader
+    std::string displayName;    // User-friendly display name
+    ShaderDataType type = ShaderDataType::Float;
+    float floatValue = 0.0f;    // For float uniforms
+    float vec3Value[3] = {0.0f, 0.0f, 0.0f};  // For vec3 uniforms
+    float minValue = 0.0f;      // Range for UI
+    float maxValue = 1.0f;
+    
+    UniformParameter() = default;
+    
+    // Float parameter constructor
+    static UniformParameter Float(const std::string& n, const std::string& display, float val, float minV = 0.0f, float maxV = 1.0f) {
+        UniformParameter p;
+        p.name = n;
+        p.displayName = display;
+        p.type = ShaderDataType::Float;
+        p.floatValue = val;
+        p.minValue = minV;
+        p.maxValue = maxV;
+        return p;
+    }
+    
+    // Vec3 parameter constructor
+    static UniformParameter Vec3(const std::string& n, const std::string& display, float r, float g, float b) {
+        UniformParameter p;
+        p.name = n;
+        p.displayName = display;
+        p.type = ShaderDataType::Vec3;
+        p.vec3Value[0] = r;
+        p.vec3Value[1] = g;
+        p.vec3Value[2] = b;
+        return p;
+    }
+    
+    // Sampler2D parameter constructor (for texture nodes)
+    static UniformParameter Sampler2D(const std::string& n, const std::string& display, int texUnit = 0,
+                                      const std::string& path = std::string()) {
+        UniformParameter p;
+        p.name = n;
+        p.displayName = display;
+        p.type = ShaderDataType::Sampler2D;
+        p.textureUnit = texUnit;
+        p.texturePath = path;
+        return p;
+    }
+    
+    int textureUnit = 0;        // Texture unit for sampler2D uniforms
+    std::string texturePath;    // Image bound to that unit
+};
+
+// Parameters carried per instance in the sweep block: one vec4 slot each, in order,
+// for everything but samplers
+inline bool isSweepParameter(const UniformParameter& param) { return param.type != ShaderDataType::Sampler2D; }
+
+inline int sweepSlotCount(const std::vector<UniformParameter>& params) {
+    int count = 0;
+    for (const auto& param : params) count += isSweepParameter(param) ? 1 : 0;
+    return count;
+}
+
+} // namespace ShaderGraph
+
+#endif // SHADER_TYPES_H
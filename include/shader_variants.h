@@ -0,0 +1,95 @@
+#ifndef SHADER_VARIANTS_H
+#define SHADER_VARIANTS_H
+
+#include "material_generator.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+
+struct GLFWwindow;
+class ShaderCompiler;
+class ProgramCache;
+
+// Programs for every requested permutation of a graph's static switches.
+//
+// build() generates the variants headlessly (see generateVariants), so variants whose
+// switches only change dead code share one source and one program. Distinct sources
+// are queued on a compiler of their own, one build at a time, with the program binary
+// cache attached; programs whose source survives a rebuild are kept.
+class ShaderVariantManager {
+public:
+    enum class State {
+        Queued,
+        Building,
+        Ready,
+        Failed
+    };
+
+    struct Program {
+        uint64_t hash = 0;              // Vertex and fragment source
+        std::string fragmentSource;
+        unsigned int program = 0;       // 0 until Ready
+        State state = State::Queued;
+        bool fromCache = false;
+        std::string errorLog;
+    };
+
+    struct Stats {
+        size_t variants = 0;
+        size_t programs = 0;            // Distinct sources
+        size_t ready = 0;
+        size_t failed = 0;
+        size_t fromCache = 0;
+        size_t pending = 0;             // Queued or building
+    };
+
+    ShaderVariantManager();
+    ~ShaderVariantManager();
+    ShaderVariantManager(const ShaderVariantManager&) = delete;
+    ShaderVariantManager& operator=(const ShaderVariantManager&) = delete;
+
+    // Render thread, main context current
+    void init(GLFWwindow* mainWindow);
+    void shutdown();
+
+    // Optional binary cache (not owned); must outlive the manager
+    void setProgramCache(ProgramCache* cache);
+
+    // Replace the variant set with the given keyword sets of graph
+    void build(const ShaderGraph::GraphDesc& graph, const std::vector<std::vector<std::string>>& keywordSets,
+               bool useUniformBlock);
+
+    // Poll the finished build and start the next one. Render thread, once per frame.
+    void update();
+
+    // Program of a variant (keywords in any order); 0 while building, failed or unknown
+    unsigned int getProgram(std::vector<std::string> keywords) const;
+
+    const std::vector<ShaderGraph::MaterialVariant>& getVariants() const { return m_variants.variants; }
+    const std::vector<Program>& getPrograms() const { return m_programs; }
+    const Stats& getStats() const { return m_stats; }
+
+private:
+    void updateStats();
+
+    std::unique_ptr<ShaderCompiler> m_compiler;
+    bool m_initialized = false;
+    std::string m_vertexSource;
+
+    ShaderGraph::MaterialVariants m_variants;
+    std::vector<Program> m_programs;        // Parallel to m_variants.sources
+    std::unordered_map<std::string, size_t> m_byName;   // Variant name -> index
+    std::deque<size_t> m_queue;             // Programs waiting for the compiler
+
+    // Build in flight, by hash so it survives a rebuild that keeps its source
+    bool m_building = false;
+    uint64_t m_buildingHash = 0;
+    uint64_t m_ticket = 0;
+
+    Stats m_stats;
+};
+
+#endif // SHADER_VARIANTS_H
@@ -0,0 +1,160 @@
+#ifndef SUBGRAPH_BAKE_H
+#define SUBGRAPH_BAKE_H
+
+#include "graph_desc.h"
+#include "shader_bake.h"
+#include "shader_cost.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Automatic baking of time-invariant subgraphs. A value computed only from constants
+// and TexCoord is the same every frame, so when it is expensive enough it can be
+// rendered once on the CPU (shader_bake.h) and replaced by one texture fetch.
+//
+// Candidates are the maximal UV-only values: live values built from Const and the
+// TexCoord input alone (no uniforms, time, textures or other varyings) whose user is
+// not UV-only, or which feed the output directly. Their cost is the costScore of the
+// instructions they need. The baked texture repeats, so coordinates outside [0, 1]
+// read the pattern tiled rather than extrapolated, and detail finer than a texel is
+// filtered away; both are the price of the substitution.
+
+namespace ShaderGraph {
+
+// Per node override, keyed by the IR origin of a candidate's root
+struct SubgraphBakeSettings {
+    BakeFormat format = BakeFormat::Default;
+    uint16_t size = 0;              // 0 = SubgraphBakeOptions::size
+};
+
+struct SubgraphBakeOptions {
+    float minCost = 24.0f;          // costScore a subgraph must reach to be baked
+    uint32_t size = 256;            // Square texture size
+    BakeFormat format = BakeFormat::UNorm8;
+    bool mipmaps = true;
+    unsigned threads = 0;           // Baker threads, 0 = hardware concurrency
+    std::string pathPrefix;         // Texture files are pathPrefix + sampler + ".dds"
+};
+
+struct SubgraphBake {
+    IRValue root = IRNone;
+    int32_t origin = -1;            // Node that created the root
+    int components = 0;             // Of the root value
+    ShaderCost cost;                // Of the instructions the bake replaces
+    uint32_t size = 0;
+    BakeFormat format = BakeFormat::UNorm8;
+    uint64_t key = 0;               // Structure of the subgraph, size and format
+    std::string sampler;            // u_bake_<key>
+    std::string path;
+    int textureUnit = -1;           // Assigned by applySubgraphBakes, -1 = left procedural
+    BakeRange range;                // Filled by renderSubgraphBake
+    TextureImage image;
+};
+
+// Settings of every node, indexed like graph.nodes (the origins lowerGraph records)
+std::vector<SubgraphBakeSettings> subgraphBakeSettings(const GraphDesc& graph);
+
+// Candidates above the cost threshold, in IR order; settings (optional) is indexed by origin
+void findSubgraphBakes(const IRModule& module, const SubgraphBakeOptions& options,
+                       const std::vector<SubgraphBakeSettings>* settings, std::vector<SubgraphBake>& bakes);
+
+// Render a candidate into bake.image and bake.range
+bool renderSubgraphBake(const IRModule& module, const SubgraphBakeOptions& options, SubgraphBake& bake,
+                        std::string& error);
+
+// Replace every baked root by a fetch from its texture and append its sampler to
+// parameters, on the highest texture units the parameters leave free. Bakes that get no
+// unit stay procedural. Returns how many were substituted.
+size_t applySubgraphBakes(IRModule& module, std::vector<SubgraphBake>& bakes, std::vector<UniformParameter>& parameters);
+
+// Encode bake.image as DDS at path, creating the directories it needs
+bool writeSubgraphBake(const SubgraphBake& bake, const std::string& path, std::string& error);
+
+// Bakes for the editor, rendered and written to bake.path on a worker thread so a frame
+// never waits for one. Results are kept by key and shared by every graph; beyond the
+// capacity the least recently requested are evicted and their files deleted. Everything
+// but the worker runs on the caller's thread.
+class SubgraphBakeCache {
+public:
+    enum class Status {
+        Ready,      // bake.range is filled and the file exists
+        Pending,    // Queued or rendering; the caller keeps the subgraph procedural
+        Failed      // error says why; not retried until the entry is evicted
+    };
+
+    explicit SubgraphBakeCache(size_t capacity = 64);
+    ~SubgraphBakeCache();
+    SubgraphBakeCache(const SubgraphBakeCache&) = delete;
+    SubgraphBakeCache& operator=(const SubgraphBakeCache&) = delete;
+
+    // Look a candidate up, queueing it (with a copy of module) when it isn't known or its
+    // file has gone missing
+    Status request(const IRModule& module, const SubgraphBakeOptions& options, SubgraphBake& bake, std::string& error);
+
+    // Mark a bake a graph still samples, so it isn't evicted. Each frame, for every key in use.
+    void keep(uint64_t key);
+
+    // Take finished bakes and evict down to the capacity. Once per frame.
+    void update();
+
+    // Delete the bakes a previous session left in directory; their ranges weren't kept
+    static bool removeStaleFiles(const std::string& directory, std::string& error);
+
+    // Moves whenever a bake finishes, so graphs waiting on one can rebuild
+    uint64_t getRevision() const { return m_revision; }
+    size_t getRenderCount() const { return m_renders; }
+    size_t getPendingCount() const { return m_pending.size(); }
+
+private:
+    struct Entry {
+        bool failed = false;
+        BakeRange range;
+        std::string path;
+        std::string error;
+        uint64_t lastUse = 0;       // update() tick of the last request or keep()
+    };
+
+    // Worker input and output
+    struct Job {
+        IRModule module;
+        SubgraphBakeOptions options;
+        SubgraphBake bake;
+    };
+    struct Done {
+        uint64_t key = 0;
+        bool success = false;
+        BakeRange range;
+        std::string path;
+        std::string error;
+    };
+
+    void workerLoop();
+    void evict();
+
+    size_t m_capacity;
+
+    // Caller's thread
+    std::unordered_map<uint64_t, Entry> m_entries;
+    std::unordered_set<uint64_t> m_pending;
+    uint64_t m_tick = 0;
+    uint64_t m_revision = 0;
+    size_t m_renders = 0;
+
+    // Shared with the worker, started by the first request
+    std::thread m_worker;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<Job> m_jobs;
+    std::vector<Done> m_done;
+    bool m_quit = false;
+};
+
+} // namespace ShaderGraph
+
+#endif // SUBGRAPH_BAKE_H
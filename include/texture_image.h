@@ -0,0 +1,94 @@
+#ifndef TEXTURE_IMAGE_H
+#define TEXTURE_IMAGE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// CPU side of texture loading: container parsing and decoding into GPU-ready levels.
+// Nothing here touches GL, so it runs on worker threads.
+//
+// Supported files:
+//   .tga   24/32-bit truecolor and 8-bit greyscale, raw or RLE
+//   .ppm   binary (P6), 8-bit
+//   .dds   BC1-BC5 (DXT1/3/5, ATI1/2), DX10 header with BC7, RGBA8, BGRA8 and RGBA16F,
+//          uncompressed 24/32-bit by channel masks
+//   .ktx2  RGBA8/BGRA8, RGBA16F, BC1-BC5, BC7 and ASTC 4x4/5x5/6x6/8x8, without supercompression
+//
+// Compressed data is passed through untouched. Rows run top to bottom for every
+// format, the way DDS and KTX2 store them.
+
+namespace ShaderGraph {
+
+enum class TextureFormat {
+    RGBA8,
+    BC1,
+    BC2,
+    BC3,
+    BC4,
+    BC5,
+    BC7,
+    ASTC4x4,
+    ASTC5x5,
+    ASTC6x6,
+    ASTC8x8,
+    RGBA16F     // Half floats, for values outside [0, 1] (baked subgraphs)
+};
+
+struct TextureFormatInfo {
+    const char* name;
+    uint8_t blockWidth;         // 1x1 for uncompressed formats
+    uint8_t blockHeight;
+    uint8_t bytesPerBlock;
+    bool compressed;
+};
+
+const TextureFormatInfo& textureFormatInfo(TextureFormat format);
+
+// Bytes in one level, and in one row of blocks (a row of pixels for RGBA8)
+size_t textureLevelSize(TextureFormat format, uint32_t width, uint32_t height);
+size_t textureRowSize(TextureFormat format, uint32_t width);
+
+struct TextureLevel {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    size_t offset = 0;          // Into TextureImage::pixels
+    size_t size = 0;
+};
+
+struct TextureImage {
+    TextureFormat format = TextureFormat::RGBA8;
+    std::vector<TextureLevel> levels;   // Largest first
+    std::vector<uint8_t> pixels;
+
+    uint32_t width() const { return levels.empty() ? 0 : levels[0].width; }
+    uint32_t height() const { return levels.empty() ? 0 : levels[0].height; }
+    const uint8_t* levelData(size_t level) const { return pixels.data() + levels[level].offset; }
+};
+
+// Decode a file in memory; the container is recognised by its signature (TGA has
+// none and is the fallback)
+bool decodeTexture(const uint8_t* data, size_t size, TextureImage& image, std::string& error);
+
+// Levels in a full mip chain down to 1x1
+uint32_t textureMipCount(uint32_t width, uint32_t height);
+
+// Lay out count levels back to back, halving down from width x height, and allocate
+// zeroed pixel storage for them
+void layoutTextureLevels(TextureImage& image, TextureFormat format, uint32_t width, uint32_t height, uint32_t count);
+
+// Fill in the rest of the mip chain of a single-level RGBA8 image with a box filter
+void generateMipmaps(TextureImage& image);
+
+// IEEE half conversion for RGBA16F texels; rounds to nearest even, overflow goes to infinity
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t half);
+
+// DDS with every level of an RGBA8 image (uncompressed 32-bit) or an RGBA16F one (DX10
+// header), what decodeTexture reads back
+bool encodeDDS(const TextureImage& image, std::vector<uint8_t>& file, std::string& error);
+
+} // namespace ShaderGraph
+
+#endif // TEXTURE_IMAGE_H
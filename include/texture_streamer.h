@@ -0,0 +1,166 @@
+#ifndef TEXTURE_STREAMER_H
+#define TEXTURE_STREAMER_H
+
+#include "texture_image.h"
+#include "shader_types.h"
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Textures of the graph's samplers, loaded without stalling the frame.
+//
+// Files are read, hashed and decoded (see texture_image.h) on worker threads; single-level
+// RGBA8 images get their mip chain there too. Files with the same content share one GL
+// texture. The render thread streams the levels in through a ring of pixel unpack buffer
+// segments, one segment per frame, so a 4K texture arrives over several frames instead
+// of in one long upload. The ring is persistently mapped when GL_ARB_buffer_storage is
+// available and mapped per frame otherwise. Compressed formats are uploaded as they are
+// when the GPU supports them. Until a texture is complete its units get a grey placeholder.
+class TextureStreamer {
+public:
+    struct Stats {
+        size_t files = 0;           // Distinct paths requested
+        size_t textures = 0;        // Distinct contents
+        size_t resident = 0;
+        size_t loading = 0;         // Reading, decoding or uploading
+        size_t failed = 0;
+        size_t residentBytes = 0;
+        size_t uploadedBytes = 0;   // Last update()
+        bool persistentMapping = false;
+    };
+
+    explicit TextureStreamer(unsigned workerCount = 2, size_t segmentBytes = 8u << 20, unsigned segmentCount = 3);
+    ~TextureStreamer();
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Render thread, context current
+    void init();
+    void shutdown();
+
+    // GL texture for a file, or the placeholder while it loads or when it failed.
+    // The first call queues the file.
+    unsigned int acquire(const std::string& path);
+
+    // Count the users of a file. When the last one releases it the file is forgotten and,
+    // unless another path has the same content, its GL texture deleted; acquiring it again
+    // reloads it. Files that are never retained stay for the session.
+    void retain(const std::string& path);
+    void release(const std::string& path);
+
+    // Bind the texture of every sampler parameter to its unit; leaves unit 0 active. With
+    // active (parallel to params) only flagged samplers are bound, so the textures of
+    // disconnected nodes are never loaded.
+    void bind(const std::vector<ShaderGraph::UniformParameter>& params, const std::vector<uint8_t>* active = nullptr);
+
+    // Take decoded images and upload up to one segment. Render thread, once per frame.
+    void update();
+
+    // Error of a failed file, empty otherwise
+    const std::string& getError(const std::string& path) const;
+
+    // True while files are loading or uploading
+    bool isBusy() const;
+
+    // Moves whenever a texture becomes resident or fails, so cached renders can redraw
+    uint64_t getRevision() const { return m_revision; }
+    const Stats& getStats() const { return m_stats; }
+
+private:
+    enum class State {
+        Uploading,
+        Resident,
+        Failed
+    };
+
+    struct Texture {
+        State state = State::Uploading;
+        unsigned int texture = 0;
+        ShaderGraph::TextureImage image;   // Released once resident
+        size_t level = 0;                  // Upload cursor: level, then row of blocks
+        uint32_t row = 0;
+        size_t bytes = 0;
+        std::string error;
+    };
+
+    struct File {
+        bool loaded = false;        // Content hash known
+        uint64_t content = 0;
+        std::string error;          // Read errors, before there is content
+    };
+
+    // Worker output
+    struct Decoded {
+        std::string path;
+        bool read = false;          // False when the file couldn't be opened (error says why)
+        uint64_t content = 0;
+        bool decoded = false;       // False when another path claimed this content first
+        ShaderGraph::TextureImage image;
+        std::string error;
+    };
+
+    // A staged copy waiting for its Tex(Sub)Image call
+    struct Upload {
+        Texture* texture;
+        size_t level;
+        uint32_t row;
+        uint32_t rows;
+        size_t offset;             // Into the buffer
+        size_t size;
+    };
+
+    void workerLoop();
+    void receive(Decoded& decoded);
+    bool createTexture(Texture& texture);
+    void stage(std::vector<Upload>& uploads, uint8_t* segment, size_t segmentOffset);
+    void submit(const std::vector<Upload>& uploads);
+    void finish(Texture& texture);
+    void drop(const std::string& path);
+    bool formatSupported(ShaderGraph::TextureFormat format) const;
+    void updateStats();
+
+    unsigned m_workerCount;
+    size_t m_segmentBytes;
+    unsigned m_segmentCount;
+    bool m_initialized = false;
+
+    unsigned int m_placeholder = 0;
+    unsigned int m_buffer = 0;
+    uint8_t* m_mapped = nullptr;            // Whole ring, when persistently mapped
+    std::vector<void*> m_fences;            // GLsync per segment
+    unsigned m_segment = 0;
+
+    // Formats the GPU samples directly
+    bool m_s3tc = false;
+    bool m_bptc = false;
+    bool m_astc = false;
+
+    // Render thread
+    std::unordered_map<std::string, File> m_files;
+    std::unordered_map<std::string, uint32_t> m_references;
+    std::unordered_map<uint64_t, std::unique_ptr<Texture>> m_textures;   // By content hash
+    std::deque<Texture*> m_uploadQueue;
+    std::vector<Upload> m_uploads;
+    size_t m_pendingFiles = 0;              // Queued to the workers, result not received yet
+    uint64_t m_revision = 0;
+    Stats m_stats;
+    static const std::string s_noError;
+
+    // Shared with the workers
+    std::vector<std::thread> m_workers;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    std::deque<std::string> m_jobs;
+    std::vector<Decoded> m_decoded;
+    std::unordered_set<uint64_t> m_contents;    // Claimed by a worker for decoding
+    bool m_quit = false;
+};
+
+#endif // TEXTURE_STREAMER_H
@@ -0,0 +1,108 @@
+#ifndef UNIFORM_REFLECTION_H
+#define UNIFORM_REFLECTION_H
+
+#include <vector>
+#include <cstdint>
+
+namespace ShaderGraph {
+struct UniformParameter;
+}
+
+// Uniform block binding point used for the PerFrame block
+constexpr unsigned int PerFrameBlockBinding = 0;
+
+// Built-in per-frame uniforms as a std140 block. The member order keeps every vec3
+// followed by a scalar or padding so the layout matches PerFrameBlock below (and the
+// HLSL cbuffer PerFrame packing).
+inline constexpr const char* PerFrameBlockGLSL = R"(layout(std140) uniform PerFrame
+{
+    mat4 model;
+    mat4 view;
+    mat4 projection;
+    vec3 lightPos;
+    float time;
+    vec3 viewPos;
+    vec3 lightColor;
+    vec3 objectColor;
+};
+)";
+
+// Per-instance parameters of the sweep preview (see ParameterSweep): every instance
+// owns SweepSlots(params) consecutive vec4 slots, one per non-sampler parameter, and
+// SweepInstance is the instance's flat varying. 1024 slots fill 16 KB, the smallest
+// GL_MAX_UNIFORM_BLOCK_SIZE an implementation may have.
+constexpr unsigned int SweepBlockBinding = 1;
+constexpr int SweepBlockSlots = 1024;
+
+inline constexpr const char* SweepBlockGLSL = R"(layout(std140) uniform SweepParameters
+{
+    vec4 sweep[1024];
+};
+)";
+
+// CPU mirror of the std140 PerFrame block
+struct PerFrameBlock {
+    float model[16];
+    float view[16];
+    float projection[16];
+    float lightPos[3];
+    float time;
+    float viewPos[3];
+    float pad0;
+    float lightColor[3];
+    float pad1;
+    float objectColor[3];
+    float pad2;
+};
+static_assert(sizeof(PerFrameBlock) == 256, "PerFrameBlock must match the std140 layout");
+
+// Uniform locations of the built-in inputs (-1 when unused by the program)
+struct BuiltinUniformLocations {
+    int model = -1;
+    int view = -1;
+    int projection = -1;
+    int time = -1;
+    int lightPos = -1;
+    int viewPos = -1;
+    int lightColor = -1;
+    int objectColor = -1;
+    int sweepGrid = -1;         // Columns and rows of the sweep preview
+};
+
+// Reflection table for one linked program. Locations are resolved once per link
+// (built-ins) and once per parameter-list change (user parameters), so the render
+// loop never calls glGetUniformLocation.
+class UniformReflection {
+public:
+    // Query built-in locations and bind the PerFrame and SweepParameters blocks. Call after every program swap.
+    void reflect(unsigned int program);
+
+    // Resolve user parameter locations; a no-op while the program and revision are unchanged.
+    // Locations are parallel to params. Returns true when the locations were re-queried.
+    bool resolveParameters(const std::vector<ShaderGraph::UniformParameter>& params, uint64_t revision);
+
+    // Upload one parameter value to the current program (skipped for location -1)
+    static void upload(const ShaderGraph::UniformParameter& param, int location);
+
+    unsigned int getProgram() const { return m_program; }
+    const BuiltinUniformLocations& getBuiltins() const { return m_builtins; }
+    const std::vector<int>& getParameterLocations() const { return m_parameterLocations; }
+
+    // True when the program declares the PerFrame block instead of loose built-ins
+    bool hasPerFrameBlock() const { return m_hasPerFrameBlock; }
+
+    // True when the program reads user parameters per instance from the SweepParameters block
+    bool hasSweepBlock() const { return m_hasSweepBlock; }
+
+private:
+    unsigned int m_program = 0;
+    BuiltinUniformLocations m_builtins;
+    bool m_hasPerFrameBlock = false;
+    bool m_hasSweepBlock = false;
+
+    std::vector<int> m_parameterLocations;
+    uint64_t m_parameterRevision = 0;
+    bool m_hasParameterRevision = false;
+};
+
+#endif // UNIFORM_REFLECTION_H
@@ -1,46 +1,30 @@
 #include "app.h"
 #include "mat.h"
 #include "shader_graph.h"
+#include "compile_scheduler.h"
+#include "program_cache.h"
+#include "uniform_reflection.h"
+#include "material_generator.h"
+#include "frame_profiler.h"
+#include "node_preview.h"
+#include "shader_variants.h"
+#include "texture_streamer.h"
+#include "parameter_sweep.h"
+#include "preview_mesh.h"
+#include "mesh_io.h"
+#include "gl_platform.h"
 #include <iostream>
 #include <cstring>
+#include <cstdio>
 #include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <optional>
 
-#ifdef __APPLE__
-#define GL_SILENCE_DEPRECATION
-#include <OpenGL/gl3.h>
-#elif defined(_WIN32)
-#include <GL/glew.h>
-#endif
-
-#include <GLFW/glfw3.h>
 #include <imgui.h>
 #include <imgui_impl_glfw.h>
 #include <imgui_impl_opengl3.h>
 
-// Default vertex shader
-static const char* defaultVertexShader = R"(
-#version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec3 aNormal;
-layout (location = 2) in vec2 aTexCoord;
-
-out vec3 FragPos;
-out vec3 Normal;
-out vec2 TexCoord;
-
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
-
-void main()
-{
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
-    TexCoord = aTexCoord;
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
-}
-)";
-
 // Default fragment shader
 static const char* defaultFragmentShader = R"(
 #version 330 core
@@ -82,56 +66,21 @@ void main()
 }
 )";
 
-// Cube vertices with normals and UVs
-static float cubeVertices[] = {
-    // positions          // normals           // texcoords
-    // Back face
-    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
-     0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 0.0f,
-     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
-     0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  1.0f, 1.0f,
-    -0.5f,  0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 1.0f,
-    -0.5f, -0.5f, -0.5f,  0.0f,  0.0f, -1.0f,  0.0f, 0.0f,
-
-    // Front face
-    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f, 0.0f,
-     0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f, 0.0f,
-     0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f, 1.0f,
-     0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  1.0f, 1.0f,
-    -0.5f,  0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f, 1.0f,
-    -0.5f, -0.5f,  0.5f,  0.0f,  0.0f,  1.0f,  0.0f, 0.0f,
-
-    // Left face
-    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
-    -0.5f,  0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
-    -0.5f, -0.5f, -0.5f, -1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
-    -0.5f, -0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-    -0.5f,  0.5f,  0.5f, -1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
-
-    // Right face
-     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-     0.5f,  0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 1.0f,
-     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-     0.5f, -0.5f, -0.5f,  1.0f,  0.0f,  0.0f,  1.0f, 0.0f,
-     0.5f, -0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 0.0f,
-     0.5f,  0.5f,  0.5f,  1.0f,  0.0f,  0.0f,  0.0f, 1.0f,
-
-    // Bottom face
-    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
-     0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 1.0f,
-     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
-     0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  1.0f, 0.0f,
-    -0.5f, -0.5f,  0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 0.0f,
-    -0.5f, -0.5f, -0.5f,  0.0f, -1.0f,  0.0f,  0.0f, 1.0f,
-
-    // Top face
-    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f,
-     0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 1.0f,
-     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
-     0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  1.0f, 0.0f,
-    -0.5f,  0.5f,  0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 0.0f,
-    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
+namespace {
+
+// Tab label of a document loaded from or saved to path
+std::string fileName(const std::string& path) {
+    const size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? path : path.substr(slash + 1);
+}
+
+} // namespace
+
+// Emitter and buffer a document's generators write through on the pool. The scheduler
+// runs one generator per document at a time, so they are never shared.
+struct App::FragmentWriter {
+    ShaderGraph::IREmitter emitter{ShaderGraph::IREmitter::Language::GLSL};
+    ShaderGraph::CodeWriter out;
 };
 
 App::App() {
@@ -144,16 +93,56 @@ void App::init(int width, int height, const std::string& name) {
     m_windowName = name;
     
     initWindow();
+    
+    m_profiler = std::make_unique<FrameProfiler>();
+    m_passes.graphUpdate = m_profiler->addPass("Graph update", FrameProfiler::PassType::Cpu);
+    m_passes.generate = m_profiler->addPass("Shader generation", FrameProfiler::PassType::Cpu);
+    m_passes.compile = m_profiler->addPass("Compile submit", FrameProfiler::PassType::Cpu);
+    m_passes.uniforms = m_profiler->addPass("Uniform upload", FrameProfiler::PassType::Cpu);
+    m_passes.previewGpu = m_profiler->addPass("Preview (GPU)", FrameProfiler::PassType::Gpu);
+    m_passes.nodePreviews = m_profiler->addPass("Node previews", FrameProfiler::PassType::Cpu);
+    m_passes.nodePreviewsGpu = m_profiler->addPass("Node previews (GPU)", FrameProfiler::PassType::Gpu);
+    m_passes.imguiGpu = m_profiler->addPass("ImGui (GPU)", FrameProfiler::PassType::Gpu);
+    m_profiler->init();
+    
+    m_scheduler = std::make_unique<CompileScheduler>();
+    m_scheduler->init(m_window);
+    m_programCache = std::make_unique<ProgramCache>();
+    m_programCache->init();
+    m_scheduler->setProgramCache(m_programCache.get());
+    m_nodePreviews = std::make_unique<NodePreviewRenderer>();
+    m_nodePreviews->init();
+    m_nodePreviews->setProgramCache(m_programCache.get());
+    m_variants = std::make_unique<ShaderVariantManager>();
+    m_variants->init(m_window);
+    m_variants->setProgramCache(m_programCache.get());
+    m_textures = std::make_unique<TextureStreamer>();
+    m_textures->init();
+    m_nodePreviews->setTextureStreamer(m_textures.get());
+    m_bakeCache = std::make_unique<ShaderGraph::SubgraphBakeCache>();
+    std::string bakeError;
+    if (!ShaderGraph::SubgraphBakeCache::removeStaleFiles(ShaderGraph::ShaderGraphEditor::BakeCacheDirectory, bakeError)) {
+        std::cerr << bakeError << std::endl;
+    }
+    m_sweep = std::make_unique<ParameterSweep>();
+    m_sweep->init();
+    
     initImGui();
     initCubeRenderer();
     initFramebuffer(m_fbWidth, m_fbHeight);
     initShaderGraph();
     
-    // Initialize shader sources
-    m_vertexShaderSource = defaultVertexShader;
-    
-    // Generate initial fragment shader from graph
-    updateShaderFromGraph();
+    // The focused document is ready for the first frame; its program, and everything
+    // about the other files, arrives through the scheduler
+    std::string error;
+    while (!m_pendingOpens.empty() && m_documents.empty()) {
+        const std::string path = m_pendingOpens.front();
+        m_pendingOpens.pop_front();
+        if (!openDocument(path, error)) std::cerr << path << ": " << error << std::endl;
+    }
+    if (m_documents.empty()) addDocument("Untitled " + std::to_string(++m_untitledCount));
+    focusDocument(0);
+    updateDocuments();
     
     std::cout << "App initialized" << std::endl;
 }
@@ -228,27 +217,15 @@ void App::initImGui() {
 }
 
 void App::initCubeRenderer() {
-    // Create VAO and VBO for the cube
-    glGenVertexArrays(1, &m_cubeVAO);
-    glGenBuffers(1, &m_cubeVBO);
-    
-    glBindVertexArray(m_cubeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, m_cubeVBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(cubeVertices), cubeVertices, GL_STATIC_DRAW);
-    
-    // Position attribute (location 0)
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    
-    // Normal attribute (location 1)
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+    // Indexed preview mesh; attributes stay at locations 0, 1 and 2
+    m_mesh = std::make_unique<PreviewMesh>();
+    setPreviewMesh(static_cast<int>(ShaderGraph::MeshShape::Cube));
     
-    // TexCoord attribute (location 2)
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
-    
-    glBindVertexArray(0);
+    // Buffer backing the std140 PerFrame block
+    glGenBuffers(1, &m_perFrameUBO);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_perFrameUBO);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(PerFrameBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
 void App::initFramebuffer(int width, int height) {
@@ -277,87 +254,221 @@ void App::initFramebuffer(int width, int height) {
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
 }
 
-void App::compileShaders() {
-    m_shaderCompileError = false;
-    m_shaderErrorLog.clear();
-    
-    // Delete old shader program if exists
-    if (m_shaderProgram != 0) {
-        glDeleteProgram(m_shaderProgram);
+void App::pollCompileScheduler() {
+    {
+        FrameProfiler::Scope scope(m_profiler.get(), m_passes.compile);
+        m_scheduler->update();
     }
-    
-    // Compile vertex shader
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    const char* vertSrc = m_vertexShaderSource.c_str();
-    glShaderSource(vertexShader, 1, &vertSrc, NULL);
-    glCompileShader(vertexShader);
-    
-    int success;
-    char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        m_shaderCompileError = true;
-        m_shaderErrorLog = "VERTEX SHADER ERROR:\n" + std::string(infoLog);
-        glDeleteShader(vertexShader);
-        return;
+    CompileScheduler::Result result;
+    while (m_scheduler->poll(result)) {
+        Document* document = findDocument(result.document);
+        if (!document) {
+            if (result.build.program) glDeleteProgram(result.build.program);
+            continue;
+        }
+        document->vertexSource = std::move(result.sources.vertex);
+        document->fragmentSource = std::move(result.sources.fragment);
+        if (result.build.success) {
+            if (document->program != 0) {
+                glDeleteProgram(document->program);
+            }
+            document->program = result.build.program;
+            document->uniforms->reflect(document->program);
+            if (document == m_document) m_previewDirty = true;
+            document->compileError = false;
+            document->errorLog.clear();
+        } else {
+            // Keep the last good program on screen and report the error
+            document->compileError = true;
+            document->errorLog = std::move(result.build.errorLog);
+        }
     }
-    
-    // Compile fragment shader
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    const char* fragSrc = m_fragmentShaderSource.c_str();
-    glShaderSource(fragmentShader, 1, &fragSrc, NULL);
-    glCompileShader(fragmentShader);
-    
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        m_shaderCompileError = true;
-        m_shaderErrorLog = "FRAGMENT SHADER ERROR:\n" + std::string(infoLog);
-        glDeleteShader(vertexShader);
-        glDeleteShader(fragmentShader);
-        return;
+}
+
+void App::open(const std::string& path) {
+    m_pendingOpens.push_back(path);
+}
+
+App::Document& App::addDocument(const std::string& name) {
+    auto document = std::make_unique<Document>();
+    document->id = m_scheduler->addDocument(CompileScheduler::Priority::Background);
+    document->name = name;
+    document->graph = std::make_unique<ShaderGraph::ShaderGraphEditor>("Shader Graph##" + std::to_string(document->id));
+    if (m_showNodePreviews) document->graph->setNodePreviewSize(64.0f);
+    document->graph->setBakeCache(m_bakeCache.get());
+    document->writer = std::make_shared<FragmentWriter>();
+    document->uniforms = std::make_unique<UniformReflection>();
+    document->vertexSource = ShaderGraph::buildVertexShader(false);
+    m_documents.push_back(std::move(document));
+    return *m_documents.back();
+}
+
+bool App::openDocument(const std::string& path, std::string& error) {
+    ShaderGraph::GraphDesc graph;
+    if (!ShaderGraph::loadGraphFile(path, graph, error)) return false;
+    Document& document = addDocument(fileName(path));
+    document.graph->loadGraph(graph);
+    std::snprintf(document.path, sizeof(document.path), "%s", path.c_str());
+    return true;
+}
+
+// Files given at startup: one per frame, so even a long list never holds up a frame for
+// more than a single load. Their builds queue behind the focused document's.
+void App::openPendingDocuments() {
+    if (m_pendingOpens.empty()) return;
+    const std::string path = m_pendingOpens.front();
+    m_pendingOpens.pop_front();
+    std::string error;
+    if (!openDocument(path, error)) std::cerr << path << ": " << error << std::endl;
+}
+
+void App::closeDocument(size_t index) {
+    Document& document = *m_documents[index];
+    m_scheduler->removeDocument(document.id);
+    if (document.program) glDeleteProgram(document.program);
+    for (const std::string& path : document.texturePaths) m_textures->release(path);
+    const bool focused = &document == m_document;
+    m_documents.erase(m_documents.begin() + static_cast<std::ptrdiff_t>(index));
+    if (m_documents.empty()) addDocument("Untitled " + std::to_string(++m_untitledCount));
+    if (focused) {
+        m_document = nullptr;
+        focusDocument(std::min(index, m_documents.size() - 1));
     }
-    
-    // Link shaders
-    m_shaderProgram = glCreateProgram();
-    glAttachShader(m_shaderProgram, vertexShader);
-    glAttachShader(m_shaderProgram, fragmentShader);
-    glLinkProgram(m_shaderProgram);
-    
-    glGetProgramiv(m_shaderProgram, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(m_shaderProgram, 512, NULL, infoLog);
-        m_shaderCompileError = true;
-        m_shaderErrorLog = "SHADER LINKING ERROR:\n" + std::string(infoLog);
+}
+
+void App::focusDocument(size_t index) {
+    Document* document = m_documents[index].get();
+    if (document == m_document) return;
+    if (m_document) m_scheduler->setPriority(m_document->id, CompileScheduler::Priority::Background);
+    m_scheduler->setPriority(document->id, CompileScheduler::Priority::Focused);
+    m_document = document;
+    m_shaderGraph = document->graph.get();
+    // Options that belong to the preview rather than to a document
+    m_shaderGraph->setNodePreviewSize(m_showNodePreviews ? 64.0f : 0.0f);
+    m_shaderGraph->setInstancedParameters(m_sweepPreview);
+    m_previewDirty = true;
+}
+
+App::Document* App::findDocument(uint32_t id) {
+    for (auto& document : m_documents) {
+        if (document->id == id) return document.get();
     }
-    
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+    return nullptr;
 }
 
-void App::initShaderGraph() {
-    m_shaderGraph = std::make_unique<ShaderGraph::ShaderGraphEditor>();
+// The focused document is rebuilt whenever it changes (with auto-compile on). Documents
+// that have never been built are submitted one per frame; the scheduler runs them after
+// the focused one.
+void App::updateDocuments() {
+    if (m_document && (m_autoCompile || !m_document->hasGraphRevision)) submitBuild(*m_document);
+    for (auto& document : m_documents) {
+        if (document.get() != m_document && !document->hasGraphRevision) {
+            submitBuild(*document);
+            break;
+        }
+    }
 }
 
-void App::updateShaderFromGraph() {
-    if (!m_shaderGraph) return;
+void App::submitBuild(Document& document) {
+    ShaderGraph::ShaderGraphEditor& graph = *document.graph;
     
-    std::string newCode = m_shaderGraph->generateFragmentShader();
+    // Skip generation entirely while the graph hasn't changed
+    if (document.hasGraphRevision && !graph.isShaderStale(document.lastGraphRevision)) return;
+    document.lastGraphRevision = graph.getRevision();
+    document.hasGraphRevision = true;
     
-    // Only recompile if code changed
-    if (newCode != m_lastGeneratedCode) {
-        m_lastGeneratedCode = newCode;
-        m_fragmentShaderSource = newCode;
-        compileShaders();
+    // The IR comes from the live nodes, so it's built here; the text is written on the
+    // pool. The scheduler drops the build when the text comes out the same as before.
+    m_profiler->beginCpu(m_passes.generate);
+    auto inputs = std::make_shared<ShaderGraph::ShaderGraphEditor::FragmentShaderInputs>();
+    graph.captureFragmentShader(*inputs);
+    m_profiler->endCpu(m_passes.generate);
+    
+    std::shared_ptr<FragmentWriter> writer = document.writer;
+    m_scheduler->submit(document.id, [inputs, writer](CompileScheduler::Sources& sources) {
+        writer->out.clear();
+        ShaderGraph::ShaderGraphEditor::writeFragmentShader(writer->out, writer->emitter, *inputs);
+        writer->out.copyTo(sources.fragment);
+        sources.vertex = ShaderGraph::buildVertexShader(inputs->useUniformBlock, inputs->instancedParameters);
+    });
+}
+
+// The streamer keeps a file while some document's material or baked samplers name it, so
+// textures replaced by an edit or a newer bake leave GPU memory
+void App::updateTextureReferences(Document& document) {
+    ShaderGraph::ShaderGraphEditor& graph = *document.graph;
+    const uint64_t revision = graph.getRevision() + graph.getParameterRegistry().getValueRevision();
+    if (document.hasTextureRevision && revision == document.textureRevision) return;
+    document.textureRevision = revision;
+    document.hasTextureRevision = true;
+    
+    std::vector<std::string> paths;
+    auto collect = [&paths](const std::vector<ShaderGraph::UniformParameter>& params) {
+        for (const auto& param : params) {
+            if (param.type == ShaderGraph::ShaderDataType::Sampler2D && !param.texturePath.empty()) {
+                paths.push_back(param.texturePath);
+            }
+        }
+    };
+    collect(graph.getParameterRegistry().parameters());
+    collect(graph.getBakedSamplers());
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+    // New references first, so paths in both lists never reach zero
+    for (const std::string& path : paths) m_textures->retain(path);
+    for (const std::string& path : document.texturePaths) m_textures->release(path);
+    document.texturePaths = std::move(paths);
+}
+
+void App::renderSchedulerStats() {
+    const CompileScheduler::Stats stats = m_scheduler->getStats();
+    const size_t focused = static_cast<size_t>(CompileScheduler::Priority::Focused);
+    const size_t background = static_cast<size_t>(CompileScheduler::Priority::Background);
+    ImGui::Text("Builds: %zu documents, %zu generating, %zu queued, %zu waiting for a slot, %zu/%zu compiling",
+                stats.documents, stats.generating, stats.queuedGenerations, stats.queuedCompiles, stats.compiling,
+                stats.slots);
+    ImGui::Text("Latency: focused %.1f ms (avg %.1f, max %.1f), background avg %.1f ms (max %.1f)",
+                stats.lastLatency[focused], stats.averageLatency[focused], stats.maxLatency[focused],
+                stats.averageLatency[background], stats.maxLatency[background]);
+    ImGui::TextDisabled("%llu built, %llu unchanged, %llu superseded", static_cast<unsigned long long>(stats.delivered),
+                        static_cast<unsigned long long>(stats.unchanged),
+                        static_cast<unsigned long long>(stats.superseded));
+}
+
+void App::initShaderGraph() {
+    // Per-platform fragment budgets; a cost_budgets.txt next to the executable replaces the defaults
+    m_costBudgets = ShaderGraph::defaultCostBudgets();
+    std::ifstream budgetFile("cost_budgets.txt");
+    if (budgetFile) {
+        std::stringstream text;
+        text << budgetFile.rdbuf();
+        std::vector<ShaderGraph::CostBudget> budgets;
+        std::string error;
+        if (ShaderGraph::parseCostBudgets(text.str(), budgets, error) && !budgets.empty()) {
+            m_costBudgets = std::move(budgets);
+            m_costBudget = 0;
+        } else if (!error.empty()) {
+            std::cerr << "cost_budgets.txt: " << error << std::endl;
+        }
     }
 }
 
 void App::shutdown() {
     // Cleanup OpenGL resources
-    if (m_cubeVAO) glDeleteVertexArrays(1, &m_cubeVAO);
-    if (m_cubeVBO) glDeleteBuffers(1, &m_cubeVBO);
-    if (m_shaderProgram) glDeleteProgram(m_shaderProgram);
+    if (m_mesh) m_mesh->shutdown();
+    if (m_perFrameUBO) glDeleteBuffers(1, &m_perFrameUBO);
+    if (m_scheduler) m_scheduler->shutdown();
+    if (m_variants) m_variants->shutdown();
+    if (m_textures) m_textures->shutdown();
+    if (m_sweep) m_sweep->shutdown();
+    if (m_nodePreviews) m_nodePreviews->shutdown();
+    if (m_profiler) m_profiler->shutdown();
+    for (auto& document : m_documents) {
+        if (document->program) glDeleteProgram(document->program);
+    }
+    m_documents.clear();
+    m_document = nullptr;
+    m_shaderGraph = nullptr;
     if (m_framebuffer) glDeleteFramebuffers(1, &m_framebuffer);
     if (m_textureColorbuffer) glDeleteTextures(1, &m_textureColorbuffer);
     if (m_rbo) glDeleteRenderbuffers(1, &m_rbo);
@@ -376,6 +487,8 @@ void App::shutdown() {
 }
 
 void App::renderCubeToTexture() {
+    m_profiler->beginGpu(m_passes.previewGpu);
+    
     // Bind our framebuffer
     glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
     glViewport(0, 0, m_fbWidth, m_fbHeight);
@@ -385,8 +498,9 @@ void App::renderCubeToTexture() {
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
     glEnable(GL_DEPTH_TEST);
     
-    if (m_shaderProgram && !m_shaderCompileError) {
-        glUseProgram(m_shaderProgram);
+    if (m_document && m_document->program) {
+        const UniformReflection& uniforms = *m_document->uniforms;
+        glUseProgram(m_document->program);
         
         // Create transformation matrices
         float model[16], view[16], projection[16];
@@ -400,46 +514,131 @@ void App::renderCubeToTexture() {
         // View matrix - camera position
         mat::lookAt(view, 0.0f, 0.0f, 3.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f);
         
-        // Projection matrix
-        mat::perspective(projection, 45.0f * 3.14159f / 180.0f, (float)m_fbWidth / (float)m_fbHeight, 0.1f, 100.0f);
+        // Projection matrix; a sweep grid draws every instance into its own cell
+        const bool sweep = uniforms.hasSweepBlock();
+        float aspect = (float)m_fbWidth / (float)m_fbHeight;
+        if (sweep) {
+            const ShaderGraph::ParameterRegistry& registry = m_shaderGraph->getParameterRegistry();
+            m_sweep->update(registry.parameters(), registry.getValueRevision());
+            aspect *= (float)m_sweep->getGridRows() / (float)m_sweep->getGridColumns();
+        }
+        mat::perspective(projection, 45.0f * 3.14159f / 180.0f, aspect, 0.1f, 100.0f);
         
         // Set built-in uniforms
-        glUniformMatrix4fv(glGetUniformLocation(m_shaderProgram, "model"), 1, GL_FALSE, model);
-        glUniformMatrix4fv(glGetUniformLocation(m_shaderProgram, "view"), 1, GL_FALSE, view);
-        glUniformMatrix4fv(glGetUniformLocation(m_shaderProgram, "projection"), 1, GL_FALSE, projection);
-        glUniform1f(glGetUniformLocation(m_shaderProgram, "time"), m_time);
-        glUniform3f(glGetUniformLocation(m_shaderProgram, "lightPos"), 2.0f, 2.0f, 2.0f);
-        glUniform3f(glGetUniformLocation(m_shaderProgram, "viewPos"), 0.0f, 0.0f, 3.0f);
-        glUniform3f(glGetUniformLocation(m_shaderProgram, "lightColor"), 1.0f, 1.0f, 1.0f);
-        glUniform3f(glGetUniformLocation(m_shaderProgram, "objectColor"), 0.3f, 0.6f, 0.9f);
+        if (uniforms.hasPerFrameBlock()) {
+            // One buffer write for all built-ins
+            PerFrameBlock block = {};
+            std::memcpy(block.model, model, sizeof(block.model));
+            std::memcpy(block.view, view, sizeof(block.view));
+            std::memcpy(block.projection, projection, sizeof(block.projection));
+            block.lightPos[0] = 2.0f; block.lightPos[1] = 2.0f; block.lightPos[2] = 2.0f;
+            block.time = m_time;
+            block.viewPos[0] = 0.0f; block.viewPos[1] = 0.0f; block.viewPos[2] = 3.0f;
+            block.lightColor[0] = 1.0f; block.lightColor[1] = 1.0f; block.lightColor[2] = 1.0f;
+            block.objectColor[0] = 0.3f; block.objectColor[1] = 0.6f; block.objectColor[2] = 0.9f;
+            
+            glBindBuffer(GL_UNIFORM_BUFFER, m_perFrameUBO);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(block), &block);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            glBindBufferBase(GL_UNIFORM_BUFFER, PerFrameBlockBinding, m_perFrameUBO);
+        } else {
+            const BuiltinUniformLocations& loc = uniforms.getBuiltins();
+            glUniformMatrix4fv(loc.model, 1, GL_FALSE, model);
+            glUniformMatrix4fv(loc.view, 1, GL_FALSE, view);
+            glUniformMatrix4fv(loc.projection, 1, GL_FALSE, projection);
+            glUniform1f(loc.time, m_time);
+            glUniform3f(loc.lightPos, 2.0f, 2.0f, 2.0f);
+            glUniform3f(loc.viewPos, 0.0f, 0.0f, 3.0f);
+            glUniform3f(loc.lightColor, 1.0f, 1.0f, 1.0f);
+            glUniform3f(loc.objectColor, 0.3f, 0.6f, 0.9f);
+        }
         
-        // Set user parameter uniforms
+        // Set user parameter uniforms and the textures of their samplers
         setShaderUniforms();
+        m_textures->bind(m_shaderGraph->getParameterRegistry().parameters(), &m_shaderGraph->getActiveParameters());
+        m_textures->bind(m_shaderGraph->getBakedSamplers());
         
-        // Draw the cube
-        glBindVertexArray(m_cubeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, 36);
-        glBindVertexArray(0);
+        // Draw the mesh, once per sweep cell in a single call
+        if (sweep) {
+            glUniform2i(uniforms.getBuiltins().sweepGrid, m_sweep->getGridColumns(), m_sweep->getGridRows());
+            m_mesh->draw(m_sweep->getInstanceCount());
+        } else {
+            m_mesh->draw();
+        }
     }
     
     glDisable(GL_DEPTH_TEST);
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    
+    m_profiler->endGpu(m_passes.previewGpu);
+}
+
+void App::renderNodePreviews() {
+    if (!m_shaderGraph || !m_showNodePreviews) return;
+    // Uses the visibility of the last drawn frame, so culled nodes cost nothing here
+    FrameProfiler::Scope scope(m_profiler.get(), m_passes.nodePreviews);
+    m_profiler->beginGpu(m_passes.nodePreviewsGpu);
+    m_nodePreviews->render(*m_shaderGraph, m_time);
+    m_profiler->endGpu(m_passes.nodePreviewsGpu);
+}
+
+bool App::previewNeedsRender() {
+    if (!m_renderOnDemand || m_previewDirty || m_rotatePreview) return true;
+    if (!m_shaderGraph) return false;
+    // Static materials only change when a parameter does
+    if (m_shaderGraph->getParameterRegistry().getValueRevision() != m_previewValueRevision) return true;
+    if (m_textures->getRevision() != m_previewTextureRevision) return true;
+    return m_shaderGraph->isTimeDependent();
+}
+
+// Seconds to wait for events before the next frame, or a negative value to keep
+// running at the display rate
+double App::idleWaitTimeout() {
+    if (!m_renderOnDemand) return -1.0;
+    if (m_activeFrames > 0) return -1.0;
+    if (m_scheduler->isBusy() || !m_pendingOpens.empty()) return -1.0;
+    if (m_variants->getStats().pending > 0) return -1.0;
+    if (m_textures->isBusy()) return -1.0;
+    if (m_bakeCache->getPendingCount() > 0) return -1.0;
+    if (m_showNodePreviews && m_nodePreviews->getStats().pending > 0) return -1.0;
+    if (glfwGetWindowAttrib(m_window, GLFW_ICONIFIED)) return 0.5;
+    
+    const bool focused = glfwGetWindowAttrib(m_window, GLFW_FOCUSED) != 0;
+    const bool animated = m_rotatePreview || (m_shaderGraph && m_shaderGraph->isTimeDependent());
+    if (animated) return focused ? -1.0 : 1.0 / 15.0;
+    if (m_showNodePreviews && m_nodePreviews->getStats().animated > 0) {
+        return std::max<double>(m_nodePreviews->getAnimationInterval(), focused ? 0.0 : 1.0 / 15.0);
+    }
+    return 0.5;
 }
 
 void App::setShaderUniforms() {
-    if (!m_shaderGraph || !m_shaderProgram) return;
+    if (!m_shaderGraph || !m_document->program) return;
+    FrameProfiler::Scope scope(m_profiler.get(), m_passes.uniforms);
     
-    const auto& params = m_shaderGraph->getParameters();
-    for (const auto& param : params) {
-        int loc = glGetUniformLocation(m_shaderProgram, param.name.c_str());
-        if (loc != -1) {
-            if (param.type == ShaderGraph::ShaderDataType::Float) {
-                glUniform1f(loc, param.floatValue);
-            } else if (param.type == ShaderGraph::ShaderDataType::Vec3) {
-                glUniform3f(loc, param.vec3Value[0], param.vec3Value[1], param.vec3Value[2]);
-            }
+    // Locations are only re-queried when the program or the parameter layout changes.
+    // Uniform values are program state, so after that only edited parameters are uploaded.
+    // Parameters the output doesn't read are skipped; connecting one changes the shader,
+    // and the new program gets every value.
+    ShaderGraph::ParameterRegistry& registry = m_shaderGraph->getParameterRegistry();
+    const auto& params = registry.parameters();
+    const auto& active = m_shaderGraph->getActiveParameters();
+    UniformReflection& uniforms = *m_document->uniforms;
+    const auto& locations = uniforms.getParameterLocations();
+    if (uniforms.resolveParameters(params, registry.getLayoutRevision())) {
+        for (size_t i = 0; i < params.size(); ++i) {
+            UniformReflection::upload(params[i], locations[i]);
+        }
+        // Baked subgraph samplers only change with the program
+        for (const auto& sampler : m_shaderGraph->getBakedSamplers()) {
+            UniformReflection::upload(sampler, glGetUniformLocation(uniforms.getProgram(), sampler.name.c_str()));
+        }
+    } else {
+        for (uint32_t i : registry.getDirty()) {
+            if (active[i]) UniformReflection::upload(params[i], locations[i]);
         }
     }
+    registry.clearDirty();
 }
 
 void App::renderPreviewWindow() {
@@ -468,9 +667,14 @@ void App::renderShaderEditorWindow() {
     ImGui::Begin("Generated Shader (Read-Only)");
     
     // Display compilation status at the top
-    if (m_shaderCompileError) {
+    if (m_scheduler->isBusy(m_document->id)) {
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.8f, 0.3f, 1.0f));
+        ImGui::Text("Compiling... (%s)", m_scheduler->getBackendName());
+        ImGui::PopStyleColor();
+        ImGui::Separator();
+    } else if (m_document->compileError) {
         ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.3f, 0.3f, 1.0f));
-        ImGui::TextWrapped("Compilation Error: %s", m_shaderErrorLog.c_str());
+        ImGui::TextWrapped("Compilation Error: %s", m_document->errorLog.c_str());
         ImGui::PopStyleColor();
         ImGui::Separator();
     } else {
@@ -484,9 +688,48 @@ void App::renderShaderEditorWindow() {
     ImGui::Checkbox("Auto-compile on graph change", &m_autoCompile);
     ImGui::SameLine();
     if (ImGui::Button("Compile Now")) {
-        updateShaderFromGraph();
+        submitBuild(*m_document);
+    }
+    bool useUniformBlock = m_shaderGraph->getUseUniformBlock();
+    if (ImGui::Checkbox("Built-ins as uniform block (std140)", &useUniformBlock)) {
+        m_shaderGraph->setUseUniformBlock(useUniformBlock);
+    }
+    bool liveTweak = m_shaderGraph->getLiveTweak();
+    if (ImGui::Checkbox("Live-tweak constants", &liveTweak)) {
+        m_shaderGraph->setLiveTweak(liveTweak);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Dragged Float and Color values are uploaded as uniforms and only\n"
+                          "folded back into the shader once the edit settles");
+    }
+    const ShaderGraph::PrecisionPolicy& precision = m_shaderGraph->getPrecisionPolicy();
+    ImGui::SetNextItemWidth(120.f);
+    if (ImGui::BeginCombo("Precision target", ShaderGraph::shaderTargetName(precision.target))) {
+        for (int target = 0; target < static_cast<int>(ShaderGraph::ShaderTarget::Count); ++target) {
+            const auto value = static_cast<ShaderGraph::ShaderTarget>(target);
+            if (ImGui::Selectable(ShaderGraph::shaderTargetName(value), value == precision.target)) {
+                m_shaderGraph->setPrecisionPolicy(ShaderGraph::PrecisionPolicy::forTarget(value));
+            }
+        }
+        ImGui::EndCombo();
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Mobile and console targets compute in half precision by default\n"
+                          "(mediump / min16float / half); positions, time and texture coordinates\n"
+                          "stay full. Right-click a node to override its precision.");
+    }
+    renderSubgraphBakeOptions();
+    renderSchedulerStats();
+    if (m_programCache->isEnabled()) {
+        ImGui::Text("Program cache: %zu hits, %zu misses, %zu rejected (%zu in memory)",
+                    m_programCache->getHits(), m_programCache->getMisses(),
+                    m_programCache->getRejected(), m_programCache->getMemoryEntries());
     }
     
+    ImGui::Separator();
+    renderCostSummary();
+    ImGui::Separator();
+    renderVariantsSummary();
     ImGui::Separator();
     
     // Tabs for vertex and fragment shaders (read-only)
@@ -495,7 +738,17 @@ void App::renderShaderEditorWindow() {
             // Read-only text display
             ImGui::BeginChild("FragmentShaderCode", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar);
             ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.9f, 0.9f, 1.0f));
-            ImGui::TextUnformatted(m_fragmentShaderSource.c_str());
+            ImGui::TextUnformatted(m_document->fragmentSource.c_str());
+            ImGui::PopStyleColor();
+            ImGui::EndChild();
+            ImGui::EndTabItem();
+        }
+        
+        if (ImGui::BeginTabItem("Fragment Shader (HLSL)")) {
+            // Emitted natively from the same IR as the GLSL shader
+            ImGui::BeginChild("HLSLShaderCode", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar);
+            ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.9f, 0.9f, 1.0f));
+            ImGui::TextUnformatted(m_shaderGraph->generateHLSLShader().c_str());
             ImGui::PopStyleColor();
             ImGui::EndChild();
             ImGui::EndTabItem();
@@ -505,7 +758,7 @@ void App::renderShaderEditorWindow() {
             // Read-only text display
             ImGui::BeginChild("VertexShaderCode", ImVec2(0, 0), true, ImGuiWindowFlags_HorizontalScrollbar);
             ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.9f, 0.9f, 0.9f, 1.0f));
-            ImGui::TextUnformatted(m_vertexShaderSource.c_str());
+            ImGui::TextUnformatted(m_document->vertexSource.c_str());
             ImGui::PopStyleColor();
             ImGui::EndChild();
             ImGui::EndTabItem();
@@ -516,26 +769,213 @@ void App::renderShaderEditorWindow() {
     ImGui::End();
 }
 
+void App::renderSubgraphBakeOptions() {
+    bool baking = m_shaderGraph->getSubgraphBaking();
+    if (ImGui::Checkbox("Bake UV-only subgraphs", &baking)) {
+        m_shaderGraph->setSubgraphBaking(baking);
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Subgraphs computed only from constants and UVs are rendered once into\n"
+                          "a texture and sampled instead, when they cost more than the threshold.\n"
+                          "The texture repeats outside [0, 1]. Right-click a node to override\n"
+                          "the format or size of the bake rooted at it.");
+    }
+    if (!baking) return;
+    
+    ShaderGraph::SubgraphBakeOptions options = m_shaderGraph->getSubgraphBakeOptions();
+    bool changed = false;
+    ImGui::SetNextItemWidth(120.f);
+    changed |= ImGui::DragFloat("Min cost", &options.minCost, 1.0f, 0.0f, 10000.0f, "%.0f");
+    static const uint32_t sizes[] = {64, 128, 256, 512, 1024, 2048};
+    ImGui::SetNextItemWidth(120.f);
+    if (ImGui::BeginCombo("Bake size", std::to_string(options.size).c_str())) {
+        for (uint32_t size : sizes) {
+            if (ImGui::Selectable(std::to_string(size).c_str(), size == options.size)) {
+                options.size = size;
+                changed = true;
+            }
+        }
+        ImGui::EndCombo();
+    }
+    bool half = options.format == ShaderGraph::BakeFormat::Half;
+    if (ImGui::Checkbox("Half-float bakes", &half)) {
+        options.format = half ? ShaderGraph::BakeFormat::Half : ShaderGraph::BakeFormat::UNorm8;
+        changed = true;
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("RGBA16F keeps the full range; 8-bit bakes store each channel\n"
+                          "remapped to the range it covers");
+    }
+    if (changed) m_shaderGraph->setSubgraphBakeOptions(options);
+    
+    const auto& samplers = m_shaderGraph->getBakedSamplers();
+    ImGui::Text("%zu subgraphs baked, %zu textures rendered", samplers.size(), m_shaderGraph->getBakeRenderCount());
+    const size_t pending = m_shaderGraph->getBakePendingCount();
+    if (pending > 0) ImGui::TextDisabled("%zu rendering", pending);
+    const std::string& error = m_shaderGraph->getBakeError();
+    if (!error.empty()) ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "Bake failed: %s", error.c_str());
+}
+
+void App::renderVariantsSummary() {
+    if (ImGui::Button("Build variants")) {
+        // Every permutation of the graph's static switch keywords
+        ShaderGraph::GraphDesc graph = m_shaderGraph->describe();
+        std::vector<std::string> keywords = ShaderGraph::keywordsOf(graph);
+        if (keywords.size() > ShaderGraph::MaxVariantKeywords) {
+            m_variantStatus = "Too many keywords (" + std::to_string(keywords.size()) + ", at most " +
+                              std::to_string(ShaderGraph::MaxVariantKeywords) + ")";
+        } else {
+            m_variants->build(graph, ShaderGraph::enumerateVariants(keywords), m_shaderGraph->getUseUniformBlock());
+            m_variantStatus.clear();
+        }
+    }
+    ImGui::SameLine();
+    const ShaderVariantManager::Stats& stats = m_variants->getStats();
+    if (!m_variantStatus.empty()) {
+        ImGui::TextUnformatted(m_variantStatus.c_str());
+    } else {
+        ImGui::Text("%zu variants, %zu programs: %zu ready (%zu cached), %zu failed, %zu pending", stats.variants,
+                    stats.programs, stats.ready, stats.fromCache, stats.failed, stats.pending);
+    }
+    if (stats.variants > 0 && ImGui::TreeNode("Variants")) {
+        const auto& programs = m_variants->getPrograms();
+        for (const auto& variant : m_variants->getVariants()) {
+            const ShaderVariantManager::Program& program = programs[variant.source];
+            const char* state = "queued";
+            switch (program.state) {
+                case ShaderVariantManager::State::Queued: state = "queued"; break;
+                case ShaderVariantManager::State::Building: state = "building"; break;
+                case ShaderVariantManager::State::Ready: state = program.fromCache ? "ready (cache)" : "ready"; break;
+                case ShaderVariantManager::State::Failed: state = "failed"; break;
+            }
+            ImGui::Text("%s: program %zu, %s", variant.name.c_str(), variant.source, state);
+        }
+        ImGui::TreePop();
+    }
+}
+
+void App::renderCostSummary() {
+    const ShaderGraph::ShaderCostReport& cost = m_shaderGraph->getCostReport();
+    
+    if (!m_costBudgets.empty()) {
+        m_costBudget = std::min(m_costBudget, static_cast<int>(m_costBudgets.size()) - 1);
+        ImGui::SetNextItemWidth(160.f);
+        if (ImGui::BeginCombo("Budget", m_costBudgets[m_costBudget].name.c_str())) {
+            for (int i = 0; i < static_cast<int>(m_costBudgets.size()); ++i) {
+                if (ImGui::Selectable(m_costBudgets[i].name.c_str(), i == m_costBudget)) m_costBudget = i;
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SameLine();
+    }
+    bool heatMap = m_shaderGraph->getCostHeatMap();
+    if (ImGui::Checkbox("Cost heat map", &heatMap)) m_shaderGraph->setCostHeatMap(heatMap);
+    
+    ImGui::Text("Estimated cost: %.0f ALU, %d transcendental, %d texture, %d registers (%d instructions)",
+                cost.total.alu, cost.total.transcendentals, cost.total.textureFetches, cost.registers,
+                cost.total.instructions);
+    ImGui::TextDisabled("Color: %.0f ALU, %d trans, %d tex | Alpha: %.0f ALU, %d trans, %d tex",
+                        cost.color.alu, cost.color.transcendentals, cost.color.textureFetches,
+                        cost.alpha.alu, cost.alpha.transcendentals, cost.alpha.textureFetches);
+    
+    if (!m_costBudgets.empty()) {
+        const std::vector<std::string> warnings = ShaderGraph::checkBudget(cost, m_costBudgets[m_costBudget]);
+        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 0.55f, 0.2f, 1.0f));
+        for (const auto& warning : warnings) ImGui::TextWrapped("Over budget - %s", warning.c_str());
+        ImGui::PopStyleColor();
+    }
+    
+    if (ImGui::CollapsingHeader("Cost per node")) {
+        // Most expensive first
+        const auto& nodes = m_shaderGraph->getCostNodes();
+        std::vector<size_t> order;
+        for (size_t i = 0; i < nodes.size() && i < cost.perNode.size(); ++i) {
+            if (cost.perNode[i].instructions > 0) order.push_back(i);
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+            return ShaderGraph::costScore(cost.perNode[a]) > ShaderGraph::costScore(cost.perNode[b]);
+        });
+        if (ImGui::BeginTable("##nodeCosts", 4, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+            ImGui::TableSetupColumn("Node");
+            ImGui::TableSetupColumn("ALU");
+            ImGui::TableSetupColumn("Trans");
+            ImGui::TableSetupColumn("Tex");
+            ImGui::TableHeadersRow();
+            for (size_t i : order) {
+                const ShaderGraph::ShaderCost& nodeCost = cost.perNode[i];
+                ImGui::TableNextRow();
+                ImGui::TableNextColumn();
+                ImGui::Text("%s #%llu", nodes[i]->getName().c_str(), static_cast<unsigned long long>(nodes[i]->getUID()));
+                ImGui::TableNextColumn();
+                ImGui::Text("%.0f", nodeCost.alu);
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", nodeCost.transcendentals);
+                ImGui::TableNextColumn();
+                ImGui::Text("%d", nodeCost.textureFetches);
+            }
+            ImGui::EndTable();
+        }
+    }
+}
+
 void App::renderNodeGraphWindow() {
     ImGui::Begin("Node Graph");
     
     ImGui::Text("Right-click to add nodes. Connect outputs to inputs.");
+    if (m_shaderGraph) {
+        ImGui::SameLine();
+        if (ImGui::Checkbox("Node previews", &m_showNodePreviews)) {
+            for (auto& document : m_documents) document->graph->setNodePreviewSize(m_showNodePreviews ? 64.0f : 0.0f);
+        }
+        if (m_showNodePreviews) {
+            const NodePreviewRenderer::Stats& stats = m_nodePreviews->getStats();
+            ImGui::SameLine();
+            ImGui::TextDisabled("%zu visible, %zu drawn, %zu programs%s", stats.visible, stats.drawn, stats.programs,
+                                stats.pending ? ", compiling..." : "");
+        }
+    }
     ImGui::Separator();
     
+    // One tab per document; only the selected one is drawn and edited
+    size_t selected = SIZE_MAX;
+    size_t closed = SIZE_MAX;
+    if (ImGui::BeginTabBar("Documents", ImGuiTabBarFlags_Reorderable | ImGuiTabBarFlags_FittingPolicyScroll)) {
+        for (size_t i = 0; i < m_documents.size(); ++i) {
+            Document& document = *m_documents[i];
+            const std::string label = document.name + "###document" + std::to_string(document.id);
+            bool open = true;
+            const ImGuiTabItemFlags flags = document.id == m_selectDocument ? ImGuiTabItemFlags_SetSelected : 0;
+            if (ImGui::BeginTabItem(label.c_str(), &open, flags)) {
+                selected = i;
+                ImGui::EndTabItem();
+            }
+            if (!open) closed = i;
+        }
+        m_selectDocument = 0;
+        if (ImGui::TabItemButton("+", ImGuiTabItemFlags_Trailing | ImGuiTabItemFlags_NoTooltip)) {
+            m_selectDocument = addDocument("Untitled " + std::to_string(++m_untitledCount)).id;
+        }
+        ImGui::EndTabBar();
+    }
+    if (selected != SIZE_MAX) focusDocument(selected);
+    
     // Get available size for the node graph
     ImVec2 availSize = ImGui::GetContentRegionAvail();
     
     if (m_shaderGraph) {
         m_shaderGraph->setSize(availSize);
+        m_profiler->beginCpu(m_passes.graphUpdate);
         m_shaderGraph->update();
-        
-        // Auto-compile when graph changes
-        if (m_autoCompile) {
-            updateShaderFromGraph();
-        }
+        m_profiler->endCpu(m_passes.graphUpdate);
     }
     
+    // Rebuild the focused graph when it changed, and start on the documents never built
+    updateDocuments();
+    
     ImGui::End();
+    
+    // After the editor is drawn, so the closed document isn't used this frame
+    if (closed != SIZE_MAX) closeDocument(closed);
 }
 
 void App::renderParametersWindow() {
@@ -547,16 +987,30 @@ void App::renderParametersWindow() {
         return;
     }
     
-    const auto& params = m_shaderGraph->getParameters();
+    const auto& registry = m_shaderGraph->getParameterRegistry();
+    const auto& params = registry.parameters();
+    const auto& active = m_shaderGraph->getActiveParameters();
     
     if (params.empty()) {
         ImGui::TextWrapped("No parameters defined. Add Float Parameter or Vec3 Parameter nodes to the graph to create CPU-controllable uniforms.");
     } else {
         ImGui::Text("Adjust shader parameters in real-time:");
+        const TextureStreamer::Stats& textureStats = m_textures->getStats();
+        if (textureStats.files > 0) {
+            ImGui::TextDisabled("Textures: %zu resident (%.1f MB), %zu loading, %zu failed%s", textureStats.resident,
+                                textureStats.residentBytes / (1024.0 * 1024.0), textureStats.loading,
+                                textureStats.failed, textureStats.persistentMapping ? "" : " (mapped per frame)");
+        }
         ImGui::Separator();
         
-        for (const auto& param : params) {
+        for (size_t i = 0; i < params.size(); ++i) {
+            // Copy: setParameterValue() writes into the registry storage
+            const ShaderGraph::UniformParameter param = params[i];
+            const ShaderGraph::ParameterHandle handle = registry.handles()[i];
+            if (registry.owner(handle)->isLiveConstant()) continue;  // Edited on its node
             ImGui::PushID(param.name.c_str());
+            // Not read by the output: not in the shader, so editing it here would do nothing
+            ImGui::BeginDisabled(!active[i]);
             
             if (param.type == ShaderGraph::ShaderDataType::Float) {
                 float value = param.floatValue;
@@ -565,7 +1019,7 @@ void App::renderParametersWindow() {
                 if (ImGui::SliderFloat("##value", &value, param.minValue, param.maxValue, "%.3f")) {
                     ShaderGraph::UniformParameter updatedParam = param;
                     updatedParam.floatValue = value;
-                    m_shaderGraph->setParameterValue(param.name, updatedParam);
+                    m_shaderGraph->setParameterValue(handle, updatedParam);
                 }
             } else if (param.type == ShaderGraph::ShaderDataType::Vec3) {
                 float color[3] = { param.vec3Value[0], param.vec3Value[1], param.vec3Value[2] };
@@ -576,28 +1030,248 @@ void App::renderParametersWindow() {
                     updatedParam.vec3Value[0] = color[0];
                     updatedParam.vec3Value[1] = color[1];
                     updatedParam.vec3Value[2] = color[2];
-                    m_shaderGraph->setParameterValue(param.name, updatedParam);
+                    m_shaderGraph->setParameterValue(handle, updatedParam);
+                }
+            } else if (param.type == ShaderGraph::ShaderDataType::Sampler2D) {
+                char path[260];
+                std::snprintf(path, sizeof(path), "%s", param.texturePath.c_str());
+                ImGui::Text("%s (unit %d)", param.displayName.c_str(), param.textureUnit);
+                ImGui::SetNextItemWidth(200.f);
+                if (ImGui::InputText("##path", path, sizeof(path))) {
+                    ShaderGraph::UniformParameter updatedParam = param;
+                    updatedParam.texturePath = path;
+                    m_shaderGraph->setParameterValue(handle, updatedParam);
                 }
+                const std::string& error = m_textures->getError(param.texturePath);
+                if (!error.empty()) ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.4f, 1.0f), "%s", error.c_str());
             }
             
             // Show uniform name for reference
-            ImGui::TextDisabled("uniform: %s", param.name.c_str());
+            ImGui::TextDisabled(active[i] ? "uniform: %s" : "uniform: %s (inactive, not connected to the output)",
+                                param.name.c_str());
+            ImGui::EndDisabled();
             ImGui::Separator();
             
             ImGui::PopID();
         }
     }
     
+    renderSweepControls();
+    ImGui::End();
+}
+
+void App::renderSweepControls() {
+    if (!ImGui::CollapsingHeader("Parameter sweep")) return;
+    if (ImGui::Checkbox("Sweep grid preview", &m_sweepPreview)) {
+        m_shaderGraph->setInstancedParameters(m_sweepPreview);
+        m_previewDirty = true;
+    }
+    if (ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Draws the material once per grid cell in one instanced call, with the\n"
+                          "chosen parameters interpolated across columns and rows");
+    }
+    if (!m_sweepPreview) return;
+    
+    const auto& params = m_shaderGraph->getParameterRegistry().parameters();
+    auto axisControls = [&](const char* label, const ParameterSweep::Axis& current) {
+        ParameterSweep::Axis axis = current;
+        bool changed = false;
+        ImGui::PushID(label);
+        const ShaderGraph::UniformParameter* selected = nullptr;
+        for (const auto& param : params) {
+            if (param.name == axis.parameter) selected = &param;
+        }
+        ImGui::SetNextItemWidth(140.f);
+        if (ImGui::BeginCombo(label, selected ? selected->displayName.c_str() : "(none)")) {
+            if (ImGui::Selectable("(none)", !selected)) {
+                axis.parameter.clear();
+                changed = true;
+            }
+            for (const auto& param : params) {
+                if (!ShaderGraph::isSweepParameter(param)) continue;
+                ImGui::PushID(param.name.c_str());
+                if (ImGui::Selectable(param.displayName.c_str(), selected == &param)) {
+                    axis = ParameterSweep::axisFor(param, axis.steps);
+                    changed = true;
+                }
+                ImGui::PopID();
+            }
+            ImGui::EndCombo();
+        }
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(60.f);
+        changed |= ImGui::SliderInt("##steps", &axis.steps, 1, 16);
+        if (selected && selected->type == ShaderGraph::ShaderDataType::Vec3) {
+            changed |= ImGui::ColorEdit3("From", axis.from, ImGuiColorEditFlags_NoInputs);
+            ImGui::SameLine();
+            changed |= ImGui::ColorEdit3("To", axis.to, ImGuiColorEditFlags_NoInputs);
+        } else if (selected) {
+            float range[2] = {axis.from[0], axis.to[0]};
+            ImGui::SetNextItemWidth(200.f);
+            if (ImGui::DragFloat2("Range", range, 0.01f)) {
+                axis.from[0] = range[0];
+                axis.to[0] = range[1];
+                changed = true;
+            }
+        }
+        ImGui::PopID();
+        return changed ? std::make_optional(axis) : std::nullopt;
+    };
+    
+    if (auto axis = axisControls("Columns", m_sweep->getColumns())) {
+        m_sweep->setColumns(*axis);
+        m_previewDirty = true;
+    }
+    if (auto axis = axisControls("Rows", m_sweep->getRows())) {
+        m_sweep->setRows(*axis);
+        m_previewDirty = true;
+    }
+    if (ShaderGraph::sweepSlotCount(params) == 0) {
+        ImGui::TextDisabled("No Float or Vec3 parameters to sweep");
+    } else if (!m_document->uniforms->hasSweepBlock()) {
+        ImGui::TextDisabled("Waiting for the instanced program...");
+    } else {
+        ImGui::TextDisabled("%d x %d instances, one draw call", m_sweep->getGridColumns(), m_sweep->getGridRows());
+    }
+}
+
+void App::setPreviewMesh(int shape) {
+    ShaderGraph::MeshData mesh;
+    ShaderGraph::makeMeshShape(static_cast<ShaderGraph::MeshShape>(shape), mesh);
+    ShaderGraph::optimizeMesh(mesh);
+    m_mesh->upload(mesh);
+    m_meshShape = shape;
+    m_meshStatus.clear();
+    m_previewDirty = true;
+}
+
+void App::loadPreviewMesh() {
+    ShaderGraph::MeshData mesh;
+    std::string error;
+    if (!ShaderGraph::loadMesh(m_meshPath, mesh, error)) {
+        // Keep showing the current mesh
+        m_meshStatus = error;
+        std::cerr << "Mesh load failed: " << error << std::endl;
+        return;
+    }
+    m_mesh->upload(mesh);
+    m_meshShape = -1;
+    m_meshStatus = "Loaded";
+    m_previewDirty = true;
+}
+
+void App::renderMeshControls() {
+    const char* current = m_meshShape >= 0 ? ShaderGraph::meshShapeName(static_cast<ShaderGraph::MeshShape>(m_meshShape))
+                                           : "File";
+    ImGui::SetNextItemWidth(120.f);
+    if (ImGui::BeginCombo("Mesh", current)) {
+        for (int shape = 0; shape < static_cast<int>(ShaderGraph::MeshShape::Count); ++shape) {
+            if (ImGui::Selectable(ShaderGraph::meshShapeName(static_cast<ShaderGraph::MeshShape>(shape)), shape == m_meshShape)) {
+                setPreviewMesh(shape);
+            }
+        }
+        ImGui::EndCombo();
+    }
+    ImGui::SameLine();
+    ImGui::SetNextItemWidth(200.f);
+    ImGui::InputText("##meshPath", m_meshPath, sizeof(m_meshPath));
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Mesh file: .obj, .gltf or .glb");
+    ImGui::SameLine();
+    if (ImGui::Button("Load mesh") && m_meshPath[0]) loadPreviewMesh();
+    
+    const PreviewMesh::Stats& stats = m_mesh->getStats();
+    ImGui::TextDisabled("%zu vertices, %zu triangles, %.1f KB, ACMR %.2f", stats.vertices, stats.triangles,
+                        stats.bytes / 1024.0, stats.acmr);
+    if (!m_meshStatus.empty()) ImGui::TextWrapped("%s", m_meshStatus.c_str());
+}
+
+void App::renderProfilerWindow() {
+    ImGui::Begin("Profiler");
+    
+    bool paused = m_profiler->isPaused();
+    if (ImGui::Checkbox("Pause", &paused)) m_profiler->setPaused(paused);
+    if (!m_profiler->hasGpuTimers()) {
+        ImGui::SameLine();
+        ImGui::TextDisabled("(no GPU timer queries)");
+    }
+    
+    // Per-pass rolling history, each plot scaled to its own p99
+    if (ImGui::BeginTable("##passes", 6, ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp)) {
+        ImGui::TableSetupColumn("Pass");
+        ImGui::TableSetupColumn("Last");
+        ImGui::TableSetupColumn("Min");
+        ImGui::TableSetupColumn("Avg");
+        ImGui::TableSetupColumn("p99");
+        ImGui::TableSetupColumn("History (ms)", ImGuiTableColumnFlags_WidthStretch, 3.0f);
+        ImGui::TableHeadersRow();
+        
+        for (uint32_t pass = 0; pass < m_profiler->getPassCount(); ++pass) {
+            const FrameProfiler::Stats stats = m_profiler->getStats(pass);
+            const std::vector<float>& history = m_profiler->getHistory(pass);
+            ImGui::PushID(static_cast<int>(pass));
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(m_profiler->getPassName(pass).c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.last);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.min);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.avg);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", stats.p99);
+            ImGui::TableNextColumn();
+            ImGui::SetNextItemWidth(-FLT_MIN);
+            ImGui::PlotLines("##history", history.data(), static_cast<int>(history.size()),
+                             static_cast<int>(m_profiler->getHistoryOffset(pass)), nullptr, 0.0f,
+                             stats.p99 > 0.0f ? stats.p99 * 1.25f : 1.0f, ImVec2(0.0f, 24.0f));
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+    
+    ImGui::Separator();
+    ImGui::SetNextItemWidth(200.f);
+    ImGui::InputText("##tracePath", m_tracePath, sizeof(m_tracePath));
+    ImGui::SameLine();
+    if (ImGui::Button("Export Chrome trace")) {
+        std::string error;
+        m_traceStatus = m_profiler->writeChromeTrace(m_tracePath, error) ? std::string("Wrote ") + m_tracePath : error;
+    }
+    if (!m_traceStatus.empty()) ImGui::TextWrapped("%s", m_traceStatus.c_str());
+    
     ImGui::End();
 }
 
 void App::render() {
-    // Update animation
-    m_time = (float)glfwGetTime();
-    m_rotationAngle += 0.01f;
+    m_profiler->beginFrame();
     
-    // Render cube to texture
-    renderCubeToTexture();
+    // Update animation (time based, so throttled frames keep the same speed)
+    float now = (float)glfwGetTime();
+    m_frameDelta = now - m_time;
+    m_time = now;
+    if (m_rotatePreview) m_rotationAngle += 0.6f * m_frameDelta;
+    
+    // Swap in any program that finished building in the background
+    openPendingDocuments();
+    pollCompileScheduler();
+    m_variants->update();
+    m_textures->update();
+    m_bakeCache->update();
+    for (auto& document : m_documents) {
+        document->graph->updateBakes();
+        updateTextureReferences(*document);
+    }
+    
+    // Render cube to texture, unless nothing it depends on has changed
+    if (previewNeedsRender()) {
+        renderCubeToTexture();
+        m_previewDirty = false;
+        if (m_shaderGraph) m_previewValueRevision = m_shaderGraph->getParameterRegistry().getValueRevision();
+        m_previewTextureRevision = m_textures->getRevision();
+        m_previewRenders++;
+    }
+    renderNodePreviews();
     
     // Start the Dear ImGui frame
     ImGui_ImplOpenGL3_NewFrame();
@@ -641,6 +1315,7 @@ void App::render() {
     renderParametersWindow();
     renderNodeGraphWindow();
     renderShaderEditorWindow();
+    renderProfilerWindow();
     
     // Stats window
     ImGui::Begin("ShaderGraph");
@@ -650,7 +1325,46 @@ void App::render() {
     ImGui::Separator();
     ImGui::Text("Time: %.2f", m_time);
     ImGui::Text("Rotation: %.2f", m_rotationAngle);
+    if (ImGui::Checkbox("Rotate preview", &m_rotatePreview)) m_previewDirty = true;
+    ImGui::SameLine();
+    if (ImGui::Checkbox("Render on demand", &m_renderOnDemand)) m_previewDirty = true;
+    if (m_renderOnDemand && m_shaderGraph) {
+        ImGui::TextDisabled("%s material, %zu preview renders%s",
+                            m_shaderGraph->isTimeDependent() ? "Animated" : "Static", m_previewRenders,
+                            m_idle ? ", idle" : "");
+    }
+    renderMeshControls();
     ImGui::Separator();
+    if (m_shaderGraph) {
+        ImGui::SetNextItemWidth(200.f);
+        ImGui::InputText("##graphPath", m_document->path, sizeof(m_document->path));
+        ImGui::SameLine();
+        if (ImGui::Button("Save")) {
+            std::string error;
+            const bool saved = m_shaderGraph->saveToFile(m_document->path, error);
+            if (saved) m_document->name = fileName(m_document->path);
+            m_document->fileStatus = saved ? "Saved" : error;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Load")) {
+            std::string error;
+            const bool loaded = m_shaderGraph->loadFromFile(m_document->path, error);
+            if (loaded) m_document->name = fileName(m_document->path);
+            m_document->fileStatus = loaded ? "Loaded" : error;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Open in new tab")) {
+            std::string error;
+            if (openDocument(m_document->path, error)) {
+                m_selectDocument = m_documents.back()->id;
+                m_document->fileStatus.clear();
+            } else {
+                m_document->fileStatus = error;
+            }
+        }
+        if (!m_document->fileStatus.empty()) ImGui::TextWrapped("%s", m_document->fileStatus.c_str());
+        ImGui::Separator();
+    }
     ImGui::TextWrapped("Instructions:");
     ImGui::BulletText("Right-click in Node Graph to add nodes");
     ImGui::BulletText("Drag from output to input pins to connect");
@@ -662,18 +1376,31 @@ void App::render() {
     int display_w, display_h;
     glfwGetFramebufferSize(m_window, &display_w, &display_h);
     glViewport(0, 0, display_w, display_h);
+    m_profiler->beginGpu(m_passes.imguiGpu);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    m_profiler->endGpu(m_passes.imguiGpu);
 
     glfwSwapBuffers(m_window);
+    m_profiler->endFrame();
 }
 
 void App::run() {
     std::cout << "App is running..." << std::endl;
     
     while (m_window && !glfwWindowShouldClose(m_window)) {
-        glfwPollEvents();
+        double timeout = idleWaitTimeout();
+        m_idle = timeout >= 0.0;
+        if (m_idle) {
+            double start = glfwGetTime();
+            glfwWaitEventsTimeout(timeout);
+            // Woken by input: ImGui needs a few frames to settle hover and animation state
+            if (glfwGetTime() - start < timeout * 0.9) m_activeFrames = 3;
+        } else {
+            glfwPollEvents();
+            if (m_activeFrames > 0) m_activeFrames--;
+        }
         render();
     }
 }
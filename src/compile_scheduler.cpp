@@ -0,0 +1,307 @@
+#include "compile_scheduler.h"
+#include "hash_util.h"
+#include "gl_platform.h"
+#include <algorithm>
+
+CompileScheduler::CompileScheduler(unsigned workerCount, unsigned maxCompiles)
+    : m_workerCount(workerCount), m_maxCompiles(std::max(1u, maxCompiles)) {
+    if (m_workerCount == 0) {
+        const unsigned cores = std::thread::hardware_concurrency();
+        m_workerCount = cores > 1 ? cores - 1 : 1;
+    }
+}
+
+CompileScheduler::~CompileScheduler() {
+    shutdown();
+}
+
+void CompileScheduler::init(GLFWwindow* mainWindow) {
+    // The first slot picks the backend. Synchronous builds block the render thread, so
+    // more than one slot would only stack them into the same frame.
+    Slot first;
+    first.compiler = std::make_unique<ShaderCompiler>();
+    first.compiler->init(mainWindow);
+    const bool synchronous = first.compiler->getBackend() == ShaderCompiler::Backend::Synchronous;
+    m_slots.push_back(std::move(first));
+    for (unsigned i = 1; i < m_maxCompiles && !synchronous; ++i) {
+        Slot slot;
+        slot.compiler = std::make_unique<ShaderCompiler>();
+        slot.compiler->init(mainWindow);
+        m_slots.push_back(std::move(slot));
+    }
+
+    m_quit = false;
+    for (unsigned i = 0; i < m_workerCount; ++i) m_workers.emplace_back(&CompileScheduler::workerLoop, this);
+}
+
+void CompileScheduler::shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_cv.notify_all();
+    for (std::thread& worker : m_workers) worker.join();
+    m_workers.clear();
+
+    // Builds in flight are released by their compiler
+    for (Slot& slot : m_slots) slot.compiler->shutdown();
+    m_slots.clear();
+    for (Result& result : m_results) {
+        if (result.build.program) glDeleteProgram(result.build.program);
+    }
+    m_results.clear();
+    m_documents.clear();
+}
+
+void CompileScheduler::setProgramCache(ProgramCache* cache) {
+    for (Slot& slot : m_slots) slot.compiler->setProgramCache(cache);
+}
+
+CompileScheduler::DocumentId CompileScheduler::addDocument(Priority priority) {
+    auto document = std::make_unique<Document>();
+    document->id = m_nextDocument++;
+    document->priority = priority;
+    const DocumentId id = document->id;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_documents.push_back(std::move(document));
+    return id;
+}
+
+void CompileScheduler::removeDocument(DocumentId id) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Document* document = find(id);
+        if (!document) return;
+        // Erased by update() once no worker or slot refers to it
+        document->removed = true;
+        document->hasQueued = false;
+        document->queued = nullptr;
+        document->hasGenerated = false;
+        document->hasReady = false;
+    }
+    for (auto it = m_results.begin(); it != m_results.end();) {
+        if (it->document == id) {
+            if (it->build.program) glDeleteProgram(it->build.program);
+            it = m_results.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void CompileScheduler::setPriority(DocumentId id, Priority priority) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (Document* document = find(id)) document->priority = priority;
+}
+
+void CompileScheduler::submit(DocumentId id, Generator generate) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Document* document = find(id);
+        if (!document || document->removed) return;
+        if (document->hasQueued) m_stats.superseded++;
+        document->queued = std::move(generate);
+        document->queuedAt = Clock::now();
+        document->hasQueued = true;
+    }
+    m_cv.notify_one();
+}
+
+void CompileScheduler::update() {
+    // Finished builds; each slot has at most one
+    for (Slot& slot : m_slots) {
+        if (!slot.busy) continue;
+        ShaderCompiler::Result build;
+        if (!slot.compiler->poll(build)) continue;
+        slot.busy = false;
+
+        Document* document = find(slot.document);
+        if (!document || document->removed) {
+            if (build.program) glDeleteProgram(build.program);
+            if (document) document->slot = -1;
+            continue;
+        }
+        Result result;
+        result.document = document->id;
+        result.build = std::move(build);
+        result.sources = std::move(document->compiling);
+        result.latency = std::chrono::duration<double>(Clock::now() - document->compilingAt).count();
+        recordLatency(document->priority, result.latency);
+        document->slot = -1;
+        m_results.push_back(std::move(result));
+        m_stats.delivered++;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto& document : m_documents) {
+            if (!document->hasGenerated) continue;
+            document->hasGenerated = false;
+            if (document->hasLastHash && document->generated.hash == document->lastHash) {
+                // Same text as the build in the pipeline, e.g. an edit that was undone
+                m_stats.unchanged++;
+                continue;
+            }
+            if (document->hasReady) m_stats.superseded++;
+            document->ready = std::move(document->generated);
+            document->readyAt = document->generatedAt;
+            document->hasReady = true;
+            document->lastHash = document->ready.hash;
+            document->hasLastHash = true;
+        }
+
+        m_documents.erase(std::remove_if(m_documents.begin(), m_documents.end(),
+                                         [](const std::unique_ptr<Document>& document) {
+                                             return document->removed && !document->generating && document->slot < 0;
+                                         }),
+                          m_documents.end());
+    }
+
+    // One build per document at a time keeps its results in submit order
+    for (size_t i = 0; i < m_slots.size(); ++i) {
+        Slot& slot = m_slots[i];
+        if (slot.busy) continue;
+        Document* document = nextCompile();
+        if (!document) break;
+        slot.compiler->submit(document->ready.vertex, document->ready.fragment);
+        slot.document = document->id;
+        slot.busy = true;
+        document->compiling = std::move(document->ready);
+        document->compilingAt = document->readyAt;
+        document->hasReady = false;
+        document->slot = static_cast<int>(i);
+    }
+}
+
+bool CompileScheduler::poll(Result& result) {
+    if (m_results.empty()) return false;
+    result = std::move(m_results.front());
+    m_results.pop_front();
+    return true;
+}
+
+bool CompileScheduler::isBusy() const {
+    if (!m_results.empty()) return true;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& document : m_documents) {
+        if (document->removed) continue;
+        if (document->hasQueued || document->generating || document->hasGenerated || document->hasReady ||
+            document->slot >= 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CompileScheduler::isBusy(DocumentId id) const {
+    for (const Result& result : m_results) {
+        if (result.document == id) return true;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const Document* document = find(id);
+    if (!document || document->removed) return false;
+    return document->hasQueued || document->generating || document->hasGenerated || document->hasReady ||
+           document->slot >= 0;
+}
+
+CompileScheduler::Stats CompileScheduler::getStats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats stats = m_stats;
+    for (const auto& document : m_documents) {
+        if (document->removed) continue;
+        stats.documents++;
+        if (document->hasQueued) stats.queuedGenerations++;
+        if (document->generating) stats.generating++;
+        if (document->hasGenerated || document->hasReady) stats.queuedCompiles++;
+        if (document->slot >= 0) stats.compiling++;
+    }
+    stats.slots = m_slots.size();
+    return stats;
+}
+
+const char* CompileScheduler::getBackendName() const {
+    return m_slots.empty() ? "none" : m_slots.front().compiler->getBackendName();
+}
+
+void CompileScheduler::workerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        Document* document = nullptr;
+        m_cv.wait(lock, [&]() {
+            if (m_quit) return true;
+            document = nextGeneration();
+            return document != nullptr;
+        });
+        if (m_quit) break;
+
+        Sources sources;
+        const Clock::time_point submitted = document->queuedAt;
+        {
+            Generator generate = std::move(document->queued);
+            document->queued = nullptr;
+            document->hasQueued = false;
+            document->generating = true;
+            lock.unlock();
+
+            generate(sources);
+            Fnv1a64 hash;
+            hash.update(sources.vertex);
+            hash.update(sources.fragment);
+            sources.hash = hash.value();
+        }
+
+        lock.lock();
+        document->generating = false;
+        if (!document->removed) {
+            if (document->hasGenerated) m_stats.superseded++;
+            document->generated = std::move(sources);
+            document->generatedAt = submitted;
+            document->hasGenerated = true;
+        }
+        // A request that arrived meanwhile was held back while this one ran
+        if (document->hasQueued) m_cv.notify_one();
+    }
+}
+
+// Caller holds m_mutex
+CompileScheduler::Document* CompileScheduler::nextGeneration() {
+    Document* best = nullptr;
+    for (auto& document : m_documents) {
+        if (!document->hasQueued || document->generating || document->removed) continue;
+        if (!best || document->priority < best->priority ||
+            (document->priority == best->priority && document->queuedAt < best->queuedAt)) {
+            best = document.get();
+        }
+    }
+    return best;
+}
+
+CompileScheduler::Document* CompileScheduler::nextCompile() {
+    Document* best = nullptr;
+    for (auto& document : m_documents) {
+        if (!document->hasReady || document->slot >= 0 || document->removed) continue;
+        if (!best || document->priority < best->priority ||
+            (document->priority == best->priority && document->readyAt < best->readyAt)) {
+            best = document.get();
+        }
+    }
+    return best;
+}
+
+CompileScheduler::Document* CompileScheduler::find(DocumentId id) const {
+    for (const auto& document : m_documents) {
+        if (document->id == id) return document.get();
+    }
+    return nullptr;
+}
+
+void CompileScheduler::recordLatency(Priority priority, double seconds) {
+    const size_t index = static_cast<size_t>(priority);
+    const double ms = seconds * 1000.0;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    uint64_t& samples = m_stats.latencySamples[index];
+    samples++;
+    m_stats.lastLatency[index] = ms;
+    m_stats.averageLatency[index] += (ms - m_stats.averageLatency[index]) / static_cast<double>(samples);
+    m_stats.maxLatency[index] = std::max(m_stats.maxLatency[index], ms);
+}
@@ -0,0 +1,219 @@
+#include "frame_profiler.h"
+#include "gl_platform.h"
+#include <algorithm>
+#include <fstream>
+#include <cstdio>
+
+FrameProfiler::FrameProfiler(size_t historySize, size_t maxTraceEvents)
+    : m_historySize(std::max<size_t>(historySize, 1)),
+      m_maxTraceEvents(maxTraceEvents),
+      m_origin(std::chrono::steady_clock::now()) {
+    m_framePass = addPass("Frame", PassType::Cpu);
+}
+
+FrameProfiler::~FrameProfiler() {
+    shutdown();
+}
+
+void FrameProfiler::init() {
+    // ARB_timer_query is core in 3.3; a zero counter width means the driver can't time
+    GLint bits = 0;
+    glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &bits);
+    m_gpuTimers = bits > 0;
+    for (auto& pass : m_passes) {
+        if (pass.type == PassType::Gpu && m_gpuTimers) glGenQueries(QueryRingSize, pass.queries);
+    }
+    m_initialized = true;
+}
+
+void FrameProfiler::shutdown() {
+    if (!m_initialized) return;
+    for (auto& pass : m_passes) {
+        if (pass.type == PassType::Gpu && pass.queries[0]) glDeleteQueries(QueryRingSize, pass.queries);
+        std::fill(std::begin(pass.queries), std::end(pass.queries), 0u);
+    }
+    m_initialized = false;
+    m_gpuTimers = false;
+}
+
+uint32_t FrameProfiler::addPass(const std::string& name, PassType type) {
+    Pass pass;
+    pass.name = name;
+    pass.type = type;
+    pass.history.assign(m_historySize, 0.0f);
+    if (type == PassType::Gpu && m_gpuTimers) glGenQueries(QueryRingSize, pass.queries);
+    m_passes.push_back(std::move(pass));
+    return static_cast<uint32_t>(m_passes.size() - 1);
+}
+
+void FrameProfiler::beginFrame() {
+    beginCpu(m_framePass);
+}
+
+void FrameProfiler::endFrame() {
+    endCpu(m_framePass);
+
+    // Results normally arrive one or two frames late; never wait for them here
+    for (auto& pass : m_passes) {
+        if (pass.type != PassType::Gpu) continue;
+        for (uint32_t i = 0; i < QueryRingSize; ++i) collectGpu(pass, i);
+    }
+    m_frame++;
+}
+
+void FrameProfiler::beginCpu(uint32_t pass) {
+    Pass& p = m_passes[pass];
+    p.cpuOpen = !m_paused;
+    if (p.cpuOpen) p.cpuStartUs = nowUs();
+}
+
+void FrameProfiler::endCpu(uint32_t pass) {
+    Pass& p = m_passes[pass];
+    if (!p.cpuOpen) return;
+    p.cpuOpen = false;
+    record(pass, m_frame, p.cpuStartUs, nowUs() - p.cpuStartUs);
+}
+
+void FrameProfiler::beginGpu(uint32_t pass) {
+    Pass& p = m_passes[pass];
+    p.gpuOpen = false;
+    if (!m_gpuTimers || m_paused) return;
+
+    // The slot's previous query must be resolved before reuse; if the GPU is that far
+    // behind, skip this frame's sample rather than stall
+    size_t slot = p.nextQuery;
+    collectGpu(p, static_cast<uint32_t>(slot));
+    if (p.pending[slot].pending) return;
+
+    glBeginQuery(GL_TIME_ELAPSED, p.queries[slot]);
+    p.pending[slot].frame = m_frame;
+    p.pending[slot].startUs = nowUs();
+    p.gpuOpen = true;
+}
+
+void FrameProfiler::endGpu(uint32_t pass) {
+    Pass& p = m_passes[pass];
+    if (!p.gpuOpen) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    p.pending[p.nextQuery].pending = true;
+    p.nextQuery = (p.nextQuery + 1) % QueryRingSize;
+    p.gpuOpen = false;
+}
+
+void FrameProfiler::collectGpu(Pass& pass, uint32_t index) {
+    PendingQuery& query = pass.pending[index];
+    if (!query.pending) return;
+    GLint available = 0;
+    glGetQueryObjectiv(pass.queries[index], GL_QUERY_RESULT_AVAILABLE, &available);
+    if (!available) return;
+    GLuint64 elapsedNs = 0;
+    glGetQueryObjectui64v(pass.queries[index], GL_QUERY_RESULT, &elapsedNs);
+    query.pending = false;
+    record(static_cast<uint32_t>(&pass - m_passes.data()), query.frame, query.startUs,
+           static_cast<double>(elapsedNs) / 1000.0);
+}
+
+double FrameProfiler::nowUs() const {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - m_origin).count();
+}
+
+void FrameProfiler::record(uint32_t pass, uint64_t frame, double startUs, double durationUs) {
+    if (m_paused) return;
+    Pass& p = m_passes[pass];
+    p.history[p.historyNext] = static_cast<float>(durationUs / 1000.0);
+    p.historyNext = (p.historyNext + 1) % m_historySize;
+    p.historyCount++;
+
+    if (m_maxTraceEvents == 0) return;
+    TraceEvent event{pass, frame, startUs, durationUs};
+    if (m_trace.size() < m_maxTraceEvents) {
+        m_trace.push_back(event);
+    } else {
+        m_trace[m_traceNext] = event;
+    }
+    m_traceNext = (m_traceNext + 1) % m_maxTraceEvents;
+}
+
+FrameProfiler::Stats FrameProfiler::getStats(uint32_t pass) const {
+    const Pass& p = m_passes[pass];
+    Stats stats;
+    stats.samples = std::min(p.historyCount, m_historySize);
+    if (stats.samples == 0) return stats;
+
+    // The newest `samples` entries, walking back from the write cursor
+    std::vector<float> values;
+    values.reserve(stats.samples);
+    for (size_t i = 0; i < stats.samples; ++i) {
+        values.push_back(p.history[(p.historyNext + m_historySize - 1 - i) % m_historySize]);
+    }
+    stats.last = values.front();
+    stats.min = values.front();
+    double sum = 0.0;
+    for (float v : values) {
+        stats.min = std::min(stats.min, v);
+        sum += v;
+    }
+    stats.avg = static_cast<float>(sum / values.size());
+
+    size_t rank = std::min(values.size() - 1, (values.size() * 99) / 100);
+    std::nth_element(values.begin(), values.begin() + rank, values.end());
+    stats.p99 = values[rank];
+    return stats;
+}
+
+namespace {
+
+void appendJsonString(std::string& out, const std::string& text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) continue;
+        out += c;
+    }
+    out += '"';
+}
+
+} // namespace
+
+bool FrameProfiler::writeChromeTrace(const std::string& path, std::string& error) const {
+    constexpr int Pid = 1;
+    constexpr int CpuTrack = 1;
+    constexpr int GpuTrack = 2;
+
+    std::string out;
+    out.reserve(128 + m_trace.size() * 112);
+    out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    out += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+
+    // Oldest first
+    const size_t count = m_trace.size();
+    const size_t first = count < m_maxTraceEvents ? 0 : m_traceNext;
+    char buffer[160];
+    for (size_t i = 0; i < count; ++i) {
+        const TraceEvent& event = m_trace[(first + i) % count];
+        const Pass& pass = m_passes[event.pass];
+        const bool gpu = pass.type == PassType::Gpu;
+        out += ",\n{\"name\":";
+        appendJsonString(out, pass.name);
+        std::snprintf(buffer, sizeof(buffer),
+                      ",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+                      "\"args\":{\"frame\":%llu}}",
+                      gpu ? "gpu" : "cpu", Pid, gpu ? GpuTrack : CpuTrack, event.startUs, event.durationUs,
+                      static_cast<unsigned long long>(event.frame));
+        out += buffer;
+    }
+    out += "\n]}\n";
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        error = "cannot write " + path;
+        return false;
+    }
+    file << out;
+    if (!file) {
+        error = "write failed for " + path;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,318 @@
+#include "graph_binary.h"
+#include <fstream>
+#include <cstring>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace ShaderGraph {
+
+namespace {
+
+constexpr char GraphBinaryMagic[4] = {'S', 'G', 'R', 'B'};
+
+size_t alignUp(size_t value) { return (value + 7) & ~size_t(7); }
+
+bool inRange(uint64_t offset, uint64_t bytes, size_t size) {
+    return offset <= size && bytes <= size - offset;
+}
+
+} // namespace
+
+GraphFileView::~GraphFileView() {
+    close();
+}
+
+GraphFileView::GraphFileView(GraphFileView&& other) noexcept {
+    *this = std::move(other);
+}
+
+GraphFileView& GraphFileView::operator=(GraphFileView&& other) noexcept {
+    if (this == &other) return *this;
+    close();
+    m_header = other.m_header;
+    m_nodes = other.m_nodes;
+    m_links = other.m_links;
+    m_strings = other.m_strings;
+    m_mapping = other.m_mapping;
+    m_mappingSize = other.m_mappingSize;
+    m_mappingHandle = other.m_mappingHandle;
+    other.m_header = nullptr;
+    other.m_mapping = nullptr;
+    other.m_mappingSize = 0;
+    other.m_mappingHandle = nullptr;
+    return *this;
+}
+
+bool GraphFileView::open(const std::string& path, std::string& error) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path;
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+        CloseHandle(file);
+        error = path + ": empty file";
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        error = "cannot map " + path;
+        return false;
+    }
+    const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data) {
+        CloseHandle(mapping);
+        error = "cannot map " + path;
+        return false;
+    }
+    m_mappingHandle = mapping;
+    m_mappingSize = static_cast<size_t>(size.QuadPart);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        ::close(fd);
+        error = path + ": empty file";
+        return false;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        error = "cannot map " + path;
+        return false;
+    }
+    m_mappingSize = static_cast<size_t>(st.st_size);
+#endif
+    m_mapping = data;
+
+    if (!openMemory(m_mapping, m_mappingSize, error)) {
+        error = path + ": " + error;
+        close();
+        return false;
+    }
+    return true;
+}
+
+bool GraphFileView::openMemory(const void* data, size_t size, std::string& error) {
+    if (data != m_mapping) close();
+    if (!isGraphBinary(data, size) || size < sizeof(GraphFileHeader)) {
+        error = "not a binary shader graph";
+        return false;
+    }
+    const char* bytes = static_cast<const char*>(data);
+    m_header = reinterpret_cast<const GraphFileHeader*>(bytes);
+    if (m_header->version != GraphBinaryVersion) {
+        error = "unsupported version " + std::to_string(m_header->version);
+        m_header = nullptr;
+        return false;
+    }
+
+    const uint64_t nodeBytes = uint64_t(m_header->nodeCount) * sizeof(GraphFileNode);
+    const uint64_t linkBytes = uint64_t(m_header->linkCount) * sizeof(GraphFileLink);
+    if (!inRange(m_header->nodeOffset, nodeBytes, size) || !inRange(m_header->linkOffset, linkBytes, size) ||
+        !inRange(m_header->stringOffset, m_header->stringBytes, size) || (m_header->nodeOffset & 7) ||
+        (m_header->linkOffset & 7)) {
+        error = "truncated or corrupt tables";
+        m_header = nullptr;
+        return false;
+    }
+    m_nodes = reinterpret_cast<const GraphFileNode*>(bytes + m_header->nodeOffset);
+    m_links = reinterpret_cast<const GraphFileLink*>(bytes + m_header->linkOffset);
+    m_strings = bytes + m_header->stringOffset;
+
+    if (!validate(error)) {
+        m_header = nullptr;
+        return false;
+    }
+    return true;
+}
+
+// Bounds checks so later accesses need none
+bool GraphFileView::validate(std::string& error) {
+    for (uint32_t i = 0; i < m_header->nodeCount; ++i) {
+        const GraphFileNode& node = m_nodes[i];
+        if (node.kind >= static_cast<uint8_t>(NodeKind::Count)) {
+            error = "node " + std::to_string(i) + " has an unknown kind";
+            return false;
+        }
+        if (node.precision > static_cast<uint8_t>(ShaderPrecision::Half)) {
+            error = "node " + std::to_string(i) + " has an unknown precision";
+            return false;
+        }
+        if (node.textureUnit >= TextureUnitCount) {
+            error = "node " + std::to_string(i) + " has an out of range texture unit";
+            return false;
+        }
+        const unsigned bakeShift = node.bake & 0xF;
+        if ((node.bake >> 4) > static_cast<uint8_t>(BakeFormat::Off) || !validBakeSize(bakeShift ? 1u << bakeShift : 0)) {
+            error = "node " + std::to_string(i) + " has unknown bake settings";
+            return false;
+        }
+        if (!inRange(node.nameOffset, uint64_t(node.nameLength) + node.pathLength, m_header->stringBytes)) {
+            error = "node " + std::to_string(i) + " name is out of bounds";
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < m_header->linkCount; ++i) {
+        const GraphFileLink& link = m_links[i];
+        if (link.fromNode >= m_header->nodeCount || link.toNode >= m_header->nodeCount ||
+            link.fromPin >= nodeKindInfo(nodeKind(link.fromNode)).outputCount ||
+            link.toPin >= nodeKindInfo(nodeKind(link.toNode)).inputCount) {
+            error = "link " + std::to_string(i) + " is out of bounds";
+            return false;
+        }
+    }
+    return true;
+}
+
+void GraphFileView::close() {
+    if (m_mapping) {
+#ifdef _WIN32
+        UnmapViewOfFile(m_mapping);
+        CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+#else
+        munmap(const_cast<void*>(m_mapping), m_mappingSize);
+#endif
+    }
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_mappingHandle = nullptr;
+    m_header = nullptr;
+    m_nodes = nullptr;
+    m_links = nullptr;
+    m_strings = nullptr;
+}
+
+NodeDesc GraphFileView::toNodeDesc(uint32_t index) const {
+    const GraphFileNode& src = m_nodes[index];
+    NodeDesc dst;
+    dst.kind = static_cast<NodeKind>(src.kind);
+    dst.id = src.id;
+    std::memcpy(dst.pos, src.pos, sizeof(dst.pos));
+    std::memcpy(dst.value, src.value, sizeof(dst.value));
+    dst.textureUnit = src.textureUnit;
+    dst.precision = static_cast<ShaderPrecision>(src.precision);
+    dst.bakeFormat = static_cast<BakeFormat>(src.bake >> 4);
+    dst.bakeSize = (src.bake & 0xF) ? static_cast<uint16_t>(1u << (src.bake & 0xF)) : 0;
+    dst.name.assign(nodeName(index));
+    dst.path.assign(nodePath(index));
+    return dst;
+}
+
+void GraphFileView::toDesc(GraphDesc& graph) const {
+    graph.clear();
+    graph.nodes.reserve(nodeCount());
+    for (uint32_t i = 0; i < nodeCount(); ++i) graph.nodes.push_back(toNodeDesc(i));
+    graph.links.assign(reinterpret_cast<const LinkDesc*>(m_links),
+                       reinterpret_cast<const LinkDesc*>(m_links) + linkCount());
+}
+
+bool writeGraphBinary(const GraphDesc& graph, std::vector<char>& out, std::string& error) {
+    static_assert(sizeof(LinkDesc) == sizeof(GraphFileLink), "Links are copied as a block");
+
+    size_t stringBytes = 0;
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        const NodeDesc& node = graph.nodes[i];
+        // The text format refuses these as well
+        if (node.textureUnit < 0 || node.textureUnit >= TextureUnitCount) {
+            error = "node " + std::to_string(i) + " has an out of range texture unit";
+            return false;
+        }
+        stringBytes += node.name.size() + node.path.size();
+    }
+
+    GraphFileHeader header{};
+    std::memcpy(header.magic, GraphBinaryMagic, sizeof(header.magic));
+    header.version = GraphBinaryVersion;
+    header.nodeCount = static_cast<uint32_t>(graph.nodes.size());
+    header.linkCount = static_cast<uint32_t>(graph.links.size());
+    header.stringBytes = static_cast<uint32_t>(stringBytes);
+    header.nodeOffset = sizeof(GraphFileHeader);
+    header.linkOffset = header.nodeOffset + graph.nodes.size() * sizeof(GraphFileNode);
+    header.stringOffset = header.linkOffset + graph.links.size() * sizeof(GraphFileLink);
+
+    out.assign(alignUp(header.stringOffset + stringBytes), 0);
+    std::memcpy(out.data(), &header, sizeof(header));
+
+    auto* nodes = reinterpret_cast<GraphFileNode*>(out.data() + header.nodeOffset);
+    char* strings = out.data() + header.stringOffset;
+    uint32_t stringCursor = 0;
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        const NodeDesc& src = graph.nodes[i];
+        GraphFileNode& dst = nodes[i];
+        dst.id = src.id;
+        std::memcpy(dst.pos, src.pos, sizeof(dst.pos));
+        std::memcpy(dst.value, src.value, sizeof(dst.value));
+        dst.nameOffset = stringCursor;
+        dst.nameLength = static_cast<uint32_t>(src.name.size());
+        dst.kind = static_cast<uint8_t>(src.kind);
+        uint8_t sizeShift = 0;
+        while (src.bakeSize > (1u << sizeShift)) ++sizeShift;
+        dst.bake = static_cast<uint8_t>(static_cast<uint8_t>(src.bakeFormat) << 4 | (src.bakeSize ? sizeShift : 0));
+        dst.textureUnit = static_cast<uint8_t>(src.textureUnit);
+        dst.precision = static_cast<uint8_t>(src.precision);
+        dst.pathLength = static_cast<uint32_t>(src.path.size());
+        std::memcpy(strings + stringCursor, src.name.data(), src.name.size());
+        std::memcpy(strings + stringCursor + dst.nameLength, src.path.data(), src.path.size());
+        stringCursor += dst.nameLength + dst.pathLength;
+    }
+    if (!graph.links.empty()) {
+        std::memcpy(out.data() + header.linkOffset, graph.links.data(), graph.links.size() * sizeof(GraphFileLink));
+    }
+    return true;
+}
+
+bool loadGraphBinary(const std::string& path, GraphDesc& graph, std::string& error) {
+    GraphFileView view;
+    if (!view.open(path, error)) return false;
+    view.toDesc(graph);
+    return true;
+}
+
+bool saveGraphBinary(const std::string& path, const GraphDesc& graph, std::string& error) {
+    std::vector<char> data;
+    if (!writeGraphBinary(graph, data, error)) return false;
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        error = "cannot write " + path;
+        return false;
+    }
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file) {
+        error = "write failed for " + path;
+        return false;
+    }
+    return true;
+}
+
+bool isGraphBinary(const void* data, size_t size) {
+    return size >= sizeof(GraphBinaryMagic) && std::memcmp(data, GraphBinaryMagic, sizeof(GraphBinaryMagic)) == 0;
+}
+
+bool isGraphBinaryFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[sizeof(GraphBinaryMagic)] = {};
+    file.read(magic, sizeof(magic));
+    return isGraphBinary(magic, static_cast<size_t>(file.gcount()));
+}
+
+} // namespace ShaderGraph
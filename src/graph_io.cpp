@@ -0,0 +1,305 @@
+#include "graph_io.h"
+#include "graph_binary.h"
+#include <unordered_map>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+
+namespace ShaderGraph {
+
+namespace {
+
+constexpr int GraphTextVersion = 1;
+
+// Cursor over one line
+struct LineReader {
+    std::string_view line;
+    size_t pos = 0;
+
+    void skipSpace() {
+        while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t' || line[pos] == '\r')) pos++;
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return pos >= line.size();
+    }
+
+    // Next whitespace-separated token; a token may contain a "quoted string"
+    std::string_view token() {
+        skipSpace();
+        size_t start = pos;
+        bool quoted = false;
+        while (pos < line.size()) {
+            char c = line[pos];
+            if (c == '"') quoted = !quoted;
+            else if (!quoted && (c == ' ' || c == '\t' || c == '\r')) break;
+            else if (quoted && c == '\\' && pos + 1 < line.size()) pos++;
+            pos++;
+        }
+        return line.substr(start, pos - start);
+    }
+};
+
+bool parseUInt(std::string_view text, uint64_t& value) {
+    if (text.empty()) return false;
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') return false;
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return true;
+}
+
+bool parseFloats(std::string_view text, float* values, int maxCount, int& count) {
+    count = 0;
+    std::string buffer(text);
+    const char* cursor = buffer.c_str();
+    while (*cursor && count < maxCount) {
+        char* end = nullptr;
+        float v = std::strtof(cursor, &end);
+        if (end == cursor) return false;
+        values[count++] = v;
+        cursor = end;
+        if (*cursor == ',') cursor++;
+        else if (*cursor) return false;
+    }
+    return *cursor == '\0';
+}
+
+bool parseQuoted(std::string_view text, std::string& out) {
+    if (text.size() < 2 || text.front() != '"' || text.back() != '"') return false;
+    out.clear();
+    for (size_t i = 1; i + 1 < text.size(); ++i) {
+        if (text[i] == '\\' && i + 2 < text.size()) i++;
+        out += text[i];
+    }
+    return true;
+}
+
+void writeQuoted(std::string& out, const std::string& text) {
+    out += '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (c == '\n' || c == '\r') continue;
+        out += c;
+    }
+    out += '"';
+}
+
+void writeFloat(std::string& out, float value) {
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+    out += buffer;
+}
+
+int resolvePin(std::string_view text, const char* const* pins, uint8_t count) {
+    uint64_t index = 0;
+    if (parseUInt(text, index)) return index < count ? static_cast<int>(index) : -1;
+    return findPin(pins, count, text);
+}
+
+std::string lineError(size_t lineNumber, const std::string& message) {
+    return "line " + std::to_string(lineNumber) + ": " + message;
+}
+
+} // namespace
+
+bool parseGraphText(std::string_view text, GraphDesc& graph, std::string& error) {
+    graph.clear();
+    std::unordered_map<uint64_t, uint32_t> nodeIndex;
+    bool sawHeader = false;
+    size_t lineNumber = 0;
+
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) end = text.size();
+        LineReader reader{text.substr(start, end - start)};
+        start = end + 1;
+        lineNumber++;
+
+        if (reader.atEnd() || reader.line[reader.pos] == '#') continue;
+        std::string_view keyword = reader.token();
+
+        if (!sawHeader) {
+            uint64_t version = 0;
+            if (keyword != "shadergraph" || !parseUInt(reader.token(), version)) {
+                error = lineError(lineNumber, "expected 'shadergraph <version>' header");
+                return false;
+            }
+            if (version != GraphTextVersion) {
+                error = lineError(lineNumber, "unsupported version " + std::to_string(version));
+                return false;
+            }
+            sawHeader = true;
+            continue;
+        }
+
+        if (keyword == "node") {
+            NodeDesc node;
+            std::string_view kindName;
+            if (!parseUInt(reader.token(), node.id) || (kindName = reader.token()).empty()) {
+                error = lineError(lineNumber, "expected 'node <id> <kind>'");
+                return false;
+            }
+            if (!nodeKindFromName(kindName, node.kind)) {
+                error = lineError(lineNumber, "unknown node kind '" + std::string(kindName) + "'");
+                return false;
+            }
+            while (!reader.atEnd()) {
+                std::string_view field = reader.token();
+                size_t eq = field.find('=');
+                std::string_view key = field.substr(0, eq);
+                std::string_view value = eq == std::string_view::npos ? std::string_view() : field.substr(eq + 1);
+                int count = 0;
+                bool ok = false;
+                if (key == "pos") ok = parseFloats(value, node.pos, 2, count);
+                else if (key == "value") ok = parseFloats(value, node.value, 4, count);
+                else if (key == "name") ok = parseQuoted(value, node.name);
+                else if (key == "path") ok = parseQuoted(value, node.path);
+                else if (key == "precision") ok = precisionFromName(value, node.precision);
+                else if (key == "bake") ok = bakeFormatFromName(value, node.bakeFormat);
+                else if (key == "bakesize") {
+                    uint64_t size = 0;
+                    ok = parseUInt(value, size) && validBakeSize(size);
+                    node.bakeSize = static_cast<uint16_t>(size);
+                }
+                else if (key == "unit") {
+                    uint64_t unit = 0;
+                    ok = parseUInt(value, unit) && unit < TextureUnitCount;
+                    node.textureUnit = static_cast<int>(unit);
+                }
+                if (!ok) {
+                    error = lineError(lineNumber, "bad field '" + std::string(field) + "'");
+                    return false;
+                }
+            }
+            if (!nodeIndex.emplace(node.id, static_cast<uint32_t>(graph.nodes.size())).second) {
+                error = lineError(lineNumber, "duplicate node id " + std::to_string(node.id));
+                return false;
+            }
+            graph.nodes.push_back(std::move(node));
+        } else if (keyword == "link") {
+            uint64_t fromId = 0, toId = 0;
+            bool ok = parseUInt(reader.token(), fromId);
+            std::string_view fromPin = reader.token();
+            ok = parseUInt(reader.token(), toId) && ok;
+            std::string_view toPin = reader.token();
+            if (!ok || fromPin.empty() || toPin.empty()) {
+                error = lineError(lineNumber, "expected 'link <from id> <from pin> <to id> <to pin>'");
+                return false;
+            }
+            auto from = nodeIndex.find(fromId);
+            auto to = nodeIndex.find(toId);
+            if (from == nodeIndex.end() || to == nodeIndex.end()) {
+                error = lineError(lineNumber, "link refers to an unknown node");
+                return false;
+            }
+            const NodeKindInfo& fromInfo = nodeKindInfo(graph.nodes[from->second].kind);
+            const NodeKindInfo& toInfo = nodeKindInfo(graph.nodes[to->second].kind);
+            int fromIndex = resolvePin(fromPin, fromInfo.outputs, fromInfo.outputCount);
+            int toIndex = resolvePin(toPin, toInfo.inputs, toInfo.inputCount);
+            if (fromIndex < 0 || toIndex < 0) {
+                error = lineError(lineNumber, "unknown pin");
+                return false;
+            }
+            graph.links.push_back({from->second, static_cast<uint32_t>(fromIndex), to->second,
+                                   static_cast<uint32_t>(toIndex)});
+        } else {
+            error = lineError(lineNumber, "unknown record '" + std::string(keyword) + "'");
+            return false;
+        }
+    }
+
+    if (!sawHeader) {
+        error = "missing 'shadergraph' header";
+        return false;
+    }
+    return true;
+}
+
+std::string writeGraphText(const GraphDesc& graph) {
+    std::string out = "shadergraph " + std::to_string(GraphTextVersion) + "\n";
+    for (const auto& node : graph.nodes) {
+        out += "node " + std::to_string(node.id) + " " + nodeKindInfo(node.kind).name + " pos=";
+        writeFloat(out, node.pos[0]);
+        out += ',';
+        writeFloat(out, node.pos[1]);
+
+        bool hasValue = false;
+        for (float v : node.value) hasValue |= v != 0.0f;
+        if (hasValue) {
+            out += " value=";
+            for (int i = 0; i < 4; ++i) {
+                if (i) out += ',';
+                writeFloat(out, node.value[i]);
+            }
+        }
+        if (node.kind == NodeKind::Texture) out += " unit=" + std::to_string(node.textureUnit);
+        if (!node.name.empty()) {
+            out += " name=";
+            writeQuoted(out, node.name);
+        }
+        if (!node.path.empty()) {
+            out += " path=";
+            writeQuoted(out, node.path);
+        }
+        if (node.precision != ShaderPrecision::Default) out += std::string(" precision=") + precisionName(node.precision);
+        if (node.bakeFormat != BakeFormat::Default) out += std::string(" bake=") + bakeFormatName(node.bakeFormat);
+        if (node.bakeSize != 0) out += " bakesize=" + std::to_string(node.bakeSize);
+        out += '\n';
+    }
+    for (const auto& link : graph.links) {
+        if (link.fromNode >= graph.nodes.size() || link.toNode >= graph.nodes.size()) continue;
+        const NodeDesc& from = graph.nodes[link.fromNode];
+        const NodeDesc& to = graph.nodes[link.toNode];
+        const NodeKindInfo& fromInfo = nodeKindInfo(from.kind);
+        const NodeKindInfo& toInfo = nodeKindInfo(to.kind);
+        if (link.fromPin >= fromInfo.outputCount || link.toPin >= toInfo.inputCount) continue;
+        out += "link " + std::to_string(from.id) + " " + fromInfo.outputs[link.fromPin] + " " +
+               std::to_string(to.id) + " " + toInfo.inputs[link.toPin] + "\n";
+    }
+    return out;
+}
+
+bool loadGraphFile(const std::string& path, GraphDesc& graph, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    if (isGraphBinaryFile(path)) {
+        file.close();
+        return loadGraphBinary(path, graph, error);
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    if (!parseGraphText(buffer.str(), graph, error)) {
+        error = path + ": " + error;
+        return false;
+    }
+    return true;
+}
+
+bool saveGraphFile(const std::string& path, const GraphDesc& graph, std::string& error) {
+    const std::string binaryExtension = GraphBinaryExtension;
+    if (path.size() >= binaryExtension.size() &&
+        path.compare(path.size() - binaryExtension.size(), binaryExtension.size(), binaryExtension) == 0) {
+        return saveGraphBinary(path, graph, error);
+    }
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        error = "cannot write " + path;
+        return false;
+    }
+    file << writeGraphText(graph);
+    if (!file) {
+        error = "write failed for " + path;
+        return false;
+    }
+    return true;
+}
+
+} // namespace ShaderGraph
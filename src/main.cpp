@@ -1,10 +1,12 @@
 #include <iostream>
 #include "app.h"
 
-int main() {
+int main(int argc, char** argv) {
     std::cout << "Welcome to ShaderGraph!" << std::endl;
     
     App app;
+    // Graph files to open, one tab each; the first is focused
+    for (int i = 1; i < argc; ++i) app.open(argv[i]);
     app.init(1280, 720, "ShaderGraph");
     app.run();
     
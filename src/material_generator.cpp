@@ -0,0 +1,167 @@
+#include "material_generator.h"
+#include "shader_ir.h"
+#include "shader_lang.h"
+#include "uniform_reflection.h"
+#include "hash_util.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace ShaderGraph {
+
+namespace {
+
+// Default vertex shader, split so the built-in uniforms can be swapped for the PerFrame block
+const char* vertexShaderInputs = R"(
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec3 aNormal;
+layout (location = 2) in vec2 aTexCoord;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+
+)";
+
+const char* vertexShaderUniforms = R"(uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+)";
+
+const char* vertexShaderMain = R"(
+void main()
+{
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * aNormal;
+    TexCoord = aTexCoord;
+    gl_Position = projection * view * model * vec4(aPos, 1.0);
+}
+)";
+
+// Same surface as vertexShaderMain; the clip-space remap leaves depth untouched
+const char* instancedVertexShaderMain = R"(
+flat out int SweepInstance;
+uniform ivec2 sweepGrid;
+
+void main()
+{
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * aNormal;
+    TexCoord = aTexCoord;
+    SweepInstance = gl_InstanceID;
+
+    vec4 clip = projection * view * model * vec4(aPos, 1.0);
+    vec2 scale = 1.0 / vec2(max(sweepGrid, ivec2(1)));
+    vec2 cell = vec2(gl_InstanceID % max(sweepGrid.x, 1), gl_InstanceID / max(sweepGrid.x, 1));
+    vec2 center = vec2((cell.x + 0.5) * scale.x, 1.0 - (cell.y + 0.5) * scale.y) * 2.0 - 1.0;
+    clip.xy = clip.xy * scale + center * clip.w;
+    gl_Position = clip;
+}
+)";
+
+} // namespace
+
+void generateMaterial(const GraphDesc& graph, const MaterialOptions& options, MaterialSources& sources) {
+    IRModule module;
+    lowerGraph(graph, module, options.keywords);
+    // Parameters of disconnected nodes or dead branches are left out of the material
+    std::vector<UniformParameter> parameters = parametersOf(graph);
+    std::vector<uint8_t> active;
+    activeParameters(module, parameters, active);
+    sources.parameters.clear();
+    for (size_t i = 0; i < parameters.size(); ++i) {
+        if (active[i]) sources.parameters.push_back(std::move(parameters[i]));
+    }
+
+    // Subgraphs that fail to bake stay procedural
+    sources.bakes.clear();
+    if (options.subgraphBake) {
+        std::vector<SubgraphBake> bakes;
+        const std::vector<SubgraphBakeSettings> settings = subgraphBakeSettings(graph);
+        findSubgraphBakes(module, *options.subgraphBake, &settings, bakes);
+        for (SubgraphBake& bake : bakes) {
+            std::string error;
+            if (renderSubgraphBake(module, *options.subgraphBake, bake, error)) sources.bakes.push_back(std::move(bake));
+        }
+        applySubgraphBakes(module, sources.bakes, sources.parameters);
+        sources.bakes.erase(std::remove_if(sources.bakes.begin(), sources.bakes.end(),
+                                           [](const SubgraphBake& bake) { return bake.textureUnit < 0; }),
+                            sources.bakes.end());
+    }
+
+    CrossPlatformShaderGenerator generator;
+    sources.glsl = options.glsl ? generator.generateGLSL(module, sources.parameters, options.useUniformBlock,
+                                                         options.instancedParameters, options.precision)
+                                : std::string();
+    sources.hlsl = options.hlsl ? generator.generateHLSL(module, sources.parameters, options.precision) : std::string();
+    if (options.estimateCost) estimateCost(module, sources.cost);
+    else sources.cost.clear();
+}
+
+std::vector<std::vector<std::string>> enumerateVariants(const std::vector<std::string>& keywords) {
+    std::vector<std::vector<std::string>> sets;
+    if (keywords.size() > MaxVariantKeywords) return sets;
+    std::vector<std::string> sorted = keywords;
+    std::sort(sorted.begin(), sorted.end());
+    sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+    const size_t count = size_t(1) << sorted.size();
+    sets.resize(count);
+    for (size_t mask = 0; mask < count; ++mask) {
+        for (size_t k = 0; k < sorted.size(); ++k) {
+            if (mask & (size_t(1) << k)) sets[mask].push_back(sorted[k]);
+        }
+    }
+    return sets;
+}
+
+std::string variantName(const std::vector<std::string>& keywords) {
+    if (keywords.empty()) return "default";
+    std::string name;
+    for (const auto& keyword : keywords) {
+        if (!name.empty()) name += '+';
+        name += keyword;
+    }
+    return name;
+}
+
+void generateVariants(const GraphDesc& graph, const MaterialOptions& options,
+                      const std::vector<std::vector<std::string>>& keywordSets, MaterialVariants& out) {
+    out.variants.clear();
+    out.sources.clear();
+    out.hashes.clear();
+    out.variants.reserve(keywordSets.size());
+
+    std::unordered_map<uint64_t, size_t> byHash;
+    MaterialOptions variantOptions = options;
+    MaterialSources sources;
+    for (const auto& keywords : keywordSets) {
+        MaterialVariant variant;
+        variant.keywords = keywords;
+        std::sort(variant.keywords.begin(), variant.keywords.end());
+        variant.name = variantName(variant.keywords);
+
+        variantOptions.keywords = &variant.keywords;
+        generateMaterial(graph, variantOptions, sources);
+        Fnv1a64 hash;
+        hash.update(sources.glsl);
+        hash.update(sources.hlsl);
+
+        auto it = byHash.find(hash.value());
+        if (it == byHash.end()) {
+            it = byHash.emplace(hash.value(), out.sources.size()).first;
+            out.sources.push_back(std::move(sources));
+            out.hashes.push_back(hash.value());
+            sources = MaterialSources();
+        }
+        variant.source = it->second;
+        out.variants.push_back(std::move(variant));
+    }
+}
+
+std::string buildVertexShader(bool useUniformBlock, bool instancedParameters) {
+    return std::string(vertexShaderInputs) + (useUniformBlock ? PerFrameBlockGLSL : vertexShaderUniforms) +
+           (instancedParameters ? instancedVertexShaderMain : vertexShaderMain);
+}
+
+} // namespace ShaderGraph
@@ -0,0 +1,650 @@
+#include "mesh.h"
+#include "texture_image.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace ShaderGraph {
+
+namespace {
+
+constexpr float Pi = 3.14159265358979f;
+constexpr float UnitCubeRadius = 0.8660254f;
+
+struct Vec3 {
+    float x, y, z;
+};
+
+Vec3 operator+(Vec3 a, Vec3 b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+Vec3 operator-(Vec3 a, Vec3 b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+Vec3 operator*(Vec3 a, float s) { return {a.x * s, a.y * s, a.z * s}; }
+float dot(Vec3 a, Vec3 b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+Vec3 cross(Vec3 a, Vec3 b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+
+Vec3 normalize(Vec3 v) {
+    const float length = std::sqrt(dot(v, v));
+    return length > 1e-20f ? v * (1.0f / length) : Vec3{0.0f, 0.0f, 1.0f};
+}
+
+Vec3 position(const MeshData& mesh, uint32_t vertex) {
+    const float* p = &mesh.positions[size_t(vertex) * 3];
+    return {p[0], p[1], p[2]};
+}
+
+uint32_t addVertex(MeshData& mesh, Vec3 p, Vec3 n, float u, float v) {
+    const uint32_t index = static_cast<uint32_t>(mesh.vertexCount());
+    mesh.positions.insert(mesh.positions.end(), {p.x, p.y, p.z});
+    mesh.normals.insert(mesh.normals.end(), {n.x, n.y, n.z});
+    mesh.uvs.insert(mesh.uvs.end(), {u, v});
+    return index;
+}
+
+void addTriangle(MeshData& mesh, uint32_t a, uint32_t b, uint32_t c) {
+    mesh.indices.insert(mesh.indices.end(), {a, b, c});
+}
+
+// Grid of rows x columns vertices appended by the caller, row-major; the seam column
+// is duplicated so texture coordinates wrap
+void addGrid(MeshData& mesh, uint32_t first, int rows, int columns) {
+    for (int i = 0; i + 1 < rows; ++i) {
+        for (int j = 0; j + 1 < columns; ++j) {
+            const uint32_t a = first + uint32_t(i * columns + j);
+            const uint32_t b = a + 1;
+            const uint32_t d = a + uint32_t(columns);
+            const uint32_t c = d + 1;
+            addTriangle(mesh, a, b, c);
+            addTriangle(mesh, a, c, d);
+        }
+    }
+}
+
+// A point of a surface of revolution's profile: radius and height, with the outward
+// normal in the same (radius, height) plane
+struct ProfilePoint {
+    float r, y;
+    float nr, ny;
+};
+
+// Revolve a bottom-to-top profile around the y axis. Rows at radius zero collapse into
+// a pole, so their degenerate triangles are skipped.
+void addLathe(MeshData& mesh, const std::vector<ProfilePoint>& profile, int segments) {
+    const uint32_t first = static_cast<uint32_t>(mesh.vertexCount());
+    const int rows = static_cast<int>(profile.size());
+    const int columns = segments + 1;
+    for (int i = 0; i < rows; ++i) {
+        const ProfilePoint& p = profile[size_t(i)];
+        const float v = 1.0f - static_cast<float>(i) / static_cast<float>(rows - 1);
+        for (int j = 0; j < columns; ++j) {
+            const float u = static_cast<float>(j) / static_cast<float>(segments);
+            const float angle = u * 2.0f * Pi;
+            const float c = std::cos(angle), s = -std::sin(angle);
+            addVertex(mesh, {p.r * c, p.y, p.r * s}, normalize({p.nr * c, p.ny, p.nr * s}), u, v);
+        }
+    }
+    for (int i = 0; i + 1 < rows; ++i) {
+        for (int j = 0; j < segments; ++j) {
+            const uint32_t a = first + uint32_t(i * columns + j);
+            const uint32_t b = a + 1;
+            const uint32_t d = a + uint32_t(columns);
+            const uint32_t c = d + 1;
+            if (profile[size_t(i)].r > 0.0f) addTriangle(mesh, a, b, c);
+            if (profile[size_t(i) + 1].r > 0.0f) addTriangle(mesh, a, c, d);
+        }
+    }
+}
+
+// Catmull-Rom through (r, y) control points, with normals from the curve's tangent
+std::vector<ProfilePoint> smoothProfile(const std::vector<std::pair<float, float>>& points, int samplesPerSpan) {
+    std::vector<std::pair<float, float>> curve;
+    const size_t n = points.size();
+    for (size_t i = 0; i + 1 < n; ++i) {
+        const auto& p0 = points[i > 0 ? i - 1 : i];
+        const auto& p1 = points[i];
+        const auto& p2 = points[i + 1];
+        const auto& p3 = points[i + 2 < n ? i + 2 : i + 1];
+        for (int k = 0; k < samplesPerSpan; ++k) {
+            const float t = static_cast<float>(k) / static_cast<float>(samplesPerSpan);
+            const float t2 = t * t, t3 = t2 * t;
+            auto spline = [&](float a, float b, float c, float d) {
+                return 0.5f * (2.0f * b + (c - a) * t + (2.0f * a - 5.0f * b + 4.0f * c - d) * t2 +
+                               (3.0f * b - a - 3.0f * c + d) * t3);
+            };
+            curve.push_back({std::max(0.0f, spline(p0.first, p1.first, p2.first, p3.first)),
+                             spline(p0.second, p1.second, p2.second, p3.second)});
+        }
+    }
+    curve.push_back(points.back());
+
+    std::vector<ProfilePoint> profile;
+    for (size_t i = 0; i < curve.size(); ++i) {
+        const auto& prev = curve[i > 0 ? i - 1 : i];
+        const auto& next = curve[i + 1 < curve.size() ? i + 1 : i];
+        const float dr = next.first - prev.first, dy = next.second - prev.second;
+        const float length = std::max(std::sqrt(dr * dr + dy * dy), 1e-12f);
+        profile.push_back({curve[i].first, curve[i].second, dy / length, -dr / length});
+    }
+    return profile;
+}
+
+// Tube of varying radius along a curve in the xy plane
+template <typename Curve, typename Radius>
+void addTube(MeshData& mesh, Curve curve, Radius radius, int lengthSegments, int ringSegments) {
+    const uint32_t first = static_cast<uint32_t>(mesh.vertexCount());
+    const Vec3 binormal = {0.0f, 0.0f, 1.0f};
+    for (int i = 0; i <= lengthSegments; ++i) {
+        const float t = static_cast<float>(i) / static_cast<float>(lengthSegments);
+        const float dt = 1e-3f;
+        const Vec3 center = curve(t);
+        const Vec3 tangent = normalize(curve(std::min(t + dt, 1.0f)) - curve(std::max(t - dt, 0.0f)));
+        const Vec3 normal = normalize(cross(binormal, tangent));
+        const float r = radius(t);
+        for (int j = 0; j <= ringSegments; ++j) {
+            const float u = static_cast<float>(j) / static_cast<float>(ringSegments);
+            const float angle = u * 2.0f * Pi;
+            const Vec3 direction = normal * std::cos(angle) + binormal * std::sin(angle);
+            addVertex(mesh, center + direction * r, direction, u, t);
+        }
+    }
+    addGrid(mesh, first, lengthSegments + 1, ringSegments + 1);
+}
+
+void makeCube(MeshData& mesh) {
+    // Normal, right and up of each face; right x up = normal keeps the winding CCW
+    const Vec3 faces[6][3] = {
+        {{0, 0, 1}, {1, 0, 0}, {0, 1, 0}},   {{0, 0, -1}, {-1, 0, 0}, {0, 1, 0}},
+        {{1, 0, 0}, {0, 0, -1}, {0, 1, 0}},  {{-1, 0, 0}, {0, 0, 1}, {0, 1, 0}},
+        {{0, 1, 0}, {1, 0, 0}, {0, 0, -1}},  {{0, -1, 0}, {1, 0, 0}, {0, 0, 1}},
+    };
+    for (const auto& face : faces) {
+        const Vec3 n = face[0], right = face[1] * 0.5f, up = face[2] * 0.5f;
+        const Vec3 center = n * 0.5f;
+        const uint32_t a = addVertex(mesh, center - right - up, n, 0.0f, 1.0f);
+        addVertex(mesh, center + right - up, n, 1.0f, 1.0f);
+        addVertex(mesh, center + right + up, n, 1.0f, 0.0f);
+        addVertex(mesh, center - right + up, n, 0.0f, 0.0f);
+        addTriangle(mesh, a, a + 1, a + 2);
+        addTriangle(mesh, a, a + 2, a + 3);
+    }
+}
+
+void makeSphere(MeshData& mesh) {
+    const float radius = 0.8f;
+    const int rings = 32;
+    std::vector<ProfilePoint> profile;
+    for (int i = 0; i <= rings; ++i) {
+        const float phi = -0.5f * Pi + Pi * static_cast<float>(i) / static_cast<float>(rings);
+        const float r = i == 0 || i == rings ? 0.0f : std::cos(phi);
+        profile.push_back({radius * r, radius * std::sin(phi), r, std::sin(phi)});
+    }
+    addLathe(mesh, profile, 64);
+}
+
+void makePlane(MeshData& mesh) {
+    // Facing the camera, subdivided so vertex-stage effects have something to move
+    const float size = 1.2f;
+    const int divisions = 32;
+    const uint32_t first = static_cast<uint32_t>(mesh.vertexCount());
+    for (int i = 0; i <= divisions; ++i) {
+        const float v = static_cast<float>(i) / static_cast<float>(divisions);
+        for (int j = 0; j <= divisions; ++j) {
+            const float u = static_cast<float>(j) / static_cast<float>(divisions);
+            addVertex(mesh, {(u - 0.5f) * size, (0.5f - v) * size, 0.0f}, {0.0f, 0.0f, 1.0f}, u, v);
+        }
+    }
+    // Rows run top to bottom here, so flip the grid's winding
+    const uint32_t columns = divisions + 1;
+    for (uint32_t i = 0; i < uint32_t(divisions); ++i) {
+        for (uint32_t j = 0; j < uint32_t(divisions); ++j) {
+            const uint32_t a = first + i * columns + j;
+            addTriangle(mesh, a, a + columns, a + columns + 1);
+            addTriangle(mesh, a, a + columns + 1, a + 1);
+        }
+    }
+}
+
+void makeTorus(MeshData& mesh) {
+    const float major = 0.55f, minor = 0.25f;
+    const int tubeSegments = 32;
+    std::vector<ProfilePoint> profile;
+    for (int i = 0; i <= tubeSegments; ++i) {
+        // Start at the inner equator and go down and around, so the profile runs bottom
+        // to top on the outside like the lathe expects
+        const float psi = Pi + 2.0f * Pi * static_cast<float>(i) / static_cast<float>(tubeSegments);
+        const float c = std::cos(psi), s = std::sin(psi);
+        profile.push_back({major + minor * c, minor * s, c, s});
+    }
+    // The profile width never reaches zero, so no rows are skipped
+    addLathe(mesh, profile, 64);
+}
+
+// A teapot silhouette rather than Newell's patches: lathed body and lid, with the spout
+// and handle swept along Bezier curves
+void makeTeapot(MeshData& mesh) {
+    addLathe(mesh, smoothProfile({{0.0f, -0.42f}, {0.3f, -0.42f}, {0.44f, -0.36f}, {0.52f, -0.2f},
+                                  {0.53f, 0.0f}, {0.47f, 0.16f}, {0.38f, 0.26f}, {0.33f, 0.28f}}, 4),
+             48);
+    addLathe(mesh, smoothProfile({{0.34f, 0.27f}, {0.3f, 0.32f}, {0.18f, 0.37f}, {0.06f, 0.39f},
+                                  {0.05f, 0.43f}, {0.08f, 0.47f}, {0.0f, 0.5f}}, 4),
+             48);
+
+    auto quadratic = [](Vec3 a, Vec3 b, Vec3 c) {
+        return [=](float t) { return a * ((1 - t) * (1 - t)) + b * (2 * t * (1 - t)) + c * (t * t); };
+    };
+    auto cubic = [](Vec3 a, Vec3 b, Vec3 c, Vec3 d) {
+        return [=](float t) {
+            const float s = 1 - t;
+            return a * (s * s * s) + b * (3 * s * s * t) + c * (3 * s * t * t) + d * (t * t * t);
+        };
+    };
+    addTube(mesh, quadratic({0.42f, -0.12f, 0.0f}, {0.78f, -0.12f, 0.0f}, {0.8f, 0.26f, 0.0f}),
+            [](float t) { return 0.11f - 0.065f * t; }, 16, 16);
+    addTube(mesh, cubic({-0.46f, 0.16f, 0.0f}, {-0.86f, 0.26f, 0.0f}, {-0.86f, -0.26f, 0.0f}, {-0.48f, -0.2f, 0.0f}),
+            [](float) { return 0.045f; }, 24, 12);
+}
+
+// Forsyth, "Linear-speed vertex cache optimisation"
+constexpr int ForsythCacheSize = 32;
+
+float vertexScore(int cachePosition, uint32_t remaining) {
+    if (remaining == 0) return -1.0f;
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // The last triangle's vertices: fixed, so strips don't win over fans
+            score = 0.75f;
+        } else {
+            const float scaled = 1.0f - static_cast<float>(cachePosition - 3) / static_cast<float>(ForsythCacheSize - 3);
+            score = std::pow(scaled, 1.5f);
+        }
+    }
+    // Favour vertices with few triangles left, so they don't end up as lone stragglers
+    return score + 2.0f / std::sqrt(static_cast<float>(remaining));
+}
+
+std::vector<uint32_t> optimizeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount) {
+    const size_t triangleCount = indices.size() / 3;
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    if (triangleCount == 0) return result;
+
+    // Triangles of each vertex; the first `remaining` entries are the ones not emitted yet
+    std::vector<uint32_t> remaining(vertexCount, 0);
+    for (uint32_t index : indices) ++remaining[index];
+    std::vector<uint32_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; ++v) offsets[v + 1] = offsets[v] + remaining[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); ++i) adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) score[v] = vertexScore(-1, remaining[v]);
+
+    std::vector<float> triangleScore(triangleCount);
+    std::vector<bool> emitted(triangleCount, false);
+    int best = -1;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+        if (triangleScore[t] > bestScore) {
+            bestScore = triangleScore[t];
+            best = static_cast<int>(t);
+        }
+    }
+
+    std::vector<uint32_t> cache, nextCache;
+    cache.reserve(ForsythCacheSize + 3);
+    nextCache.reserve(ForsythCacheSize + 3);
+    size_t scanCursor = 0;
+
+    while (result.size() < indices.size()) {
+        if (best < 0) {
+            // Nothing in the cache has triangles left: continue with the next unemitted one
+            while (emitted[scanCursor]) ++scanCursor;
+            best = static_cast<int>(scanCursor);
+        }
+
+        const uint32_t* triangle = &indices[size_t(best) * 3];
+        emitted[size_t(best)] = true;
+        nextCache.clear();
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t v = triangle[k];
+            result.push_back(v);
+            nextCache.push_back(v);
+
+            // Move the triangle out of the vertex's remaining range
+            uint32_t* list = &adjacency[offsets[v]];
+            uint32_t& count = remaining[v];
+            for (uint32_t i = 0; i < count; ++i) {
+                if (list[i] == uint32_t(best)) {
+                    std::swap(list[i], list[count - 1]);
+                    break;
+                }
+            }
+            --count;
+        }
+        for (uint32_t v : cache) {
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) nextCache.push_back(v);
+        }
+        cache.swap(nextCache);
+
+        // Evicted vertices drop their cache bonus too
+        for (size_t i = 0; i < cache.size(); ++i) {
+            const uint32_t v = cache[i];
+            cachePosition[v] = i < size_t(ForsythCacheSize) ? static_cast<int>(i) : -1;
+            score[v] = vertexScore(cachePosition[v], remaining[v]);
+        }
+
+        best = -1;
+        bestScore = -1.0f;
+        for (uint32_t v : cache) {
+            for (uint32_t i = 0; i < remaining[v]; ++i) {
+                const uint32_t t = adjacency[offsets[v] + i];
+                const float s = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                triangleScore[t] = s;
+                if (s > bestScore) {
+                    bestScore = s;
+                    best = static_cast<int>(t);
+                }
+            }
+        }
+        if (cache.size() > size_t(ForsythCacheSize)) cache.resize(ForsythCacheSize);
+    }
+    return result;
+}
+
+// Sander, Nehab and Barczak, "Fast triangle reordering for vertex locality and reduced
+// overdraw": cut the cache-ordered list where the simulated cache starts over, then draw
+// the clusters that face away from the mesh's center first, since they occlude the rest
+// from most view directions. Clusters keep their internal order, so cache reuse is kept.
+std::vector<uint32_t> optimizeOverdraw(const MeshData& mesh, const std::vector<uint32_t>& indices) {
+    const size_t triangleCount = indices.size() / 3;
+    const size_t cacheSize = 16;
+
+    std::vector<size_t> clusterStarts;
+    std::vector<uint32_t> fifo;
+    for (size_t t = 0; t < triangleCount; ++t) {
+        int misses = 0;
+        for (int k = 0; k < 3; ++k) {
+            const uint32_t v = indices[t * 3 + k];
+            if (std::find(fifo.begin(), fifo.end(), v) != fifo.end()) continue;
+            ++misses;
+            fifo.insert(fifo.begin(), v);
+            if (fifo.size() > cacheSize) fifo.pop_back();
+        }
+        if (t == 0 || misses == 3) clusterStarts.push_back(t);
+    }
+    clusterStarts.push_back(triangleCount);
+    if (clusterStarts.size() <= 2) return indices;
+
+    Vec3 meshCenter = {0.0f, 0.0f, 0.0f};
+    float meshArea = 0.0f;
+    struct Cluster {
+        size_t begin, end;
+        float sortKey;
+    };
+    std::vector<Cluster> clusters;
+    std::vector<std::pair<Vec3, Vec3>> moments;   // Area-weighted centroid sum and normal sum
+    for (size_t c = 0; c + 1 < clusterStarts.size(); ++c) {
+        Vec3 centroid = {0.0f, 0.0f, 0.0f}, normal = {0.0f, 0.0f, 0.0f};
+        float area = 0.0f;
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t) {
+            const Vec3 a = position(mesh, indices[t * 3]);
+            const Vec3 b = position(mesh, indices[t * 3 + 1]);
+            const Vec3 d = position(mesh, indices[t * 3 + 2]);
+            const Vec3 n = cross(b - a, d - a);
+            const float triangleArea = 0.5f * std::sqrt(dot(n, n));
+            centroid = centroid + (a + b + d) * (triangleArea / 3.0f);
+            normal = normal + n;
+            area += triangleArea;
+        }
+        meshCenter = meshCenter + centroid;
+        meshArea += area;
+        clusters.push_back({clusterStarts[c], clusterStarts[c + 1], 0.0f});
+        moments.push_back({area > 0.0f ? centroid * (1.0f / area) : centroid, normalize(normal)});
+    }
+    if (meshArea > 0.0f) meshCenter = meshCenter * (1.0f / meshArea);
+    for (size_t c = 0; c < clusters.size(); ++c) {
+        clusters[c].sortKey = dot(moments[c].first - meshCenter, moments[c].second);
+    }
+    std::stable_sort(clusters.begin(), clusters.end(),
+                     [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices.size());
+    for (const auto& cluster : clusters) {
+        result.insert(result.end(), indices.begin() + std::ptrdiff_t(cluster.begin * 3),
+                      indices.begin() + std::ptrdiff_t(cluster.end * 3));
+    }
+    return result;
+}
+
+// Renumber vertices in order of first use and drop unreferenced ones
+void optimizeVertexFetch(MeshData& mesh) {
+    const size_t vertexCount = mesh.vertexCount();
+    std::vector<uint32_t> remap(vertexCount, UINT32_MAX);
+    uint32_t next = 0;
+    for (uint32_t& index : mesh.indices) {
+        if (remap[index] == UINT32_MAX) remap[index] = next++;
+        index = remap[index];
+    }
+
+    auto reorder = [&](std::vector<float>& attribute, size_t components) {
+        if (attribute.size() != vertexCount * components) return;
+        std::vector<float> reordered(size_t(next) * components);
+        for (size_t v = 0; v < vertexCount; ++v) {
+            if (remap[v] == UINT32_MAX) continue;
+            std::copy_n(&attribute[v * components], components, &reordered[size_t(remap[v]) * components]);
+        }
+        attribute.swap(reordered);
+    };
+    reorder(mesh.positions, 3);
+    reorder(mesh.normals, 3);
+    reorder(mesh.uvs, 2);
+}
+
+} // namespace
+
+void MeshData::clear() {
+    positions.clear();
+    normals.clear();
+    uvs.clear();
+    indices.clear();
+}
+
+const char* meshShapeName(MeshShape shape) {
+    switch (shape) {
+        case MeshShape::Cube: return "Cube";
+        case MeshShape::Sphere: return "Sphere";
+        case MeshShape::Plane: return "Plane";
+        case MeshShape::Torus: return "Torus";
+        case MeshShape::Teapot: return "Teapot";
+        default: return "Mesh";
+    }
+}
+
+void makeMeshShape(MeshShape shape, MeshData& mesh) {
+    mesh.clear();
+    switch (shape) {
+        case MeshShape::Sphere: makeSphere(mesh); break;
+        case MeshShape::Plane: makePlane(mesh); break;
+        case MeshShape::Torus: makeTorus(mesh); break;
+        case MeshShape::Teapot:
+            makeTeapot(mesh);
+            normalizeMesh(mesh);
+            break;
+        default: makeCube(mesh); break;
+    }
+}
+
+void completeMesh(MeshData& mesh) {
+    const size_t vertexCount = mesh.vertexCount();
+    mesh.positions.resize(vertexCount * 3);
+    mesh.indices.resize(mesh.indices.size() - mesh.indices.size() % 3);
+
+    if (mesh.normals.size() != vertexCount * 3) {
+        // Unnormalized cross products weight each face by its area
+        mesh.normals.assign(vertexCount * 3, 0.0f);
+        for (size_t t = 0; t < mesh.triangleCount(); ++t) {
+            const uint32_t* triangle = &mesh.indices[t * 3];
+            const Vec3 a = position(mesh, triangle[0]);
+            const Vec3 n = cross(position(mesh, triangle[1]) - a, position(mesh, triangle[2]) - a);
+            for (int k = 0; k < 3; ++k) {
+                float* out = &mesh.normals[size_t(triangle[k]) * 3];
+                out[0] += n.x;
+                out[1] += n.y;
+                out[2] += n.z;
+            }
+        }
+        for (size_t v = 0; v < vertexCount; ++v) {
+            float* out = &mesh.normals[v * 3];
+            const Vec3 n = normalize({out[0], out[1], out[2]});
+            out[0] = n.x;
+            out[1] = n.y;
+            out[2] = n.z;
+        }
+    }
+    if (mesh.uvs.size() != vertexCount * 2) mesh.uvs.assign(vertexCount * 2, 0.0f);
+}
+
+void normalizeMesh(MeshData& mesh) {
+    const size_t vertexCount = mesh.vertexCount();
+    if (vertexCount == 0) return;
+    Vec3 lo = position(mesh, 0), hi = lo;
+    for (size_t v = 1; v < vertexCount; ++v) {
+        const Vec3 p = position(mesh, uint32_t(v));
+        lo = {std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z)};
+        hi = {std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z)};
+    }
+    const Vec3 center = (lo + hi) * 0.5f;
+    float radius = 0.0f;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const Vec3 d = position(mesh, uint32_t(v)) - center;
+        radius = std::max(radius, dot(d, d));
+    }
+    radius = std::sqrt(radius);
+    const float scale = radius > 0.0f ? UnitCubeRadius / radius : 1.0f;
+    for (size_t v = 0; v < vertexCount; ++v) {
+        float* p = &mesh.positions[v * 3];
+        p[0] = (p[0] - center.x) * scale;
+        p[1] = (p[1] - center.y) * scale;
+        p[2] = (p[2] - center.z) * scale;
+    }
+}
+
+void optimizeMesh(MeshData& mesh) {
+    if (mesh.indices.empty()) return;
+    mesh.indices = optimizeVertexCache(mesh.indices, mesh.vertexCount());
+    mesh.indices = optimizeOverdraw(mesh, mesh.indices);
+    optimizeVertexFetch(mesh);
+}
+
+float averageCacheMissRatio(const std::vector<uint32_t>& indices, size_t vertexCount, size_t cacheSize) {
+    if (indices.size() < 3) return 0.0f;
+    // FIFO with a timestamp per vertex: in the cache when it entered fewer than
+    // cacheSize misses ago
+    std::vector<size_t> entered(vertexCount, SIZE_MAX);
+    size_t misses = 0;
+    for (uint32_t index : indices) {
+        if (index >= vertexCount) continue;
+        if (entered[index] == SIZE_MAX || misses - entered[index] >= cacheSize) {
+            entered[index] = misses;
+            ++misses;
+        }
+    }
+    return static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+}
+
+uint32_t packNormal(float x, float y, float z) {
+    auto snorm10 = [](float v) {
+        const float clamped = std::max(-1.0f, std::min(1.0f, v));
+        const int q = static_cast<int>(std::lround(clamped * 511.0f));
+        return static_cast<uint32_t>(q) & 0x3FFu;
+    };
+    return snorm10(x) | (snorm10(y) << 10) | (snorm10(z) << 20);
+}
+
+void packMesh(const MeshData& mesh, PackedMesh& packed) {
+    const size_t vertexCount = mesh.vertexCount();
+    const bool hasNormals = mesh.normals.size() == vertexCount * 3;
+    const bool hasUVs = mesh.uvs.size() == vertexCount * 2;
+
+    packed.vertices.resize(vertexCount);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        PackedVertex& out = packed.vertices[v];
+        std::copy_n(&mesh.positions[v * 3], 3, out.position);
+        out.normal = hasNormals ? packNormal(mesh.normals[v * 3], mesh.normals[v * 3 + 1], mesh.normals[v * 3 + 2])
+                                : packNormal(0.0f, 0.0f, 1.0f);
+        out.uv[0] = floatToHalf(hasUVs ? mesh.uvs[v * 2] : 0.0f);
+        out.uv[1] = floatToHalf(hasUVs ? mesh.uvs[v * 2 + 1] : 0.0f);
+    }
+
+    packed.index32 = vertexCount > 65536;   // Index 65535 is still a uint16_t
+    packed.indexCount = static_cast<uint32_t>(mesh.indices.size());
+    if (packed.index32) {
+        packed.indices.resize(mesh.indices.size() * sizeof(uint32_t));
+        std::memcpy(packed.indices.data(), mesh.indices.data(), packed.indices.size());
+    } else {
+        packed.indices.resize(mesh.indices.size() * sizeof(uint16_t));
+        for (size_t i = 0; i < mesh.indices.size(); ++i) {
+            const uint16_t index = static_cast<uint16_t>(mesh.indices[i]);
+            std::memcpy(&packed.indices[i * sizeof(uint16_t)], &index, sizeof(index));
+        }
+    }
+}
+
+bool unpackMesh(const PackedMesh& packed, MeshData& mesh, std::string& error) {
+    const size_t indexSize = packed.index32 ? sizeof(uint32_t) : sizeof(uint16_t);
+    if (packed.indices.size() != size_t(packed.indexCount) * indexSize) {
+        error = "index buffer holds " + std::to_string(packed.indices.size()) + " bytes, expected " +
+                std::to_string(size_t(packed.indexCount) * indexSize);
+        return false;
+    }
+    if (packed.indexCount % 3 != 0) {
+        error = "index count " + std::to_string(packed.indexCount) + " is not a triangle list";
+        return false;
+    }
+
+    const size_t vertexCount = packed.vertices.size();
+    mesh.clear();
+    mesh.indices.resize(packed.indexCount);
+    for (size_t i = 0; i < mesh.indices.size(); ++i) {
+        uint32_t index = 0;
+        if (packed.index32) {
+            std::memcpy(&index, &packed.indices[i * sizeof(uint32_t)], sizeof(index));
+        } else {
+            uint16_t index16 = 0;
+            std::memcpy(&index16, &packed.indices[i * sizeof(uint16_t)], sizeof(index16));
+            index = index16;
+        }
+        if (index >= vertexCount) {
+            error = "index " + std::to_string(i) + " references vertex " + std::to_string(index) + " of " +
+                    std::to_string(vertexCount);
+            mesh.clear();
+            return false;
+        }
+        mesh.indices[i] = index;
+    }
+
+    // Signed-normalized like GL: -512 and -511 both read as -1
+    auto snorm10 = [](uint32_t bits) {
+        const int q = static_cast<int>(bits & 0x3FFu) - ((bits & 0x200u) ? 0x400 : 0);
+        return std::max(static_cast<float>(q) / 511.0f, -1.0f);
+    };
+    mesh.positions.resize(vertexCount * 3);
+    mesh.normals.resize(vertexCount * 3);
+    mesh.uvs.resize(vertexCount * 2);
+    for (size_t v = 0; v < vertexCount; ++v) {
+        const PackedVertex& in = packed.vertices[v];
+        std::copy_n(in.position, 3, &mesh.positions[v * 3]);
+        for (int c = 0; c < 3; ++c) mesh.normals[v * 3 + c] = snorm10(in.normal >> (10 * c));
+        mesh.uvs[v * 2] = halfToFloat(in.uv[0]);
+        mesh.uvs[v * 2 + 1] = halfToFloat(in.uv[1]);
+    }
+    return true;
+}
+
+} // namespace ShaderGraph
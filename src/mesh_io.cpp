@@ -0,0 +1,848 @@
+#include "mesh_io.h"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+namespace ShaderGraph {
+
+namespace {
+
+bool readFile(const std::string& path, std::vector<uint8_t>& data, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::ostringstream buffer;
+    buffer << file.rdbuf();
+    const std::string bytes = buffer.str();
+    data.assign(bytes.begin(), bytes.end());
+    return true;
+}
+
+std::string directoryOf(const std::string& path) {
+    const size_t slash = path.find_last_of("/\\");
+    return slash == std::string::npos ? std::string() : path.substr(0, slash + 1);
+}
+
+std::string lowerExtension(const std::string& path) {
+    const size_t dot = path.find_last_of('.');
+    if (dot == std::string::npos || path.find_first_of("/\\", dot) != std::string::npos) return std::string();
+    std::string extension = path.substr(dot);
+    for (char& c : extension) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return extension;
+}
+
+// ----------------------------------------------------------------------------
+// OBJ
+// ----------------------------------------------------------------------------
+
+struct ObjCorner {
+    int position, uv, normal;
+    bool operator==(const ObjCorner& other) const {
+        return position == other.position && uv == other.uv && normal == other.normal;
+    }
+};
+
+struct ObjCornerHash {
+    size_t operator()(const ObjCorner& c) const {
+        return (size_t(uint32_t(c.position)) * 73856093u) ^ (size_t(uint32_t(c.uv)) * 19349663u) ^
+               (size_t(uint32_t(c.normal)) * 83492791u);
+    }
+};
+
+// 1-based, or negative counting back from the last element so far; -1 when absent
+bool resolveObjIndex(const char* text, size_t count, int& index) {
+    if (*text == '\0') {
+        index = -1;
+        return true;
+    }
+    char* end = nullptr;
+    const long value = std::strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value == 0) return false;
+    const long resolved = value > 0 ? value - 1 : static_cast<long>(count) + value;
+    if (resolved < 0 || resolved >= static_cast<long>(count)) return false;
+    index = static_cast<int>(resolved);
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// JSON, just enough for glTF
+// ----------------------------------------------------------------------------
+
+struct Json {
+    enum class Type { Null, Bool, Number, String, Array, Object };
+    Type type = Type::Null;
+    bool boolean = false;
+    double number = 0.0;
+    std::string string;
+    std::vector<Json> array;
+    std::vector<std::pair<std::string, Json>> object;
+
+    const Json* find(const char* key) const {
+        if (type != Type::Object) return nullptr;
+        for (const auto& member : object) {
+            if (member.first == key) return &member.second;
+        }
+        return nullptr;
+    }
+    const Json* at(size_t index) const {
+        return type == Type::Array && index < array.size() ? &array[index] : nullptr;
+    }
+    size_t size() const { return type == Type::Array ? array.size() : 0; }
+};
+
+class JsonParser {
+public:
+    JsonParser(const char* begin, const char* end) : m_p(begin), m_end(end) {}
+
+    bool parse(Json& value, std::string& error) {
+        if (!parseValue(value, 0) || (skipSpace(), m_p != m_end)) {
+            error = "invalid JSON" + (m_error.empty() ? std::string() : ": " + m_error);
+            return false;
+        }
+        return true;
+    }
+
+private:
+    void skipSpace() {
+        while (m_p != m_end && (*m_p == ' ' || *m_p == '\t' || *m_p == '\n' || *m_p == '\r')) ++m_p;
+    }
+
+    bool fail(const char* message) {
+        if (m_error.empty()) m_error = message;
+        return false;
+    }
+
+    bool literal(const char* word) {
+        const size_t length = std::strlen(word);
+        if (size_t(m_end - m_p) < length || std::memcmp(m_p, word, length) != 0) return fail("unexpected token");
+        m_p += length;
+        return true;
+    }
+
+    bool parseString(std::string& out) {
+        ++m_p;   // Opening quote
+        while (m_p != m_end && *m_p != '"') {
+            if (*m_p != '\\') {
+                out += *m_p++;
+                continue;
+            }
+            if (++m_p == m_end) break;
+            const char escape = *m_p++;
+            switch (escape) {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                case 'r': out += '\r'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'u': {
+                    if (m_end - m_p < 4) return fail("bad escape");
+                    unsigned code = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        const char h = *m_p++;
+                        if (!std::isxdigit(static_cast<unsigned char>(h))) return fail("bad escape");
+                        code = code * 16 + unsigned(std::isdigit(static_cast<unsigned char>(h)) ? h - '0' : (std::tolower(h) - 'a' + 10));
+                    }
+                    // Names and URIs only need to round-trip, so encode as UTF-8 without pairing surrogates
+                    if (code < 0x80) {
+                        out += static_cast<char>(code);
+                    } else if (code < 0x800) {
+                        out += static_cast<char>(0xC0 | (code >> 6));
+                        out += static_cast<char>(0x80 | (code & 0x3F));
+                    } else {
+                        out += static_cast<char>(0xE0 | (code >> 12));
+                        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                        out += static_cast<char>(0x80 | (code & 0x3F));
+                    }
+                    break;
+                }
+                default: out += escape; break;
+            }
+        }
+        if (m_p == m_end) return fail("unterminated string");
+        ++m_p;
+        return true;
+    }
+
+    bool parseValue(Json& value, int depth) {
+        if (depth > 64) return fail("nested too deeply");
+        skipSpace();
+        if (m_p == m_end) return fail("unexpected end");
+        switch (*m_p) {
+            case '{': {
+                value.type = Json::Type::Object;
+                ++m_p;
+                skipSpace();
+                if (m_p != m_end && *m_p == '}') {
+                    ++m_p;
+                    return true;
+                }
+                while (true) {
+                    skipSpace();
+                    if (m_p == m_end || *m_p != '"') return fail("expected a key");
+                    value.object.emplace_back();
+                    if (!parseString(value.object.back().first)) return false;
+                    skipSpace();
+                    if (m_p == m_end || *m_p != ':') return fail("expected ':'");
+                    ++m_p;
+                    if (!parseValue(value.object.back().second, depth + 1)) return false;
+                    skipSpace();
+                    if (m_p != m_end && *m_p == ',') {
+                        ++m_p;
+                        continue;
+                    }
+                    if (m_p != m_end && *m_p == '}') {
+                        ++m_p;
+                        return true;
+                    }
+                    return fail("expected ',' or '}'");
+                }
+            }
+            case '[': {
+                value.type = Json::Type::Array;
+                ++m_p;
+                skipSpace();
+                if (m_p != m_end && *m_p == ']') {
+                    ++m_p;
+                    return true;
+                }
+                while (true) {
+                    value.array.emplace_back();
+                    if (!parseValue(value.array.back(), depth + 1)) return false;
+                    skipSpace();
+                    if (m_p != m_end && *m_p == ',') {
+                        ++m_p;
+                        continue;
+                    }
+                    if (m_p != m_end && *m_p == ']') {
+                        ++m_p;
+                        return true;
+                    }
+                    return fail("expected ',' or ']'");
+                }
+            }
+            case '"':
+                value.type = Json::Type::String;
+                return parseString(value.string);
+            case 't':
+                value.type = Json::Type::Bool;
+                value.boolean = true;
+                return literal("true");
+            case 'f':
+                value.type = Json::Type::Bool;
+                return literal("false");
+            case 'n':
+                return literal("null");
+            default: {
+                // strtod needs a terminator; numbers are short
+                const char* start = m_p;
+                while (m_p != m_end && (std::isdigit(static_cast<unsigned char>(*m_p)) || *m_p == '-' || *m_p == '+' ||
+                                        *m_p == '.' || *m_p == 'e' || *m_p == 'E')) {
+                    ++m_p;
+                }
+                const std::string text(start, m_p);
+                char* end = nullptr;
+                value.type = Json::Type::Number;
+                value.number = std::strtod(text.c_str(), &end);
+                if (text.empty() || end != text.c_str() + text.size()) return fail("bad number");
+                return true;
+            }
+        }
+    }
+
+    const char* m_p;
+    const char* m_end;
+    std::string m_error;
+};
+
+double numberOf(const Json* value, double fallback) {
+    return value && value->type == Json::Type::Number ? value->number : fallback;
+}
+
+// Non-negative integer property, or -1 when absent or malformed
+long long indexOf(const Json* value) {
+    const double number = numberOf(value, -1.0);
+    return number >= 0.0 && number == std::floor(number) && number < 9e15 ? static_cast<long long>(number) : -1;
+}
+
+// ----------------------------------------------------------------------------
+// glTF
+// ----------------------------------------------------------------------------
+
+constexpr uint32_t GlbMagic = 0x46546C67;       // "glTF"
+constexpr uint32_t GlbChunkJson = 0x4E4F534A;   // "JSON"
+constexpr uint32_t GlbChunkBin = 0x004E4942;    // "BIN\0"
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+bool decodeBase64(std::string_view text, std::vector<uint8_t>& out) {
+    auto value = [](char c) -> int {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+' || c == '-') return 62;
+        if (c == '/' || c == '_') return 63;
+        return -1;
+    };
+    uint32_t bits = 0;
+    int count = 0;
+    for (char c : text) {
+        if (c == '=') break;
+        const int v = value(c);
+        if (v < 0) return false;
+        bits = (bits << 6) | uint32_t(v);
+        count += 6;
+        if (count >= 8) {
+            count -= 8;
+            out.push_back(static_cast<uint8_t>((bits >> count) & 0xFF));
+        }
+    }
+    return true;
+}
+
+struct Mat4 {
+    float m[16];   // Column-major, as glTF stores it
+};
+
+Mat4 identity() {
+    Mat4 r{};
+    r.m[0] = r.m[5] = r.m[10] = r.m[15] = 1.0f;
+    return r;
+}
+
+Mat4 multiply(const Mat4& a, const Mat4& b) {
+    Mat4 r{};
+    for (int column = 0; column < 4; ++column) {
+        for (int row = 0; row < 4; ++row) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; ++k) sum += a.m[k * 4 + row] * b.m[column * 4 + k];
+            r.m[column * 4 + row] = sum;
+        }
+    }
+    return r;
+}
+
+Mat4 nodeTransform(const Json& node) {
+    const Json* matrix = node.find("matrix");
+    if (matrix && matrix->size() == 16) {
+        Mat4 r;
+        for (size_t i = 0; i < 16; ++i) r.m[i] = static_cast<float>(numberOf(matrix->at(i), 0.0));
+        return r;
+    }
+    float t[3] = {0, 0, 0}, q[4] = {0, 0, 0, 1}, s[3] = {1, 1, 1};
+    if (const Json* v = node.find("translation")) for (size_t i = 0; i < 3; ++i) t[i] = float(numberOf(v->at(i), t[i]));
+    if (const Json* v = node.find("rotation")) for (size_t i = 0; i < 4; ++i) q[i] = float(numberOf(v->at(i), q[i]));
+    if (const Json* v = node.find("scale")) for (size_t i = 0; i < 3; ++i) s[i] = float(numberOf(v->at(i), s[i]));
+
+    const float x = q[0], y = q[1], z = q[2], w = q[3];
+    Mat4 r = identity();
+    r.m[0] = (1 - 2 * (y * y + z * z)) * s[0];
+    r.m[1] = (2 * (x * y + z * w)) * s[0];
+    r.m[2] = (2 * (x * z - y * w)) * s[0];
+    r.m[4] = (2 * (x * y - z * w)) * s[1];
+    r.m[5] = (1 - 2 * (x * x + z * z)) * s[1];
+    r.m[6] = (2 * (y * z + x * w)) * s[1];
+    r.m[8] = (2 * (x * z + y * w)) * s[2];
+    r.m[9] = (2 * (y * z - x * w)) * s[2];
+    r.m[10] = (1 - 2 * (x * x + y * y)) * s[2];
+    r.m[12] = t[0];
+    r.m[13] = t[1];
+    r.m[14] = t[2];
+    return r;
+}
+
+class GltfLoader {
+public:
+    GltfLoader(const Json& root, const std::string& baseDirectory, const uint8_t* bin, size_t binSize)
+        : m_root(root), m_baseDirectory(baseDirectory), m_bin(bin), m_binSize(binSize) {}
+
+    bool load(MeshData& mesh, std::string& error) {
+        if (!loadBuffers(error)) return false;
+
+        const Json* scenes = m_root.find("scenes");
+        const long long sceneIndex = std::max(0LL, indexOf(m_root.find("scene")));
+        const Json* scene = scenes ? scenes->at(size_t(sceneIndex)) : nullptr;
+        if (scene) {
+            const Json* roots = scene->find("nodes");
+            for (size_t i = 0; roots && i < roots->size(); ++i) {
+                if (!visitNode(indexOf(roots->at(i)), identity(), 0, mesh, error)) return false;
+            }
+        } else {
+            // No scene: every mesh, untransformed
+            const Json* meshes = m_root.find("meshes");
+            for (size_t i = 0; meshes && i < meshes->size(); ++i) {
+                if (!appendMesh(*meshes->at(i), identity(), mesh, error)) return false;
+            }
+        }
+        if (mesh.indices.empty()) {
+            error = "no triangles in the default scene";
+            return false;
+        }
+        return true;
+    }
+
+private:
+    struct Accessor {
+        const uint8_t* data = nullptr;   // Null for accessors without a buffer view (all zeros)
+        size_t count = 0;
+        size_t stride = 0;
+        int componentType = 0;
+        size_t components = 0;
+        bool normalized = false;
+    };
+
+    bool loadBuffers(std::string& error) {
+        const Json* buffers = m_root.find("buffers");
+        for (size_t i = 0; buffers && i < buffers->size(); ++i) {
+            const Json& buffer = *buffers->at(i);
+            const long long byteLength = indexOf(buffer.find("byteLength"));
+            const Json* uri = buffer.find("uri");
+            std::vector<uint8_t> data;
+            if (!uri || uri->type != Json::Type::String) {
+                if (i != 0 || !m_bin) {
+                    error = "buffer " + std::to_string(i) + " has no data";
+                    return false;
+                }
+                data.assign(m_bin, m_bin + m_binSize);
+            } else if (uri->string.compare(0, 5, "data:") == 0) {
+                const size_t comma = uri->string.find(',');
+                if (comma == std::string::npos || uri->string.rfind(";base64", comma) == std::string::npos ||
+                    !decodeBase64(std::string_view(uri->string).substr(comma + 1), data)) {
+                    error = "buffer " + std::to_string(i) + ": unsupported data URI";
+                    return false;
+                }
+            } else if (!readFile(m_baseDirectory + uri->string, data, error)) {
+                return false;
+            }
+            if (byteLength < 0 || data.size() < size_t(byteLength)) {
+                error = "buffer " + std::to_string(i) + " is shorter than its byteLength";
+                return false;
+            }
+            data.resize(size_t(byteLength));
+            m_buffers.push_back(std::move(data));
+        }
+        return true;
+    }
+
+    bool accessor(long long index, Accessor& out, std::string& error) const {
+        const Json* accessors = m_root.find("accessors");
+        const Json* a = index >= 0 && accessors ? accessors->at(size_t(index)) : nullptr;
+        if (!a) {
+            error = "missing accessor " + std::to_string(index);
+            return false;
+        }
+        if (a->find("sparse")) {
+            error = "sparse accessors are not supported";
+            return false;
+        }
+        static const std::pair<const char*, size_t> types[] = {
+            {"SCALAR", 1}, {"VEC2", 2}, {"VEC3", 3}, {"VEC4", 4}};
+        const Json* type = a->find("type");
+        out.components = 0;
+        for (const auto& t : types) {
+            if (type && type->string == t.first) out.components = t.second;
+        }
+        out.componentType = static_cast<int>(indexOf(a->find("componentType")));
+        const long long count = indexOf(a->find("count"));
+        const size_t componentSize = out.componentType == 5120 || out.componentType == 5121   ? 1
+                                     : out.componentType == 5122 || out.componentType == 5123 ? 2
+                                     : out.componentType == 5125 || out.componentType == 5126 ? 4
+                                                                                              : 0;
+        if (!out.components || !componentSize || count < 0) {
+            error = "unsupported accessor " + std::to_string(index);
+            return false;
+        }
+        out.count = size_t(count);
+        out.normalized = a->find("normalized") && a->find("normalized")->boolean;
+        const size_t elementSize = componentSize * out.components;
+
+        const long long viewIndex = indexOf(a->find("bufferView"));
+        if (viewIndex < 0) {
+            out.data = nullptr;
+            out.stride = elementSize;
+            return true;
+        }
+        const Json* views = m_root.find("bufferViews");
+        const Json* view = views ? views->at(size_t(viewIndex)) : nullptr;
+        const long long bufferIndex = view ? indexOf(view->find("buffer")) : -1;
+        if (bufferIndex < 0 || size_t(bufferIndex) >= m_buffers.size()) {
+            error = "accessor " + std::to_string(index) + " has a bad buffer view";
+            return false;
+        }
+        const std::vector<uint8_t>& buffer = m_buffers[size_t(bufferIndex)];
+        const long long viewOffset = std::max(0LL, indexOf(view->find("byteOffset")));
+        const long long viewLength = indexOf(view->find("byteLength"));
+        const long long stride = indexOf(view->find("byteStride"));
+        const long long offset = std::max(0LL, indexOf(a->find("byteOffset")));
+        out.stride = stride > 0 ? size_t(stride) : elementSize;
+
+        // Everything the accessor reads must lie inside its view, and the view inside its buffer
+        const unsigned long long used =
+            out.count ? (unsigned long long)offset + (out.count - 1) * (unsigned long long)out.stride + elementSize : 0;
+        if (viewLength < 0 || (unsigned long long)viewOffset + (unsigned long long)viewLength > buffer.size() ||
+            used > (unsigned long long)viewLength) {
+            error = "accessor " + std::to_string(index) + " is out of bounds";
+            return false;
+        }
+        out.data = buffer.data() + viewOffset + offset;
+        return true;
+    }
+
+    static float component(const Accessor& a, size_t element, size_t c) {
+        if (!a.data) return 0.0f;
+        const uint8_t* p = a.data + element * a.stride;
+        switch (a.componentType) {
+            case 5126: {
+                float v;
+                std::memcpy(&v, p + c * 4, 4);
+                return v;
+            }
+            case 5120: {
+                const float v = static_cast<float>(static_cast<int8_t>(p[c]));
+                return a.normalized ? std::max(v / 127.0f, -1.0f) : v;
+            }
+            case 5121: {
+                const float v = static_cast<float>(p[c]);
+                return a.normalized ? v / 255.0f : v;
+            }
+            case 5122: {
+                int16_t s;
+                std::memcpy(&s, p + c * 2, 2);
+                return a.normalized ? std::max(float(s) / 32767.0f, -1.0f) : float(s);
+            }
+            case 5123: {
+                uint16_t s;
+                std::memcpy(&s, p + c * 2, 2);
+                return a.normalized ? float(s) / 65535.0f : float(s);
+            }
+            default: {
+                uint32_t s;
+                std::memcpy(&s, p + c * 4, 4);
+                return static_cast<float>(s);
+            }
+        }
+    }
+
+    static uint32_t indexAt(const Accessor& a, size_t element) {
+        if (!a.data) return 0;
+        const uint8_t* p = a.data + element * a.stride;
+        if (a.componentType == 5121) return p[0];
+        if (a.componentType == 5123) {
+            uint16_t v;
+            std::memcpy(&v, p, 2);
+            return v;
+        }
+        return read32(p);
+    }
+
+    bool readAttribute(const Json& attributes, const char* name, size_t components, std::vector<float>& out,
+                       size_t expectedCount, std::string& error) const {
+        const Json* index = attributes.find(name);
+        if (!index) return true;
+        Accessor a;
+        if (!accessor(indexOf(index), a, error)) return false;
+        if (a.components < components || (expectedCount != SIZE_MAX && a.count != expectedCount)) {
+            error = std::string(name) + " accessor doesn't match the primitive";
+            return false;
+        }
+        out.resize(a.count * components);
+        for (size_t i = 0; i < a.count; ++i) {
+            for (size_t c = 0; c < components; ++c) out[i * components + c] = component(a, i, c);
+        }
+        return true;
+    }
+
+    bool visitNode(long long index, const Mat4& parent, int depth, MeshData& mesh, std::string& error) {
+        const Json* nodes = m_root.find("nodes");
+        const Json* node = index >= 0 && nodes ? nodes->at(size_t(index)) : nullptr;
+        if (!node || depth > 64) {
+            error = "bad node hierarchy";
+            return false;
+        }
+        const Mat4 transform = multiply(parent, nodeTransform(*node));
+        const long long meshIndex = indexOf(node->find("mesh"));
+        if (meshIndex >= 0) {
+            const Json* meshes = m_root.find("meshes");
+            const Json* m = meshes ? meshes->at(size_t(meshIndex)) : nullptr;
+            if (!m) {
+                error = "missing mesh " + std::to_string(meshIndex);
+                return false;
+            }
+            if (!appendMesh(*m, transform, mesh, error)) return false;
+        }
+        const Json* children = node->find("children");
+        for (size_t i = 0; children && i < children->size(); ++i) {
+            if (!visitNode(indexOf(children->at(i)), transform, depth + 1, mesh, error)) return false;
+        }
+        return true;
+    }
+
+    bool appendMesh(const Json& gltfMesh, const Mat4& transform, MeshData& mesh, std::string& error) {
+        const Json* primitives = gltfMesh.find("primitives");
+        for (size_t p = 0; primitives && p < primitives->size(); ++p) {
+            const Json& primitive = *primitives->at(p);
+            // Points and lines have nothing to shade; strips and fans are rare enough to skip
+            if (indexOf(primitive.find("mode")) >= 0 && indexOf(primitive.find("mode")) != 4) continue;
+            const Json* attributes = primitive.find("attributes");
+            if (!attributes || !attributes->find("POSITION")) continue;
+
+            MeshData part;
+            if (!readAttribute(*attributes, "POSITION", 3, part.positions, SIZE_MAX, error)) return false;
+            const size_t vertexCount = part.vertexCount();
+            if (!readAttribute(*attributes, "NORMAL", 3, part.normals, vertexCount, error) ||
+                !readAttribute(*attributes, "TEXCOORD_0", 2, part.uvs, vertexCount, error)) {
+                return false;
+            }
+
+            if (const Json* indices = primitive.find("indices")) {
+                Accessor a;
+                if (!accessor(indexOf(indices), a, error)) return false;
+                if (a.components != 1 || (a.componentType != 5121 && a.componentType != 5123 && a.componentType != 5125)) {
+                    error = "unsupported index accessor";
+                    return false;
+                }
+                part.indices.resize(a.count);
+                for (size_t i = 0; i < a.count; ++i) {
+                    part.indices[i] = indexAt(a, i);
+                    if (part.indices[i] >= vertexCount) {
+                        error = "index out of range";
+                        return false;
+                    }
+                }
+            } else {
+                part.indices.resize(vertexCount);
+                for (size_t i = 0; i < vertexCount; ++i) part.indices[i] = static_cast<uint32_t>(i);
+            }
+            completeMesh(part);
+            append(part, transform, mesh);
+        }
+        return true;
+    }
+
+    // Positions by the node transform, normals by its inverse transpose; mirroring
+    // transforms flip the winding back
+    static void append(const MeshData& part, const Mat4& t, MeshData& mesh) {
+        const float* m = t.m;
+        const float a = m[0], b = m[4], c = m[8];
+        const float d = m[1], e = m[5], f = m[9];
+        const float g = m[2], h = m[6], k = m[10];
+        const float cofactor[9] = {e * k - f * h, f * g - d * k, d * h - e * g,
+                                   c * h - b * k, a * k - c * g, b * g - a * h,
+                                   b * f - c * e, c * d - a * f, a * e - b * d};
+        const float determinant = a * cofactor[0] + b * cofactor[1] + c * cofactor[2];
+
+        const uint32_t first = static_cast<uint32_t>(mesh.vertexCount());
+        for (size_t v = 0; v < part.vertexCount(); ++v) {
+            const float* p = &part.positions[v * 3];
+            for (int r = 0; r < 3; ++r) mesh.positions.push_back(m[r] * p[0] + m[4 + r] * p[1] + m[8 + r] * p[2] + m[12 + r]);
+
+            // The cofactor matrix is the inverse transpose up to the determinant's scale
+            const float* n = &part.normals[v * 3];
+            float out[3];
+            for (int r = 0; r < 3; ++r) out[r] = cofactor[r * 3] * n[0] + cofactor[r * 3 + 1] * n[1] + cofactor[r * 3 + 2] * n[2];
+            const float length = std::sqrt(out[0] * out[0] + out[1] * out[1] + out[2] * out[2]);
+            const float scale = length > 0.0f ? (determinant < 0.0f ? -1.0f : 1.0f) / length : 0.0f;
+            for (float component : out) mesh.normals.push_back(component * scale);
+            mesh.uvs.push_back(part.uvs[v * 2]);
+            mesh.uvs.push_back(part.uvs[v * 2 + 1]);
+        }
+        for (size_t i = 0; i + 2 < part.indices.size(); i += 3) {
+            const uint32_t i0 = first + part.indices[i];
+            uint32_t i1 = first + part.indices[i + 1], i2 = first + part.indices[i + 2];
+            if (determinant < 0.0f) std::swap(i1, i2);
+            mesh.indices.insert(mesh.indices.end(), {i0, i1, i2});
+        }
+    }
+
+    const Json& m_root;
+    std::string m_baseDirectory;
+    const uint8_t* m_bin;
+    size_t m_binSize;
+    std::vector<std::vector<uint8_t>> m_buffers;
+};
+
+} // namespace
+
+bool parseOBJ(std::string_view text, MeshData& mesh, std::string& error) {
+    std::vector<float> positions, uvs, normals;
+    std::unordered_map<ObjCorner, uint32_t, ObjCornerHash> corners;
+    std::vector<ObjCorner> cornerList;
+    bool everyCornerHasNormal = true;
+
+    mesh.clear();
+    size_t lineNumber = 0;
+    size_t start = 0;
+    std::vector<uint32_t> face;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) end = text.size();
+        std::string line(text.substr(start, end - start));
+        start = end + 1;
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        std::istringstream in(line);
+        std::string keyword;
+        if (!(in >> keyword) || keyword[0] == '#') continue;
+        auto fail = [&](const std::string& message) {
+            error = "line " + std::to_string(lineNumber) + ": " + message;
+            return false;
+        };
+
+        if (keyword == "v" || keyword == "vn") {
+            float x = 0, y = 0, z = 0;
+            if (!(in >> x >> y >> z)) return fail("expected three numbers");
+            auto& list = keyword == "v" ? positions : normals;
+            list.insert(list.end(), {x, y, z});
+        } else if (keyword == "vt") {
+            float u = 0, v = 0;
+            if (!(in >> u)) return fail("expected a texture coordinate");
+            in >> v;
+            // OBJ puts v = 0 at the bottom of the image
+            uvs.insert(uvs.end(), {u, 1.0f - v});
+        } else if (keyword == "f") {
+            face.clear();
+            std::string corner;
+            while (in >> corner) {
+                // p, p/t, p//n or p/t/n
+                std::string parts[3];
+                size_t part = 0;
+                for (char c : corner) {
+                    if (c == '/') {
+                        if (++part > 2) return fail("bad face corner " + corner);
+                    } else {
+                        parts[part] += c;
+                    }
+                }
+                ObjCorner key;
+                if (parts[0].empty() || !resolveObjIndex(parts[0].c_str(), positions.size() / 3, key.position) ||
+                    !resolveObjIndex(parts[1].c_str(), uvs.size() / 2, key.uv) ||
+                    !resolveObjIndex(parts[2].c_str(), normals.size() / 3, key.normal)) {
+                    return fail("bad face corner " + corner);
+                }
+                if (key.normal < 0) everyCornerHasNormal = false;
+                auto inserted = corners.emplace(key, static_cast<uint32_t>(cornerList.size()));
+                if (inserted.second) cornerList.push_back(key);
+                face.push_back(inserted.first->second);
+            }
+            if (face.size() < 3) return fail("face with fewer than three corners");
+            for (size_t i = 1; i + 1 < face.size(); ++i) mesh.indices.insert(mesh.indices.end(), {face[0], face[i], face[i + 1]});
+        }
+        // Other records (o, g, s, usemtl, mtllib, l, p) don't affect the preview
+    }
+
+    for (const ObjCorner& corner : cornerList) {
+        const float* p = &positions[size_t(corner.position) * 3];
+        mesh.positions.insert(mesh.positions.end(), {p[0], p[1], p[2]});
+        if (corner.uv >= 0) {
+            mesh.uvs.insert(mesh.uvs.end(), {uvs[size_t(corner.uv) * 2], uvs[size_t(corner.uv) * 2 + 1]});
+        } else {
+            mesh.uvs.insert(mesh.uvs.end(), {0.0f, 0.0f});
+        }
+        if (everyCornerHasNormal) {
+            const float* n = &normals[size_t(corner.normal) * 3];
+            mesh.normals.insert(mesh.normals.end(), {n[0], n[1], n[2]});
+        }
+    }
+    // Partial normals are left to completeMesh, which recomputes all of them
+    if (mesh.indices.empty()) {
+        error = "no faces";
+        return false;
+    }
+    return true;
+}
+
+bool parseGLTF(const uint8_t* data, size_t size, const std::string& baseDirectory, MeshData& mesh,
+               std::string& error) {
+    mesh.clear();
+    const char* json = reinterpret_cast<const char*>(data);
+    size_t jsonSize = size;
+    const uint8_t* bin = nullptr;
+    size_t binSize = 0;
+
+    if (size >= 12 && read32(data) == GlbMagic) {
+        // Header, then a JSON chunk and an optional binary chunk, each with length and type
+        if (read32(data + 4) != 2) {
+            error = "unsupported glTF version";
+            return false;
+        }
+        const size_t length = std::min<size_t>(read32(data + 8), size);
+        size_t offset = 12;
+        json = nullptr;
+        while (offset + 8 <= length) {
+            const size_t chunkLength = read32(data + offset);
+            const uint32_t chunkType = read32(data + offset + 4);
+            offset += 8;
+            if (chunkLength > length - offset) {
+                error = "truncated GLB chunk";
+                return false;
+            }
+            if (chunkType == GlbChunkJson && !json) {
+                json = reinterpret_cast<const char*>(data + offset);
+                jsonSize = chunkLength;
+            } else if (chunkType == GlbChunkBin && !bin) {
+                bin = data + offset;
+                binSize = chunkLength;
+            }
+            offset += (chunkLength + 3) & ~size_t(3);
+        }
+        if (!json) {
+            error = "GLB without a JSON chunk";
+            return false;
+        }
+    }
+
+    Json root;
+    if (!JsonParser(json, json + jsonSize).parse(root, error)) return false;
+    const Json* asset = root.find("asset");
+    const Json* version = asset ? asset->find("version") : nullptr;
+    if (!version || version->string.compare(0, 2, "2.") != 0) {
+        error = "not a glTF 2.0 asset";
+        return false;
+    }
+    if (const Json* required = root.find("extensionsRequired")) {
+        if (required->size()) {
+            error = "requires extension " + required->at(0)->string;
+            return false;
+        }
+    }
+    return GltfLoader(root, baseDirectory, bin, binSize).load(mesh, error);
+}
+
+bool loadMesh(const std::string& path, MeshData& mesh, std::string& error) {
+    std::vector<uint8_t> data;
+    if (!readFile(path, data, error)) return false;
+
+    const std::string extension = lowerExtension(path);
+    bool parsed = false;
+    if (extension == ".obj") {
+        parsed = parseOBJ(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()), mesh, error);
+    } else if (extension == ".gltf" || extension == ".glb") {
+        parsed = parseGLTF(data.data(), data.size(), directoryOf(path), mesh, error);
+    } else {
+        error = "unsupported mesh format " + (extension.empty() ? path : extension);
+        return false;
+    }
+    if (!parsed) {
+        error = path + ": " + error;
+        return false;
+    }
+
+    completeMesh(mesh);
+    normalizeMesh(mesh);
+    optimizeMesh(mesh);
+    return true;
+}
+
+} // namespace ShaderGraph
@@ -0,0 +1,303 @@
+#include "node_preview.h"
+#include "shader_graph.h"
+#include "shader_compiler.h"
+#include "program_cache.h"
+#include "texture_streamer.h"
+#include "hash_util.h"
+#include "gl_platform.h"
+#include <algorithm>
+#include <iostream>
+
+// Flat quad facing the camera, with the varyings the generated fragment shaders read.
+// FragPos spans the front face of the preview cube.
+static const char* previewVertexShader = R"(#version 330 core
+layout (location = 0) in vec2 aPos;
+
+out vec3 FragPos;
+out vec3 Normal;
+out vec2 TexCoord;
+
+void main()
+{
+    TexCoord = aPos * 0.5 + 0.5;
+    FragPos = vec3(aPos * 0.5, 0.5);
+    Normal = vec3(0.0, 0.0, 1.0);
+    gl_Position = vec4(aPos, 0.0, 1.0);
+}
+)";
+
+// Entries of nodes off screen this long are dropped along with their program reference
+static constexpr uint64_t ForgetAfterFrames = 600;
+
+NodePreviewRenderer::NodePreviewRenderer(int tileSize, int atlasSize)
+    : m_tileSize(std::max(tileSize, 8)),
+      m_atlasSize(std::max(atlasSize, m_tileSize)),
+      m_tilesPerRow(m_atlasSize / m_tileSize) {
+    m_tileOwners.assign(static_cast<size_t>(m_tilesPerRow * m_tilesPerRow), 0);
+}
+
+NodePreviewRenderer::~NodePreviewRenderer() {
+    shutdown();
+}
+
+void NodePreviewRenderer::init() {
+    glGenTextures(1, &m_atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, m_atlasTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_atlasSize, m_atlasSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Color only: the quad needs no depth
+    glGenFramebuffers(1, &m_framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_atlasTexture, 0);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cerr << "Preview atlas framebuffer is not complete!" << std::endl;
+    }
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    static const float quad[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+    glGenVertexArrays(1, &m_quadVAO);
+    glGenBuffers(1, &m_quadVBO);
+    glBindVertexArray(m_quadVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, m_quadVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quad), quad, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    m_initialized = true;
+}
+
+void NodePreviewRenderer::shutdown() {
+    if (!m_initialized) return;
+    for (auto& programPair : m_programs) {
+        if (programPair.second.program) glDeleteProgram(programPair.second.program);
+    }
+    m_programs.clear();
+    m_entries.clear();
+    std::fill(m_tileOwners.begin(), m_tileOwners.end(), 0);
+    if (m_quadVAO) glDeleteVertexArrays(1, &m_quadVAO);
+    if (m_quadVBO) glDeleteBuffers(1, &m_quadVBO);
+    if (m_framebuffer) glDeleteFramebuffers(1, &m_framebuffer);
+    if (m_atlasTexture) glDeleteTextures(1, &m_atlasTexture);
+    m_quadVAO = m_quadVBO = m_framebuffer = m_atlasTexture = 0;
+    m_initialized = false;
+}
+
+NodePreviewRenderer::Program* NodePreviewRenderer::acquire(uint64_t hash, const std::string& fragmentSource) {
+    auto it = m_programs.find(hash);
+    if (it != m_programs.end()) {
+        it->second.users++;
+        return &it->second;
+    }
+    if (m_compilesLeft <= 0) return nullptr;
+    m_compilesLeft--;
+
+    // Synchronous builds on the render thread: ShaderCompiler keeps only the newest
+    // request, and preview shaders are small enough to stay within a frame at this budget
+    const bool cached = m_cache && m_cache->isEnabled();
+    uint64_t key = 0;
+    unsigned int program = 0;
+    if (cached) {
+        key = m_cache->makeKey(previewVertexShader, fragmentSource);
+        program = m_cache->load(key);
+    }
+    if (!program) {
+        ShaderCompiler::Result result = ShaderCompiler::buildProgram(previewVertexShader, fragmentSource, cached);
+        if (result.success) {
+            program = result.program;
+            if (cached) m_cache->store(key, program);
+        } else {
+            std::cerr << "Node preview shader failed: " << result.errorLog << std::endl;
+        }
+        m_stats.compiled++;
+    }
+
+    // Failed builds are kept too, so a broken shader isn't rebuilt every frame
+    Program& entry = m_programs[hash];
+    entry.program = program;
+    entry.users = 1;
+    if (program) entry.uniforms.reflect(program);
+    return &entry;
+}
+
+void NodePreviewRenderer::release(Program* program) {
+    if (!program || --program->users > 0) return;
+    for (auto it = m_programs.begin(); it != m_programs.end(); ++it) {
+        if (&it->second != program) continue;
+        if (program->program) glDeleteProgram(program->program);
+        m_programs.erase(it);
+        return;
+    }
+}
+
+int NodePreviewRenderer::allocateTile(uintptr_t owner) {
+    // A free tile, else the one of the node that has been off screen the longest
+    int best = -1;
+    uint64_t oldest = m_frame;
+    for (size_t i = 0; i < m_tileOwners.size(); ++i) {
+        if (m_tileOwners[i] == 0) {
+            best = static_cast<int>(i);
+            break;
+        }
+        auto it = m_entries.find(m_tileOwners[i]);
+        uint64_t seen = it != m_entries.end() ? it->second.lastSeen : 0;
+        if (seen < oldest) {
+            oldest = seen;
+            best = static_cast<int>(i);
+        }
+    }
+    if (best < 0) return -1;
+    auto previous = m_entries.find(m_tileOwners[best]);
+    if (previous != m_entries.end()) previous->second.tile = -1;
+    m_tileOwners[best] = owner;
+    return best;
+}
+
+void NodePreviewRenderer::tileUVs(int tile, float uv0[2], float uv1[2]) const {
+    // GL textures start at the bottom; flip V so the tile reads upright in ImGui
+    const float scale = 1.0f / static_cast<float>(m_atlasSize);
+    const int x = (tile % m_tilesPerRow) * m_tileSize;
+    const int y = (tile / m_tilesPerRow) * m_tileSize;
+    uv0[0] = x * scale;
+    uv0[1] = (y + m_tileSize) * scale;
+    uv1[0] = (x + m_tileSize) * scale;
+    uv1[1] = y * scale;
+}
+
+void NodePreviewRenderer::render(ShaderGraph::ShaderGraphEditor& editor, float time) {
+    m_frame++;
+    m_stats = Stats();
+    m_compilesLeft = m_compileBudget;
+    m_draws.clear();
+    if (!m_initialized) return;
+
+    editor.collectVisiblePreviews(m_visible);
+    const uint64_t graphRevision = editor.getRevision();
+    // Both revisions only grow, so their sum moves when either does
+    const uint64_t valueRevision = editor.getParameterRegistry().getValueRevision() +
+                                   (m_textures ? m_textures->getRevision() : 0);
+    const ImTextureID atlas = (ImTextureID)(intptr_t)m_atlasTexture;
+
+    for (ShaderGraph::ShaderNodeBase* node : m_visible) {
+        const uintptr_t uid = node->getUID();
+        Entry& entry = m_entries[uid];
+        entry.lastSeen = m_frame;
+
+        // The shader changes with the graph; the program only when the source does
+        if (!entry.hasGraphRevision || entry.graphRevision != graphRevision) {
+            std::string fragment;
+            bool timeDependent = false;
+            if (!editor.generatePreviewShader(node, fragment, timeDependent)) {
+                release(entry.program);
+                entry.program = nullptr;
+            } else {
+                const uint64_t hash = Fnv1a64::hash(fragment);
+                if (!entry.program || hash != entry.sourceHash) {
+                    Program* program = acquire(hash, fragment);
+                    if (!program) {
+                        m_stats.pending++;   // Over the compile budget; keep the old image
+                        continue;
+                    }
+                    release(entry.program);
+                    entry.program = program;
+                    entry.sourceHash = hash;
+                    entry.drawn = false;
+                }
+                entry.timeDependent = timeDependent;
+            }
+            entry.graphRevision = graphRevision;
+            entry.hasGraphRevision = true;
+        }
+
+        if (!entry.program || !entry.program->program) {
+            node->clearPreview();
+            continue;
+        }
+        if (entry.tile < 0) {
+            entry.tile = allocateTile(uid);
+            entry.drawn = false;
+            if (entry.tile < 0) {
+                node->clearPreview();
+                continue;
+            }
+        }
+
+        if (entry.timeDependent) m_stats.animated++;
+        bool redraw = !entry.drawn || entry.valueRevision != valueRevision;
+        if (entry.timeDependent && time - entry.drawTime >= m_animationInterval) redraw = true;
+        if (redraw) {
+            entry.drawn = true;
+            entry.valueRevision = valueRevision;
+            entry.drawTime = time;
+            m_draws.push_back(&entry);
+        }
+
+        float uv0[2], uv1[2];
+        tileUVs(entry.tile, uv0, uv1);
+        node->setPreview(atlas, ImVec2(uv0[0], uv0[1]), ImVec2(uv1[0], uv1[1]));
+    }
+    m_stats.visible = m_visible.size();
+
+    drawTiles(editor, time);
+
+    // Nodes gone for a while (scrolled far away or deleted) give back their tile and program
+    for (auto it = m_entries.begin(); it != m_entries.end();) {
+        Entry& entry = it->second;
+        if (m_frame - entry.lastSeen <= ForgetAfterFrames) {
+            ++it;
+            continue;
+        }
+        if (entry.tile >= 0) m_tileOwners[entry.tile] = 0;
+        release(entry.program);
+        it = m_entries.erase(it);
+    }
+    m_stats.programs = m_programs.size();
+}
+
+void NodePreviewRenderer::drawTiles(ShaderGraph::ShaderGraphEditor& editor, float time) {
+    m_stats.drawn = m_draws.size();
+    if (m_draws.empty()) return;
+
+    // One pass over the atlas: each tile is its own viewport, scissored so nothing bleeds
+    const ShaderGraph::ParameterRegistry& registry = editor.getParameterRegistry();
+    const auto& params = registry.parameters();
+    glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+    glDisable(GL_DEPTH_TEST);
+    glEnable(GL_SCISSOR_TEST);
+    glBindVertexArray(m_quadVAO);
+    if (m_textures) m_textures->bind(params);
+
+    for (Entry* entry : m_draws) {
+        Program& program = *entry->program;
+        const int x = (entry->tile % m_tilesPerRow) * m_tileSize;
+        const int y = (entry->tile / m_tilesPerRow) * m_tileSize;
+        glViewport(x, y, m_tileSize, m_tileSize);
+        glScissor(x, y, m_tileSize, m_tileSize);
+        glUseProgram(program.program);
+
+        const BuiltinUniformLocations& loc = program.uniforms.getBuiltins();
+        glUniform1f(loc.time, time);
+        glUniform3f(loc.lightPos, 2.0f, 2.0f, 2.0f);
+        glUniform3f(loc.viewPos, 0.0f, 0.0f, 3.0f);
+        glUniform3f(loc.lightColor, 1.0f, 1.0f, 1.0f);
+        glUniform3f(loc.objectColor, 0.3f, 0.6f, 0.9f);
+
+        // Tiles redraw rarely, so every parameter is uploaded; locations stay cached per program
+        program.uniforms.resolveParameters(params, registry.getLayoutRevision());
+        const auto& locations = program.uniforms.getParameterLocations();
+        for (size_t i = 0; i < params.size(); ++i) UniformReflection::upload(params[i], locations[i]);
+
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    }
+
+    glBindVertexArray(0);
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
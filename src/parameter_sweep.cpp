@@ -0,0 +1,99 @@
+#include "parameter_sweep.h"
+#include "uniform_reflection.h"
+#include "gl_platform.h"
+#include <algorithm>
+
+namespace {
+
+void applyAxis(const ParameterSweep::Axis& axis, const ShaderGraph::UniformParameter& param, int index, int count,
+               float value[3]) {
+    if (axis.parameter.empty() || axis.parameter != param.name) return;
+    const float t = count > 1 ? static_cast<float>(index) / static_cast<float>(count - 1) : 0.0f;
+    for (int c = 0; c < 3; ++c) value[c] = axis.from[c] + (axis.to[c] - axis.from[c]) * t;
+}
+
+} // namespace
+
+ParameterSweep::~ParameterSweep() {
+    shutdown();
+}
+
+void ParameterSweep::init() {
+    if (m_buffer) return;
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+    glBufferData(GL_UNIFORM_BUFFER, SweepBlockSlots * 4 * sizeof(float), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    m_dirty = true;
+}
+
+void ParameterSweep::shutdown() {
+    if (m_buffer) glDeleteBuffers(1, &m_buffer);
+    m_buffer = 0;
+}
+
+void ParameterSweep::setColumns(const Axis& axis) {
+    m_columns = axis;
+    m_dirty = true;
+}
+
+void ParameterSweep::setRows(const Axis& axis) {
+    m_rows = axis;
+    m_dirty = true;
+}
+
+ParameterSweep::Axis ParameterSweep::axisFor(const ShaderGraph::UniformParameter& param, int steps) {
+    Axis axis;
+    axis.parameter = param.name;
+    axis.steps = steps;
+    if (param.type == ShaderGraph::ShaderDataType::Vec3) {
+        for (int c = 0; c < 3; ++c) {
+            axis.from[c] = 0.0f;
+            axis.to[c] = param.vec3Value[c];
+        }
+    } else {
+        axis.from[0] = param.minValue;
+        axis.to[0] = param.maxValue;
+    }
+    return axis;
+}
+
+void ParameterSweep::update(const std::vector<ShaderGraph::UniformParameter>& params, uint64_t valueRevision) {
+    if (!m_buffer) return;
+
+    const int slots = ShaderGraph::sweepSlotCount(params);
+    const int maxInstances = SweepBlockSlots / std::max(1, slots);
+    const int columns = std::max(1, std::min(m_columns.steps, maxInstances));
+    const int rows = std::max(1, std::min(m_rows.steps, maxInstances / columns));
+
+    if (m_dirty || valueRevision != m_valueRevision || columns != m_gridColumns || rows != m_gridRows) {
+        m_gridColumns = columns;
+        m_gridRows = rows;
+        m_valueRevision = valueRevision;
+        m_dirty = false;
+
+        // Slots follow the parameter order the fragment shader was generated with
+        m_data.assign(size_t(columns) * rows * slots * 4, 0.0f);
+        float* out = m_data.data();
+        for (int row = 0; row < rows; ++row) {
+            for (int column = 0; column < columns; ++column) {
+                for (const auto& param : params) {
+                    if (!ShaderGraph::isSweepParameter(param)) continue;
+                    float value[3] = {param.floatValue, 0.0f, 0.0f};
+                    if (param.type == ShaderGraph::ShaderDataType::Vec3) std::copy(param.vec3Value, param.vec3Value + 3, value);
+                    applyAxis(m_columns, param, column, columns, value);
+                    applyAxis(m_rows, param, row, rows, value);
+                    std::copy(value, value + 3, out);
+                    out += 4;
+                }
+            }
+        }
+
+        if (!m_data.empty()) {
+            glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+            glBufferSubData(GL_UNIFORM_BUFFER, 0, static_cast<GLsizeiptr>(m_data.size() * sizeof(float)), m_data.data());
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+    }
+    glBindBufferBase(GL_UNIFORM_BUFFER, SweepBlockBinding, m_buffer);
+}
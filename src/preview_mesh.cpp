@@ -0,0 +1,66 @@
+#include "preview_mesh.h"
+#include "gl_platform.h"
+#include <cstddef>
+
+PreviewMesh::~PreviewMesh() {
+    shutdown();
+}
+
+void PreviewMesh::upload(const ShaderGraph::MeshData& mesh) {
+    ShaderGraph::PackedMesh packed;
+    ShaderGraph::packMesh(mesh, packed);
+
+    if (!m_vao) {
+        glGenVertexArrays(1, &m_vao);
+        glGenBuffers(1, &m_vertexBuffer);
+        glGenBuffers(1, &m_indexBuffer);
+    }
+    glBindVertexArray(m_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(packed.vertices.size() * sizeof(ShaderGraph::PackedVertex)),
+                 packed.vertices.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(packed.indices.size()), packed.indices.data(),
+                 GL_STATIC_DRAW);
+
+    // Same locations as before: the generated vertex shaders declare aPos, aNormal and aTexCoord there
+    const GLsizei stride = sizeof(ShaderGraph::PackedVertex);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)offsetof(ShaderGraph::PackedVertex, position));
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(ShaderGraph::PackedVertex, normal));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(ShaderGraph::PackedVertex, uv));
+    glEnableVertexAttribArray(2);
+
+    // The element buffer binding is VAO state, so leave it bound until the VAO is unbound
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+    m_indexType = packed.index32 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+    m_indexCount = static_cast<int>(packed.indexCount);
+    m_stats.vertices = mesh.vertexCount();
+    m_stats.triangles = mesh.triangleCount();
+    m_stats.bytes = packed.vertices.size() * sizeof(ShaderGraph::PackedVertex) + packed.indices.size();
+    m_stats.acmr = ShaderGraph::averageCacheMissRatio(mesh.indices, mesh.vertexCount());
+}
+
+void PreviewMesh::shutdown() {
+    if (m_vao) glDeleteVertexArrays(1, &m_vao);
+    if (m_vertexBuffer) glDeleteBuffers(1, &m_vertexBuffer);
+    if (m_indexBuffer) glDeleteBuffers(1, &m_indexBuffer);
+    m_vao = m_vertexBuffer = m_indexBuffer = 0;
+    m_indexCount = 0;
+    m_stats = Stats();
+}
+
+void PreviewMesh::draw(int instances) const {
+    if (!m_vao || !m_indexCount) return;
+    glBindVertexArray(m_vao);
+    if (instances > 1) {
+        glDrawElementsInstanced(GL_TRIANGLES, m_indexCount, m_indexType, nullptr, instances);
+    } else {
+        glDrawElements(GL_TRIANGLES, m_indexCount, m_indexType, nullptr);
+    }
+    glBindVertexArray(0);
+}
@@ -0,0 +1,189 @@
+#include "program_cache.h"
+#include "hash_util.h"
+#include "gl_platform.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <cstdio>
+
+namespace {
+
+// On-disk layout: header followed by the raw driver binary
+struct CacheFileHeader {
+    char magic[4];        // "SGPB"
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;
+    uint32_t size;
+};
+
+constexpr uint32_t CacheFileVersion = 1;
+
+std::string glString(GLenum name) {
+    const GLubyte* str = glGetString(name);
+    return str ? reinterpret_cast<const char*>(str) : "";
+}
+
+} // namespace
+
+ProgramCache::ProgramCache(std::string directory, size_t maxMemoryEntries)
+    : m_directory(std::move(directory)), m_maxMemoryEntries(maxMemoryEntries) {}
+
+void ProgramCache::init() {
+    // Core since 4.1 (ARB_get_program_binary before). Contexts without it leave the
+    // count at zero and flag an invalid enum, which we clear.
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    glGetError();
+    m_enabled = formats > 0;
+    m_driverId = glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+
+    if (m_enabled) {
+        std::error_code ec;
+        std::filesystem::create_directories(m_directory, ec);
+        if (ec) {
+            std::cerr << "Program cache: cannot create " << m_directory << ": " << ec.message() << std::endl;
+        }
+    }
+    std::cout << "Program binary cache " << (m_enabled ? "enabled" : "unavailable") << std::endl;
+}
+
+uint64_t ProgramCache::makeKey(const std::string& vertexSource, const std::string& fragmentSource) const {
+    Fnv1a64 h;
+    h.update(m_driverId);
+    h.update(vertexSource);
+    h.update(fragmentSource);
+    return h.value();
+}
+
+unsigned int ProgramCache::load(uint64_t key) {
+    if (!m_enabled) return 0;
+
+    const Entry* entry = find(key);
+    if (!entry) {
+        Entry fromDisk;
+        if (!readFile(key, fromDisk)) {
+            m_misses++;
+            return 0;
+        }
+        insert(std::move(fromDisk));
+        entry = find(key);
+    }
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, entry->format, entry->data.data(), static_cast<GLsizei>(entry->data.size()));
+
+    GLint linked = GL_FALSE;
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked) {
+        // Driver update or format change - fall back to a full compile
+        glDeleteProgram(program);
+        evict(key);
+        m_rejected++;
+        m_misses++;
+        return 0;
+    }
+
+    m_hits++;
+    return program;
+}
+
+void ProgramCache::store(uint64_t key, unsigned int program) {
+    if (!m_enabled || program == 0) return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) return;
+
+    Entry entry;
+    entry.key = key;
+    entry.data.resize(length);
+    GLenum format = 0;
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &format, entry.data.data());
+    if (written <= 0) return;
+    entry.data.resize(written);
+    entry.format = format;
+
+    writeFile(entry);
+    insert(std::move(entry));
+}
+
+const ProgramCache::Entry* ProgramCache::find(uint64_t key) {
+    auto it = m_index.find(key);
+    if (it == m_index.end()) return nullptr;
+    // Move to front (most recently used)
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return &*it->second;
+}
+
+void ProgramCache::insert(Entry entry) {
+    auto existing = m_index.find(entry.key);
+    if (existing != m_index.end()) {
+        m_lru.erase(existing->second);
+        m_index.erase(existing);
+    }
+    m_lru.push_front(std::move(entry));
+    m_index[m_lru.front().key] = m_lru.begin();
+
+    while (m_lru.size() > m_maxMemoryEntries) {
+        m_index.erase(m_lru.back().key);
+        m_lru.pop_back();
+    }
+}
+
+// Drop a key from memory and disk
+void ProgramCache::evict(uint64_t key) {
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+    std::error_code ec;
+    std::filesystem::remove(pathFor(key), ec);
+}
+
+std::string ProgramCache::pathFor(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+    return (std::filesystem::path(m_directory) / name).string();
+}
+
+bool ProgramCache::readFile(uint64_t key, Entry& entry) const {
+    std::ifstream file(pathFor(key), std::ios::binary);
+    if (!file) return false;
+
+    CacheFileHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (std::string(header.magic, 4) != "SGPB" || header.version != CacheFileVersion || header.key != key) {
+        return false;
+    }
+
+    entry.key = key;
+    entry.format = header.format;
+    entry.data.resize(header.size);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(entry.data.data()), header.size));
+}
+
+void ProgramCache::writeFile(const Entry& entry) const {
+    // Write to a temporary file first so a crash never leaves a truncated binary behind
+    std::string path = pathFor(entry.key);
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        if (!file) return;
+
+        CacheFileHeader header{};
+        header.magic[0] = 'S'; header.magic[1] = 'G'; header.magic[2] = 'P'; header.magic[3] = 'B';
+        header.version = CacheFileVersion;
+        header.key = entry.key;
+        header.format = entry.format;
+        header.size = static_cast<uint32_t>(entry.data.size());
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entry.data.data()), entry.data.size());
+        if (!file) return;
+    }
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) std::filesystem::remove(tmpPath, ec);
+}
@@ -0,0 +1,909 @@
+#include "shader_bake.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <thread>
+#include <unordered_map>
+
+// SHADERGRAPH_BAKE_SCALAR forces the portable kernels (the tests check both against a reference)
+#if defined(SHADERGRAPH_BAKE_SCALAR)
+#elif defined(__AVX__)
+#define SHADERGRAPH_BAKE_AVX 1
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SHADERGRAPH_BAKE_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#define SHADERGRAPH_BAKE_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace ShaderGraph {
+
+namespace {
+
+// ----------------------------------------------------------------------------
+// SIMD lanes
+// ----------------------------------------------------------------------------
+
+#if defined(SHADERGRAPH_BAKE_AVX)
+constexpr uint32_t Lanes = 8;
+struct Vec { __m256 v; };
+inline Vec load(const float* p) { return {_mm256_load_ps(p)}; }
+inline void store(float* p, Vec a) { _mm256_store_ps(p, a.v); }
+inline Vec splat(float x) { return {_mm256_set1_ps(x)}; }
+inline Vec operator+(Vec a, Vec b) { return {_mm256_add_ps(a.v, b.v)}; }
+inline Vec operator-(Vec a, Vec b) { return {_mm256_sub_ps(a.v, b.v)}; }
+inline Vec operator*(Vec a, Vec b) { return {_mm256_mul_ps(a.v, b.v)}; }
+inline Vec operator/(Vec a, Vec b) { return {_mm256_div_ps(a.v, b.v)}; }
+inline Vec vmin(Vec a, Vec b) { return {_mm256_min_ps(a.v, b.v)}; }
+inline Vec vmax(Vec a, Vec b) { return {_mm256_max_ps(a.v, b.v)}; }
+inline Vec vabs(Vec a) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v)}; }
+inline Vec vsqrt(Vec a) { return {_mm256_sqrt_ps(a.v)}; }
+inline Vec vround(Vec a) { return {_mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC)}; }
+#elif defined(SHADERGRAPH_BAKE_SSE2)
+constexpr uint32_t Lanes = 4;
+struct Vec { __m128 v; };
+inline Vec load(const float* p) { return {_mm_load_ps(p)}; }
+inline void store(float* p, Vec a) { _mm_store_ps(p, a.v); }
+inline Vec splat(float x) { return {_mm_set1_ps(x)}; }
+inline Vec operator+(Vec a, Vec b) { return {_mm_add_ps(a.v, b.v)}; }
+inline Vec operator-(Vec a, Vec b) { return {_mm_sub_ps(a.v, b.v)}; }
+inline Vec operator*(Vec a, Vec b) { return {_mm_mul_ps(a.v, b.v)}; }
+inline Vec operator/(Vec a, Vec b) { return {_mm_div_ps(a.v, b.v)}; }
+inline Vec vmin(Vec a, Vec b) { return {_mm_min_ps(a.v, b.v)}; }
+inline Vec vmax(Vec a, Vec b) { return {_mm_max_ps(a.v, b.v)}; }
+inline Vec vabs(Vec a) { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v)}; }
+inline Vec vsqrt(Vec a) { return {_mm_sqrt_ps(a.v)}; }
+// No round instruction before SSE4.1: adding 1.5 * 2^23 pushes the fraction out of the
+// mantissa (exact for |x| < 2^22, beyond which every float is already whole)
+inline Vec vround(Vec a) {
+    const __m128 magic = _mm_set1_ps(12582912.0f);
+    const __m128 small = _mm_cmplt_ps(_mm_andnot_ps(_mm_set1_ps(-0.0f), a.v), _mm_set1_ps(4194304.0f));
+    const __m128 rounded = _mm_sub_ps(_mm_add_ps(a.v, magic), magic);
+    return {_mm_or_ps(_mm_and_ps(small, rounded), _mm_andnot_ps(small, a.v))};
+}
+#elif defined(SHADERGRAPH_BAKE_NEON)
+constexpr uint32_t Lanes = 4;
+struct Vec { float32x4_t v; };
+inline Vec load(const float* p) { return {vld1q_f32(p)}; }
+inline void store(float* p, Vec a) { vst1q_f32(p, a.v); }
+inline Vec splat(float x) { return {vdupq_n_f32(x)}; }
+inline Vec operator+(Vec a, Vec b) { return {vaddq_f32(a.v, b.v)}; }
+inline Vec operator-(Vec a, Vec b) { return {vsubq_f32(a.v, b.v)}; }
+inline Vec operator*(Vec a, Vec b) { return {vmulq_f32(a.v, b.v)}; }
+inline Vec operator/(Vec a, Vec b) { return {vdivq_f32(a.v, b.v)}; }
+inline Vec vmin(Vec a, Vec b) { return {vminq_f32(a.v, b.v)}; }
+inline Vec vmax(Vec a, Vec b) { return {vmaxq_f32(a.v, b.v)}; }
+inline Vec vabs(Vec a) { return {vabsq_f32(a.v)}; }
+inline Vec vsqrt(Vec a) { return {vsqrtq_f32(a.v)}; }
+inline Vec vround(Vec a) { return {vrndnq_f32(a.v)}; }
+#else
+constexpr uint32_t Lanes = 4;
+struct Vec { float v[4]; };
+inline Vec load(const float* p) { return {{p[0], p[1], p[2], p[3]}}; }
+inline void store(float* p, Vec a) { std::memcpy(p, a.v, sizeof(a.v)); }
+inline Vec splat(float x) { return {{x, x, x, x}}; }
+template <typename F>
+inline Vec each(Vec a, Vec b, F f) { return {{f(a.v[0], b.v[0]), f(a.v[1], b.v[1]), f(a.v[2], b.v[2]), f(a.v[3], b.v[3])}}; }
+inline Vec operator+(Vec a, Vec b) { return each(a, b, [](float x, float y) { return x + y; }); }
+inline Vec operator-(Vec a, Vec b) { return each(a, b, [](float x, float y) { return x - y; }); }
+inline Vec operator*(Vec a, Vec b) { return each(a, b, [](float x, float y) { return x * y; }); }
+inline Vec operator/(Vec a, Vec b) { return each(a, b, [](float x, float y) { return x / y; }); }
+inline Vec vmin(Vec a, Vec b) { return each(a, b, [](float x, float y) { return y < x ? y : x; }); }
+inline Vec vmax(Vec a, Vec b) { return each(a, b, [](float x, float y) { return x < y ? y : x; }); }
+inline Vec vabs(Vec a) { return each(a, a, [](float x, float) { return std::fabs(x); }); }
+inline Vec vsqrt(Vec a) { return each(a, a, [](float x, float) { return std::sqrt(x); }); }
+inline Vec vround(Vec a) { return each(a, a, [](float x, float) { return std::nearbyint(x); }); }
+#endif
+
+static_assert(BakeTileSize % Lanes == 0, "a slot is a whole number of vectors");
+constexpr uint32_t VecsPerSlot = BakeTileSize / Lanes;
+
+// sin(x): reduce by pi to r in [-pi/2, pi/2], so sin(x) = (-1)^k sin(r), then a degree 11
+// odd polynomial (error below 1e-7 on the reduced range)
+inline Vec vsin(Vec x) {
+    const Vec k = vround(x * splat(0.318309886f));
+    // Two-part pi keeps the reduction exact for large k
+    const Vec r = (x - k * splat(3.140625f)) - k * splat(9.67653590e-4f);
+    const Vec half = k * splat(0.5f);
+    const Vec sign = splat(1.0f) - splat(4.0f) * vabs(half - vround(half));
+    const Vec r2 = r * r;
+    Vec p = splat(-2.50521084e-8f);
+    p = p * r2 + splat(2.75573192e-6f);
+    p = p * r2 + splat(-1.98412698e-4f);
+    p = p * r2 + splat(8.33333333e-3f);
+    p = p * r2 + splat(-1.66666667e-1f);
+    p = p * r2 + splat(1.0f);
+    return sign * (r * p);
+}
+
+inline Vec vcos(Vec x) { return vsin(x + splat(1.57079633f)); }
+
+// ----------------------------------------------------------------------------
+// Program
+// ----------------------------------------------------------------------------
+
+enum class Kernel : uint8_t {
+    Fill,       // value[] into every lane
+    FragPos,
+    Normal,
+    TexCoord,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Min,
+    Max,
+    Pow,
+    Sin,
+    Cos,
+    Abs,
+    Mix,
+    Clamp,
+    Normalize,
+    Dot,
+    Texture
+};
+
+// One instruction over a span. Every component of every value lives in its own slot, so
+// swizzles and MakeVec3 are just slot renaming and never run.
+struct Step {
+    Kernel kernel = Kernel::Fill;
+    uint8_t components = 1;         // Of the result (of the operand for Normalize and Dot)
+    uint32_t out[4] = {};
+    uint32_t in[3][4] = {};         // Per result component, with scalars broadcast
+    float value[4] = {};
+    uint32_t sampler = 0;
+};
+
+struct Ref {
+    uint32_t slot[4] = {};
+    uint8_t components = 0;
+    bool uniform = true;            // Same for every pixel
+
+    uint32_t lane(int c) const { return slot[components <= 1 ? 0 : std::min<int>(c, components - 1)]; }
+};
+
+struct Sampler {
+    uint32_t width = 1;
+    uint32_t height = 1;
+    std::vector<uint8_t> rgba = {128, 128, 128, 255};   // The streamer's placeholder grey
+};
+
+struct Program {
+    std::vector<Step> prologue;     // Uniform values, run once per worker
+    std::vector<Step> body;         // Run per span
+    uint32_t slotCount = 0;
+    Ref color;
+    Ref alpha;
+    std::vector<Sampler> samplers;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+bool builtinUniform(const std::string& name, const BakeOptions& options, float value[4]) {
+    const float* source = nullptr;
+    if (name == "time") {
+        value[0] = options.time;
+        return true;
+    }
+    if (name == "lightPos") source = options.lightPos;
+    else if (name == "viewPos") source = options.viewPos;
+    else if (name == "lightColor") source = options.lightColor;
+    else if (name == "objectColor") source = options.objectColor;
+    if (!source) return false;
+    std::copy(source, source + 3, value);
+    return true;
+}
+
+bool loadSampler(const UniformParameter& param, Sampler& sampler, std::string& error) {
+    if (param.texturePath.empty()) return true;
+    std::ifstream file(param.texturePath, std::ios::binary);
+    if (!file) {
+        error = "cannot open texture " + param.texturePath;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    TextureImage image;
+    std::string decodeError;
+    if (!decodeTexture(data.data(), data.size(), image, decodeError)) {
+        error = param.texturePath + ": " + decodeError;
+        return false;
+    }
+    sampler.width = image.width();
+    sampler.height = image.height();
+    if (image.format == TextureFormat::RGBA16F) {
+        const size_t count = size_t(sampler.width) * sampler.height * 4;
+        sampler.rgba.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            uint16_t half;
+            std::memcpy(&half, image.levelData(0) + i * 2, sizeof(half));
+            const float x = halfToFloat(half);
+            sampler.rgba[i] = static_cast<uint8_t>((!(x > 0.0f) ? 0.0f : x >= 1.0f ? 1.0f : x) * 255.0f + 0.5f);
+        }
+        return true;
+    }
+    if (image.format != TextureFormat::RGBA8) {
+        error = param.texturePath + ": " + textureFormatInfo(image.format).name +
+                " images can't be sampled on the CPU; bake from an uncompressed source";
+        return false;
+    }
+    sampler.rgba.assign(image.levelData(0), image.levelData(0) + image.levels[0].size);
+    return true;
+}
+
+// Virtual slots first (one per produced component), then a linear scan reuses the slots
+// of per-pixel values after their last read. Uniform values keep theirs for good.
+class Compiler {
+public:
+    Compiler(const IRModule& module, const std::vector<UniformParameter>& parameters, const BakeOptions& options,
+             Program& program)
+        : m_module(module), m_parameters(parameters), m_options(options), m_program(program) {}
+
+    bool compile(std::string& error) {
+        if (m_module.color == IRNone || m_module.alpha == IRNone) {
+            error = "nothing is connected to the output";
+            return false;
+        }
+        for (size_t i = 0; i < m_parameters.size(); ++i) m_byName.emplace(m_parameters[i].name, i);
+
+        std::vector<bool> live;
+        markLive(m_module, live);
+        std::vector<Ref> refs(m_module.instrs.size());
+        for (size_t i = 0; i < m_module.instrs.size(); ++i) {
+            if (live[i] && !lower(m_module.instrs[i], refs, refs[i], error)) return false;
+        }
+        m_program.color = refs[m_module.color];
+        m_program.alpha = refs[m_module.alpha];
+        allocate();
+        return true;
+    }
+
+private:
+    uint32_t newSlot(bool uniform) {
+        m_uniformSlot.push_back(uniform);
+        return static_cast<uint32_t>(m_uniformSlot.size() - 1);
+    }
+
+    Step& add(Kernel kernel, int components, bool uniform, Ref& result) {
+        Step step;
+        step.kernel = kernel;
+        step.components = static_cast<uint8_t>(components);
+        const int outputs = kernel == Kernel::Dot ? 1 : kernel == Kernel::Texture ? 4 : components;
+        result.components = static_cast<uint8_t>(outputs);
+        result.uniform = uniform;
+        for (int c = 0; c < outputs; ++c) result.slot[c] = step.out[c] = newSlot(uniform);
+        std::vector<Step>& list = uniform ? m_program.prologue : m_program.body;
+        list.push_back(step);
+        return list.back();
+    }
+
+    void fill(const float value[4], int components, Ref& result) {
+        Step& step = add(Kernel::Fill, components, true, result);
+        std::copy(value, value + 4, step.value);
+    }
+
+    // Component-wise ops broadcast scalar operands over the result
+    void elementwise(Kernel kernel, const IRInstr& instr, int operands, const std::vector<Ref>& refs, Ref& result) {
+        const int components = componentCount(instr.type);
+        bool uniform = true;
+        for (int k = 0; k < operands; ++k) uniform = uniform && refs[instr.operands[k]].uniform;
+        Step& step = add(kernel, components, uniform, result);
+        for (int k = 0; k < operands; ++k) {
+            for (int c = 0; c < components; ++c) step.in[k][c] = refs[instr.operands[k]].lane(c);
+        }
+    }
+
+    bool lower(const IRInstr& instr, const std::vector<Ref>& refs, Ref& result, std::string& error) {
+        const float zero[4] = {};
+        switch (instr.op) {
+            case IROp::Const:
+                fill(instr.constant, componentCount(instr.type), result);
+                return true;
+            case IROp::Input: {
+                const std::string& name = m_module.str(instr.aux);
+                const Kernel kernel = name == "FragPos" ? Kernel::FragPos : name == "Normal" ? Kernel::Normal
+                                    : name == "TexCoord" ? Kernel::TexCoord : Kernel::Fill;
+                if (kernel == Kernel::Fill) fill(zero, componentCount(instr.type), result);
+                else add(kernel, componentCount(instr.type), false, result);
+                return true;
+            }
+            case IROp::Uniform: {
+                // Unset uniforms read zero, as they do on the GPU
+                const std::string& name = m_module.str(instr.aux);
+                float value[4] = {};
+                if (!builtinUniform(name, m_options, value)) {
+                    auto it = m_byName.find(name);
+                    if (it != m_byName.end()) {
+                        const UniformParameter& param = m_parameters[it->second];
+                        if (param.type == ShaderDataType::Float) value[0] = param.floatValue;
+                        else std::copy(param.vec3Value, param.vec3Value + 3, value);
+                    }
+                }
+                fill(value, componentCount(instr.type), result);
+                return true;
+            }
+            case IROp::Swizzle: {
+                const Ref& base = refs[instr.operands[0]];
+                const std::string& mask = m_module.str(instr.aux);
+                result.components = static_cast<uint8_t>(mask.size());
+                result.uniform = base.uniform;
+                for (size_t c = 0; c < mask.size(); ++c) result.slot[c] = base.lane(swizzleComponent(mask[c]));
+                return true;
+            }
+            case IROp::MakeVec3: {
+                result.components = 3;
+                result.uniform = true;
+                for (int c = 0; c < 3; ++c) {
+                    const Ref& part = refs[instr.operands[c]];
+                    result.slot[c] = part.slot[0];
+                    result.uniform = result.uniform && part.uniform;
+                }
+                return true;
+            }
+            case IROp::Add: elementwise(Kernel::Add, instr, 2, refs, result); return true;
+            case IROp::Sub: elementwise(Kernel::Sub, instr, 2, refs, result); return true;
+            case IROp::Mul: elementwise(Kernel::Mul, instr, 2, refs, result); return true;
+            case IROp::Div: elementwise(Kernel::Div, instr, 2, refs, result); return true;
+            case IROp::Min: elementwise(Kernel::Min, instr, 2, refs, result); return true;
+            case IROp::Max: elementwise(Kernel::Max, instr, 2, refs, result); return true;
+            case IROp::Pow: elementwise(Kernel::Pow, instr, 2, refs, result); return true;
+            case IROp::Sin: elementwise(Kernel::Sin, instr, 1, refs, result); return true;
+            case IROp::Cos: elementwise(Kernel::Cos, instr, 1, refs, result); return true;
+            case IROp::Abs: elementwise(Kernel::Abs, instr, 1, refs, result); return true;
+            case IROp::Normalize: elementwise(Kernel::Normalize, instr, 1, refs, result); return true;
+            case IROp::Mix: elementwise(Kernel::Mix, instr, 3, refs, result); return true;
+            case IROp::Clamp: elementwise(Kernel::Clamp, instr, 3, refs, result); return true;
+            case IROp::Dot: {
+                const Ref& a = refs[instr.operands[0]];
+                const Ref& b = refs[instr.operands[1]];
+                const int components = std::max(a.components, b.components);
+                Step& step = add(Kernel::Dot, components, a.uniform && b.uniform, result);
+                for (int c = 0; c < components; ++c) {
+                    step.in[0][c] = a.lane(c);
+                    step.in[1][c] = b.lane(c);
+                }
+                return true;
+            }
+            case IROp::Texture: {
+                const Ref& uv = refs[instr.operands[0]];
+                uint32_t sampler = 0;
+                if (!samplerIndex(m_module.str(instr.aux), sampler, error)) return false;
+                Step& step = add(Kernel::Texture, 4, uv.uniform, result);
+                step.in[0][0] = uv.lane(0);
+                step.in[0][1] = uv.lane(1);
+                step.sampler = sampler;
+                return true;
+            }
+        }
+        error = "unsupported instruction";
+        return false;
+    }
+
+    static int swizzleComponent(char c) {
+        switch (c) {
+            case 'y': case 'g': return 1;
+            case 'z': case 'b': return 2;
+            case 'w': case 'a': return 3;
+            default: return 0;
+        }
+    }
+
+    bool samplerIndex(const std::string& name, uint32_t& index, std::string& error) {
+        auto cached = m_samplerByName.find(name);
+        if (cached != m_samplerByName.end()) {
+            index = cached->second;
+            return true;
+        }
+        Sampler sampler;
+        auto it = m_byName.find(name);
+        if (it != m_byName.end() && !loadSampler(m_parameters[it->second], sampler, error)) return false;
+        index = static_cast<uint32_t>(m_program.samplers.size());
+        m_program.samplers.push_back(std::move(sampler));
+        m_samplerByName.emplace(name, index);
+        return true;
+    }
+
+    void allocate() {
+        const size_t virtualCount = m_uniformSlot.size();
+        const uint32_t Unassigned = UINT32_MAX;
+        std::vector<uint32_t> physical(virtualCount, Unassigned);
+        uint32_t next = 0;
+        for (Step& step : m_program.prologue) {
+            for (int c = 0; c < outputCount(step); ++c) physical[step.out[c]] = next++;
+        }
+
+        // Last body step reading each per-pixel slot; the outputs are read at the very end
+        const size_t end = m_program.body.size();
+        std::vector<size_t> lastUse(virtualCount, 0);
+        for (size_t s = 0; s < m_program.body.size(); ++s) {
+            const Step& step = m_program.body[s];
+            for (int c = 0; c < outputCount(step); ++c) lastUse[step.out[c]] = s;
+            for (int k = 0; k < inputCount(step); ++k) {
+                for (int c = 0; c < inputComponents(step); ++c) lastUse[step.in[k][c]] = s;
+            }
+        }
+        for (const Ref* ref : {&m_program.color, &m_program.alpha}) {
+            for (int c = 0; c < ref->components; ++c) lastUse[ref->slot[c]] = end;
+        }
+
+        // Outputs are assigned before the step's inputs are released, so no kernel writes
+        // a slot it still has to read
+        std::vector<uint32_t> free;
+        for (size_t s = 0; s < m_program.body.size(); ++s) {
+            Step& step = m_program.body[s];
+            for (int c = 0; c < outputCount(step); ++c) {
+                uint32_t slot;
+                if (!free.empty()) {
+                    slot = free.back();
+                    free.pop_back();
+                } else {
+                    slot = next++;
+                }
+                physical[step.out[c]] = slot;
+            }
+            auto release = [&](uint32_t v) {
+                if (m_uniformSlot[v] || lastUse[v] != s || physical[v] == Unassigned) return;
+                free.push_back(physical[v]);
+                lastUse[v] = end + 1;   // Released once even when read twice by this step
+            };
+            for (int k = 0; k < inputCount(step); ++k) {
+                for (int c = 0; c < inputComponents(step); ++c) release(step.in[k][c]);
+            }
+            for (int c = 0; c < outputCount(step); ++c) release(step.out[c]);
+        }
+        m_program.slotCount = next;
+
+        auto remap = [&](Step& step) {
+            for (int c = 0; c < outputCount(step); ++c) step.out[c] = physical[step.out[c]];
+            for (int k = 0; k < inputCount(step); ++k) {
+                for (int c = 0; c < inputComponents(step); ++c) step.in[k][c] = physical[step.in[k][c]];
+            }
+        };
+        for (Step& step : m_program.prologue) remap(step);
+        for (Step& step : m_program.body) remap(step);
+        for (Ref* ref : {&m_program.color, &m_program.alpha}) {
+            for (int c = 0; c < ref->components; ++c) ref->slot[c] = physical[ref->slot[c]];
+        }
+    }
+
+    static int outputCount(const Step& step) {
+        return step.kernel == Kernel::Dot ? 1 : step.kernel == Kernel::Texture ? 4 : step.components;
+    }
+
+    static int inputCount(const Step& step) {
+        switch (step.kernel) {
+            case Kernel::Fill: case Kernel::FragPos: case Kernel::Normal: case Kernel::TexCoord: return 0;
+            case Kernel::Sin: case Kernel::Cos: case Kernel::Abs: case Kernel::Normalize: case Kernel::Texture: return 1;
+            case Kernel::Mix: case Kernel::Clamp: return 3;
+            default: return 2;
+        }
+    }
+
+    static int inputComponents(const Step& step) { return step.kernel == Kernel::Texture ? 2 : step.components; }
+
+    const IRModule& m_module;
+    const std::vector<UniformParameter>& m_parameters;
+    const BakeOptions& m_options;
+    Program& m_program;
+    std::unordered_map<std::string, size_t> m_byName;
+    std::unordered_map<std::string, uint32_t> m_samplerByName;
+    std::vector<bool> m_uniformSlot;
+};
+
+// ----------------------------------------------------------------------------
+// Kernels
+// ----------------------------------------------------------------------------
+
+class Evaluator {
+public:
+    explicit Evaluator(const Program& program) : m_program(program), m_slots(size_t(program.slotCount) * VecsPerSlot) {
+        for (const Step& step : program.prologue) run(step, 0, 0);
+    }
+
+    // Shade BakeTileSize pixels of row y from x0 into rgba (the row's first pixel)
+    void shade(uint32_t x0, uint32_t y, float* row) {
+        for (const Step& step : m_program.body) run(step, x0, y);
+        const uint32_t count = std::min(BakeTileSize, m_program.width - x0);
+        const float* channels[4] = {slot(m_program.color.lane(0)), slot(m_program.color.lane(1)),
+                                    slot(m_program.color.lane(2)), slot(m_program.alpha.lane(0))};
+        for (uint32_t p = 0; p < count; ++p) {
+            for (int c = 0; c < 4; ++c) row[(x0 + p) * 4 + c] = channels[c][p];
+        }
+    }
+
+private:
+    float* slot(uint32_t index) { return reinterpret_cast<float*>(m_slots.data() + size_t(index) * VecsPerSlot); }
+
+    template <typename F>
+    void map1(const Step& step, F f) {
+        for (int c = 0; c < step.components; ++c) {
+            const float* a = slot(step.in[0][c]);
+            float* out = slot(step.out[c]);
+            for (uint32_t i = 0; i < BakeTileSize; i += Lanes) store(out + i, f(load(a + i)));
+        }
+    }
+
+    template <typename F>
+    void map2(const Step& step, F f) {
+        for (int c = 0; c < step.components; ++c) {
+            const float* a = slot(step.in[0][c]);
+            const float* b = slot(step.in[1][c]);
+            float* out = slot(step.out[c]);
+            for (uint32_t i = 0; i < BakeTileSize; i += Lanes) store(out + i, f(load(a + i), load(b + i)));
+        }
+    }
+
+    template <typename F>
+    void map3(const Step& step, F f) {
+        for (int c = 0; c < step.components; ++c) {
+            const float* a = slot(step.in[0][c]);
+            const float* b = slot(step.in[1][c]);
+            const float* t = slot(step.in[2][c]);
+            float* out = slot(step.out[c]);
+            for (uint32_t i = 0; i < BakeTileSize; i += Lanes) store(out + i, f(load(a + i), load(b + i), load(t + i)));
+        }
+    }
+
+    void fillLanes(uint32_t index, float value) {
+        float* out = slot(index);
+        for (uint32_t i = 0; i < BakeTileSize; i += Lanes) store(out + i, splat(value));
+    }
+
+    // Pixel centers of the span; the preview plane is 1.2 units across, +Y up
+    void surface(float* u, float* v, uint32_t x0, uint32_t y) const {
+        const float invWidth = 1.0f / static_cast<float>(m_program.width);
+        const float vy = (static_cast<float>(y) + 0.5f) / static_cast<float>(m_program.height);
+        for (uint32_t p = 0; p < BakeTileSize; ++p) {
+            u[p] = (static_cast<float>(x0 + p) + 0.5f) * invWidth;
+            v[p] = vy;
+        }
+    }
+
+    void run(const Step& step, uint32_t x0, uint32_t y) {
+        switch (step.kernel) {
+            case Kernel::Fill:
+                for (int c = 0; c < step.components; ++c) fillLanes(step.out[c], step.value[c]);
+                break;
+            case Kernel::TexCoord:
+                surface(slot(step.out[0]), slot(step.out[std::min<int>(1, step.components - 1)]), x0, y);
+                break;
+            case Kernel::FragPos: {
+                alignas(32) float u[BakeTileSize], v[BakeTileSize];
+                surface(u, v, x0, y);
+                float* out[3] = {slot(step.out[0]), slot(step.out[std::min<int>(1, step.components - 1)]),
+                                 slot(step.out[std::min<int>(2, step.components - 1)])};
+                for (uint32_t p = 0; p < BakeTileSize; ++p) {
+                    out[2][p] = 0.0f;
+                    out[1][p] = (0.5f - v[p]) * 1.2f;
+                    out[0][p] = (u[p] - 0.5f) * 1.2f;
+                }
+                break;
+            }
+            case Kernel::Normal:
+                for (int c = 0; c < step.components; ++c) fillLanes(step.out[c], c == 2 ? 1.0f : 0.0f);
+                break;
+            case Kernel::Add: map2(step, [](Vec a, Vec b) { return a + b; }); break;
+            case Kernel::Sub: map2(step, [](Vec a, Vec b) { return a - b; }); break;
+            case Kernel::Mul: map2(step, [](Vec a, Vec b) { return a * b; }); break;
+            case Kernel::Div: map2(step, [](Vec a, Vec b) { return a / b; }); break;
+            case Kernel::Min: map2(step, [](Vec a, Vec b) { return vmin(a, b); }); break;
+            case Kernel::Max: map2(step, [](Vec a, Vec b) { return vmax(a, b); }); break;
+            case Kernel::Pow:
+                // No vector pow; it only appears in Fresnel, one per pixel
+                for (int c = 0; c < step.components; ++c) {
+                    const float* a = slot(step.in[0][c]);
+                    const float* b = slot(step.in[1][c]);
+                    float* out = slot(step.out[c]);
+                    for (uint32_t i = 0; i < BakeTileSize; ++i) out[i] = std::pow(a[i], b[i]);
+                }
+                break;
+            case Kernel::Sin: map1(step, [](Vec a) { return vsin(a); }); break;
+            case Kernel::Cos: map1(step, [](Vec a) { return vcos(a); }); break;
+            case Kernel::Abs: map1(step, [](Vec a) { return vabs(a); }); break;
+            case Kernel::Mix:
+                map3(step, [](Vec a, Vec b, Vec t) { return a * (splat(1.0f) - t) + b * t; });
+                break;
+            case Kernel::Clamp: map3(step, [](Vec x, Vec lo, Vec hi) { return vmin(vmax(x, lo), hi); }); break;
+            case Kernel::Normalize:
+                for (uint32_t i = 0; i < BakeTileSize; i += Lanes) {
+                    Vec length = splat(0.0f);
+                    for (int c = 0; c < step.components; ++c) {
+                        const Vec x = load(slot(step.in[0][c]) + i);
+                        length = length + x * x;
+                    }
+                    length = vsqrt(length);
+                    for (int c = 0; c < step.components; ++c) {
+                        store(slot(step.out[c]) + i, load(slot(step.in[0][c]) + i) / length);
+                    }
+                }
+                break;
+            case Kernel::Dot:
+                for (uint32_t i = 0; i < BakeTileSize; i += Lanes) {
+                    Vec sum = splat(0.0f);
+                    for (int c = 0; c < step.components; ++c) {
+                        sum = sum + load(slot(step.in[0][c]) + i) * load(slot(step.in[1][c]) + i);
+                    }
+                    store(slot(step.out[0]) + i, sum);
+                }
+                break;
+            case Kernel::Texture: sample(step); break;
+        }
+    }
+
+    // Bilinear with repeat, texel centers at half coordinates like GL
+    void sample(const Step& step) {
+        const Sampler& sampler = m_program.samplers[step.sampler];
+        const float* u = slot(step.in[0][0]);
+        const float* v = slot(step.in[0][1]);
+        float* out[4] = {slot(step.out[0]), slot(step.out[1]), slot(step.out[2]), slot(step.out[3])};
+        const float width = static_cast<float>(sampler.width), height = static_cast<float>(sampler.height);
+        const int32_t lastX = static_cast<int32_t>(sampler.width) - 1, lastY = static_cast<int32_t>(sampler.height) - 1;
+
+        // Address math for the whole span first, so it vectorizes; repeat wraps the
+        // coordinate into [0, size) before the texel pair is taken
+        alignas(32) int32_t ix[BakeTileSize], iy[BakeTileSize];
+        alignas(32) float tx[BakeTileSize], ty[BakeTileSize];
+        bool finite = true;
+        for (uint32_t p = 0; p < BakeTileSize; ++p) {
+            float x = u[p] - std::floor(u[p]), y = v[p] - std::floor(v[p]);
+            // NaN and infinite coordinates (x - floor(x) is NaN for both) read black
+            const bool valid = x >= 0.0f && y >= 0.0f;
+            finite = finite && valid;
+            x = valid ? x : 0.0f;
+            y = valid ? y : 0.0f;
+            const float sx = x * width - 0.5f + width, sy = y * height - 0.5f + height;
+            const float fx = std::floor(sx), fy = std::floor(sy);
+            tx[p] = sx - fx;
+            ty[p] = sy - fy;
+            ix[p] = static_cast<int32_t>(fx);
+            iy[p] = static_cast<int32_t>(fy);
+        }
+        for (uint32_t p = 0; p < BakeTileSize; ++p) {
+            if (!finite && !(u[p] - std::floor(u[p]) >= 0.0f && v[p] - std::floor(v[p]) >= 0.0f)) {
+                for (int c = 0; c < 4; ++c) out[c][p] = 0.0f;
+                continue;
+            }
+            const int32_t x0 = ix[p] % static_cast<int32_t>(sampler.width);
+            const int32_t y0 = iy[p] % static_cast<int32_t>(sampler.height);
+            const int32_t x1 = x0 == lastX ? 0 : x0 + 1, y1 = y0 == lastY ? 0 : y0 + 1;
+            const uint8_t* t00 = &sampler.rgba[(size_t(y0) * sampler.width + x0) * 4];
+            const uint8_t* t10 = &sampler.rgba[(size_t(y0) * sampler.width + x1) * 4];
+            const uint8_t* t01 = &sampler.rgba[(size_t(y1) * sampler.width + x0) * 4];
+            const uint8_t* t11 = &sampler.rgba[(size_t(y1) * sampler.width + x1) * 4];
+            for (int c = 0; c < 4; ++c) {
+                const float top = t00[c] + (t10[c] - t00[c]) * tx[p];
+                const float bottom = t01[c] + (t11[c] - t01[c]) * tx[p];
+                out[c][p] = (top + (bottom - top) * ty[p]) * (1.0f / 255.0f);
+            }
+        }
+    }
+
+    const Program& m_program;
+    std::vector<Vec> m_slots;
+};
+
+// ----------------------------------------------------------------------------
+// Work-stealing rows
+// ----------------------------------------------------------------------------
+
+// Rows are dealt out as one contiguous range per worker. A worker takes rows from the
+// front of its own range; once that is empty it steals the back half of the largest
+// remaining one, so expensive regions (texture-heavy rows) still balance out. A range is
+// packed into one atomic as begin << 32 | end, so taking and stealing are single CASes.
+// fn(worker, row) runs on the calling thread as worker 0 and on threads - 1 more.
+template <typename RowFn>
+void parallelRows(uint32_t rows, unsigned threads, RowFn&& fn) {
+    threads = std::max(1u, std::min<unsigned>(threads, rows));
+    auto pack = [](uint64_t begin, uint64_t end) { return begin << 32 | end; };
+    std::vector<std::atomic<uint64_t>> ranges(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+        ranges[t].store(pack(uint64_t(rows) * t / threads, uint64_t(rows) * (t + 1) / threads));
+    }
+
+    auto work = [&](unsigned self) {
+        for (;;) {
+            uint64_t range = ranges[self].load();
+            while (uint32_t(range >> 32) < uint32_t(range)) {
+                const uint32_t row = uint32_t(range >> 32);
+                if (ranges[self].compare_exchange_weak(range, pack(row + 1, uint32_t(range)))) {
+                    fn(self, row);
+                    range = ranges[self].load();
+                }
+            }
+
+            unsigned victim = self;
+            uint32_t most = 0;
+            for (unsigned t = 0; t < threads; ++t) {
+                const uint64_t r = ranges[t].load();
+                const uint32_t remaining = uint32_t(r) > uint32_t(r >> 32) ? uint32_t(r) - uint32_t(r >> 32) : 0;
+                if (t != self && remaining > most) {
+                    most = remaining;
+                    victim = t;
+                }
+            }
+            if (victim == self) return;
+            uint64_t stolen = ranges[victim].load();
+            const uint32_t begin = uint32_t(stolen >> 32), end = uint32_t(stolen);
+            if (begin >= end) continue;
+            const uint32_t middle = begin + (end - begin) / 2;
+            if (ranges[victim].compare_exchange_strong(stolen, pack(begin, middle))) {
+                ranges[self].store(pack(middle, end));
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    for (unsigned t = 1; t < threads; ++t) workers.emplace_back(work, t);
+    work(0);
+    for (auto& worker : workers) worker.join();
+}
+
+// 2x2 box filter in float; odd edges clamp onto the last row or column
+void downsample(const std::vector<float>& src, uint32_t srcWidth, uint32_t srcHeight, std::vector<float>& dst,
+                uint32_t width, uint32_t y) {
+    const uint32_t y0 = std::min(y * 2, srcHeight - 1), y1 = std::min(y * 2 + 1, srcHeight - 1);
+    for (uint32_t x = 0; x < width; ++x) {
+        const uint32_t x0 = std::min(x * 2, srcWidth - 1), x1 = std::min(x * 2 + 1, srcWidth - 1);
+        for (int c = 0; c < 4; ++c) {
+            dst[(size_t(y) * width + x) * 4 + c] =
+                0.25f * (src[(size_t(y0) * srcWidth + x0) * 4 + c] + src[(size_t(y0) * srcWidth + x1) * 4 + c] +
+                         src[(size_t(y1) * srcWidth + x0) * 4 + c] + src[(size_t(y1) * srcWidth + x1) * 4 + c]);
+        }
+    }
+}
+
+// Float rows to texels: RGBA8 remapped by the range and clamped, RGBA16F as they are
+class Quantizer {
+public:
+    Quantizer(TextureFormat format, const BakeRange& range) : m_half(format == TextureFormat::RGBA16F) {
+        for (int c = 0; c < 4; ++c) {
+            m_bias[c] = range.bias[c];
+            m_invScale[c] = range.scale[c] != 0.0f ? 1.0f / range.scale[c] : 0.0f;
+        }
+    }
+
+    void row(const float* src, uint8_t* dst, uint32_t width) const {
+        if (m_half) {
+            for (uint32_t i = 0; i < width * 4; ++i) {
+                const uint16_t half = floatToHalf(src[i]);
+                std::memcpy(dst + i * 2, &half, sizeof(half));
+            }
+            return;
+        }
+        for (uint32_t i = 0; i < width * 4; ++i) {
+            const float x = (src[i] - m_bias[i & 3]) * m_invScale[i & 3];
+            dst[i] = static_cast<uint8_t>((!(x > 0.0f) ? 0.0f : x >= 1.0f ? 1.0f : x) * 255.0f + 0.5f);
+        }
+    }
+
+private:
+    bool m_half;
+    float m_bias[4];
+    float m_invScale[4];
+};
+
+// Finite extremes of every channel, one per worker
+struct ChannelBounds {
+    float lo[4] = {INFINITY, INFINITY, INFINITY, INFINITY};
+    float hi[4] = {-INFINITY, -INFINITY, -INFINITY, -INFINITY};
+
+    void add(const float* rgba, uint32_t width) {
+        for (uint32_t i = 0; i < width * 4; ++i) {
+            const float x = rgba[i];
+            if (!std::isfinite(x)) continue;
+            lo[i & 3] = std::min(lo[i & 3], x);
+            hi[i & 3] = std::max(hi[i & 3], x);
+        }
+    }
+};
+
+} // namespace
+
+bool bakeModule(const IRModule& module, const std::vector<UniformParameter>& parameters, const BakeOptions& options,
+                TextureImage& image, std::string& error, BakeRange* range) {
+    if (options.width == 0 || options.height == 0 || options.width > 16384 || options.height > 16384) {
+        error = "unsupported bake size " + std::to_string(options.width) + "x" + std::to_string(options.height);
+        return false;
+    }
+    if (options.format != TextureFormat::RGBA8 && options.format != TextureFormat::RGBA16F) {
+        error = std::string("can't bake into ") + textureFormatInfo(options.format).name;
+        return false;
+    }
+    Program program;
+    program.width = options.width;
+    program.height = options.height;
+    if (!Compiler(module, parameters, options, program).compile(error)) return false;
+
+    const unsigned threads =
+        options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    const uint32_t levelCount = options.mipmaps ? textureMipCount(options.width, options.height) : 1;
+    layoutTextureLevels(image, options.format, options.width, options.height, levelCount);
+    const size_t texelBytes = textureFormatInfo(options.format).bytesPerBlock;
+    const bool fit = options.fitRange && options.format == TextureFormat::RGBA8;
+
+    // Each worker shades with its own slots; constructing one runs the uniform prologue
+    std::vector<Evaluator> evaluators;
+    evaluators.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t) evaluators.emplace_back(program);
+
+    // Level 0 is kept in float when the mips are filtered from it or its range is needed
+    // before it can be stored; otherwise rows go straight to texels
+    BakeRange stored;
+    const bool keepLevel = levelCount > 1 || fit;
+    std::vector<float> level(keepLevel ? size_t(options.width) * options.height * 4 : 0);
+    std::vector<std::vector<float>> rows(keepLevel ? 0 : threads, std::vector<float>(size_t(options.width) * 4));
+    std::vector<ChannelBounds> bounds(fit ? threads : 0);
+    const Quantizer direct(options.format, stored);
+    parallelRows(options.height, threads, [&](unsigned worker, uint32_t y) {
+        float* row = keepLevel ? level.data() + size_t(y) * options.width * 4 : rows[worker].data();
+        for (uint32_t x = 0; x < options.width; x += BakeTileSize) evaluators[worker].shade(x, y, row);
+        if (fit) bounds[worker].add(row, options.width);
+        else direct.row(row, image.pixels.data() + image.levels[0].offset + size_t(y) * options.width * texelBytes,
+                        options.width);
+    });
+
+    if (fit) {
+        ChannelBounds total;
+        for (const ChannelBounds& b : bounds) {
+            for (int c = 0; c < 4; ++c) {
+                total.lo[c] = std::min(total.lo[c], b.lo[c]);
+                total.hi[c] = std::max(total.hi[c], b.hi[c]);
+            }
+        }
+        for (int c = 0; c < 4; ++c) {
+            if (!(total.lo[c] <= total.hi[c])) continue;    // Nothing finite: identity
+            stored.bias[c] = total.lo[c];
+            stored.scale[c] = total.hi[c] - total.lo[c];    // 0 for a constant channel
+        }
+    }
+    const Quantizer quantizer(options.format, stored);
+    if (fit) {
+        parallelRows(options.height, threads, [&](unsigned, uint32_t y) {
+            quantizer.row(level.data() + size_t(y) * options.width * 4,
+                          image.pixels.data() + image.levels[0].offset + size_t(y) * options.width * texelBytes,
+                          options.width);
+        });
+    }
+
+    std::vector<float> next;
+    for (uint32_t i = 1; i < levelCount; ++i) {
+        const TextureLevel& src = image.levels[i - 1];
+        const TextureLevel& dst = image.levels[i];
+        next.resize(size_t(dst.width) * dst.height * 4);
+        parallelRows(dst.height, threads, [&](unsigned, uint32_t y) {
+            downsample(level, src.width, src.height, next, dst.width, y);
+            quantizer.row(next.data() + size_t(y) * dst.width * 4,
+                          image.pixels.data() + dst.offset + size_t(y) * dst.width * texelBytes, dst.width);
+        });
+        level.swap(next);
+    }
+    if (range) *range = stored;
+    return true;
+}
+
+bool bakeGraph(const GraphDesc& graph, const BakeOptions& options, TextureImage& image, std::string& error,
+               const std::vector<std::string>* keywords) {
+    IRModule module;
+    lowerGraph(graph, module, keywords);
+    return bakeModule(module, parametersOf(graph), options, image, error);
+}
+
+const char* bakeKernelName() {
+#if defined(SHADERGRAPH_BAKE_AVX)
+    return "AVX";
+#elif defined(SHADERGRAPH_BAKE_SSE2)
+    return "SSE2";
+#elif defined(SHADERGRAPH_BAKE_NEON)
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+} // namespace ShaderGraph
@@ -0,0 +1,371 @@
+#include "shader_compiler.h"
+#include "program_cache.h"
+#include "gl_platform.h"
+#include <iostream>
+#include <vector>
+
+// glMaxShaderCompilerThreadsKHR / ARB (loaded at runtime, not part of the 3.3 core headers)
+typedef void (*PFN_MaxShaderCompilerThreads)(GLuint count);
+
+namespace {
+
+std::string shaderInfoLog(GLuint shader) {
+    GLint length = 0;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+    if (length <= 1) return std::string();
+    std::vector<char> log(length);
+    glGetShaderInfoLog(shader, length, nullptr, log.data());
+    return std::string(log.data());
+}
+
+std::string programInfoLog(GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+    if (length <= 1) return std::string();
+    std::vector<char> log(length);
+    glGetProgramInfoLog(program, length, nullptr, log.data());
+    return std::string(log.data());
+}
+
+GLuint createShader(GLenum stage, const std::string& source) {
+    GLuint shader = glCreateShader(stage);
+    const char* src = source.c_str();
+    glShaderSource(shader, 1, &src, nullptr);
+    glCompileShader(shader);
+    return shader;
+}
+
+// Check compile/link status of a finished build. Deletes the shaders, and the program on failure.
+bool checkBuild(GLuint vertexShader, GLuint fragmentShader, GLuint program, std::string& errorLog) {
+    bool ok = true;
+    GLint success = 0;
+
+    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    if (!success) {
+        errorLog = "VERTEX SHADER ERROR:\n" + shaderInfoLog(vertexShader);
+        ok = false;
+    }
+
+    if (ok) {
+        glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
+        if (!success) {
+            errorLog = "FRAGMENT SHADER ERROR:\n" + shaderInfoLog(fragmentShader);
+            ok = false;
+        }
+    }
+
+    if (ok) {
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            errorLog = "SHADER LINKING ERROR:\n" + programInfoLog(program);
+            ok = false;
+        }
+    }
+
+    glDetachShader(program, vertexShader);
+    glDetachShader(program, fragmentShader);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    if (!ok) glDeleteProgram(program);
+    return ok;
+}
+
+} // namespace
+
+ShaderCompiler::~ShaderCompiler() {
+    shutdown();
+}
+
+void ShaderCompiler::init(GLFWwindow* mainWindow) {
+    m_backend = Backend::Synchronous;
+
+    // Prefer driver-side parallel compilation
+    bool khr = glfwExtensionSupported("GL_KHR_parallel_shader_compile") == GLFW_TRUE;
+    bool arb = !khr && glfwExtensionSupported("GL_ARB_parallel_shader_compile") == GLFW_TRUE;
+    if (khr || arb) {
+        auto maxThreads = reinterpret_cast<PFN_MaxShaderCompilerThreads>(
+            glfwGetProcAddress(khr ? "glMaxShaderCompilerThreadsKHR" : "glMaxShaderCompilerThreadsARB"));
+        if (maxThreads) {
+            maxThreads(0xFFFFFFFFu);  // Let the driver pick
+        }
+        m_backend = Backend::ParallelKHR;
+    } else if (mainWindow) {
+        // Hidden window whose context shares objects with the main one
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        m_workerWindow = glfwCreateWindow(1, 1, "ShaderCompiler", nullptr, mainWindow);
+        glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+        if (m_workerWindow) {
+            m_quit = false;
+            m_worker = std::thread(&ShaderCompiler::workerLoop, this);
+            m_backend = Backend::SharedContext;
+        }
+    }
+
+    std::cout << "Shader compiler backend: " << getBackendName() << std::endl;
+}
+
+void ShaderCompiler::shutdown() {
+    if (m_worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+        }
+        m_cv.notify_all();
+        m_worker.join();
+    }
+    if (m_workerWindow) {
+        glfwDestroyWindow(m_workerWindow);
+        m_workerWindow = nullptr;
+    }
+
+    if (m_hasInFlight) {
+        glDeleteShader(m_inFlight.vertexShader);
+        glDeleteShader(m_inFlight.fragmentShader);
+        glDeleteProgram(m_inFlight.program);
+        m_hasInFlight = false;
+    }
+    if (m_hasFinished) {
+        releaseResult(m_finished);
+        m_hasFinished = false;
+    }
+    if (m_hasCacheHit) {
+        glDeleteProgram(m_cacheHit.program);
+        m_hasCacheHit = false;
+    }
+    m_hasPending = false;
+}
+
+const char* ShaderCompiler::getBackendName() const {
+    switch (m_backend) {
+        case Backend::ParallelKHR: return "parallel (KHR_parallel_shader_compile)";
+        case Backend::SharedContext: return "worker thread (shared context)";
+        case Backend::Synchronous: return "synchronous";
+    }
+    return "synchronous";
+}
+
+uint64_t ShaderCompiler::submit(const std::string& vertexSource, const std::string& fragmentSource) {
+    Job job;
+    job.ticket = m_nextTicket++;
+    job.vertexSource = vertexSource;
+    job.fragmentSource = fragmentSource;
+    uint64_t ticket = job.ticket;
+    
+    if (m_cache && m_cache->isEnabled()) {
+        job.cacheKey = m_cache->makeKey(vertexSource, fragmentSource);
+        job.retrievableBinary = true;
+        
+        if (unsigned int program = m_cache->load(job.cacheKey)) {
+            if (m_hasCacheHit) glDeleteProgram(m_cacheHit.program);
+            m_cacheHit = Result();
+            m_cacheHit.ticket = ticket;
+            m_cacheHit.program = program;
+            m_cacheHit.success = true;
+            m_cacheHit.fromCache = true;
+            m_cacheHit.cacheKey = job.cacheKey;
+            m_hasCacheHit = true;
+            
+            // Anything still queued is older than this program
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_hasPending = false;
+            return ticket;
+        }
+    }
+
+    switch (m_backend) {
+        case Backend::ParallelKHR:
+            if (m_hasInFlight) {
+                // Coalesce: keep only the newest request until the driver is done
+                m_pending = std::move(job);
+                m_hasPending = true;
+            } else {
+                startParallel(job);
+            }
+            break;
+
+        case Backend::SharedContext: {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pending = std::move(job);
+            m_hasPending = true;
+            m_cv.notify_one();
+            break;
+        }
+
+        case Backend::Synchronous: {
+            Result result = buildProgram(job.vertexSource, job.fragmentSource, job.retrievableBinary);
+            result.ticket = job.ticket;
+            result.cacheKey = job.cacheKey;
+            if (m_hasFinished) releaseResult(m_finished);
+            m_finished = std::move(result);
+            m_hasFinished = true;
+            break;
+        }
+    }
+
+    return ticket;
+}
+
+bool ShaderCompiler::poll(Result& result) {
+    for (;;) {
+        Result next;
+        if (m_hasCacheHit) {
+            next = std::move(m_cacheHit);
+            m_hasCacheHit = false;
+        } else if (!pollBackend(next)) {
+            return false;
+        }
+        
+        if (next.success && !next.fromCache && m_cache) {
+            m_cache->store(next.cacheKey, next.program);
+        }
+        
+        // A newer program (e.g. a cache hit) was already handed out
+        if (next.ticket < m_lastDeliveredTicket) {
+            if (next.program) glDeleteProgram(next.program);
+            continue;
+        }
+        
+        m_lastDeliveredTicket = next.ticket;
+        result = std::move(next);
+        return true;
+    }
+}
+
+bool ShaderCompiler::pollBackend(Result& result) {
+    switch (m_backend) {
+        case Backend::ParallelKHR: {
+            if (!m_hasInFlight) return false;
+            if (!finishParallel(result)) return false;
+            if (m_hasPending) {
+                m_hasPending = false;
+                startParallel(m_pending);
+            }
+            return true;
+        }
+
+        case Backend::SharedContext: {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_hasFinished) return false;
+            if (m_finishedFence) {
+                GLsync fence = static_cast<GLsync>(m_finishedFence);
+                GLenum status = glClientWaitSync(fence, 0, 0);
+                if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) return false;
+                glDeleteSync(fence);
+                m_finishedFence = nullptr;
+            }
+            result = std::move(m_finished);
+            m_hasFinished = false;
+            return true;
+        }
+
+        case Backend::Synchronous:
+            if (!m_hasFinished) return false;
+            result = std::move(m_finished);
+            m_hasFinished = false;
+            return true;
+    }
+    return false;
+}
+
+bool ShaderCompiler::isBusy() const {
+    if (m_backend == Backend::SharedContext) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_hasCacheHit || m_hasPending || m_workerBusy || m_hasFinished;
+    }
+    return m_hasCacheHit || m_hasPending || m_hasInFlight || m_hasFinished;
+}
+
+ShaderCompiler::Result ShaderCompiler::buildProgram(const std::string& vertexSource, const std::string& fragmentSource,
+                                                    bool retrievableBinary) {
+    Result result;
+    GLuint vertexShader = createShader(GL_VERTEX_SHADER, vertexSource);
+    GLuint fragmentShader = createShader(GL_FRAGMENT_SHADER, fragmentSource);
+    GLuint program = glCreateProgram();
+    if (retrievableBinary) {
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+
+    result.success = checkBuild(vertexShader, fragmentShader, program, result.errorLog);
+    result.program = result.success ? program : 0;
+    return result;
+}
+
+void ShaderCompiler::startParallel(const Job& job) {
+    // With parallel compile enabled none of these calls wait for the driver
+    m_inFlight.ticket = job.ticket;
+    m_inFlight.cacheKey = job.cacheKey;
+    m_inFlight.vertexShader = createShader(GL_VERTEX_SHADER, job.vertexSource);
+    m_inFlight.fragmentShader = createShader(GL_FRAGMENT_SHADER, job.fragmentSource);
+    m_inFlight.program = glCreateProgram();
+    if (job.retrievableBinary) {
+        glProgramParameteri(m_inFlight.program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    glAttachShader(m_inFlight.program, m_inFlight.vertexShader);
+    glAttachShader(m_inFlight.program, m_inFlight.fragmentShader);
+    glLinkProgram(m_inFlight.program);
+    m_hasInFlight = true;
+}
+
+bool ShaderCompiler::finishParallel(Result& result) {
+    GLint done = GL_FALSE;
+    glGetProgramiv(m_inFlight.program, GL_COMPLETION_STATUS_KHR, &done);
+    if (done == GL_FALSE) return false;
+
+    result = Result();
+    result.ticket = m_inFlight.ticket;
+    result.cacheKey = m_inFlight.cacheKey;
+    result.success = checkBuild(m_inFlight.vertexShader, m_inFlight.fragmentShader, m_inFlight.program, result.errorLog);
+    result.program = result.success ? m_inFlight.program : 0;
+    m_hasInFlight = false;
+    return true;
+}
+
+void ShaderCompiler::workerLoop() {
+    glfwMakeContextCurrent(m_workerWindow);
+
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_quit || m_hasPending; });
+            if (m_quit) break;
+            job = std::move(m_pending);
+            m_hasPending = false;
+            m_workerBusy = true;
+        }
+
+        Result result = buildProgram(job.vertexSource, job.fragmentSource, job.retrievableBinary);
+        result.ticket = job.ticket;
+        result.cacheKey = job.cacheKey;
+
+        // The fence lets the render thread know the program is visible in its context
+        GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_hasFinished) {
+            // Superseded before the render thread picked it up
+            releaseResult(m_finished);
+        }
+        m_finished = std::move(result);
+        m_finishedFence = fence;
+        m_hasFinished = true;
+        m_workerBusy = false;
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+void ShaderCompiler::releaseResult(Result& result) {
+    if (result.program) {
+        glDeleteProgram(result.program);
+        result.program = 0;
+    }
+    if (m_finishedFence) {
+        glDeleteSync(static_cast<GLsync>(m_finishedFence));
+        m_finishedFence = nullptr;
+    }
+}
@@ -0,0 +1,127 @@
+#include "shader_variants.h"
+#include "shader_compiler.h"
+#include "hash_util.h"
+#include "gl_platform.h"
+#include <algorithm>
+#include <iostream>
+
+ShaderVariantManager::ShaderVariantManager() : m_compiler(std::make_unique<ShaderCompiler>()) {}
+
+ShaderVariantManager::~ShaderVariantManager() {
+    shutdown();
+}
+
+void ShaderVariantManager::init(GLFWwindow* mainWindow) {
+    m_compiler->init(mainWindow);
+    m_initialized = true;
+}
+
+void ShaderVariantManager::shutdown() {
+    if (!m_initialized) return;
+    m_compiler->shutdown();
+    for (auto& program : m_programs) {
+        if (program.program) glDeleteProgram(program.program);
+    }
+    m_programs.clear();
+    m_queue.clear();
+    m_building = false;
+    m_initialized = false;
+}
+
+void ShaderVariantManager::setProgramCache(ProgramCache* cache) {
+    m_compiler->setProgramCache(cache);
+}
+
+void ShaderVariantManager::build(const ShaderGraph::GraphDesc& graph,
+                                 const std::vector<std::vector<std::string>>& keywordSets, bool useUniformBlock) {
+    ShaderGraph::MaterialOptions options;
+    options.hlsl = false;
+    options.useUniformBlock = useUniformBlock;
+    ShaderGraph::generateVariants(graph, options, keywordSets, m_variants);
+    m_vertexSource = ShaderGraph::buildVertexShader(useUniformBlock);
+
+    // Keep the programs of sources that didn't change
+    std::unordered_map<uint64_t, Program> previous;
+    for (auto& program : m_programs) previous.emplace(program.hash, std::move(program));
+    m_programs.clear();
+    m_programs.resize(m_variants.sources.size());
+    m_queue.clear();
+
+    for (size_t i = 0; i < m_programs.size(); ++i) {
+        Fnv1a64 hash;
+        hash.update(m_vertexSource);
+        hash.update(m_variants.sources[i].glsl);
+        auto it = previous.find(hash.value());
+        if (it != previous.end()) {
+            m_programs[i] = std::move(it->second);
+            previous.erase(it);
+            if (m_programs[i].state == State::Queued) m_queue.push_back(i);
+            continue;
+        }
+        Program& program = m_programs[i];
+        program.hash = hash.value();
+        program.fragmentSource = std::move(m_variants.sources[i].glsl);
+        m_queue.push_back(i);
+    }
+    for (auto& stale : previous) {
+        if (stale.second.program) glDeleteProgram(stale.second.program);
+    }
+
+    m_byName.clear();
+    for (size_t i = 0; i < m_variants.variants.size(); ++i) m_byName.emplace(m_variants.variants[i].name, i);
+    updateStats();
+}
+
+void ShaderVariantManager::update() {
+    if (!m_initialized) return;
+
+    ShaderCompiler::Result result;
+    while (m_compiler->poll(result)) {
+        auto it = std::find_if(m_programs.begin(), m_programs.end(),
+                               [&](const Program& p) { return p.hash == m_buildingHash; });
+        if (!m_building || result.ticket != m_ticket || it == m_programs.end() || it->state != State::Building) {
+            // Source dropped by a rebuild while it was compiling
+            if (result.program) glDeleteProgram(result.program);
+        } else {
+            it->program = result.success ? result.program : 0;
+            it->state = result.success ? State::Ready : State::Failed;
+            it->fromCache = result.fromCache;
+            it->errorLog = std::move(result.errorLog);
+            if (!result.success) std::cerr << "Shader variant failed to build:\n" << it->errorLog << std::endl;
+        }
+        if (result.ticket == m_ticket) m_building = false;
+        updateStats();
+    }
+
+    // The compiler coalesces queued requests, so hand it one source at a time
+    if (m_building || m_queue.empty()) return;
+    Program& next = m_programs[m_queue.front()];
+    m_queue.pop_front();
+    next.state = State::Building;
+    m_buildingHash = next.hash;
+    m_ticket = m_compiler->submit(m_vertexSource, next.fragmentSource);
+    m_building = true;
+    updateStats();
+}
+
+unsigned int ShaderVariantManager::getProgram(std::vector<std::string> keywords) const {
+    std::sort(keywords.begin(), keywords.end());
+    auto it = m_byName.find(ShaderGraph::variantName(keywords));
+    if (it == m_byName.end()) return 0;
+    return m_programs[m_variants.variants[it->second].source].program;
+}
+
+void ShaderVariantManager::updateStats() {
+    m_stats = Stats();
+    m_stats.variants = m_variants.variants.size();
+    m_stats.programs = m_programs.size();
+    for (const auto& program : m_programs) {
+        switch (program.state) {
+            case State::Ready: m_stats.ready++; break;
+            case State::Failed: m_stats.failed++; break;
+            case State::Queued:
+            case State::Building: m_stats.pending++; break;
+        }
+        if (program.fromCache) m_stats.fromCache++;
+    }
+}
@@ -0,0 +1,459 @@
+#include "subgraph_bake.h"
+#include "hash_util.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace ShaderGraph {
+
+namespace {
+
+bool isTexCoord(const IRModule& module, const IRInstr& instr) {
+    return instr.op == IROp::Input && module.str(instr.aux) == "TexCoord";
+}
+
+// Instructions the value at root needs (operands always precede their users)
+std::vector<uint8_t> coneOf(const IRModule& module, IRValue root) {
+    std::vector<uint8_t> cone(static_cast<size_t>(root) + 1, 0);
+    cone[root] = 1;
+    for (size_t i = cone.size(); i-- > 0;) {
+        if (!cone[i]) continue;
+        for (IRValue operand : module.instrs[i].operands) {
+            if (operand != IRNone) cone[operand] = 1;
+        }
+    }
+    return cone;
+}
+
+// Hash of the subgraph independent of where it sits in the module
+uint64_t structureKey(const IRModule& module, const std::vector<uint8_t>& cone, uint32_t size, BakeFormat format,
+                      bool mipmaps) {
+    Fnv1a64 hash;
+    std::vector<int32_t> local(cone.size(), -1);
+    int32_t next = 0;
+    for (size_t i = 0; i < cone.size(); ++i) {
+        if (!cone[i]) continue;
+        const IRInstr& instr = module.instrs[i];
+        local[i] = next++;
+        const uint8_t header[2] = {static_cast<uint8_t>(instr.op), static_cast<uint8_t>(instr.type)};
+        hash.update(header, sizeof(header));
+        for (IRValue operand : instr.operands) {
+            const int32_t index = operand == IRNone ? -1 : local[operand];
+            hash.update(&index, sizeof(index));
+        }
+        if (instr.op == IROp::Const) hash.update(instr.constant, sizeof(instr.constant));
+        else if (instr.op == IROp::Input || instr.op == IROp::Swizzle) hash.update(module.str(instr.aux));
+    }
+    const uint8_t settings[2] = {static_cast<uint8_t>(format), static_cast<uint8_t>(mipmaps)};
+    hash.update(&size, sizeof(size));
+    hash.update(settings, sizeof(settings));
+    return hash.value();
+}
+
+IRValue append(IRModule& module, const IRInstr& instr, int32_t origin, int32_t nodeId) {
+    module.instrs.push_back(instr);
+    module.origins.push_back(origin);
+    module.nodeIds.push_back(nodeId);
+    return static_cast<IRValue>(module.instrs.size() - 1);
+}
+
+uint32_t internString(IRModule& module, const std::string& text) {
+    auto it = std::find(module.strings.begin(), module.strings.end(), text);
+    if (it != module.strings.end()) return static_cast<uint32_t>(it - module.strings.begin());
+    module.strings.push_back(text);
+    return static_cast<uint32_t>(module.strings.size() - 1);
+}
+
+} // namespace
+
+std::vector<SubgraphBakeSettings> subgraphBakeSettings(const GraphDesc& graph) {
+    std::vector<SubgraphBakeSettings> settings(graph.nodes.size());
+    for (size_t i = 0; i < graph.nodes.size(); ++i) {
+        settings[i].format = graph.nodes[i].bakeFormat;
+        settings[i].size = graph.nodes[i].bakeSize;
+    }
+    return settings;
+}
+
+void findSubgraphBakes(const IRModule& module, const SubgraphBakeOptions& options,
+                       const std::vector<SubgraphBakeSettings>* settings, std::vector<SubgraphBake>& bakes) {
+    bakes.clear();
+    const size_t count = module.instrs.size();
+    if (count == 0) return;
+
+    // UV-only values, and those of them that actually vary with TexCoord
+    std::vector<uint8_t> uvOnly(count, 0);
+    std::vector<uint8_t> readsUV(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        const IRInstr& instr = module.instrs[i];
+        if (instr.op == IROp::Const) {
+            uvOnly[i] = 1;
+            continue;
+        }
+        if (instr.op == IROp::Input || instr.op == IROp::Uniform || instr.op == IROp::Texture) {
+            uvOnly[i] = readsUV[i] = isTexCoord(module, instr) ? 1 : 0;
+            continue;
+        }
+        uvOnly[i] = 1;
+        for (IRValue operand : instr.operands) {
+            if (operand == IRNone) continue;
+            uvOnly[i] = uvOnly[i] && uvOnly[operand];
+            readsUV[i] = readsUV[i] || readsUV[operand];
+        }
+    }
+
+    // Roots: UV-only values with a live user that isn't, or read by the output
+    std::vector<bool> live;
+    markLive(module, live);
+    std::vector<uint8_t> root(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (!live[i] || uvOnly[i]) continue;
+        for (IRValue operand : module.instrs[i].operands) {
+            if (operand != IRNone && uvOnly[operand]) root[operand] = 1;
+        }
+    }
+    for (IRValue output : {module.color, module.alpha}) {
+        if (output != IRNone && uvOnly[output]) root[output] = 1;
+    }
+
+    // Bake what a swizzle selects from, once per base
+    std::vector<uint8_t> candidate(count, 0);
+    for (size_t i = 0; i < count; ++i) {
+        if (!root[i]) continue;
+        IRValue value = static_cast<IRValue>(i);
+        while (module.at(value).op == IROp::Swizzle) value = module.at(value).operands[0];
+        candidate[value] = 1;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        if (!candidate[i]) continue;
+        const IRValue value = static_cast<IRValue>(i);
+        if (!readsUV[value] || isTexCoord(module, module.at(value))) continue;
+
+        SubgraphBake bake;
+        bake.root = value;
+        bake.origin = static_cast<size_t>(value) < module.origins.size() ? module.origins[value] : -1;
+        bake.components = componentCount(module.at(value).type);
+        bake.size = options.size;
+        bake.format = options.format == BakeFormat::Default ? BakeFormat::UNorm8 : options.format;
+        if (settings && bake.origin >= 0 && static_cast<size_t>(bake.origin) < settings->size()) {
+            const SubgraphBakeSettings& node = (*settings)[bake.origin];
+            if (node.format != BakeFormat::Default) bake.format = node.format;
+            if (node.size != 0) bake.size = node.size;
+        }
+        if (bake.format == BakeFormat::Off || bake.components == 0) continue;
+
+        const std::vector<uint8_t> cone = coneOf(module, value);
+        for (size_t j = 0; j < cone.size(); ++j) {
+            if (cone[j]) bake.cost.add(instructionCost(module, module.instrs[j]));
+        }
+        const float score = costScore(bake.cost);
+        if (score <= 0.0f || score < options.minCost) continue;
+
+        bake.key = structureKey(module, cone, bake.size, bake.format, options.mipmaps);
+        char name[32];
+        std::snprintf(name, sizeof(name), "u_bake_%016llx", static_cast<unsigned long long>(bake.key));
+        bake.sampler = name;
+        bake.path = options.pathPrefix + bake.sampler + ".dds";
+        bakes.push_back(std::move(bake));
+    }
+}
+
+bool renderSubgraphBake(const IRModule& module, const SubgraphBakeOptions& options, SubgraphBake& bake,
+                        std::string& error) {
+    if (bake.root == IRNone || static_cast<size_t>(bake.root) >= module.instrs.size()) {
+        error = "bake root is out of range";
+        return false;
+    }
+
+    // The same instructions with the root as the output: vec4 splits into color and
+    // alpha, vec2 fills red and green and a float all three color channels
+    IRModule source = module;
+    IRBuilder ir(source);
+    const IRValue value = bake.root;
+    IRValue color = IRNone;
+    IRValue alpha = ir.constant(1.0f);
+    switch (bake.components) {
+        case 1: color = ir.makeVec3(value, value, value); break;
+        case 2: color = ir.makeVec3(ir.swizzle(value, "x"), ir.swizzle(value, "y"), ir.constant(0.0f)); break;
+        case 3: color = value; break;
+        default:
+            color = ir.swizzle(value, "xyz");
+            alpha = ir.swizzle(value, "w");
+            break;
+    }
+    ir.setOutput(color, alpha);
+
+    BakeOptions bakeOptions;
+    bakeOptions.width = bake.size;
+    bakeOptions.height = bake.size;
+    bakeOptions.mipmaps = options.mipmaps;
+    bakeOptions.threads = options.threads;
+    bakeOptions.format = bake.format == BakeFormat::Half ? TextureFormat::RGBA16F : TextureFormat::RGBA8;
+    bakeOptions.fitRange = bake.format != BakeFormat::Half;
+    return bakeModule(source, {}, bakeOptions, bake.image, error, &bake.range);
+}
+
+size_t applySubgraphBakes(IRModule& module, std::vector<SubgraphBake>& bakes, std::vector<UniformParameter>& parameters) {
+    // Highest units first, so the graph's own textures keep the low ones
+    bool used[16] = {};
+    for (const UniformParameter& param : parameters) {
+        if (param.type == ShaderDataType::Sampler2D && param.textureUnit >= 0 && param.textureUnit < 16) {
+            used[param.textureUnit] = true;
+        }
+    }
+    std::vector<int> bakeAt(module.instrs.size(), -1);
+    int unit = 15;
+    for (size_t b = 0; b < bakes.size(); ++b) {
+        SubgraphBake& bake = bakes[b];
+        bake.textureUnit = -1;
+        if (bake.root == IRNone || static_cast<size_t>(bake.root) >= module.instrs.size()) continue;
+        // A subgraph baked twice (same structure and settings) shares one texture
+        bool shared = false;
+        for (size_t other = 0; other < b && !shared; ++other) {
+            if (bakes[other].textureUnit >= 0 && bakes[other].sampler == bake.sampler) {
+                bake.textureUnit = bakes[other].textureUnit;
+                shared = true;
+            }
+        }
+        if (!shared) {
+            while (unit >= 0 && used[unit]) --unit;
+            if (unit < 0) continue;
+            bake.textureUnit = unit;
+            used[unit] = true;
+            parameters.push_back(UniformParameter::Sampler2D(bake.sampler, "Baked subgraph", unit, bake.path));
+        }
+        bakeAt[bake.root] = static_cast<int>(b);
+    }
+
+    IRValue texCoord = IRNone;
+    for (size_t i = 0; i < module.instrs.size() && texCoord == IRNone; ++i) {
+        if (isTexCoord(module, module.instrs[i])) texCoord = static_cast<IRValue>(i);
+    }
+
+    // Rebuild in order with the roots replaced; what only they used is left dead
+    IRModule rebuilt;
+    rebuilt.strings = module.strings;
+    rebuilt.instrs.reserve(module.instrs.size());
+    rebuilt.origins.reserve(module.instrs.size());
+    rebuilt.nodeIds.reserve(module.instrs.size());
+    std::vector<IRValue> remap(module.instrs.size(), IRNone);
+    size_t applied = 0;
+    for (size_t i = 0; i < module.instrs.size(); ++i) {
+        const int32_t origin = i < module.origins.size() ? module.origins[i] : -1;
+        const int32_t nodeId = i < module.nodeIds.size() ? module.nodeIds[i] : -1;
+        IRInstr instr = module.instrs[i];
+        for (IRValue& operand : instr.operands) {
+            if (operand != IRNone) operand = remap[operand];
+        }
+        // Every baked root reads TexCoord, which therefore comes first
+        if (bakeAt[i] < 0 || texCoord == IRNone || remap[texCoord] == IRNone) {
+            remap[i] = append(rebuilt, instr, origin, nodeId);
+            continue;
+        }
+        const SubgraphBake& bake = bakes[bakeAt[i]];
+        auto derived = [&](IROp op, ShaderDataType type) {
+            IRInstr out;
+            out.op = op;
+            out.type = type;
+            out.precision = instr.precision;
+            return out;
+        };
+
+        IRInstr fetch = derived(IROp::Texture, ShaderDataType::Vec4);
+        fetch.operands[0] = remap[texCoord];
+        fetch.aux = internString(rebuilt, bake.sampler);
+        IRValue value = append(rebuilt, fetch, origin, nodeId);
+
+        const int components = std::max(1, std::min(bake.components, 4));
+        if (components < 4) {
+            static const char* masks[] = {"", "x", "xy", "xyz"};
+            IRInstr swizzle = derived(IROp::Swizzle, vectorType(components));
+            swizzle.operands[0] = value;
+            swizzle.aux = internString(rebuilt, masks[components]);
+            value = append(rebuilt, swizzle, origin, nodeId);
+        }
+        // Undo the range fit on the channels the root uses
+        bool identity = true;
+        for (int c = 0; c < components; ++c) identity = identity && bake.range.scale[c] == 1.0f && bake.range.bias[c] == 0.0f;
+        if (!identity) {
+            const ShaderDataType type = vectorType(components);
+            IRInstr scale = derived(IROp::Const, type);
+            IRInstr bias = derived(IROp::Const, type);
+            std::memcpy(scale.constant, bake.range.scale, sizeof(scale.constant));
+            std::memcpy(bias.constant, bake.range.bias, sizeof(bias.constant));
+            IRInstr mul = derived(IROp::Mul, type);
+            mul.operands[0] = value;
+            mul.operands[1] = append(rebuilt, scale, origin, nodeId);
+            value = append(rebuilt, mul, origin, nodeId);
+            IRInstr add = derived(IROp::Add, type);
+            add.operands[0] = value;
+            add.operands[1] = append(rebuilt, bias, origin, nodeId);
+            value = append(rebuilt, add, origin, nodeId);
+        }
+        remap[i] = value;
+        ++applied;
+    }
+    rebuilt.color = module.color == IRNone ? IRNone : remap[module.color];
+    rebuilt.alpha = module.alpha == IRNone ? IRNone : remap[module.alpha];
+    module = std::move(rebuilt);
+    return applied;
+}
+
+bool writeSubgraphBake(const SubgraphBake& bake, const std::string& path, std::string& error) {
+    std::vector<uint8_t> file;
+    if (!encodeDDS(bake.image, file, error)) return false;
+    const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    if (!directory.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec) {
+            error = "cannot create " + directory.string() + ": " + ec.message();
+            return false;
+        }
+    }
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+    if (!out) {
+        error = "cannot write " + path;
+        return false;
+    }
+    return true;
+}
+
+SubgraphBakeCache::SubgraphBakeCache(size_t capacity) : m_capacity(std::max<size_t>(capacity, 1)) {}
+
+SubgraphBakeCache::~SubgraphBakeCache() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+        m_jobs.clear();
+    }
+    m_cv.notify_all();
+    if (m_worker.joinable()) m_worker.join();
+}
+
+SubgraphBakeCache::Status SubgraphBakeCache::request(const IRModule& module, const SubgraphBakeOptions& options,
+                                                     SubgraphBake& bake, std::string& error) {
+    if (m_pending.count(bake.key)) return Status::Pending;
+    auto found = m_entries.find(bake.key);
+    if (found != m_entries.end()) {
+        Entry& entry = found->second;
+        entry.lastUse = m_tick;
+        if (entry.failed) {
+            error = entry.error;
+            return Status::Failed;
+        }
+        // The directory may have been cleared behind our back; render it again
+        std::error_code ec;
+        if (entry.path == bake.path && std::filesystem::exists(bake.path, ec)) {
+            bake.range = entry.range;
+            return Status::Ready;
+        }
+        m_entries.erase(found);
+    }
+
+    Job job;
+    job.module = module;
+    job.options = options;
+    job.bake = bake;
+    m_pending.insert(bake.key);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back(std::move(job));
+    }
+    if (!m_worker.joinable()) m_worker = std::thread(&SubgraphBakeCache::workerLoop, this);
+    m_cv.notify_one();
+    return Status::Pending;
+}
+
+void SubgraphBakeCache::keep(uint64_t key) {
+    auto found = m_entries.find(key);
+    if (found != m_entries.end()) found->second.lastUse = m_tick;
+}
+
+void SubgraphBakeCache::update() {
+    ++m_tick;
+    std::vector<Done> done;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        done.swap(m_done);
+    }
+    for (Done& result : done) {
+        m_pending.erase(result.key);
+        Entry& entry = m_entries[result.key];
+        entry.failed = !result.success;
+        entry.range = result.range;
+        entry.path = std::move(result.path);
+        entry.error = std::move(result.error);
+        entry.lastUse = m_tick;
+        if (result.success) m_renders++;
+    }
+    if (!done.empty()) m_revision++;
+    evict();
+}
+
+// Least recently used first; bakes requested or kept since the last update are in use and stay
+void SubgraphBakeCache::evict() {
+    if (m_entries.size() <= m_capacity) return;
+    std::vector<std::pair<uint64_t, uint64_t>> byUse;   // lastUse, key
+    byUse.reserve(m_entries.size());
+    for (const auto& entry : m_entries) byUse.emplace_back(entry.second.lastUse, entry.first);
+    std::sort(byUse.begin(), byUse.end());
+    size_t excess = m_entries.size() - m_capacity;
+    for (size_t i = 0; i < byUse.size() && excess > 0; ++i) {
+        if (byUse[i].first + 1 >= m_tick) break;
+        auto found = m_entries.find(byUse[i].second);
+        if (!found->second.failed) {
+            std::error_code ec;
+            std::filesystem::remove(found->second.path, ec);
+        }
+        m_entries.erase(found);
+        --excess;
+    }
+}
+
+bool SubgraphBakeCache::removeStaleFiles(const std::string& directory, std::string& error) {
+    std::error_code ec;
+    if (!std::filesystem::exists(directory, ec)) return true;
+    std::filesystem::directory_iterator it(directory, ec);
+    for (; !ec && it != std::filesystem::directory_iterator(); it.increment(ec)) {
+        const std::string name = it->path().filename().string();
+        if (name.compare(0, 7, "u_bake_") != 0 || it->path().extension() != ".dds") continue;
+        std::error_code removeError;
+        if (!std::filesystem::remove(it->path(), removeError) && removeError) {
+            error = "cannot remove " + it->path().string() + ": " + removeError.message();
+            return false;
+        }
+    }
+    if (ec) {
+        error = "cannot list " + directory + ": " + ec.message();
+        return false;
+    }
+    return true;
+}
+
+void SubgraphBakeCache::workerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this] { return m_quit || !m_jobs.empty(); });
+            if (m_quit) return;
+            job = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+        Done result;
+        result.key = job.bake.key;
+        result.path = job.bake.path;
+        result.success = renderSubgraphBake(job.module, job.options, job.bake, result.error) &&
+                         writeSubgraphBake(job.bake, job.bake.path, result.error);
+        result.range = job.bake.range;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done.push_back(std::move(result));
+    }
+}
+
+} // namespace ShaderGraph
@@ -0,0 +1,563 @@
+#include "texture_image.h"
+#include <algorithm>
+#include <cstring>
+
+namespace ShaderGraph {
+
+namespace {
+
+constexpr uint32_t MaxDimension = 16384;
+
+const TextureFormatInfo formatInfos[] = {
+    {"RGBA8", 1, 1, 4, false},
+    {"BC1", 4, 4, 8, true},
+    {"BC2", 4, 4, 16, true},
+    {"BC3", 4, 4, 16, true},
+    {"BC4", 4, 4, 8, true},
+    {"BC5", 4, 4, 16, true},
+    {"BC7", 4, 4, 16, true},
+    {"ASTC 4x4", 4, 4, 16, true},
+    {"ASTC 5x5", 5, 5, 16, true},
+    {"ASTC 6x6", 6, 6, 16, true},
+    {"ASTC 8x8", 8, 8, 16, true},
+    {"RGBA16F", 1, 1, 8, false},
+};
+static_assert(sizeof(formatInfos) / sizeof(formatInfos[0]) == size_t(TextureFormat::RGBA16F) + 1,
+              "formatInfos is indexed by TextureFormat");
+
+// Files are little-endian, like every platform the editor runs on
+uint16_t read16(const uint8_t* p) {
+    uint16_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint32_t read32(const uint8_t* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+uint64_t read64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+constexpr uint32_t fourCC(const char (&s)[5]) {
+    return uint32_t(uint8_t(s[0])) | uint32_t(uint8_t(s[1])) << 8 | uint32_t(uint8_t(s[2])) << 16 |
+           uint32_t(uint8_t(s[3])) << 24;
+}
+
+bool validSize(uint32_t width, uint32_t height, std::string& error) {
+    if (width == 0 || height == 0 || width > MaxDimension || height > MaxDimension) {
+        error = "unsupported image size " + std::to_string(width) + "x" + std::to_string(height);
+        return false;
+    }
+    return true;
+}
+
+// Expand pixels described by channel masks (R, G, B, A) to RGBA8
+void convertMasked(const uint8_t* src, size_t pixelCount, uint32_t bytesPerPixel, const uint32_t masks[4],
+                   uint8_t* dst) {
+    uint32_t shift[4], bits[4];
+    for (int c = 0; c < 4; ++c) {
+        shift[c] = 0;
+        bits[c] = 0;
+        uint32_t m = masks[c];
+        if (!m) continue;
+        while (!(m & 1)) {
+            m >>= 1;
+            shift[c]++;
+        }
+        while (m & 1) {
+            m >>= 1;
+            bits[c]++;
+        }
+    }
+    for (size_t i = 0; i < pixelCount; ++i) {
+        uint32_t pixel = 0;
+        std::memcpy(&pixel, src + i * bytesPerPixel, bytesPerPixel);
+        for (int c = 0; c < 4; ++c) {
+            if (!bits[c]) {
+                dst[i * 4 + c] = c == 3 ? 255 : 0;
+                continue;
+            }
+            // 64-bit, since channels may be up to 32 bits wide
+            const uint64_t maxValue = (uint64_t(1) << bits[c]) - 1;
+            const uint64_t value = (pixel >> shift[c]) & maxValue;
+            dst[i * 4 + c] = static_cast<uint8_t>((value * 255 + maxValue / 2) / maxValue);
+        }
+    }
+}
+
+const uint32_t bgraMasks[4] = {0x00FF0000u, 0x0000FF00u, 0x000000FFu, 0xFF000000u};
+
+// ----------------------------------------------------------------------------
+// DDS
+// ----------------------------------------------------------------------------
+
+constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+constexpr uint32_t DDPF_ALPHAPIXELS = 0x1;
+constexpr uint32_t DDPF_FOURCC = 0x4;
+constexpr uint32_t DDPF_RGB = 0x40;
+
+bool formatFromDXGI(uint32_t dxgi, TextureFormat& format, bool& bgra) {
+    bgra = false;
+    switch (dxgi) {
+        case 27: case 28: case 29: format = TextureFormat::RGBA8; return true;
+        case 87: case 90: case 91: format = TextureFormat::RGBA8; bgra = true; return true;
+        case 10: format = TextureFormat::RGBA16F; return true;
+        case 70: case 71: case 72: format = TextureFormat::BC1; return true;
+        case 73: case 74: case 75: format = TextureFormat::BC2; return true;
+        case 76: case 77: case 78: format = TextureFormat::BC3; return true;
+        case 79: case 80: format = TextureFormat::BC4; return true;
+        case 82: case 83: format = TextureFormat::BC5; return true;
+        case 97: case 98: case 99: format = TextureFormat::BC7; return true;
+        default: return false;
+    }
+}
+
+bool decodeDDS(const uint8_t* data, size_t size, TextureImage& image, std::string& error) {
+    if (size < 128) {
+        error = "truncated DDS header";
+        return false;
+    }
+    const uint8_t* header = data + 4;
+    const uint32_t flags = read32(header + 4);
+    const uint32_t height = read32(header + 8);
+    const uint32_t width = read32(header + 12);
+    const uint32_t pfFlags = read32(header + 76);
+    const uint32_t bitCount = read32(header + 84);
+    if (!validSize(width, height, error)) return false;
+
+    size_t offset = 128;
+    TextureFormat format = TextureFormat::RGBA8;
+    uint32_t masks[4] = {read32(header + 88), read32(header + 92), read32(header + 96),
+                         (pfFlags & DDPF_ALPHAPIXELS) ? read32(header + 100) : 0u};
+    uint32_t bytesPerPixel = 4;
+    bool convert = false;
+
+    if (pfFlags & DDPF_FOURCC) {
+        const uint32_t code = read32(header + 80);
+        if (code == fourCC("DX10")) {
+            if (size < 148) {
+                error = "truncated DDS DX10 header";
+                return false;
+            }
+            bool bgra = false;
+            if (!formatFromDXGI(read32(data + 128), format, bgra)) {
+                error = "unsupported DXGI format " + std::to_string(read32(data + 128));
+                return false;
+            }
+            if (bgra) {
+                std::memcpy(masks, bgraMasks, sizeof(masks));
+                convert = true;
+            }
+            offset = 148;
+        } else if (code == fourCC("DXT1")) {
+            format = TextureFormat::BC1;
+        } else if (code == fourCC("DXT2") || code == fourCC("DXT3")) {
+            format = TextureFormat::BC2;
+        } else if (code == fourCC("DXT4") || code == fourCC("DXT5")) {
+            format = TextureFormat::BC3;
+        } else if (code == fourCC("ATI1") || code == fourCC("BC4U")) {
+            format = TextureFormat::BC4;
+        } else if (code == fourCC("ATI2") || code == fourCC("BC5U")) {
+            format = TextureFormat::BC5;
+        } else {
+            error = "unsupported DDS FourCC";
+            return false;
+        }
+    } else if ((pfFlags & DDPF_RGB) && (bitCount == 24 || bitCount == 32)) {
+        bytesPerPixel = bitCount / 8;
+        convert = true;
+    } else {
+        error = "unsupported DDS pixel format";
+        return false;
+    }
+
+    uint32_t mipCount = (flags & DDSD_MIPMAPCOUNT) ? read32(header + 24) : 1;
+    mipCount = std::max(1u, std::min(mipCount, textureMipCount(width, height)));
+    layoutTextureLevels(image, format, width, height, mipCount);
+
+    // Only the first surface of arrays and cube maps is read
+    for (const TextureLevel& level : image.levels) {
+        const size_t pixelCount = size_t(level.width) * level.height;
+        const size_t sourceSize = convert ? pixelCount * bytesPerPixel : level.size;
+        if (offset > size || sourceSize > size - offset) {
+            error = "truncated DDS data";
+            return false;
+        }
+        uint8_t* dst = image.pixels.data() + level.offset;
+        if (convert) convertMasked(data + offset, pixelCount, bytesPerPixel, masks, dst);
+        else std::memcpy(dst, data + offset, level.size);
+        offset += sourceSize;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// KTX2
+// ----------------------------------------------------------------------------
+
+const uint8_t ktx2Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+bool formatFromVk(uint32_t vkFormat, TextureFormat& format, bool& bgra) {
+    bgra = false;
+    switch (vkFormat) {
+        case 37: case 43: format = TextureFormat::RGBA8; return true;
+        case 44: case 50: format = TextureFormat::RGBA8; bgra = true; return true;
+        case 97: format = TextureFormat::RGBA16F; return true;
+        case 131: case 132: case 133: case 134: format = TextureFormat::BC1; return true;
+        case 135: case 136: format = TextureFormat::BC2; return true;
+        case 137: case 138: format = TextureFormat::BC3; return true;
+        case 139: format = TextureFormat::BC4; return true;
+        case 141: format = TextureFormat::BC5; return true;
+        case 145: case 146: format = TextureFormat::BC7; return true;
+        case 157: case 158: format = TextureFormat::ASTC4x4; return true;
+        case 161: case 162: format = TextureFormat::ASTC5x5; return true;
+        case 165: case 166: format = TextureFormat::ASTC6x6; return true;
+        case 171: case 172: format = TextureFormat::ASTC8x8; return true;
+        default: return false;
+    }
+}
+
+bool decodeKTX2(const uint8_t* data, size_t size, TextureImage& image, std::string& error) {
+    if (size < 80) {
+        error = "truncated KTX2 header";
+        return false;
+    }
+    const uint32_t vkFormat = read32(data + 12);
+    const uint32_t width = read32(data + 20);
+    const uint32_t height = read32(data + 24);
+    const uint32_t depth = read32(data + 28);
+    const uint32_t levelCount = read32(data + 40);
+    const uint32_t supercompression = read32(data + 44);
+    if (!validSize(width, height, error)) return false;
+    if (depth > 1) {
+        error = "3D KTX2 textures are not supported";
+        return false;
+    }
+    if (supercompression != 0) {
+        error = "supercompressed KTX2 (BasisLZ/Zstandard) is not supported; store the blocks uncompressed";
+        return false;
+    }
+    TextureFormat format;
+    bool bgra = false;
+    if (!formatFromVk(vkFormat, format, bgra)) {
+        error = "unsupported KTX2 vkFormat " + std::to_string(vkFormat);
+        return false;
+    }
+
+    // levelCount 0 asks the loader to build the chain (see generateMipmaps)
+    const uint32_t count = std::max(1u, std::min(levelCount, textureMipCount(width, height)));
+    if (size < 80 + size_t(count) * 24) {
+        error = "truncated KTX2 level index";
+        return false;
+    }
+    layoutTextureLevels(image, format, width, height, count);
+
+    // Only the first layer and face of each level is read
+    for (uint32_t i = 0; i < count; ++i) {
+        const TextureLevel& level = image.levels[i];
+        const uint64_t byteOffset = read64(data + 80 + i * 24);
+        const uint64_t byteLength = read64(data + 80 + i * 24 + 8);
+        if (byteLength < level.size || byteOffset > size || level.size > size - byteOffset) {
+            error = "truncated KTX2 level " + std::to_string(i);
+            return false;
+        }
+        uint8_t* dst = image.pixels.data() + level.offset;
+        if (bgra) convertMasked(data + byteOffset, size_t(level.width) * level.height, 4, bgraMasks, dst);
+        else std::memcpy(dst, data + byteOffset, level.size);
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// TGA
+// ----------------------------------------------------------------------------
+
+bool decodeTGA(const uint8_t* data, size_t size, TextureImage& image, std::string& error) {
+    if (size < 18) {
+        error = "not a supported image file";
+        return false;
+    }
+    const uint8_t idLength = data[0];
+    const uint8_t colorMapType = data[1];
+    const uint8_t imageType = data[2];
+    const uint32_t width = read16(data + 12);
+    const uint32_t height = read16(data + 14);
+    const uint32_t bytesPerPixel = data[16] / 8;
+    const bool topDown = (data[17] & 0x20) != 0;
+
+    const bool greyscale = imageType == 3 || imageType == 11;
+    const bool rle = imageType == 10 || imageType == 11;
+    if (colorMapType != 0 || (imageType != 2 && imageType != 3 && imageType != 10 && imageType != 11) ||
+        (greyscale ? bytesPerPixel != 1 : (bytesPerPixel != 3 && bytesPerPixel != 4))) {
+        error = "not a supported image file (TGA must be truecolor or greyscale, 8/24/32-bit)";
+        return false;
+    }
+    if (!validSize(width, height, error)) return false;
+
+    layoutTextureLevels(image, TextureFormat::RGBA8, width, height, 1);
+    uint8_t* dst = image.pixels.data();
+    const size_t pixelCount = size_t(width) * height;
+    size_t pos = 18 + size_t(idLength);
+
+    auto store = [&](size_t index, const uint8_t* px) {
+        // File rows start at the bottom unless the descriptor says otherwise
+        size_t x = index % width, y = index / width;
+        if (!topDown) y = height - 1 - y;
+        uint8_t* out = dst + (y * width + x) * 4;
+        if (bytesPerPixel == 1) {
+            out[0] = out[1] = out[2] = px[0];
+            out[3] = 255;
+        } else {
+            out[0] = px[2];
+            out[1] = px[1];
+            out[2] = px[0];
+            out[3] = bytesPerPixel == 4 ? px[3] : 255;
+        }
+    };
+
+    size_t index = 0;
+    while (index < pixelCount) {
+        size_t run = 1;
+        bool repeat = false;
+        if (rle) {
+            if (pos >= size) break;
+            const uint8_t packet = data[pos++];
+            run = std::min<size_t>((packet & 0x7F) + 1, pixelCount - index);
+            repeat = (packet & 0x80) != 0;
+        } else {
+            run = pixelCount;
+        }
+        const size_t bytes = (repeat ? 1 : run) * bytesPerPixel;
+        if (pos > size || bytes > size - pos) break;
+        for (size_t i = 0; i < run; ++i) store(index + i, data + pos + (repeat ? 0 : i * bytesPerPixel));
+        pos += bytes;
+        index += run;
+    }
+    if (index < pixelCount) {
+        error = "truncated TGA data";
+        return false;
+    }
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// PPM
+// ----------------------------------------------------------------------------
+
+bool decodePPM(const uint8_t* data, size_t size, TextureImage& image, std::string& error) {
+    size_t pos = 2;
+    auto readNumber = [&](uint32_t& value) {
+        // Whitespace and '#' comments may separate the header fields
+        while (pos < size) {
+            if (data[pos] == '#') {
+                while (pos < size && data[pos] != '\n') pos++;
+            } else if (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\r' || data[pos] == '\n') {
+                pos++;
+            } else {
+                break;
+            }
+        }
+        if (pos >= size || data[pos] < '0' || data[pos] > '9') return false;
+        uint64_t v = 0;
+        while (pos < size && data[pos] >= '0' && data[pos] <= '9' && v <= MaxDimension) v = v * 10 + (data[pos++] - '0');
+        value = static_cast<uint32_t>(std::min<uint64_t>(v, UINT32_MAX));
+        return true;
+    };
+
+    uint32_t width = 0, height = 0, maxValue = 0;
+    if (!readNumber(width) || !readNumber(height) || !readNumber(maxValue) || maxValue == 0 || maxValue > 255) {
+        error = "bad PPM header (only 8-bit binary P6 is supported)";
+        return false;
+    }
+    if (!validSize(width, height, error)) return false;
+    pos++;   // Single whitespace before the raster
+
+    const size_t pixelCount = size_t(width) * height;
+    if (pos > size || pixelCount * 3 > size - pos) {
+        error = "truncated PPM data";
+        return false;
+    }
+    layoutTextureLevels(image, TextureFormat::RGBA8, width, height, 1);
+    uint8_t* dst = image.pixels.data();
+    for (size_t i = 0; i < pixelCount; ++i) {
+        for (int c = 0; c < 3; ++c) dst[i * 4 + c] = static_cast<uint8_t>(data[pos + i * 3 + c] * 255u / maxValue);
+        dst[i * 4 + 3] = 255;
+    }
+    return true;
+}
+
+} // namespace
+
+const TextureFormatInfo& textureFormatInfo(TextureFormat format) {
+    return formatInfos[static_cast<size_t>(format)];
+}
+
+size_t textureRowSize(TextureFormat format, uint32_t width) {
+    const TextureFormatInfo& info = textureFormatInfo(format);
+    return size_t((width + info.blockWidth - 1) / info.blockWidth) * info.bytesPerBlock;
+}
+
+size_t textureLevelSize(TextureFormat format, uint32_t width, uint32_t height) {
+    const TextureFormatInfo& info = textureFormatInfo(format);
+    return textureRowSize(format, width) * ((height + info.blockHeight - 1) / info.blockHeight);
+}
+
+uint32_t textureMipCount(uint32_t width, uint32_t height) {
+    uint32_t count = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        count++;
+    }
+    return count;
+}
+
+void layoutTextureLevels(TextureImage& image, TextureFormat format, uint32_t width, uint32_t height, uint32_t count) {
+    image.format = format;
+    image.levels.clear();
+    size_t offset = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        TextureLevel level;
+        level.width = std::max(1u, width >> i);
+        level.height = std::max(1u, height >> i);
+        level.offset = offset;
+        level.size = textureLevelSize(format, level.width, level.height);
+        offset += level.size;
+        image.levels.push_back(level);
+    }
+    image.pixels.assign(offset, 0);
+}
+
+bool decodeTexture(const uint8_t* data, size_t size, TextureImage& image, std::string& error) {
+    image = TextureImage();
+    if (size >= 4 && std::memcmp(data, "DDS ", 4) == 0) return decodeDDS(data, size, image, error);
+    if (size >= 12 && std::memcmp(data, ktx2Identifier, 12) == 0) return decodeKTX2(data, size, image, error);
+    if (size >= 2 && data[0] == 'P' && data[1] == '6') return decodePPM(data, size, image, error);
+    return decodeTGA(data, size, image, error);
+}
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t magnitude = bits & 0x7FFFFFFFu;
+    if (magnitude >= 0x7F800000u) return static_cast<uint16_t>(sign | 0x7C00u | (magnitude > 0x7F800000u ? 0x200u : 0u));
+    if (magnitude >= 0x477FF000u) return static_cast<uint16_t>(sign | 0x7C00u);   // Rounds past 65504
+    if (magnitude < 0x38800000u) {
+        // Subnormal half: shift the mantissa (with its implicit bit) into place, rounding to even
+        if (magnitude < 0x33000000u) return static_cast<uint16_t>(sign);
+        const uint32_t exponent = magnitude >> 23;
+        const uint32_t mantissa = (magnitude & 0x7FFFFFu) | 0x800000u;
+        const uint32_t shift = 126 - exponent;
+        uint32_t half = mantissa >> shift;
+        const uint32_t rest = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (rest > halfway || (rest == halfway && (half & 1))) half++;
+        return static_cast<uint16_t>(sign | half);
+    }
+    uint32_t half = ((magnitude - 0x38000000u) >> 13);
+    const uint32_t rest = magnitude & 0x1FFFu;
+    if (rest > 0x1000u || (rest == 0x1000u && (half & 1))) half++;
+    return static_cast<uint16_t>(sign | half);
+}
+
+float halfToFloat(uint16_t half) {
+    const uint32_t sign = uint32_t(half & 0x8000u) << 16;
+    const uint32_t exponent = (half >> 10) & 0x1Fu;
+    uint32_t mantissa = half & 0x3FFu;
+    uint32_t bits;
+    if (exponent == 0x1F) {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    } else if (exponent != 0) {
+        bits = sign | ((exponent + 112) << 23) | (mantissa << 13);
+    } else if (mantissa == 0) {
+        bits = sign;
+    } else {
+        // Subnormal: normalize into a float exponent
+        uint32_t e = 113;
+        while (!(mantissa & 0x400u)) {
+            mantissa <<= 1;
+            e--;
+        }
+        bits = sign | (e << 23) | ((mantissa & 0x3FFu) << 13);
+    }
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool encodeDDS(const TextureImage& image, std::vector<uint8_t>& file, std::string& error) {
+    const bool half = image.format == TextureFormat::RGBA16F;
+    if ((image.format != TextureFormat::RGBA8 && !half) || image.levels.empty()) {
+        error = "only RGBA8 and RGBA16F images can be written as DDS";
+        return false;
+    }
+    const bool mipmapped = image.levels.size() > 1;
+    uint8_t header[148] = {};
+    auto write32 = [&](size_t offset, uint32_t value) { std::memcpy(header + offset, &value, sizeof(value)); };
+    std::memcpy(header, "DDS ", 4);
+    write32(4, 124);
+    write32(8, 0x1 | 0x2 | 0x4 | 0x8 | 0x1000 | (mipmapped ? DDSD_MIPMAPCOUNT : 0u));  // Caps, size, pitch, format
+    write32(12, image.height());
+    write32(16, image.width());
+    write32(20, static_cast<uint32_t>(textureRowSize(image.format, image.width())));
+    write32(28, static_cast<uint32_t>(image.levels.size()));
+    write32(76, 32);
+    if (half) {
+        // Half floats have no channel mask encoding; DX10 header with DXGI_FORMAT_R16G16B16A16_FLOAT
+        write32(80, DDPF_FOURCC);
+        std::memcpy(header + 84, "DX10", 4);
+        write32(128, 10);
+        write32(132, 3);    // Texture2D
+        write32(140, 1);    // Array size
+    } else {
+        write32(80, DDPF_RGB | DDPF_ALPHAPIXELS);
+        write32(88, 32);
+        write32(92, 0x000000FFu);
+        write32(96, 0x0000FF00u);
+        write32(100, 0x00FF0000u);
+        write32(104, 0xFF000000u);
+    }
+    write32(108, 0x1000 | (mipmapped ? 0x400008u : 0u));  // Texture, plus complex and mipmap
+    file.assign(header, header + (half ? 148 : 128));
+    for (const TextureLevel& level : image.levels) {
+        const uint8_t* data = image.pixels.data() + level.offset;
+        file.insert(file.end(), data, data + level.size);
+    }
+    return true;
+}
+
+void generateMipmaps(TextureImage& image) {
+    if (image.format != TextureFormat::RGBA8 || image.levels.size() != 1) return;
+    const uint32_t width = image.width(), height = image.height();
+    const std::vector<uint8_t> base = std::move(image.pixels);
+    layoutTextureLevels(image, TextureFormat::RGBA8, width, height, textureMipCount(width, height));
+    std::memcpy(image.pixels.data(), base.data(), base.size());
+
+    // 2x2 box filter; odd edges clamp onto the last row or column
+    for (size_t i = 1; i < image.levels.size(); ++i) {
+        const TextureLevel& src = image.levels[i - 1];
+        const TextureLevel& dst = image.levels[i];
+        const uint8_t* in = image.pixels.data() + src.offset;
+        uint8_t* out = image.pixels.data() + dst.offset;
+        for (uint32_t y = 0; y < dst.height; ++y) {
+            const uint32_t y0 = std::min(y * 2, src.height - 1), y1 = std::min(y * 2 + 1, src.height - 1);
+            for (uint32_t x = 0; x < dst.width; ++x) {
+                const uint32_t x0 = std::min(x * 2, src.width - 1), x1 = std::min(x * 2 + 1, src.width - 1);
+                for (int c = 0; c < 4; ++c) {
+                    const uint32_t sum = in[(size_t(y0) * src.width + x0) * 4 + c] + in[(size_t(y0) * src.width + x1) * 4 + c] +
+                                         in[(size_t(y1) * src.width + x0) * 4 + c] + in[(size_t(y1) * src.width + x1) * 4 + c];
+                    out[(size_t(y) * dst.width + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                }
+            }
+        }
+    }
+}
+
+} // namespace ShaderGraph
@@ -0,0 +1,545 @@
+#include "texture_streamer.h"
+#include "hash_util.h"
+#include "gl_platform.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <cstring>
+
+// glBufferStorage (GL 4.4 / GL_ARB_buffer_storage), loaded at runtime like the other post-3.3 entry points
+typedef void (*PFN_BufferStorage)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+// GL_EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT1_EXT 0x83F1
+#define GL_COMPRESSED_RGBA_S3TC_DXT3_EXT 0x83F2
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+// GL_ARB_texture_compression_bptc
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+// GL_KHR_texture_compression_astc_ldr
+#ifndef GL_COMPRESSED_RGBA_ASTC_4x4_KHR
+#define GL_COMPRESSED_RGBA_ASTC_4x4_KHR 0x93B0
+#define GL_COMPRESSED_RGBA_ASTC_5x5_KHR 0x93B2
+#define GL_COMPRESSED_RGBA_ASTC_6x6_KHR 0x93B4
+#define GL_COMPRESSED_RGBA_ASTC_8x8_KHR 0x93B7
+#endif
+
+using ShaderGraph::TextureFormat;
+using ShaderGraph::TextureImage;
+using ShaderGraph::TextureLevel;
+
+namespace {
+
+GLenum internalFormat(TextureFormat format) {
+    switch (format) {
+        case TextureFormat::RGBA8: return GL_RGBA8;
+        case TextureFormat::BC1: return GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+        case TextureFormat::BC2: return GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+        case TextureFormat::BC3: return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+        case TextureFormat::BC4: return GL_COMPRESSED_RED_RGTC1;
+        case TextureFormat::BC5: return GL_COMPRESSED_RG_RGTC2;
+        case TextureFormat::BC7: return GL_COMPRESSED_RGBA_BPTC_UNORM;
+        case TextureFormat::ASTC4x4: return GL_COMPRESSED_RGBA_ASTC_4x4_KHR;
+        case TextureFormat::ASTC5x5: return GL_COMPRESSED_RGBA_ASTC_5x5_KHR;
+        case TextureFormat::ASTC6x6: return GL_COMPRESSED_RGBA_ASTC_6x6_KHR;
+        case TextureFormat::ASTC8x8: return GL_COMPRESSED_RGBA_ASTC_8x8_KHR;
+        case TextureFormat::RGBA16F: return GL_RGBA16F;
+    }
+    return GL_RGBA8;
+}
+
+// Client data type of the uncompressed formats
+GLenum pixelType(TextureFormat format) {
+    return format == TextureFormat::RGBA16F ? GL_HALF_FLOAT : GL_UNSIGNED_BYTE;
+}
+
+size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+const std::string TextureStreamer::s_noError;
+
+TextureStreamer::TextureStreamer(unsigned workerCount, size_t segmentBytes, unsigned segmentCount)
+    : m_workerCount(std::max(1u, workerCount)), m_segmentBytes(segmentBytes), m_segmentCount(std::max(2u, segmentCount)) {}
+
+TextureStreamer::~TextureStreamer() {
+    shutdown();
+}
+
+void TextureStreamer::init() {
+    if (m_initialized) return;
+
+    GLint major = 0, minor = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &major);
+    glGetIntegerv(GL_MINOR_VERSION, &minor);
+    m_s3tc = glfwExtensionSupported("GL_EXT_texture_compression_s3tc") == GLFW_TRUE;
+    m_bptc = major * 10 + minor >= 42 || glfwExtensionSupported("GL_ARB_texture_compression_bptc") == GLFW_TRUE;
+    m_astc = glfwExtensionSupported("GL_KHR_texture_compression_astc_ldr") == GLFW_TRUE;
+
+    const uint8_t grey[4] = {128, 128, 128, 255};
+    glGenTextures(1, &m_placeholder);
+    glBindTexture(GL_TEXTURE_2D, m_placeholder);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, grey);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // Staging ring; persistent and coherent, so copies into it need no map or flush per frame
+    const GLsizeiptr ringBytes = static_cast<GLsizeiptr>(m_segmentBytes * m_segmentCount);
+    auto bufferStorage = glfwExtensionSupported("GL_ARB_buffer_storage") == GLFW_TRUE
+                             ? reinterpret_cast<PFN_BufferStorage>(glfwGetProcAddress("glBufferStorage"))
+                             : nullptr;
+    glGenBuffers(1, &m_buffer);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+    if (bufferStorage) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(GL_PIXEL_UNPACK_BUFFER, ringBytes, nullptr, flags);
+        m_mapped = static_cast<uint8_t*>(glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, ringBytes, flags));
+        if (!m_mapped) {
+            // Immutable storage can't be respecified; start over with a plain buffer
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+            glDeleteBuffers(1, &m_buffer);
+            glGenBuffers(1, &m_buffer);
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+        }
+    }
+    if (!m_mapped) glBufferData(GL_PIXEL_UNPACK_BUFFER, ringBytes, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    m_fences.assign(m_segmentCount, nullptr);
+    m_segment = 0;
+
+    m_quit = false;
+    for (unsigned i = 0; i < m_workerCount; ++i) m_workers.emplace_back(&TextureStreamer::workerLoop, this);
+    m_initialized = true;
+    updateStats();
+}
+
+void TextureStreamer::shutdown() {
+    if (!m_initialized) return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_quit = true;
+    }
+    m_cv.notify_all();
+    for (auto& worker : m_workers) worker.join();
+    m_workers.clear();
+    m_jobs.clear();
+    m_decoded.clear();
+    m_contents.clear();
+
+    for (void* fence : m_fences) {
+        if (fence) glDeleteSync(static_cast<GLsync>(fence));
+    }
+    m_fences.clear();
+    if (m_mapped) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        m_mapped = nullptr;
+    }
+    if (m_buffer) glDeleteBuffers(1, &m_buffer);
+    for (auto& entry : m_textures) {
+        if (entry.second->texture) glDeleteTextures(1, &entry.second->texture);
+    }
+    if (m_placeholder) glDeleteTextures(1, &m_placeholder);
+    m_buffer = m_placeholder = 0;
+
+    m_files.clear();
+    m_references.clear();
+    m_textures.clear();
+    m_uploadQueue.clear();
+    m_pendingFiles = 0;
+    m_initialized = false;
+    updateStats();
+}
+
+unsigned int TextureStreamer::acquire(const std::string& path) {
+    if (!m_initialized || path.empty()) return m_placeholder;
+
+    auto it = m_files.find(path);
+    if (it == m_files.end()) {
+        m_files.emplace(path, File());
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.push_back(path);
+        }
+        m_cv.notify_one();
+        m_pendingFiles++;
+        return m_placeholder;
+    }
+    if (!it->second.loaded) return m_placeholder;
+
+    // Decoding or uploading under another path counts as loading here too
+    auto texture = m_textures.find(it->second.content);
+    if (texture == m_textures.end() || texture->second->state != State::Resident) return m_placeholder;
+    return texture->second->texture;
+}
+
+void TextureStreamer::retain(const std::string& path) {
+    if (!path.empty()) m_references[path]++;
+}
+
+void TextureStreamer::release(const std::string& path) {
+    auto it = m_references.find(path);
+    if (it == m_references.end()) return;
+    if (--it->second > 0) return;
+    m_references.erase(it);
+    drop(path);
+}
+
+void TextureStreamer::drop(const std::string& path) {
+    auto it = m_files.find(path);
+    if (it == m_files.end()) return;
+    const bool loaded = it->second.loaded;
+    const uint64_t content = it->second.content;
+    if (!loaded && it->second.error.empty()) {
+        // Still queued: take the job back. A worker already reading it finds no file in receive().
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto job = std::find(m_jobs.begin(), m_jobs.end(), path);
+        if (job != m_jobs.end()) {
+            m_jobs.erase(job);
+            m_pendingFiles--;
+        }
+    }
+    m_files.erase(it);
+    if (!loaded) return;
+
+    for (const auto& file : m_files) {
+        if (file.second.loaded && file.second.content == content) return;
+    }
+    auto texture = m_textures.find(content);
+    if (texture != m_textures.end()) {
+        m_uploadQueue.erase(std::remove(m_uploadQueue.begin(), m_uploadQueue.end(), texture->second.get()),
+                            m_uploadQueue.end());
+        if (texture->second->texture) glDeleteTextures(1, &texture->second->texture);
+        m_textures.erase(texture);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_contents.erase(content);
+    }
+    m_revision++;
+}
+
+void TextureStreamer::bind(const std::vector<ShaderGraph::UniformParameter>& params, const std::vector<uint8_t>* active) {
+    for (size_t i = 0; i < params.size(); ++i) {
+        const ShaderGraph::UniformParameter& param = params[i];
+        if (param.type != ShaderGraph::ShaderDataType::Sampler2D) continue;
+        if (active && (i >= active->size() || !(*active)[i])) continue;
+        glActiveTexture(GL_TEXTURE0 + param.textureUnit);
+        glBindTexture(GL_TEXTURE_2D, acquire(param.texturePath));
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+const std::string& TextureStreamer::getError(const std::string& path) const {
+    auto it = m_files.find(path);
+    if (it == m_files.end()) return s_noError;
+    if (!it->second.error.empty() || !it->second.loaded) return it->second.error;
+    auto texture = m_textures.find(it->second.content);
+    return texture != m_textures.end() ? texture->second->error : s_noError;
+}
+
+bool TextureStreamer::isBusy() const {
+    return m_pendingFiles > 0 || !m_uploadQueue.empty();
+}
+
+void TextureStreamer::update() {
+    if (!m_initialized) return;
+    m_stats.uploadedBytes = 0;
+
+    std::vector<Decoded> decoded;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        decoded.swap(m_decoded);
+    }
+    for (Decoded& result : decoded) receive(result);
+
+    if (!m_uploadQueue.empty()) {
+        // A segment is rewritten only once the GPU has consumed the copies staged in it;
+        // until then uploads wait a frame rather than stall
+        GLsync fence = static_cast<GLsync>(m_fences[m_segment]);
+        bool ready = true;
+        if (fence) {
+            ready = glClientWaitSync(fence, 0, 0) != GL_TIMEOUT_EXPIRED;
+            if (ready) {
+                glDeleteSync(fence);
+                m_fences[m_segment] = nullptr;
+            }
+        }
+        if (ready) {
+            const size_t segmentOffset = m_segment * m_segmentBytes;
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_buffer);
+            uint8_t* segment = m_mapped ? m_mapped + segmentOffset
+                                        : static_cast<uint8_t*>(glMapBufferRange(
+                                              GL_PIXEL_UNPACK_BUFFER, static_cast<GLintptr>(segmentOffset),
+                                              static_cast<GLsizeiptr>(m_segmentBytes),
+                                              GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+            if (segment) {
+                m_uploads.clear();
+                stage(m_uploads, segment, segmentOffset);
+                if (!m_mapped) glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+                submit(m_uploads);
+                m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+                m_segment = (m_segment + 1) % m_segmentCount;
+            }
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+            while (!m_uploadQueue.empty() &&
+                   m_uploadQueue.front()->level == m_uploadQueue.front()->image.levels.size()) {
+                finish(*m_uploadQueue.front());
+                m_uploadQueue.pop_front();
+            }
+        }
+    }
+    updateStats();
+}
+
+void TextureStreamer::workerLoop() {
+    for (;;) {
+        std::string path;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cv.wait(lock, [this]() { return m_quit || !m_jobs.empty(); });
+            if (m_quit) break;
+            path = std::move(m_jobs.front());
+            m_jobs.pop_front();
+        }
+
+        Decoded result;
+        result.path = path;
+        std::ifstream file(path, std::ios::binary);
+        std::vector<uint8_t> bytes;
+        if (file) bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (!file && !file.eof()) {
+            result.error = "cannot open " + path;
+        } else {
+            Fnv1a64 hash;
+            hash.update(bytes.data(), bytes.size());
+            result.content = hash.value();
+            result.read = true;
+
+            // The first worker to see a content decodes it; other paths just point at it
+            bool claimed = false;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                claimed = m_contents.insert(result.content).second;
+            }
+            if (claimed) {
+                result.decoded = true;
+                std::string error;
+                if (ShaderGraph::decodeTexture(bytes.data(), bytes.size(), result.image, error)) {
+                    ShaderGraph::generateMipmaps(result.image);
+                } else {
+                    result.error = path + ": " + error;
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_decoded.push_back(std::move(result));
+    }
+}
+
+void TextureStreamer::receive(Decoded& decoded) {
+    m_pendingFiles--;
+    auto found = m_files.find(decoded.path);
+    if (found == m_files.end()) {
+        // Released while a worker had it. Keep the texture only for paths waiting on the
+        // same content, otherwise let the next reader of the content decode it.
+        if (!decoded.decoded) return;
+        bool shared = false;
+        for (const auto& file : m_files) shared = shared || (file.second.loaded && file.second.content == decoded.content);
+        if (!shared) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_contents.erase(decoded.content);
+            return;
+        }
+    } else {
+        File& file = found->second;
+        if (!decoded.read) {
+            file.error = std::move(decoded.error);
+            m_revision++;
+            return;
+        }
+        file.loaded = true;
+        file.content = decoded.content;
+        if (!decoded.decoded) {
+            if (m_textures.count(decoded.content) == 0) {
+                // The path that claimed the content was released before its texture
+                // was made; read this one again so it decodes the content itself
+                std::unique_lock<std::mutex> lock(m_mutex);
+                if (m_contents.count(decoded.content) == 0) {
+                    file.loaded = false;
+                    m_jobs.push_back(decoded.path);
+                    lock.unlock();
+                    m_cv.notify_one();
+                    m_pendingFiles++;
+                    return;
+                }
+            }
+            // Shared content already resident: units bound to this path switch over now
+            m_revision++;
+            return;
+        }
+    }
+
+    std::unique_ptr<Texture>& slot = m_textures[decoded.content];
+    if (!slot) slot = std::make_unique<Texture>();
+    Texture& texture = *slot;
+    texture.image = std::move(decoded.image);
+    texture.error = std::move(decoded.error);
+    if (!texture.error.empty() || !createTexture(texture)) {
+        texture.state = State::Failed;
+        texture.image = TextureImage();
+        m_revision++;
+        return;
+    }
+    texture.state = State::Uploading;
+    m_uploadQueue.push_back(&texture);
+}
+
+bool TextureStreamer::formatSupported(TextureFormat format) const {
+    switch (format) {
+        case TextureFormat::BC1:
+        case TextureFormat::BC2:
+        case TextureFormat::BC3:
+            return m_s3tc;
+        case TextureFormat::BC7:
+            return m_bptc;
+        case TextureFormat::ASTC4x4:
+        case TextureFormat::ASTC5x5:
+        case TextureFormat::ASTC6x6:
+        case TextureFormat::ASTC8x8:
+            return m_astc;
+        default:
+            return true;    // RGBA8, RGBA16F and RGTC (BC4/BC5) are core
+    }
+}
+
+// Allocate every level up front (no unpack buffer bound, so the data pointers are null);
+// the levels are filled in by the streamed sub-image uploads
+bool TextureStreamer::createTexture(Texture& texture) {
+    const TextureImage& image = texture.image;
+    const ShaderGraph::TextureFormatInfo& info = ShaderGraph::textureFormatInfo(image.format);
+    if (!formatSupported(image.format)) {
+        texture.error = std::string(info.name) + " textures are not supported by this GPU";
+        return false;
+    }
+
+    const GLenum format = internalFormat(image.format);
+    glGenTextures(1, &texture.texture);
+    glBindTexture(GL_TEXTURE_2D, texture.texture);
+    for (size_t i = 0; i < image.levels.size(); ++i) {
+        const TextureLevel& level = image.levels[i];
+        if (info.compressed) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), format, level.width, level.height, 0,
+                                   static_cast<GLsizei>(level.size), nullptr);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), format, level.width, level.height, 0, GL_RGBA,
+                         pixelType(image.format), nullptr);
+        }
+    }
+    const bool mipmapped = image.levels.size() > 1;
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levels.size() - 1));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, mipmapped ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    texture.bytes = image.pixels.size();
+    return true;
+}
+
+// Copy whole rows of blocks, in queue order, until the segment is full
+void TextureStreamer::stage(std::vector<Upload>& uploads, uint8_t* segment, size_t segmentOffset) {
+    size_t used = 0;
+    for (Texture* texture : m_uploadQueue) {
+        const TextureImage& image = texture->image;
+        const ShaderGraph::TextureFormatInfo& info = ShaderGraph::textureFormatInfo(image.format);
+        while (texture->level < image.levels.size()) {
+            const TextureLevel& level = image.levels[texture->level];
+            const size_t rowSize = ShaderGraph::textureRowSize(image.format, level.width);
+            const uint32_t rowCount = (level.height + info.blockHeight - 1) / info.blockHeight;
+            const size_t fit = used < m_segmentBytes ? (m_segmentBytes - used) / rowSize : 0;
+            if (fit == 0) return;
+
+            const uint32_t rows = static_cast<uint32_t>(std::min<size_t>(fit, rowCount - texture->row));
+            const size_t size = rows * rowSize;
+            std::memcpy(segment + used, image.levelData(texture->level) + texture->row * rowSize, size);
+            uploads.push_back({texture, texture->level, texture->row, rows, segmentOffset + used, size});
+            used = alignUp(used + size, 16);
+            m_stats.uploadedBytes += size;
+
+            texture->row += rows;
+            if (texture->row == rowCount) {
+                texture->row = 0;
+                texture->level++;
+            }
+        }
+    }
+}
+
+// Sub-image uploads sourced from the bound unpack buffer
+void TextureStreamer::submit(const std::vector<Upload>& uploads) {
+    for (const Upload& upload : uploads) {
+        const TextureImage& image = upload.texture->image;
+        const ShaderGraph::TextureFormatInfo& info = ShaderGraph::textureFormatInfo(image.format);
+        const TextureLevel& level = image.levels[upload.level];
+        const GLint y = static_cast<GLint>(upload.row * info.blockHeight);
+        const GLsizei height = static_cast<GLsizei>(std::min(level.height, (upload.row + upload.rows) * info.blockHeight)) - y;
+        const void* offset = reinterpret_cast<const void*>(upload.offset);
+
+        glBindTexture(GL_TEXTURE_2D, upload.texture->texture);
+        if (info.compressed) {
+            glCompressedTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(upload.level), 0, y, level.width, height,
+                                      internalFormat(image.format), static_cast<GLsizei>(upload.size), offset);
+        } else {
+            glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(upload.level), 0, y, level.width, height, GL_RGBA,
+                            pixelType(image.format), offset);
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TextureStreamer::finish(Texture& texture) {
+    texture.state = State::Resident;
+    texture.image = TextureImage();
+    m_revision++;
+}
+
+void TextureStreamer::updateStats() {
+    const size_t uploaded = m_stats.uploadedBytes;
+    m_stats = Stats();
+    m_stats.uploadedBytes = uploaded;
+    m_stats.persistentMapping = m_mapped != nullptr;
+    m_stats.files = m_files.size();
+    m_stats.textures = m_textures.size();
+    m_stats.loading = m_pendingFiles;
+    for (const auto& file : m_files) {
+        if (!file.second.error.empty()) m_stats.failed++;
+    }
+    for (const auto& entry : m_textures) {
+        switch (entry.second->state) {
+            case State::Resident:
+                m_stats.resident++;
+                m_stats.residentBytes += entry.second->bytes;
+                break;
+            case State::Uploading: m_stats.loading++; break;
+            case State::Failed: m_stats.failed++; break;
+        }
+    }
+}
@@ -0,0 +1,68 @@
+#include "uniform_reflection.h"
+#include "shader_types.h"
+#include "gl_platform.h"
+
+void UniformReflection::reflect(unsigned int program) {
+    m_program = program;
+    m_builtins = BuiltinUniformLocations();
+    m_hasPerFrameBlock = false;
+    m_hasSweepBlock = false;
+    m_hasParameterRevision = false;
+    m_parameterLocations.clear();
+    if (program == 0) return;
+
+    GLuint sweepIndex = glGetUniformBlockIndex(program, "SweepParameters");
+    if (sweepIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, sweepIndex, SweepBlockBinding);
+        m_hasSweepBlock = true;
+    }
+    m_builtins.sweepGrid = glGetUniformLocation(program, "sweepGrid");
+
+    GLuint blockIndex = glGetUniformBlockIndex(program, "PerFrame");
+    if (blockIndex != GL_INVALID_INDEX) {
+        // Block bindings are program state, so this is needed after every link or binary load
+        glUniformBlockBinding(program, blockIndex, PerFrameBlockBinding);
+        m_hasPerFrameBlock = true;
+        return;
+    }
+
+    m_builtins.model = glGetUniformLocation(program, "model");
+    m_builtins.view = glGetUniformLocation(program, "view");
+    m_builtins.projection = glGetUniformLocation(program, "projection");
+    m_builtins.time = glGetUniformLocation(program, "time");
+    m_builtins.lightPos = glGetUniformLocation(program, "lightPos");
+    m_builtins.viewPos = glGetUniformLocation(program, "viewPos");
+    m_builtins.lightColor = glGetUniformLocation(program, "lightColor");
+    m_builtins.objectColor = glGetUniformLocation(program, "objectColor");
+}
+
+bool UniformReflection::resolveParameters(const std::vector<ShaderGraph::UniformParameter>& params, uint64_t revision) {
+    if (m_hasParameterRevision && m_parameterRevision == revision && m_parameterLocations.size() == params.size()) {
+        return false;
+    }
+
+    m_parameterLocations.resize(params.size());
+    for (size_t i = 0; i < params.size(); ++i) {
+        m_parameterLocations[i] = m_program ? glGetUniformLocation(m_program, params[i].name.c_str()) : -1;
+    }
+    m_parameterRevision = revision;
+    m_hasParameterRevision = true;
+    return true;
+}
+
+void UniformReflection::upload(const ShaderGraph::UniformParameter& param, int location) {
+    if (location == -1) return;
+    switch (param.type) {
+        case ShaderGraph::ShaderDataType::Float:
+            glUniform1f(location, param.floatValue);
+            break;
+        case ShaderGraph::ShaderDataType::Vec3:
+            glUniform3f(location, param.vec3Value[0], param.vec3Value[1], param.vec3Value[2]);
+            break;
+        case ShaderGraph::ShaderDataType::Sampler2D:
+            glUniform1i(location, param.textureUnit);
+            break;
+        default:
+            break;
+    }
+}
@@ -0,0 +1,207 @@
+#include "compile_scheduler.h"
+#include "gl_platform.h"
+#include "test_harness.h"
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <set>
+
+// CompileScheduler against a fake ShaderCompiler: a build finishes on the first poll after
+// its submit and gets the next program name, so the scheduling runs without a GL context.
+
+namespace {
+
+int g_compiling = 0;            // Builds submitted to a slot and not yet polled
+int g_maxCompiling = 0;
+unsigned g_nextProgram = 1;
+std::set<unsigned> g_deleted;
+
+} // namespace
+
+extern "C" void glDeleteProgram(GLuint program) {
+    g_deleted.insert(program);
+}
+
+ShaderCompiler::~ShaderCompiler() {}
+
+void ShaderCompiler::init(GLFWwindow*) {
+    m_backend = Backend::SharedContext;
+}
+
+void ShaderCompiler::shutdown() {
+    if (m_hasPending) g_compiling--;
+    m_hasPending = false;
+}
+
+const char* ShaderCompiler::getBackendName() const {
+    return "fake";
+}
+
+uint64_t ShaderCompiler::submit(const std::string& vertexSource, const std::string& fragmentSource) {
+    if (!m_hasPending) g_compiling++;
+    g_maxCompiling = std::max(g_maxCompiling, g_compiling);
+    m_pending.ticket = m_nextTicket++;
+    m_pending.vertexSource = vertexSource;
+    m_pending.fragmentSource = fragmentSource;
+    m_hasPending = true;
+    return m_pending.ticket;
+}
+
+bool ShaderCompiler::poll(Result& result) {
+    if (!m_hasPending) return false;
+    m_hasPending = false;
+    g_compiling--;
+    result = Result();
+    result.ticket = m_pending.ticket;
+    result.success = true;
+    result.program = g_nextProgram++;
+    return true;
+}
+
+namespace {
+
+using Priority = CompileScheduler::Priority;
+using Sources = CompileScheduler::Sources;
+
+CompileScheduler::Generator writes(const std::string& fragment) {
+    return [fragment](Sources& sources) { sources.fragment = fragment; };
+}
+
+// Frames until nothing is busy; the builds come back in delivery order
+std::vector<CompileScheduler::Result> drain(CompileScheduler& scheduler) {
+    std::vector<CompileScheduler::Result> results;
+    for (int frame = 0; frame < 5000 && scheduler.isBusy(); ++frame) {
+        scheduler.update();
+        CompileScheduler::Result result;
+        while (scheduler.poll(result)) results.push_back(std::move(result));
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return results;
+}
+
+} // namespace
+
+TEST(focusedDocumentGoesFirst) {
+    // One worker, held inside the first background request until the focused one is queued
+    CompileScheduler scheduler(1, 2);
+    scheduler.init(nullptr);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<bool> started{false};
+    std::vector<CompileScheduler::DocumentId> background;
+    for (int i = 0; i < 8; ++i) background.push_back(scheduler.addDocument(Priority::Background));
+    scheduler.submit(background[0], [released, &started](Sources& sources) {
+        started = true;
+        released.wait();
+        sources.fragment = "background 0";
+    });
+    for (int i = 1; i < 8; ++i) scheduler.submit(background[i], writes("background " + std::to_string(i)));
+    while (!started) std::this_thread::yield();
+    const CompileScheduler::DocumentId focused = scheduler.addDocument(Priority::Focused);
+    scheduler.submit(focused, writes("focused"));
+    release.set_value();
+
+    const std::vector<CompileScheduler::Result> results = drain(scheduler);
+    REQUIRE(results.size() == 9);
+    // Only the request that was already running may finish ahead of it
+    const auto position = std::find_if(results.begin(), results.end(),
+                                       [focused](const CompileScheduler::Result& result) { return result.document == focused; });
+    CHECK(position - results.begin() <= 1);
+    CHECK(scheduler.getStats().latencySamples[static_cast<size_t>(Priority::Focused)] == 1);
+    scheduler.shutdown();
+}
+
+TEST(compilesNeverExceedTheSlots) {
+    g_maxCompiling = 0;
+    CompileScheduler scheduler(4, 3);
+    scheduler.init(nullptr);
+    std::vector<CompileScheduler::DocumentId> documents;
+    for (int i = 0; i < 24; ++i) {
+        documents.push_back(scheduler.addDocument(i % 5 == 0 ? Priority::Focused : Priority::Background));
+        scheduler.submit(documents.back(), writes("document " + std::to_string(i)));
+    }
+    const std::vector<CompileScheduler::Result> results = drain(scheduler);
+    CHECK(results.size() == documents.size());
+    CHECK(scheduler.getStats().slots == 3);
+    CHECK(g_maxCompiling >= 1 && g_maxCompiling <= 3);
+    std::set<CompileScheduler::DocumentId> delivered;
+    for (const CompileScheduler::Result& result : results) delivered.insert(result.document);
+    CHECK(delivered.size() == documents.size());
+    scheduler.shutdown();
+    CHECK(g_compiling == 0);
+}
+
+TEST(unchangedSourcesAreNotRebuilt) {
+    CompileScheduler scheduler(2, 2);
+    scheduler.init(nullptr);
+    const CompileScheduler::DocumentId document = scheduler.addDocument(Priority::Focused);
+    scheduler.submit(document, writes("a"));
+    CHECK(drain(scheduler).size() == 1);
+
+    scheduler.submit(document, writes("a"));
+    CHECK(drain(scheduler).empty());
+    CHECK(scheduler.getStats().unchanged == 1);
+
+    // An edit that's undone again still builds the edit, and the undo after it
+    scheduler.submit(document, writes("b"));
+    const std::vector<CompileScheduler::Result> edited = drain(scheduler);
+    REQUIRE(edited.size() == 1);
+    CHECK(edited[0].sources.fragment == "b");
+    scheduler.submit(document, writes("a"));
+    CHECK(drain(scheduler).size() == 1);
+    CHECK(scheduler.getStats().delivered == 3);
+    scheduler.shutdown();
+}
+
+TEST(supersededRequestsCollapse) {
+    CompileScheduler scheduler(1, 2);
+    scheduler.init(nullptr);
+    const CompileScheduler::DocumentId document = scheduler.addDocument(Priority::Focused);
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<bool> started{false};
+    scheduler.submit(document, [released, &started](Sources& sources) {
+        started = true;
+        released.wait();
+        sources.fragment = "first";
+    });
+    while (!started) std::this_thread::yield();
+    // Each of these replaces the one queued before it
+    for (int i = 1; i <= 5; ++i) scheduler.submit(document, writes("edit " + std::to_string(i)));
+    release.set_value();
+
+    const std::vector<CompileScheduler::Result> results = drain(scheduler);
+    REQUIRE(!results.empty());
+    CHECK(results.size() <= 2);
+    CHECK(results.back().sources.fragment == "edit 5");
+    CHECK(scheduler.getStats().superseded >= 4);
+    scheduler.shutdown();
+}
+
+TEST(removedDocumentDeletesItsBuild) {
+    g_deleted.clear();
+    CompileScheduler scheduler(1, 1);
+    scheduler.init(nullptr);
+    const CompileScheduler::DocumentId kept = scheduler.addDocument(Priority::Background);
+    const CompileScheduler::DocumentId removed = scheduler.addDocument(Priority::Focused);
+    scheduler.submit(removed, writes("removed"));
+    while (scheduler.getStats().queuedCompiles == 0) std::this_thread::yield();
+    scheduler.update();
+    REQUIRE(scheduler.getStats().compiling == 1);
+    const unsigned program = g_nextProgram;
+
+    scheduler.removeDocument(removed);
+    scheduler.submit(removed, writes("ignored"));
+    scheduler.submit(kept, writes("kept"));
+    const std::vector<CompileScheduler::Result> results = drain(scheduler);
+    REQUIRE(results.size() == 1);
+    CHECK(results[0].document == kept);
+    CHECK(g_deleted.count(program) == 1);
+    CHECK(scheduler.getStats().documents == 1);
+    CHECK(!scheduler.isBusy(removed));
+    scheduler.shutdown();
+}
+
+int main() {
+    return TestHarness::runAll();
+}
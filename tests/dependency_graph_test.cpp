@@ -0,0 +1,220 @@
+#include "dependency_graph.h"
+#include "test_harness.h"
+#include <algorithm>
+#include <random>
+#include <set>
+#include <utility>
+
+// DependencyGraph against a brute-force reference: the order must put every producer
+// before its consumers, and cycles must be skipped rather than followed or reported as
+// an order.
+
+using ShaderGraph::DependencyGraph;
+
+namespace {
+
+struct Node {
+    int id = 0;
+};
+
+using Graph = DependencyGraph<Node, Node>;
+using Edge = std::pair<int, int>;
+
+// Position of every node in the order, -1 when missing; false when a node appears twice
+bool positions(const std::vector<Node*>& order, size_t count, std::vector<int>& at) {
+    at.assign(count, -1);
+    for (size_t i = 0; i < order.size(); ++i) {
+        int& slot = at[static_cast<size_t>(order[i]->id)];
+        if (slot >= 0) return false;
+        slot = static_cast<int>(i);
+    }
+    return true;
+}
+
+bool respectsEdges(const std::vector<int>& at, const std::multiset<Edge>& edges) {
+    for (const Edge& edge : edges) {
+        if (at[static_cast<size_t>(edge.first)] >= at[static_cast<size_t>(edge.second)]) return false;
+    }
+    return true;
+}
+
+// Everything root depends on, by walking the edge list
+std::set<int> upstreamOf(int root, const std::multiset<Edge>& edges) {
+    std::set<int> seen = {root};
+    std::vector<int> stack = {root};
+    while (!stack.empty()) {
+        const int node = stack.back();
+        stack.pop_back();
+        for (const Edge& edge : edges) {
+            if (edge.second == node && seen.insert(edge.first).second) stack.push_back(edge.first);
+        }
+    }
+    return seen;
+}
+
+} // namespace
+
+TEST(ordersProducersBeforeConsumers) {
+    std::vector<Node> nodes(5);
+    Graph graph;
+    for (int i = 0; i < 5; ++i) {
+        nodes[i].id = i;
+        graph.addNode(&nodes[i], &nodes[i]);
+    }
+    // A chain linked against creation order, so every edge needs a reorder
+    std::multiset<Edge> edges;
+    for (int i = 4; i > 0; --i) {
+        graph.addEdge(&nodes[i], &nodes[i - 1]);
+        edges.insert({i, i - 1});
+    }
+    std::vector<Node*> order;
+    graph.collectAll(order);
+    std::vector<int> at;
+    REQUIRE(positions(order, nodes.size(), at));
+    CHECK(order.size() == nodes.size());
+    CHECK(respectsEdges(at, edges));
+    CHECK(graph.cycleEdgeCount() == 0);
+}
+
+TEST(randomEditsMatchReference) {
+    const int count = 48;
+    std::vector<Node> nodes(count);
+    Graph graph;
+    for (int i = 0; i < count; ++i) {
+        nodes[i].id = i;
+        graph.addNode(&nodes[i], &nodes[i]);
+    }
+    // Edges follow a hidden permutation, so the graph stays acyclic
+    std::mt19937 rng(7);
+    std::vector<int> rank(count);
+    for (int i = 0; i < count; ++i) rank[i] = i;
+    std::shuffle(rank.begin(), rank.end(), rng);
+
+    std::multiset<Edge> edges;
+    std::vector<Node*> order;
+    std::vector<int> at;
+    for (int step = 0; step < 400; ++step) {
+        if (!edges.empty() && rng() % 4 == 0) {
+            auto edge = edges.begin();
+            std::advance(edge, static_cast<long>(rng() % edges.size()));
+            graph.removeEdge(&nodes[edge->first], &nodes[edge->second]);
+            edges.erase(edge);
+        } else {
+            int a = static_cast<int>(rng() % count);
+            int b = static_cast<int>(rng() % count);
+            if (a == b) continue;
+            if (rank[a] > rank[b]) std::swap(a, b);
+            graph.addEdge(&nodes[a], &nodes[b]);
+            edges.insert({a, b});
+        }
+        graph.collectAll(order);
+        REQUIRE(positions(order, nodes.size(), at));
+        CHECK(order.size() == nodes.size());
+        CHECK(respectsEdges(at, edges));
+        CHECK(graph.cycleEdgeCount() == 0);
+    }
+
+    std::vector<Node*> upstream;
+    for (int root = 0; root < count; ++root) {
+        graph.collectUpstream(&nodes[root], upstream);
+        std::set<int> ids;
+        for (Node* node : upstream) ids.insert(node->id);
+        CHECK(ids == upstreamOf(root, edges));
+        CHECK(ids.size() == upstream.size());
+        CHECK(!upstream.empty() && upstream.back() == &nodes[root]);
+    }
+}
+
+TEST(cycleEdgesAreSkipped) {
+    std::vector<Node> nodes(4);
+    Graph graph;
+    for (int i = 0; i < 4; ++i) {
+        nodes[i].id = i;
+        graph.addNode(&nodes[i], &nodes[i]);
+    }
+    graph.addEdge(&nodes[0], &nodes[1]);
+    graph.addEdge(&nodes[1], &nodes[2]);
+    graph.addEdge(&nodes[2], &nodes[3]);
+    graph.addEdge(&nodes[2], &nodes[0]);   // Closes 0 -> 1 -> 2 -> 0
+
+    std::vector<Node*> order;
+    std::vector<int> at;
+    graph.collectAll(order);
+    REQUIRE(positions(order, nodes.size(), at));
+    CHECK(order.size() == nodes.size());
+    CHECK(graph.cycleEdgeCount() == 1);
+    CHECK(at[2] < at[3]);
+
+    std::vector<Node*> upstream;
+    graph.collectUpstream(&nodes[3], upstream);
+    CHECK(upstream.size() == 4);
+    CHECK(!upstream.empty() && upstream.back() == &nodes[3]);
+
+    // Breaking the cycle makes the order incremental again
+    graph.removeEdge(&nodes[2], &nodes[0]);
+    graph.collectAll(order);
+    REQUIRE(positions(order, nodes.size(), at));
+    CHECK(graph.cycleEdgeCount() == 0);
+    CHECK(respectsEdges(at, {{0, 1}, {1, 2}, {2, 3}}));
+    graph.addEdge(&nodes[0], &nodes[3]);
+    graph.collectAll(order);
+    REQUIRE(positions(order, nodes.size(), at));
+    CHECK(respectsEdges(at, {{0, 1}, {1, 2}, {2, 3}, {0, 3}}));
+}
+
+TEST(selfLoopCountsAsCycle) {
+    Node a, b;
+    a.id = 0;
+    b.id = 1;
+    Graph graph;
+    graph.addNode(&a, &a);
+    graph.addNode(&b, &b);
+    graph.addEdge(&a, &b);
+    graph.addEdge(&b, &b);
+    std::vector<Node*> order;
+    graph.collectAll(order);
+    CHECK(order.size() == 2);
+    CHECK(graph.cycleEdgeCount() == 1);
+    CHECK(order.size() == 2 && order[0] == &a);
+}
+
+TEST(removedNodesLeaveTheOrder) {
+    const int count = 80;
+    std::vector<Node> nodes(count);
+    Graph graph;
+    for (int i = 0; i < count; ++i) {
+        nodes[i].id = i;
+        graph.addNode(&nodes[i], &nodes[i]);
+    }
+    for (int i = 1; i < count; ++i) graph.addEdge(&nodes[i], &nodes[i - 1]);
+    // Enough removals to compact the order, then new nodes reuse the freed indices
+    for (int i = 0; i < count; i += 2) graph.removeNode(&nodes[i]);
+    CHECK(graph.nodeCount() == count / 2);
+    std::vector<Node> extra(10);
+    for (int i = 0; i < 10; ++i) {
+        extra[i].id = i;
+        graph.addNode(&extra[i], &extra[i]);
+        graph.addEdge(&nodes[1], &extra[i]);
+    }
+
+    std::vector<Node*> order;
+    graph.collectAll(order);
+    CHECK(order.size() == count / 2 + 10);
+    std::set<const Node*> seen(order.begin(), order.end());
+    CHECK(seen.size() == order.size());
+    for (int i = 0; i < count; i += 2) CHECK(seen.count(&nodes[i]) == 0);
+    auto position = [&order](const Node* node) {
+        return std::find(order.begin(), order.end(), node) - order.begin();
+    };
+    for (int i = 0; i < 10; ++i) CHECK(position(&nodes[1]) < position(&extra[i]));
+
+    std::vector<Node*> upstream;
+    graph.collectUpstream(&nodes[1], upstream);
+    CHECK(upstream.size() == 1);
+    graph.collectUpstream(&extra[0], upstream);
+    CHECK(upstream.size() == 2);
+}
+
+int main() {
+    return TestHarness::runAll();
+}
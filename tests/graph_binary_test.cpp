@@ -0,0 +1,191 @@
+#include "graph_binary.h"
+#include "test_harness.h"
+#include <cstring>
+#include <filesystem>
+
+// .sgraphb files: a write and read keeps every field, the bytes sit where the format says
+// (so a layout change without a version bump fails here), and files of another version or
+// with values the text format refuses don't load.
+
+using namespace ShaderGraph;
+
+namespace {
+
+// TexCoord -> Texture -> Sin -> Output, every per-node field set somewhere
+GraphDesc sampleGraph() {
+    GraphDesc graph;
+    NodeDesc coords;
+    coords.kind = NodeKind::TexCoord;
+    coords.id = 7;
+    coords.pos[0] = -120.5f;
+    coords.pos[1] = 40.0f;
+    graph.nodes.push_back(coords);
+
+    NodeDesc texture;
+    texture.kind = NodeKind::Texture;
+    texture.id = 0x1122334455667788ull;
+    texture.textureUnit = 15;
+    texture.name = "Albedo";
+    texture.path = "textures/albedo.dds";
+    texture.precision = ShaderPrecision::Half;
+    graph.nodes.push_back(texture);
+
+    NodeDesc wave;
+    wave.kind = NodeKind::Sin;
+    wave.id = 9;
+    wave.value[0] = 0.25f;
+    wave.value[3] = -2.0f;
+    wave.bakeFormat = BakeFormat::Half;
+    wave.bakeSize = 256;
+    wave.precision = ShaderPrecision::Full;
+    graph.nodes.push_back(wave);
+
+    NodeDesc output;
+    output.kind = NodeKind::Output;
+    output.id = 10;
+    graph.nodes.push_back(output);
+
+    graph.links.push_back({0, 0, 1, 0});
+    graph.links.push_back({1, 2, 2, 0});
+    graph.links.push_back({2, 0, 3, 0});
+    return graph;
+}
+
+bool sameNode(const NodeDesc& a, const NodeDesc& b) {
+    return a.kind == b.kind && a.id == b.id && std::memcmp(a.pos, b.pos, sizeof(a.pos)) == 0 &&
+           std::memcmp(a.value, b.value, sizeof(a.value)) == 0 && a.textureUnit == b.textureUnit && a.name == b.name &&
+           a.path == b.path && a.precision == b.precision && a.bakeFormat == b.bakeFormat && a.bakeSize == b.bakeSize;
+}
+
+bool sameGraph(const GraphDesc& a, const GraphDesc& b) {
+    if (a.nodes.size() != b.nodes.size() || a.links.size() != b.links.size()) return false;
+    for (size_t i = 0; i < a.nodes.size(); ++i) {
+        if (!sameNode(a.nodes[i], b.nodes[i])) return false;
+    }
+    for (size_t i = 0; i < a.links.size(); ++i) {
+        const LinkDesc &x = a.links[i], &y = b.links[i];
+        if (x.fromNode != y.fromNode || x.fromPin != y.fromPin || x.toNode != y.toNode || x.toPin != y.toPin) return false;
+    }
+    return true;
+}
+
+template <typename T>
+T readAt(const std::vector<char>& data, size_t offset) {
+    T value;
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+}
+
+template <typename T>
+void writeAt(std::vector<char>& data, size_t offset, T value) {
+    std::memcpy(data.data() + offset, &value, sizeof(value));
+}
+
+bool opens(const std::vector<char>& data, std::string& error) {
+    GraphFileView view;
+    return view.openMemory(data.data(), data.size(), error);
+}
+
+} // namespace
+
+TEST(roundTripKeepsEveryField) {
+    const GraphDesc graph = sampleGraph();
+    std::vector<char> data;
+    std::string error;
+    REQUIRE(writeGraphBinary(graph, data, error));
+    GraphFileView view;
+    REQUIRE(view.openMemory(data.data(), data.size(), error));
+    CHECK(view.nodeName(1) == "Albedo");
+    CHECK(view.nodePath(1) == "textures/albedo.dds");
+    GraphDesc read;
+    view.toDesc(read);
+    CHECK(sameGraph(graph, read));
+
+    const std::string path = (std::filesystem::temp_directory_path() / "shadergraph_binary_test.sgraphb").string();
+    REQUIRE(saveGraphBinary(path, graph, error));
+    CHECK(isGraphBinaryFile(path));
+    GraphDesc loaded;
+    CHECK(loadGraphBinary(path, loaded, error));
+    CHECK(sameGraph(graph, loaded));
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+TEST(layoutIsPinned) {
+    std::vector<char> data;
+    std::string error;
+    REQUIRE(writeGraphBinary(sampleGraph(), data, error));
+    // Header
+    CHECK(std::memcmp(data.data(), "SGRB", 4) == 0);
+    CHECK(readAt<uint32_t>(data, 4) == 4);
+    CHECK(readAt<uint32_t>(data, 8) == 4);
+    CHECK(readAt<uint32_t>(data, 12) == 3);
+    CHECK(readAt<uint32_t>(data, 16) == 25);
+    CHECK(readAt<uint64_t>(data, 24) == 48);
+    CHECK(readAt<uint64_t>(data, 32) == 48 + 4 * 48);
+    CHECK(readAt<uint64_t>(data, 40) == 48 + 4 * 48 + 3 * 16);
+    CHECK(data.size() == 288 + 32);
+
+    // The Texture node, then the Sin node's bake and precision bytes
+    const size_t texture = 48 + 48;
+    CHECK(readAt<uint64_t>(data, texture) == 0x1122334455667788ull);
+    CHECK(readAt<uint32_t>(data, texture + 32) == 0);       // nameOffset
+    CHECK(readAt<uint32_t>(data, texture + 36) == 6);       // nameLength
+    CHECK(readAt<uint8_t>(data, texture + 40) == static_cast<uint8_t>(NodeKind::Texture));
+    CHECK(readAt<uint8_t>(data, texture + 42) == 15);       // textureUnit
+    CHECK(readAt<uint8_t>(data, texture + 43) == static_cast<uint8_t>(ShaderPrecision::Half));
+    CHECK(readAt<uint32_t>(data, texture + 44) == 19);      // pathLength
+    const size_t wave = 48 + 2 * 48;
+    CHECK(readAt<float>(data, wave + 16) == 0.25f);          // value[0]
+    CHECK(readAt<float>(data, wave + 28) == -2.0f);          // value[3]
+    CHECK(readAt<uint8_t>(data, wave + 41) == (static_cast<uint8_t>(BakeFormat::Half) << 4 | 8));
+
+    // Second link, then the string table
+    CHECK(readAt<uint32_t>(data, 240 + 16) == 1);
+    CHECK(readAt<uint32_t>(data, 240 + 20) == 2);
+    CHECK(std::memcmp(data.data() + 288, "Albedotextures/albedo.dds", 25) == 0);
+}
+
+TEST(otherVersionsAreRefused) {
+    std::vector<char> data;
+    std::string error;
+    REQUIRE(writeGraphBinary(sampleGraph(), data, error));
+    CHECK(opens(data, error));
+    for (uint32_t version : {1u, 3u, 5u}) {
+        writeAt<uint32_t>(data, 4, version);
+        error.clear();
+        CHECK(!opens(data, error));
+        CHECK(error == "unsupported version " + std::to_string(version));
+    }
+}
+
+TEST(textureUnitsStayBelowTheLimit) {
+    GraphDesc graph = sampleGraph();
+    std::vector<char> data;
+    std::string error;
+    for (int unit : {TextureUnitCount, -1, 255}) {
+        graph.nodes[1].textureUnit = unit;
+        error.clear();
+        CHECK(!writeGraphBinary(graph, data, error));
+        CHECK(error == "node 1 has an out of range texture unit");
+    }
+
+    REQUIRE(writeGraphBinary(sampleGraph(), data, error));
+    writeAt<uint8_t>(data, 48 + 48 + 42, static_cast<uint8_t>(TextureUnitCount));
+    CHECK(!opens(data, error));
+    CHECK(error == "node 1 has an out of range texture unit");
+}
+
+TEST(truncatedFilesAreRefused) {
+    std::vector<char> data;
+    std::string error;
+    REQUIRE(writeGraphBinary(sampleGraph(), data, error));
+    for (size_t size : {size_t(3), sizeof(GraphFileHeader) - 1, size_t(200), size_t(300)}) {
+        GraphFileView view;
+        CHECK(!view.openMemory(data.data(), size, error));
+    }
+}
+
+int main() {
+    return TestHarness::runAll();
+}
@@ -0,0 +1,128 @@
+#include "mesh.h"
+#include "test_harness.h"
+#include <algorithm>
+#include <cmath>
+
+// The packed GPU vertex layout: packing and reading back keeps positions exactly and
+// normals and uvs within their quantization, with 16- and 32-bit indices, and packed
+// meshes whose index buffer doesn't add up are refused.
+
+using namespace ShaderGraph;
+
+namespace {
+
+// Largest difference between two attribute arrays, infinite when their sizes differ
+float maxDifference(const std::vector<float>& a, const std::vector<float>& b) {
+    if (a.size() != b.size()) return INFINITY;
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.size(); ++i) worst = std::max(worst, std::fabs(a[i] - b[i]));
+    return worst;
+}
+
+// A strip of quads with texture coordinates over [0, 1] and tilted normals
+MeshData stripMesh(uint32_t quads) {
+    MeshData mesh;
+    for (uint32_t i = 0; i <= quads; ++i) {
+        for (int side = 0; side < 2; ++side) {
+            const float t = static_cast<float>(i) / static_cast<float>(quads);
+            mesh.positions.insert(mesh.positions.end(), {t * 3.0f - 1.5f, side ? 0.25f : -0.25f, std::sin(t * 7.0f)});
+            const float nx = std::cos(t * 7.0f), nz = -std::sin(t * 7.0f) * 0.5f, length = std::sqrt(nx * nx + nz * nz + 0.09f);
+            mesh.normals.insert(mesh.normals.end(), {nx / length, (side ? 0.3f : -0.3f) / length, nz / length});
+            mesh.uvs.insert(mesh.uvs.end(), {t, side ? 0.0f : 1.0f});
+        }
+    }
+    for (uint32_t i = 0; i < quads; ++i) {
+        const uint32_t a = i * 2;
+        mesh.indices.insert(mesh.indices.end(), {a, a + 1, a + 2, a + 2, a + 1, a + 3});
+    }
+    return mesh;
+}
+
+void checkRoundTrip(const MeshData& mesh, bool index32) {
+    PackedMesh packed;
+    packMesh(mesh, packed);
+    CHECK(packed.index32 == index32);
+    CHECK(packed.indexCount == mesh.indices.size());
+    MeshData read;
+    std::string error;
+    REQUIRE(unpackMesh(packed, read, error));
+    CHECK(read.positions == mesh.positions);
+    CHECK(read.indices == mesh.indices);
+    // 10-bit snorm steps are 1/511; halves keep 11 significant bits of uvs in [0, 1]
+    CHECK(maxDifference(read.normals, mesh.normals) <= 0.5f / 511.0f + 1e-6f);
+    CHECK(maxDifference(read.uvs, mesh.uvs) <= 1.0f / 2048.0f);
+}
+
+} // namespace
+
+TEST(packedMeshesReadBack) {
+    MeshData torus;
+    makeMeshShape(MeshShape::Torus, torus);
+    completeMesh(torus);
+    checkRoundTrip(torus, false);
+    checkRoundTrip(stripMesh(40), false);
+
+    // 65536 vertices still fit 16-bit indices, one more doesn't
+    checkRoundTrip(stripMesh(32767), false);
+    checkRoundTrip(stripMesh(32768), true);
+}
+
+TEST(extremeNormalsAndDefaults) {
+    MeshData mesh;
+    mesh.positions = {0, 0, 0, 1, 0, 0, 0, 1, 0};
+    mesh.normals = {1, 0, 0, -1, 0, 0, 0, -2, 0};   // Out of range components clamp
+    mesh.indices = {0, 1, 2};
+    PackedMesh packed;
+    packMesh(mesh, packed);
+    MeshData read;
+    std::string error;
+    REQUIRE(unpackMesh(packed, read, error));
+    CHECK(read.normals == std::vector<float>({1, 0, 0, -1, 0, 0, 0, -1, 0}));
+    CHECK(read.uvs == std::vector<float>(6, 0.0f));     // No uvs packs zeros
+
+    mesh.normals.clear();
+    packMesh(mesh, packed);
+    REQUIRE(unpackMesh(packed, read, error));
+    CHECK(read.normals == std::vector<float>({0, 0, 1, 0, 0, 1, 0, 0, 1}));
+}
+
+TEST(inconsistentIndexBuffersAreRefused) {
+    PackedMesh good;
+    packMesh(stripMesh(4), good);
+    MeshData read;
+    std::string error;
+
+    PackedMesh shortBuffer = good;
+    shortBuffer.indices.pop_back();
+    CHECK(!unpackMesh(shortBuffer, read, error));
+    CHECK(error == "index buffer holds 47 bytes, expected 48");
+
+    PackedMesh longBuffer = good;
+    longBuffer.indices.resize(longBuffer.indices.size() + 2);
+    CHECK(!unpackMesh(longBuffer, read, error));
+
+    // 16-bit indices claimed as 32-bit
+    PackedMesh wide = good;
+    wide.index32 = true;
+    CHECK(!unpackMesh(wide, read, error));
+
+    PackedMesh partial = good;
+    partial.indexCount -= 1;
+    partial.indices.resize(partial.indices.size() - 2);
+    CHECK(!unpackMesh(partial, read, error));
+    CHECK(error == "index count 23 is not a triangle list");
+
+    PackedMesh fewerVertices = good;
+    fewerVertices.vertices.resize(fewerVertices.vertices.size() - 1);
+    CHECK(!unpackMesh(fewerVertices, read, error));
+    CHECK(error == "index 23 references vertex 9 of 9");
+    CHECK(read.indices.empty() && read.positions.empty());
+
+    PackedMesh empty;
+    CHECK(unpackMesh(empty, read, error));
+    CHECK(read.vertexCount() == 0 && read.indices.empty());
+}
+
+int main() {
+    return TestHarness::runAll();
+}
@@ -0,0 +1,136 @@
+#include "parameter_registry.h"
+#include "test_harness.h"
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+
+// ParameterRegistry: handles stay stable across swap-removes and are reused once freed,
+// and name lookups survive parameters that share a name for a while.
+
+using ShaderGraph::InvalidParameterHandle;
+using ShaderGraph::ParameterHandle;
+using ShaderGraph::ParameterRegistry;
+using ShaderGraph::UniformParameter;
+
+namespace {
+
+UniformParameter floatParam(const std::string& name, float value = 0.5f) {
+    return UniformParameter::Float(name, name, value);
+}
+
+// Every live handle reads back its own parameter, and handles() is the inverse mapping
+bool consistent(const ParameterRegistry& registry, const std::map<ParameterHandle, std::string>& expected) {
+    if (registry.size() != expected.size() || registry.handles().size() != expected.size()) return false;
+    for (const auto& entry : expected) {
+        if (!registry.valid(entry.first) || registry.get(entry.first).name != entry.second) return false;
+    }
+    for (size_t i = 0; i < registry.size(); ++i) {
+        const ParameterHandle handle = registry.handles()[i];
+        if (registry.parameters()[i].name != registry.get(handle).name) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+TEST(freedHandlesAreReused) {
+    ParameterRegistry registry;
+    const ParameterHandle a = registry.add(nullptr, floatParam("u_a"));
+    const ParameterHandle b = registry.add(nullptr, floatParam("u_b"));
+    const ParameterHandle c = registry.add(nullptr, floatParam("u_c"));
+    CHECK(a != b && b != c && a != c);
+
+    registry.remove(b);
+    CHECK(!registry.valid(b));
+    CHECK(registry.find("u_b") == InvalidParameterHandle);
+    CHECK(registry.get(a).name == "u_a");
+    CHECK(registry.get(c).name == "u_c");
+
+    const ParameterHandle d = registry.add(nullptr, floatParam("u_d"));
+    CHECK(d == b);
+    CHECK(registry.get(d).name == "u_d");
+    CHECK(registry.find("u_d") == d);
+    CHECK(consistent(registry, {{a, "u_a"}, {c, "u_c"}, {d, "u_d"}}));
+
+    // Removing twice, or a handle never handed out, changes nothing
+    registry.remove(a);
+    registry.remove(a);
+    registry.remove(1000);
+    CHECK(consistent(registry, {{c, "u_c"}, {d, "u_d"}}));
+}
+
+TEST(randomAddRemoveMatchesReference) {
+    ParameterRegistry registry;
+    std::map<ParameterHandle, std::string> expected;
+    std::mt19937 rng(3);
+    size_t highest = 0;
+    size_t mostLive = 0;
+    for (int step = 0; step < 2000; ++step) {
+        if (!expected.empty() && rng() % 3 == 0) {
+            auto it = expected.begin();
+            std::advance(it, static_cast<long>(rng() % expected.size()));
+            registry.remove(it->first);
+            expected.erase(it);
+        } else {
+            const std::string name = "u_p" + std::to_string(step);
+            const ParameterHandle handle = registry.add(nullptr, floatParam(name));
+            CHECK(expected.count(handle) == 0);
+            expected[handle] = name;
+            highest = std::max<size_t>(highest, handle);
+            mostLive = std::max(mostLive, expected.size());
+        }
+        CHECK(consistent(registry, expected));
+    }
+    // Handles come from the free list before new ones are made
+    CHECK(highest < mostLive);
+    for (const auto& entry : expected) CHECK(registry.find(entry.second) == entry.first);
+}
+
+TEST(sharedNamesKeepTheOtherLookup) {
+    ParameterRegistry registry;
+    const ParameterHandle a = registry.add(nullptr, floatParam("u_a"));
+    const ParameterHandle b = registry.add(nullptr, floatParam("u_b"));
+
+    // b renamed onto a's name, then a renamed away: the name now belongs to b
+    registry.update(b, floatParam("u_a"));
+    registry.update(a, floatParam("u_c"));
+    CHECK(registry.find("u_a") == b);
+    CHECK(registry.find("u_c") == a);
+    CHECK(registry.find("u_b") == InvalidParameterHandle);
+
+    // Removing one of two parameters with the same name leaves the other findable
+    const ParameterHandle c = registry.add(nullptr, floatParam("u_a"));
+    CHECK(registry.find("u_a") == c);
+    registry.remove(c);
+    CHECK(registry.find("u_a") == b);
+    registry.remove(a);
+    CHECK(registry.find("u_a") == b);
+    CHECK(registry.find("u_c") == InvalidParameterHandle);
+}
+
+TEST(valueEditsMarkDirtyOnce) {
+    ParameterRegistry registry;
+    const ParameterHandle a = registry.add(nullptr, floatParam("u_a"));
+    const ParameterHandle b = registry.add(nullptr, floatParam("u_b"));
+    registry.clearDirty();
+    const uint64_t layout = registry.getLayoutRevision();
+
+    registry.setFloat(b, 0.5f);     // Unchanged
+    CHECK(registry.getDirty().empty());
+    registry.setFloat(b, 0.75f);
+    registry.setFloat(b, 0.25f);
+    REQUIRE(registry.getDirty().size() == 1);
+    CHECK(registry.handles()[registry.getDirty()[0]] == b);
+    CHECK(registry.getLayoutRevision() == layout);
+
+    // A rename changes the layout and marks everything
+    registry.clearDirty();
+    registry.update(a, floatParam("u_renamed"));
+    CHECK(registry.getLayoutRevision() != layout);
+    CHECK(registry.getDirty().size() == 2);
+}
+
+int main() {
+    return TestHarness::runAll();
+}
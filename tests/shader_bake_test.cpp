@@ -0,0 +1,242 @@
+#include "shader_bake.h"
+#include "test_harness.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+
+// The baker's kernels (SIMD or, built with SHADERGRAPH_BAKE_SCALAR, portable) against a
+// per-pixel evaluation in double precision. Bakes go to RGBA16F so values outside [0, 1]
+// survive; widths that aren't a multiple of BakeTileSize cover the partial last span.
+
+using namespace ShaderGraph;
+
+namespace {
+
+struct Pixel {
+    double u, v;
+};
+
+using Reference = std::function<void(const Pixel&, double rgba[4])>;
+
+// Largest difference between the bake and the reference, relative above magnitude 1
+double bakeError(const IRModule& module, const std::vector<UniformParameter>& parameters, const Reference& reference,
+                 uint32_t width, uint32_t height, unsigned threads = 1) {
+    BakeOptions options;
+    options.width = width;
+    options.height = height;
+    options.mipmaps = false;
+    options.threads = threads;
+    options.format = TextureFormat::RGBA16F;
+    options.time = 0.75f;
+    TextureImage image;
+    std::string error;
+    if (!bakeModule(module, parameters, options, image, error)) {
+        std::fprintf(stderr, "bake failed: %s\n", error.c_str());
+        return INFINITY;
+    }
+    double worst = 0.0;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            // Pixel centers, v = 0 on the top row, computed the way the baker does in float
+            const Pixel pixel = {(static_cast<float>(x) + 0.5f) * (1.0f / static_cast<float>(width)),
+                                 (static_cast<float>(y) + 0.5f) / static_cast<float>(height)};
+            double expected[4];
+            reference(pixel, expected);
+            for (int c = 0; c < 4; ++c) {
+                uint16_t half;
+                std::memcpy(&half, image.levelData(0) + ((size_t(y) * width + x) * 4 + c) * 2, sizeof(half));
+                const double got = halfToFloat(half);
+                worst = std::max(worst, std::fabs(got - expected[c]) / std::max(1.0, std::fabs(expected[c])));
+            }
+        }
+    }
+    return worst;
+}
+
+// Half floats keep 11 significant bits
+constexpr double Tolerance = 2e-3;
+
+struct Graph {
+    IRModule module;
+    IRBuilder ir{module};
+    IRValue u = IRNone, v = IRNone;
+
+    Graph() {
+        const IRValue uv = ir.input("TexCoord", ShaderDataType::Vec2);
+        u = ir.swizzle(uv, "x");
+        v = ir.swizzle(uv, "y");
+    }
+};
+
+} // namespace
+
+TEST(arithmeticKernels) {
+    Graph g;
+    IRBuilder& ir = g.ir;
+    const IRValue color = ir.makeVec3(ir.add(g.u, g.v), ir.sub(g.u, ir.mul(g.v, ir.constant(2.0f))),
+                                      ir.div(ir.mul(g.u, g.v), ir.add(g.v, ir.constant(0.5f))));
+    ir.setOutput(color, ir.div(ir.constant(1.0f), ir.add(g.u, ir.constant(0.25f))));
+    const Reference reference = [](const Pixel& p, double out[4]) {
+        out[0] = p.u + p.v;
+        out[1] = p.u - p.v * 2.0;
+        out[2] = p.u * p.v / (p.v + 0.5);
+        out[3] = 1.0 / (p.u + 0.25);
+    };
+    CHECK(bakeError(g.module, {}, reference, 37, 5) < Tolerance);
+}
+
+TEST(minMaxAbsClampKernels) {
+    Graph g;
+    IRBuilder& ir = g.ir;
+    const IRValue color = ir.makeVec3(ir.min(g.u, g.v), ir.max(g.u, ir.constant(0.3f)),
+                                      ir.unary(IROp::Abs, ir.sub(g.u, g.v)));
+    const IRValue alpha = ir.clamp(ir.sub(ir.mul(g.u, ir.constant(3.0f)), ir.constant(1.0f)), ir.constant(0.2f), ir.constant(0.8f));
+    ir.setOutput(color, alpha);
+    const Reference reference = [](const Pixel& p, double out[4]) {
+        out[0] = std::min(p.u, p.v);
+        out[1] = std::max(p.u, 0.3);
+        out[2] = std::fabs(p.u - p.v);
+        out[3] = std::min(std::max(p.u * 3.0 - 1.0, 0.2), 0.8);
+    };
+    CHECK(bakeError(g.module, {}, reference, 19, 7) < Tolerance);
+}
+
+TEST(trigonometryKernels) {
+    // Arguments well outside [-pi, pi], to exercise the range reduction
+    Graph g;
+    IRBuilder& ir = g.ir;
+    const IRValue color = ir.makeVec3(ir.unary(IROp::Sin, ir.sub(ir.mul(g.u, ir.constant(40.0f)), ir.constant(20.0f))),
+                                      ir.unary(IROp::Cos, ir.add(ir.mul(g.v, ir.constant(30.0f)), ir.constant(5.0f))),
+                                      ir.unary(IROp::Sin, ir.mul(ir.mul(g.u, g.v), ir.constant(200.0f))));
+    ir.setOutput(color, ir.unary(IROp::Cos, ir.mul(g.u, ir.constant(-90.0f))));
+    const Reference reference = [](const Pixel& p, double out[4]) {
+        out[0] = std::sin(static_cast<float>(p.u * 40.0f) - 20.0f);
+        out[1] = std::cos(static_cast<float>(p.v * 30.0f) + 5.0f);
+        out[2] = std::sin(static_cast<float>(static_cast<float>(p.u * p.v) * 200.0f));
+        out[3] = std::cos(static_cast<float>(p.u * -90.0f));
+    };
+    CHECK(bakeError(g.module, {}, reference, 64, 16) < Tolerance);
+}
+
+TEST(powMixKernels) {
+    Graph g;
+    IRBuilder& ir = g.ir;
+    const IRValue a = ir.constant(0.1f, 0.9f, -0.5f);
+    const IRValue b = ir.makeVec3(g.u, g.v, ir.constant(2.0f));
+    const IRValue mixed = ir.mix(a, b, g.u);    // Scalar t broadcast over vec3
+    ir.setOutput(mixed, ir.pow(ir.add(g.u, ir.constant(0.1f)), ir.mul(g.v, ir.constant(3.0f))));
+    const Reference reference = [](const Pixel& p, double out[4]) {
+        const double from[3] = {0.1, 0.9, -0.5}, to[3] = {p.u, p.v, 2.0};
+        for (int c = 0; c < 3; ++c) out[c] = from[c] * (1.0 - p.u) + to[c] * p.u;
+        out[3] = std::pow(p.u + 0.1, p.v * 3.0);
+    };
+    CHECK(bakeError(g.module, {}, reference, 23, 9) < Tolerance);
+}
+
+TEST(normalizeDotKernels) {
+    Graph g;
+    IRBuilder& ir = g.ir;
+    const IRValue n = ir.unary(IROp::Normalize, ir.makeVec3(ir.sub(g.u, ir.constant(0.5f)), ir.sub(g.v, ir.constant(0.5f)),
+                                                           ir.constant(0.25f)));
+    ir.setOutput(n, ir.dot(n, ir.constant(0.3f, 0.5f, 0.8f)));
+    const Reference reference = [](const Pixel& p, double out[4]) {
+        const double x = p.u - 0.5, y = p.v - 0.5, z = 0.25;
+        const double length = std::sqrt(x * x + y * y + z * z);
+        out[0] = x / length;
+        out[1] = y / length;
+        out[2] = z / length;
+        out[3] = (0.3 * x + 0.5 * y + 0.8 * z) / length;
+    };
+    CHECK(bakeError(g.module, {}, reference, 33, 4) < Tolerance);
+}
+
+TEST(uniformsAndBuiltins) {
+    Graph g;
+    IRBuilder& ir = g.ir;
+    const IRValue scale = ir.uniform("u_scale", ShaderDataType::Float);
+    const IRValue tint = ir.uniform("u_tint", ShaderDataType::Vec3);
+    const IRValue time = ir.uniform("time", ShaderDataType::Float);
+    const IRValue unset = ir.uniform("u_unset", ShaderDataType::Float);
+    ir.setOutput(ir.mul(tint, ir.mul(g.u, scale)), ir.add(ir.unary(IROp::Sin, ir.add(time, g.v)), unset));
+    std::vector<UniformParameter> parameters = {UniformParameter::Float("u_scale", "Scale", 2.5f, 0.0f, 10.0f),
+                                                UniformParameter::Vec3("u_tint", "Tint", 0.2f, 0.4f, 0.6f)};
+    const Reference reference = [](const Pixel& p, double out[4]) {
+        const double tint[3] = {0.2f, 0.4f, 0.6f};
+        for (int c = 0; c < 3; ++c) out[c] = tint[c] * p.u * 2.5;
+        out[3] = std::sin(0.75 + p.v);
+    };
+    CHECK(bakeError(g.module, parameters, reference, 17, 3) < Tolerance);
+}
+
+TEST(textureKernelIsBilinearRepeat) {
+    // 3x2 TGA (bottom row first in the file)
+    const uint8_t texels[2][3][4] = {{{255, 0, 0, 255}, {0, 255, 0, 128}, {0, 0, 255, 0}},
+                                     {{10, 20, 30, 40}, {200, 100, 50, 25}, {255, 255, 255, 255}}};
+    const std::string path = (std::filesystem::temp_directory_path() / "shadergraph_bake_test.tga").string();
+    {
+        uint8_t header[18] = {};
+        header[2] = 2;
+        header[12] = 3;
+        header[14] = 2;
+        header[16] = 32;
+        header[17] = 0x20;  // Top row first
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(header), sizeof(header));
+        for (const auto& row : texels) {
+            for (const auto& texel : row) {
+                const uint8_t bgra[4] = {texel[2], texel[1], texel[0], texel[3]};
+                file.write(reinterpret_cast<const char*>(bgra), 4);
+            }
+        }
+    }
+    Graph g;
+    IRBuilder& ir = g.ir;
+    // Coordinates beyond [0, 1] on both sides read the repeated texture
+    const IRValue uv = ir.sub(ir.mul(ir.input("TexCoord", ShaderDataType::Vec2), ir.constant(2.5f)), ir.constant(0.7f));
+    const IRValue sample = ir.texture("u_tex", uv);
+    ir.setOutput(ir.swizzle(sample, "xyz"), ir.swizzle(sample, "w"));
+    std::vector<UniformParameter> parameters = {UniformParameter::Sampler2D("u_tex", "Texture", 0, path)};
+    const Reference reference = [&texels](const Pixel& p, double out[4]) {
+        const double u = static_cast<float>(p.u * 2.5f) - 0.7f, v = static_cast<float>(p.v * 2.5f) - 0.7f;
+        const double x = (u - std::floor(u)) * 3.0 - 0.5, y = (v - std::floor(v)) * 2.0 - 0.5;
+        const double fx = std::floor(x), fy = std::floor(y);
+        const int x0 = (static_cast<int>(fx) + 3) % 3, y0 = (static_cast<int>(fy) + 2) % 2;
+        const int x1 = (x0 + 1) % 3, y1 = (y0 + 1) % 2;
+        const double tx = x - fx, ty = y - fy;
+        for (int c = 0; c < 4; ++c) {
+            const double top = texels[y0][x0][c] + (texels[y0][x1][c] - texels[y0][x0][c]) * tx;
+            const double bottom = texels[y1][x0][c] + (texels[y1][x1][c] - texels[y1][x0][c]) * tx;
+            out[c] = (top + (bottom - top) * ty) / 255.0;
+        }
+    };
+    CHECK(bakeError(g.module, parameters, reference, 29, 11) < Tolerance);
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+TEST(threadsDoNotChangeTheResult) {
+    Graph g;
+    IRBuilder& ir = g.ir;
+    const IRValue wave = ir.unary(IROp::Sin, ir.mul(ir.add(g.u, ir.mul(g.v, g.v)), ir.constant(25.0f)));
+    ir.setOutput(ir.makeVec3(wave, g.u, g.v), ir.constant(1.0f));
+    BakeOptions options;
+    options.width = 45;
+    options.height = 31;
+    TextureImage single, pooled;
+    std::string error;
+    options.threads = 1;
+    REQUIRE(bakeModule(g.module, {}, options, single, error));
+    options.threads = 4;
+    REQUIRE(bakeModule(g.module, {}, options, pooled, error));
+    CHECK(single.levels.size() == textureMipCount(45, 31));
+    CHECK(single.pixels == pooled.pixels);
+}
+
+int main() {
+    std::printf("kernels: %s\n", bakeKernelName());
+    return TestHarness::runAll();
+}
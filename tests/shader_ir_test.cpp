@@ -0,0 +1,219 @@
+#include "shader_lang.h"
+#include "test_harness.h"
+#include <cfloat>
+#include <string>
+#include <vector>
+
+// IRBuilder's folding, identities and CSE, which shape the code of every graph, and
+// IREmitter's fragment cache: output from an emitter that has seen other modules and
+// targets must match a fresh emitter's, and an edit must only reformat what it changes.
+
+using namespace ShaderGraph;
+
+namespace {
+
+bool isConstant(const IRModule& module, IRValue value, float x, float y = NAN, float z = NAN) {
+    const IRInstr& instr = module.at(value);
+    if (instr.op != IROp::Const) return false;
+    if (std::isnan(y)) return instr.type == ShaderDataType::Float && instr.constant[0] == x;
+    return instr.type == ShaderDataType::Vec3 && instr.constant[0] == x && instr.constant[1] == y && instr.constant[2] == z;
+}
+
+bool isOp(const IRModule& module, IRValue value, IROp op, ShaderDataType type) {
+    return module.at(value).op == op && module.at(value).type == type;
+}
+
+// sin(tint) at half precision on the reduced-precision targets
+void buildTinted(IRModule& module) {
+    IRBuilder ir(module);
+    const IRValue tint = ir.uniform("tint", ShaderDataType::Vec3);
+    ir.setOutput(ir.unary(IROp::Sin, tint), ir.constant(1.0f));
+}
+
+std::string hlsl(IREmitter& emitter, const IRModule& module, ShaderTarget target) {
+    CrossPlatformShaderGenerator generator;
+    CodeWriter out;
+    generator.writeHLSL(out, emitter, module, {}, PrecisionPolicy::forTarget(target));
+    return out.str();
+}
+
+std::string freshHLSL(const IRModule& module, ShaderTarget target) {
+    IREmitter emitter(IREmitter::Language::HLSL);
+    return hlsl(emitter, module, target);
+}
+
+// A chain of stages, two computed values each; stage k is node k, and inserted (when not
+// negative) adds node 1000 before stage inserted. Origins are positions, as in the editor.
+void buildChain(IRModule& module, int stages, int inserted) {
+    IRBuilder ir(module);
+    IRValue value = ir.input("TexCoord", ShaderDataType::Vec2);
+    value = ir.swizzle(value, "x");
+    int position = 0;
+    for (int k = 0; k < stages; ++k) {
+        if (k == inserted) {
+            ir.setOrigin(position++, 1000);
+            value = ir.mul(value, ir.constant(2.0f));
+        }
+        ir.setOrigin(position++, k);
+        value = ir.add(ir.unary(IROp::Sin, value), ir.constant(static_cast<float>(k) * 0.01f));
+    }
+    ir.setOrigin(-1);
+    ir.setOutput(ir.makeVec3(value, value, value), ir.constant(1.0f));
+}
+
+} // namespace
+
+TEST(constantSubtreesFold) {
+    IRModule module;
+    IRBuilder ir(module);
+    CHECK(isConstant(module, ir.add(ir.constant(2.0f), ir.constant(3.0f)), 5.0f));
+    CHECK(isConstant(module, ir.sub(ir.constant(2.0f), ir.constant(3.0f)), -1.0f));
+    CHECK(isConstant(module, ir.div(ir.constant(3.0f), ir.constant(4.0f)), 0.75f));
+    CHECK(isConstant(module, ir.pow(ir.constant(2.0f), ir.constant(10.0f)), 1024.0f));
+    CHECK(isConstant(module, ir.min(ir.constant(2.0f), ir.constant(-3.0f)), -3.0f));
+    // A scalar broadcasts over the vector operand
+    CHECK(isConstant(module, ir.mul(ir.constant(1.0f, 2.0f, 3.0f), ir.constant(2.0f)), 2.0f, 4.0f, 6.0f));
+    CHECK(isConstant(module, ir.unary(IROp::Abs, ir.constant(-1.5f, 0.0f, 2.0f)), 1.5f, 0.0f, 2.0f));
+    CHECK(isConstant(module, ir.unary(IROp::Cos, ir.constant(0.0f)), 1.0f));
+    CHECK(isConstant(module, ir.mix(ir.constant(0.0f, 2.0f, 4.0f), ir.constant(4.0f, 2.0f, 0.0f), ir.constant(0.25f)),
+                     1.0f, 2.0f, 3.0f));
+    CHECK(isConstant(module, ir.clamp(ir.constant(-1.0f, 0.5f, 3.0f), ir.constant(0.0f), ir.constant(1.0f)), 0.0f, 0.5f, 1.0f));
+    CHECK(isConstant(module, ir.makeVec3(ir.constant(1.0f), ir.constant(2.0f), ir.constant(3.0f)), 1.0f, 2.0f, 3.0f));
+    const IRValue zx = ir.swizzle(ir.constant(1.0f, 2.0f, 3.0f), "zx");
+    CHECK(module.at(zx).op == IROp::Const && module.at(zx).type == ShaderDataType::Vec2);
+    CHECK(module.at(zx).constant[0] == 3.0f && module.at(zx).constant[1] == 1.0f);
+
+    // Nothing that isn't constant folds
+    const IRValue x = ir.uniform("x", ShaderDataType::Float);
+    CHECK(isOp(module, ir.add(x, ir.constant(1.0f)), IROp::Add, ShaderDataType::Float));
+    CHECK(isOp(module, ir.unary(IROp::Normalize, ir.constant(3.0f, 0.0f, 4.0f)), IROp::Normalize, ShaderDataType::Vec3));
+}
+
+TEST(nonFiniteResultsStayInstructions) {
+    // The GPU's answer for these differs from the host's, and a literal can't spell them
+    IRModule module;
+    IRBuilder ir(module);
+    CHECK(isOp(module, ir.div(ir.constant(1.0f), ir.constant(0.0f)), IROp::Div, ShaderDataType::Float));
+    CHECK(isOp(module, ir.div(ir.constant(0.0f), ir.constant(0.0f)), IROp::Div, ShaderDataType::Float));
+    CHECK(isOp(module, ir.pow(ir.constant(-1.0f), ir.constant(0.5f)), IROp::Pow, ShaderDataType::Float));
+    CHECK(isOp(module, ir.mul(ir.constant(FLT_MAX), ir.constant(2.0f)), IROp::Mul, ShaderDataType::Float));
+    CHECK(isOp(module, ir.sub(ir.constant(-FLT_MAX, 0.0f, 0.0f), ir.constant(FLT_MAX)), IROp::Sub, ShaderDataType::Vec3));
+    CHECK(isOp(module, ir.unary(IROp::Sin, ir.constant(INFINITY)), IROp::Sin, ShaderDataType::Float));
+    const IRValue nan = ir.div(ir.constant(0.0f), ir.constant(0.0f));
+    CHECK(isOp(module, ir.add(nan, ir.constant(1.0f)), IROp::Add, ShaderDataType::Float));
+    CHECK(isOp(module, ir.mix(ir.constant(FLT_MAX), ir.constant(-FLT_MAX), ir.constant(-1.0f)), IROp::Mix,
+               ShaderDataType::Float));
+    CHECK(isOp(module, ir.clamp(ir.constant(NAN), ir.constant(0.0f), ir.constant(1.0f)), IROp::Clamp, ShaderDataType::Float));
+}
+
+TEST(identitiesKeepTheResultType) {
+    IRModule module;
+    IRBuilder ir(module);
+    const IRValue x = ir.uniform("x", ShaderDataType::Float);
+    const IRValue v = ir.uniform("v", ShaderDataType::Vec3);
+    const IRValue zero = ir.constant(0.0f), one = ir.constant(1.0f);
+    CHECK(ir.add(x, zero) == x);
+    CHECK(ir.add(zero, v) == v);
+    CHECK(ir.sub(v, zero) == v);
+    CHECK(ir.mul(one, x) == x);
+    CHECK(ir.mul(v, one) == v);
+    CHECK(ir.div(v, one) == v);
+    CHECK(ir.pow(x, one) == x);
+    CHECK(ir.mix(x, ir.uniform("y", ShaderDataType::Float), zero) == x);
+    CHECK(ir.mix(ir.uniform("w", ShaderDataType::Vec3), v, one) == v);
+
+    // Not identities
+    CHECK(isOp(module, ir.sub(zero, x), IROp::Sub, ShaderDataType::Float));
+    CHECK(isOp(module, ir.div(one, x), IROp::Div, ShaderDataType::Float));
+    // A vector of ones or zeros would widen a scalar, so the scalar can't stand in
+    CHECK(isOp(module, ir.mul(x, ir.constant(1.0f, 1.0f, 1.0f)), IROp::Mul, ShaderDataType::Vec3));
+    CHECK(isOp(module, ir.add(ir.constant(0.0f, 0.0f, 0.0f), x), IROp::Add, ShaderDataType::Vec3));
+    // mix(scalar, vec3, 0) is a vec3
+    CHECK(isOp(module, ir.mix(x, v, zero), IROp::Mix, ShaderDataType::Vec3));
+    CHECK(isOp(module, ir.mix(v, x, one), IROp::Mix, ShaderDataType::Vec3));
+}
+
+TEST(identicalSubexpressionsAreShared) {
+    IRModule module;
+    IRBuilder ir(module);
+    const IRValue uv = ir.input("TexCoord", ShaderDataType::Vec2);
+    const IRValue u = ir.swizzle(uv, "x"), v = ir.swizzle(uv, "y");
+    CHECK(ir.input("TexCoord", ShaderDataType::Vec2) == uv);
+    CHECK(ir.swizzle(uv, "r") == u);
+    CHECK(ir.swizzle(ir.swizzle(uv, "yx"), "y") == u);
+    const IRValue sum = ir.add(u, v);
+    CHECK(ir.add(v, u) == sum);     // Commutative operands are ordered
+    CHECK(ir.mul(u, v) == ir.mul(v, u));
+    const IRValue n = ir.input("Normal", ShaderDataType::Vec3);
+    CHECK(ir.dot(n, ir.constant(1.0f, 2.0f, 3.0f)) == ir.dot(ir.constant(1.0f, 2.0f, 3.0f), n));
+    CHECK(ir.sub(u, v) != ir.sub(v, u));
+    CHECK(ir.unary(IROp::Sin, sum) == ir.unary(IROp::Sin, ir.add(v, u)));
+    CHECK(ir.unary(IROp::Sin, sum) != ir.unary(IROp::Cos, sum));
+    CHECK(ir.constant(0.5f) == ir.constant(0.5f));
+    CHECK(ir.constant(0.0f) != ir.constant(-0.0f));
+    CHECK(ir.uniform("a", ShaderDataType::Float) != ir.uniform("a", ShaderDataType::Vec3));
+
+    // Built twice, emitted once
+    const size_t before = module.instrs.size();
+    const IRValue wave = ir.unary(IROp::Sin, ir.mul(ir.add(u, v), ir.constant(4.0f)));
+    CHECK(ir.unary(IROp::Sin, ir.mul(ir.constant(4.0f), ir.add(v, u))) == wave);
+    CHECK(module.instrs.size() == before + 3);
+    ir.setOutput(ir.makeVec3(wave, ir.unary(IROp::Sin, ir.mul(ir.add(u, v), ir.constant(4.0f))), wave), ir.constant(1.0f));
+    IREmitter emitter(IREmitter::Language::GLSL);
+    const std::string body = emitter.emitBody(module);
+    CHECK(body.find("sin(") == body.rfind("sin("));
+    CHECK(body.find("vec3(v2, v2, v2)") != std::string::npos);
+}
+
+TEST(halfSpellingFollowsTheTarget) {
+    IRModule module;
+    buildTinted(module);
+    IREmitter emitter(IREmitter::Language::HLSL);
+    const std::string console = hlsl(emitter, module, ShaderTarget::Console);
+    const std::string mobile = hlsl(emitter, module, ShaderTarget::Mobile);
+    const std::string consoleAgain = hlsl(emitter, module, ShaderTarget::Console);
+    CHECK(console.find("half3 ") != std::string::npos);
+    CHECK(mobile.find("min16float3 ") != std::string::npos);
+    CHECK(mobile.find("half3 ") == std::string::npos);
+    CHECK(console == freshHLSL(module, ShaderTarget::Console));
+    CHECK(mobile == freshHLSL(module, ShaderTarget::Mobile));
+    CHECK(consoleAgain == console);
+    CHECK(hlsl(emitter, module, ShaderTarget::Desktop) == freshHLSL(module, ShaderTarget::Desktop));
+}
+
+TEST(insertedNodeKeepsLaterFragments) {
+    IRModule before, after;
+    buildChain(before, 200, -1);
+    buildChain(after, 200, 10);
+    IREmitter emitter(IREmitter::Language::GLSL);
+    emitter.emitBody(before);
+    const IREmitter::CacheStats first = emitter.getCacheStats();
+    const std::string body = emitter.emitBody(after);
+    const size_t misses = emitter.getCacheStats().misses - first.misses;
+
+    // The inserted multiply and its literal, and the sin reading it
+    CHECK(misses <= 3);
+    CHECK(emitter.getCacheStats().hits - first.hits >= 600);
+    IREmitter fresh(IREmitter::Language::GLSL);
+    CHECK(body == fresh.emitBody(after));
+    CHECK(body.find("float v1000_0 = (v9_1 * 2.0);") != std::string::npos);
+    CHECK(body.find("float v10_0 = sin(v1000_0);") != std::string::npos);
+}
+
+TEST(unnamedValuesAreNumberedInOrder) {
+    IRModule module;
+    IRBuilder ir(module);
+    const IRValue uv = ir.input("TexCoord", ShaderDataType::Vec2);
+    const IRValue wave = ir.unary(IROp::Sin, ir.swizzle(uv, "x"));
+    ir.setOutput(ir.makeVec3(wave, wave, ir.unary(IROp::Cos, wave)), ir.constant(1.0f));
+    IREmitter emitter(IREmitter::Language::GLSL);
+    const std::string body = emitter.emitBody(module);
+    CHECK(body.find("float v0 = sin(TexCoord.x);") != std::string::npos);
+    CHECK(body.find("float v1 = cos(v0);") != std::string::npos);
+    CHECK(body.find("vec3 v2 = vec3(v0, v0, v1);") != std::string::npos);
+    CHECK(emitter.emitBody(module) == body);
+}
+
+int main() {
+    return TestHarness::runAll();
+}
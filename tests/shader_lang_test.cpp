@@ -0,0 +1,57 @@
+#include "shader_lang.h"
+#include "test_harness.h"
+#include <string>
+
+// The HLSL/GLSL text converters against golden strings: renames apply to whole
+// identifiers only, saturate and tex2D rewrite their (possibly nested) arguments, and
+// semantics are stripped without touching other uses of ':'.
+
+using ShaderGraph::GLSLtoHLSLConverter;
+using ShaderGraph::HLSLtoGLSLConverter;
+
+TEST(functionsAndTypesAreRenamed) {
+    CHECK(HLSLtoGLSLConverter::convert("float3 c = lerp(a, b, frac(t));") == "vec3 c = mix(a, b, fract(t));");
+    CHECK(HLSLtoGLSLConverter::convert("half2 d = ddx(uv) + atan2(y, x) * rsqrt(r);") ==
+          "vec2 d = dFdx(uv) + atan(y, x) * inversesqrt(r);");
+    CHECK(HLSLtoGLSLConverter::convert("float4x4 m;\nint3 i;\tbool2 b;") == "mat4 m;\nivec3 i;\tbvec2 b;");
+    CHECK(HLSLtoGLSLConverter::convert("lerp(lerp(a,b,t),frac(frac(c)),0.5)") == "mix(mix(a,b,t),fract(fract(c)),0.5)");
+    CHECK(GLSLtoHLSLConverter::convert("vec3 c = mix(a, b, fract(t)); mat3 n; float k = mod(x, 2.0);") ==
+          "float3 c = lerp(a, b, frac(t)); float3x3 n; float k = fmod(x, 2.0);");
+}
+
+TEST(partialIdentifiersAreLeftAlone) {
+    const std::string hlsl = "float lerpAmount = myfrac + frac_2 + fraction + _lerp + lerp2;\n"
+                             "float3x v = halfway * float3_scale;\n"
+                             "saturated = unsaturate(x) + saturate_(y) + tex2Dlod(s, uv);";
+    CHECK(HLSLtoGLSLConverter::convert(hlsl) == hlsl);
+    const std::string glsl = "float mixture = remix + fractal + vec3ish + modulo;";
+    CHECK(GLSLtoHLSLConverter::convert(glsl) == glsl);
+    // Renames stop at every non-identifier character
+    CHECK(HLSLtoGLSLConverter::convert("frac.x+lerp[0]-float3") == "fract.x+mix[0]-vec3");
+}
+
+TEST(saturateBecomesClamp) {
+    CHECK(HLSLtoGLSLConverter::convert("saturate(x)") == "clamp(x, 0.0, 1.0)");
+    CHECK(HLSLtoGLSLConverter::convert("saturate(saturate(x))") == "clamp(clamp(x, 0.0, 1.0), 0.0, 1.0)");
+    CHECK(HLSLtoGLSLConverter::convert("saturate( saturate (x) * 2.0 )") == "clamp(clamp(x, 0.0, 1.0) * 2.0, 0.0, 1.0)");
+    CHECK(HLSLtoGLSLConverter::convert("saturate(lerp(a, frac(b), saturate(t)))") ==
+          "clamp(mix(a, fract(b), clamp(t, 0.0, 1.0)), 0.0, 1.0)");
+    CHECK(HLSLtoGLSLConverter::convert("float3 c = saturate(tex2D(albedo, uv).rgb);") ==
+          "vec3 c = clamp(texture(albedo, uv).rgb, 0.0, 1.0);");
+    // Without a balanced call there is nothing to rewrite
+    CHECK(HLSLtoGLSLConverter::convert("saturate(x") == "saturate(x");
+    CHECK(HLSLtoGLSLConverter::convert("saturate + 1") == "saturate + 1");
+}
+
+TEST(semanticsAreStripped) {
+    CHECK(HLSLtoGLSLConverter::convert("float4 position : SV_POSITION;") == "vec4 position;");
+    CHECK(HLSLtoGLSLConverter::convert("float2 uv :TEXCOORD1, float3 n : NORMAL") == "vec2 uv, vec3 n");
+    CHECK(HLSLtoGLSLConverter::convert("float4 main() : SV_Target") == "vec4 main()");
+    // Only semantics go
+    CHECK(HLSLtoGLSLConverter::convert("x = a ? b : c;") == "x = a ? b : c;");
+    CHECK(HLSLtoGLSLConverter::convert("x = a ? b : COLORFUL;") == "x = a ? b : COLORFUL;");
+}
+
+int main() {
+    return TestHarness::runAll();
+}
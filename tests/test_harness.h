@@ -0,0 +1,63 @@
+#ifndef TEST_HARNESS_H
+#define TEST_HARNESS_H
+
+#include <cstdio>
+#include <vector>
+
+// Just enough of a test runner for the ctest targets. TEST(name) registers a case,
+// CHECK reports a failed condition and carries on, REQUIRE also leaves the case.
+// main() returns non-zero when any check failed.
+
+namespace TestHarness {
+
+struct Case {
+    const char* name;
+    void (*run)();
+};
+
+inline std::vector<Case>& cases() {
+    static std::vector<Case> list;
+    return list;
+}
+
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+struct Registration {
+    Registration(const char* name, void (*run)()) { cases().push_back({name, run}); }
+};
+
+inline bool check(bool ok, const char* expression, const char* file, int line) {
+    if (!ok) {
+        std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        failures()++;
+    }
+    return ok;
+}
+
+inline int runAll() {
+    for (const Case& test : cases()) {
+        const int before = failures();
+        test.run();
+        std::printf("%s %s\n", failures() == before ? "pass" : "FAIL", test.name);
+    }
+    std::printf("%zu cases, %d failed checks\n", cases().size(), failures());
+    return failures() == 0 ? 0 : 1;
+}
+
+} // namespace TestHarness
+
+#define TEST(name)                                                               \
+    static void name();                                                          \
+    static const TestHarness::Registration name##Registration(#name, name);      \
+    static void name()
+
+#define CHECK(expression) TestHarness::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+#define REQUIRE(expression)                 \
+    do {                                    \
+        if (!CHECK(expression)) return;     \
+    } while (0)
+
+#endif // TEST_HARNESS_H
@@ -0,0 +1,362 @@
+#include "texture_image.h"
+#include "test_harness.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <random>
+
+// Container decoding against hand-built files: every level must come from the offset
+// the container gives it and land at the offset a plain per-level layout predicts, and
+// uncompressed pixels must match a straightforward per-pixel conversion.
+
+using namespace ShaderGraph;
+
+namespace {
+
+struct Block {
+    uint32_t width, height, bytes;
+};
+
+Block blockOf(TextureFormat format) {
+    switch (format) {
+        case TextureFormat::RGBA8: return {1, 1, 4};
+        case TextureFormat::RGBA16F: return {1, 1, 8};
+        case TextureFormat::BC1:
+        case TextureFormat::BC4: return {4, 4, 8};
+        case TextureFormat::ASTC5x5: return {5, 5, 16};
+        case TextureFormat::ASTC8x8: return {8, 8, 16};
+        default: return {4, 4, 16};
+    }
+}
+
+struct ReferenceLevel {
+    uint32_t width, height;
+    size_t offset, size;
+};
+
+std::vector<ReferenceLevel> referenceLayout(TextureFormat format, uint32_t width, uint32_t height, uint32_t count) {
+    const Block block = blockOf(format);
+    std::vector<ReferenceLevel> levels;
+    size_t offset = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t w = std::max(1u, width >> i), h = std::max(1u, height >> i);
+        const size_t size = size_t((w + block.width - 1) / block.width) * ((h + block.height - 1) / block.height) * block.bytes;
+        levels.push_back({w, h, offset, size});
+        offset += size;
+    }
+    return levels;
+}
+
+uint8_t pattern(size_t level, size_t i) {
+    return static_cast<uint8_t>(level * 31 + i * 7 + 1);
+}
+
+void put32(std::vector<uint8_t>& file, size_t offset, uint32_t value) {
+    if (file.size() < offset + 4) file.resize(offset + 4);
+    std::memcpy(file.data() + offset, &value, 4);
+}
+
+void put64(std::vector<uint8_t>& file, size_t offset, uint64_t value) {
+    if (file.size() < offset + 8) file.resize(offset + 8);
+    std::memcpy(file.data() + offset, &value, 8);
+}
+
+// DDS header; fourCC 0 means uncompressed with the given bit count and masks
+std::vector<uint8_t> ddsHeader(uint32_t width, uint32_t height, uint32_t mips, const char* fourCC, uint32_t bitCount = 0,
+                               const uint32_t masks[4] = nullptr) {
+    std::vector<uint8_t> file(128, 0);
+    std::memcpy(file.data(), "DDS ", 4);
+    put32(file, 4, 124);
+    put32(file, 8, 0x1007 | (mips > 1 ? 0x20000u : 0u));
+    put32(file, 12, height);
+    put32(file, 16, width);
+    put32(file, 28, mips);
+    put32(file, 76, 32);
+    if (fourCC) {
+        put32(file, 80, 0x4);
+        std::memcpy(file.data() + 84, fourCC, 4);
+    } else {
+        put32(file, 80, 0x40 | (masks[3] ? 0x1u : 0u));
+        put32(file, 88, bitCount);
+        for (int c = 0; c < 4; ++c) put32(file, 92 + 4 * c, masks[c]);
+    }
+    return file;
+}
+
+// Decoded levels sit where the reference layout puts them and hold the pattern bytes
+bool levelsMatch(const TextureImage& image, TextureFormat format, uint32_t width, uint32_t height, uint32_t count) {
+    const std::vector<ReferenceLevel> reference = referenceLayout(format, width, height, count);
+    if (image.format != format || image.levels.size() != reference.size()) return false;
+    if (image.pixels.size() != reference.back().offset + reference.back().size) return false;
+    for (size_t i = 0; i < reference.size(); ++i) {
+        const TextureLevel& level = image.levels[i];
+        if (level.width != reference[i].width || level.height != reference[i].height || level.offset != reference[i].offset ||
+            level.size != reference[i].size) {
+            return false;
+        }
+        for (size_t b = 0; b < level.size; ++b) {
+            if (image.pixels[level.offset + b] != pattern(i, b)) return false;
+        }
+    }
+    return true;
+}
+
+bool decodes(const std::vector<uint8_t>& file, TextureImage& image) {
+    std::string error;
+    return decodeTexture(file.data(), file.size(), image, error) && error.empty();
+}
+
+bool rejectsTruncated(const std::vector<uint8_t>& file) {
+    TextureImage image;
+    std::string error;
+    return !decodeTexture(file.data(), file.size() - 1, image, error) && !error.empty();
+}
+
+std::vector<uint8_t> randomPixels(size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::vector<uint8_t> pixels(count * 4);
+    for (uint8_t& byte : pixels) byte = static_cast<uint8_t>(rng());
+    return pixels;
+}
+
+// TGA of rgba (top row first); rle packs runs of equal pixels
+std::vector<uint8_t> tgaFile(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, uint32_t bytesPerPixel,
+                             bool topDown, bool rle) {
+    const bool grey = bytesPerPixel == 1;
+    std::vector<uint8_t> file(18, 0);
+    file[0] = 3;    // Image ID, skipped
+    file[2] = static_cast<uint8_t>((grey ? 3 : 2) + (rle ? 8 : 0));
+    file[12] = static_cast<uint8_t>(width);
+    file[14] = static_cast<uint8_t>(height);
+    file[16] = static_cast<uint8_t>(bytesPerPixel * 8);
+    file[17] = topDown ? 0x20 : 0;
+    file.insert(file.end(), {'i', 'd', '!'});
+
+    std::vector<std::vector<uint8_t>> pixels;
+    for (uint32_t row = 0; row < height; ++row) {
+        const uint32_t y = topDown ? row : height - 1 - row;
+        for (uint32_t x = 0; x < width; ++x) {
+            const uint8_t* p = &rgba[(size_t(y) * width + x) * 4];
+            if (grey) pixels.push_back({p[0]});
+            else if (bytesPerPixel == 3) pixels.push_back({p[2], p[1], p[0]});
+            else pixels.push_back({p[2], p[1], p[0], p[3]});
+        }
+    }
+    if (!rle) {
+        for (const auto& pixel : pixels) file.insert(file.end(), pixel.begin(), pixel.end());
+        return file;
+    }
+    for (size_t i = 0; i < pixels.size();) {
+        size_t run = 1;
+        while (i + run < pixels.size() && run < 128 && pixels[i + run] == pixels[i]) run++;
+        if (run > 1) {
+            file.push_back(static_cast<uint8_t>(0x80 | (run - 1)));
+            file.insert(file.end(), pixels[i].begin(), pixels[i].end());
+        } else {
+            while (i + run < pixels.size() && run < 128 && pixels[i + run] != pixels[i + run - 1]) run++;
+            file.push_back(static_cast<uint8_t>(run - 1));
+            for (size_t k = 0; k < run; ++k) file.insert(file.end(), pixels[i + k].begin(), pixels[i + k].end());
+        }
+        i += run;
+    }
+    return file;
+}
+
+} // namespace
+
+TEST(ddsBlockLevelsFollowTheLayout) {
+    // Odd sizes, so the small levels are partial blocks
+    for (const char* fourCC : {"DXT1", "DXT5", "ATI1", "ATI2"}) {
+        const TextureFormat format = std::strcmp(fourCC, "DXT1") == 0   ? TextureFormat::BC1
+                                     : std::strcmp(fourCC, "DXT5") == 0 ? TextureFormat::BC3
+                                     : std::strcmp(fourCC, "ATI1") == 0 ? TextureFormat::BC4
+                                                                        : TextureFormat::BC5;
+        const uint32_t width = 37, height = 10, mips = textureMipCount(width, height);
+        std::vector<uint8_t> file = ddsHeader(width, height, mips, fourCC);
+        const std::vector<ReferenceLevel> reference = referenceLayout(format, width, height, mips);
+        for (size_t i = 0; i < reference.size(); ++i) {
+            for (size_t b = 0; b < reference[i].size; ++b) file.push_back(pattern(i, b));
+        }
+        TextureImage image;
+        CHECK(decodes(file, image));
+        CHECK(levelsMatch(image, format, width, height, mips));
+        CHECK(rejectsTruncated(file));
+    }
+}
+
+TEST(ddsDx10HeaderSkipsItsExtraBytes) {
+    const uint32_t width = 16, height = 8, mips = 3;
+    std::vector<uint8_t> file = ddsHeader(width, height, mips, "DX10");
+    put32(file, 128, 98);   // BC7
+    file.resize(148);
+    const std::vector<ReferenceLevel> reference = referenceLayout(TextureFormat::BC7, width, height, mips);
+    for (size_t i = 0; i < reference.size(); ++i) {
+        for (size_t b = 0; b < reference[i].size; ++b) file.push_back(pattern(i, b));
+    }
+    TextureImage image;
+    CHECK(decodes(file, image));
+    CHECK(levelsMatch(image, TextureFormat::BC7, width, height, mips));
+    CHECK(rejectsTruncated(file));
+}
+
+TEST(ddsMaskedPixelsMatchPerPixelConversion) {
+    const uint32_t width = 5, height = 3;
+    const std::vector<uint8_t> rgba = randomPixels(width * height, 11);
+    const uint32_t bgra[4] = {0x00FF0000u, 0x0000FF00u, 0x000000FFu, 0xFF000000u};
+    const uint32_t bgr[4] = {0x00FF0000u, 0x0000FF00u, 0x000000FFu, 0};
+    for (uint32_t bytesPerPixel : {4u, 3u}) {
+        std::vector<uint8_t> file = ddsHeader(width, height, 1, nullptr, bytesPerPixel * 8, bytesPerPixel == 4 ? bgra : bgr);
+        for (size_t i = 0; i < width * height; ++i) {
+            file.push_back(rgba[i * 4 + 2]);
+            file.push_back(rgba[i * 4 + 1]);
+            file.push_back(rgba[i * 4 + 0]);
+            if (bytesPerPixel == 4) file.push_back(rgba[i * 4 + 3]);
+        }
+        TextureImage image;
+        REQUIRE(decodes(file, image));
+        REQUIRE(image.levels.size() == 1 && image.pixels.size() == rgba.size());
+        bool same = true;
+        for (size_t i = 0; i < width * height; ++i) {
+            for (int c = 0; c < 4; ++c) {
+                const uint8_t expected = c == 3 && bytesPerPixel == 3 ? 255 : rgba[i * 4 + c];
+                same = same && image.pixels[i * 4 + c] == expected;
+            }
+        }
+        CHECK(same);
+        CHECK(rejectsTruncated(file));
+    }
+}
+
+TEST(ddsWideMasksScaleWithoutOverflow) {
+    // One channel filling all 32 bits, and 24 bits, where value * 255 no longer fits 32
+    const uint32_t values[] = {0u, 1u, 0x00FFFFFFu, 0x7FFFFFFFu, 0x80000000u, 0x80808080u, 0xFFFFFFFEu, 0xFFFFFFFFu};
+    for (uint32_t bits : {32u, 24u}) {
+        const uint32_t mask = bits == 32 ? 0xFFFFFFFFu : 0x00FFFFFFu;
+        const uint32_t masks[4] = {mask, 0, 0, 0};
+        std::vector<uint8_t> file = ddsHeader(8, 1, 1, nullptr, 32, masks);
+        for (uint32_t value : values) put32(file, file.size(), value);
+        TextureImage image;
+        REQUIRE(decodes(file, image));
+        REQUIRE(image.pixels.size() == 8 * 4);
+        bool same = true;
+        for (size_t i = 0; i < 8; ++i) {
+            const double maxValue = bits == 32 ? 4294967295.0 : 16777215.0;
+            const uint8_t expected = static_cast<uint8_t>(std::lround((values[i] & mask) / maxValue * 255.0));
+            same = same && image.pixels[i * 4] == expected && image.pixels[i * 4 + 1] == 0 && image.pixels[i * 4 + 2] == 0 &&
+                   image.pixels[i * 4 + 3] == 255;
+        }
+        CHECK(same);
+    }
+}
+
+TEST(encodedDdsReadsBack) {
+    for (TextureFormat format : {TextureFormat::RGBA8, TextureFormat::RGBA16F}) {
+        TextureImage source;
+        layoutTextureLevels(source, format, 12, 5, textureMipCount(12, 5));
+        for (size_t i = 0; i < source.levels.size(); ++i) {
+            for (size_t b = 0; b < source.levels[i].size; ++b) source.pixels[source.levels[i].offset + b] = pattern(i, b);
+        }
+        std::vector<uint8_t> file;
+        std::string error;
+        REQUIRE(encodeDDS(source, file, error));
+        TextureImage image;
+        CHECK(decodes(file, image));
+        CHECK(levelsMatch(image, format, 12, 5, textureMipCount(12, 5)));
+    }
+}
+
+TEST(ktx2LevelsComeFromTheirIndexEntries) {
+    const struct {
+        uint32_t vkFormat;
+        TextureFormat format;
+    } cases[] = {{131, TextureFormat::BC1}, {146, TextureFormat::BC7}, {161, TextureFormat::ASTC5x5},
+                 {37, TextureFormat::RGBA8}, {97, TextureFormat::RGBA16F}};
+    for (const auto& test : cases) {
+        const uint32_t width = 21, height = 13, mips = 4;
+        std::vector<uint8_t> file(80 + mips * 24, 0);
+        const uint8_t identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+        std::memcpy(file.data(), identifier, 12);
+        put32(file, 12, test.vkFormat);
+        put32(file, 20, width);
+        put32(file, 24, height);
+        put32(file, 32, 0);
+        put32(file, 36, 1);
+        put32(file, 40, mips);
+        // Smallest level first in the file, as KTX2 writers store them, with padding between
+        const std::vector<ReferenceLevel> reference = referenceLayout(test.format, width, height, mips);
+        for (size_t i = reference.size(); i-- > 0;) {
+            file.resize(file.size() + 5, 0xEE);
+            put64(file, 80 + i * 24, file.size());
+            put64(file, 80 + i * 24 + 8, reference[i].size);
+            for (size_t b = 0; b < reference[i].size; ++b) file.push_back(pattern(i, b));
+        }
+        TextureImage image;
+        CHECK(decodes(file, image));
+        CHECK(levelsMatch(image, test.format, width, height, mips));
+
+        // A level running past the end of the file
+        std::vector<uint8_t> truncated = file;
+        truncated.resize(truncated.size() - 1);
+        std::string error;
+        CHECK(!decodeTexture(truncated.data(), truncated.size(), image, error) && !error.empty());
+    }
+}
+
+TEST(tgaMatchesReferencePixels) {
+    const uint32_t width = 7, height = 5;
+    std::vector<uint8_t> rgba = randomPixels(width * height, 5);
+    // Runs for the RLE packets, one crossing a row
+    for (size_t i = 3; i < 12; ++i) std::memcpy(&rgba[i * 4], &rgba[3 * 4], 4);
+    for (uint32_t bytesPerPixel : {1u, 3u, 4u}) {
+        std::vector<uint8_t> expected = rgba;
+        for (size_t i = 0; i < width * height; ++i) {
+            if (bytesPerPixel == 1) expected[i * 4 + 1] = expected[i * 4 + 2] = expected[i * 4];
+            if (bytesPerPixel != 4) expected[i * 4 + 3] = 255;
+        }
+        for (bool topDown : {false, true}) {
+            for (bool rle : {false, true}) {
+                const std::vector<uint8_t> file = tgaFile(rgba, width, height, bytesPerPixel, topDown, rle);
+                TextureImage image;
+                REQUIRE(decodes(file, image));
+                CHECK(image.width() == width && image.height() == height);
+                CHECK(image.pixels == expected);
+                CHECK(rejectsTruncated(file));
+            }
+        }
+    }
+}
+
+TEST(mipmapsMatchBoxFilter) {
+    const uint32_t width = 9, height = 6;
+    TextureImage image;
+    layoutTextureLevels(image, TextureFormat::RGBA8, width, height, 1);
+    image.pixels = randomPixels(width * height, 9);
+    generateMipmaps(image);
+    REQUIRE(image.levels.size() == textureMipCount(width, height));
+    const std::vector<ReferenceLevel> reference = referenceLayout(TextureFormat::RGBA8, width, height, textureMipCount(width, height));
+    for (size_t i = 1; i < reference.size(); ++i) {
+        const ReferenceLevel& src = reference[i - 1];
+        const ReferenceLevel& dst = reference[i];
+        REQUIRE(image.levels[i].offset == dst.offset && image.levels[i].width == dst.width);
+        bool same = true;
+        for (uint32_t y = 0; y < dst.height; ++y) {
+            for (uint32_t x = 0; x < dst.width; ++x) {
+                for (int c = 0; c < 4; ++c) {
+                    uint32_t sum = 0;
+                    for (uint32_t dy = 0; dy < 2; ++dy) {
+                        for (uint32_t dx = 0; dx < 2; ++dx) {
+                            const uint32_t sx = std::min(x * 2 + dx, src.width - 1), sy = std::min(y * 2 + dy, src.height - 1);
+                            sum += image.pixels[src.offset + (size_t(sy) * src.width + sx) * 4 + c];
+                        }
+                    }
+                    same = same && image.pixels[dst.offset + (size_t(y) * dst.width + x) * 4 + c] == (sum + 2) / 4;
+                }
+            }
+        }
+        CHECK(same);
+    }
+}
+
+int main() {
+    return TestHarness::runAll();
+}
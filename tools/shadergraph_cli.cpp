@@ -0,0 +1,482 @@
+// Headless batch compiler: turns .sgraph/.sgraphb files into GLSL/HLSL shaders on a worker pool,
+// optionally validating the GLSL with an offscreen GL context.
+//
+//   shadergraph_cli [options] <graph file or directory>...
+//
+//   -o <dir>      output directory (default: shaders)
+//   -j <n>        worker threads (default: hardware concurrency)
+//   --no-glsl     skip GLSL output
+//   --no-hlsl     skip HLSL output
+//   --ubo         use the std140 PerFrame block for built-ins
+//   --target <t>  precision target: desktop (default), mobile (GLSL ES with mediump,
+//                 min16float) or console (native half); see shader_precision.h
+//   --validate    compile and link every GLSL shader with an offscreen context
+//   --binary      also write each graph as .sgraphb (converts a text library)
+//   --params      only list the parameters of each graph (no generation)
+//   --cost        print the estimated cost of each material
+//   --budget <n>  warn and fail when a material exceeds the named budget (implies --cost)
+//   --budgets <f> budget definitions (see shader_cost.h) instead of the built-in targets
+//   --variants    generate every permutation of the graph's static switch keywords; variants
+//                 with the same output share one file, listed in <name>.variants.txt
+//   --bake <n>    also bake each material on the CPU into an n x n <name>.bake.dds with mips
+//                 (plain materials only, not with --variants); see shader_bake.h
+//   --bake-subgraphs <c>
+//                 replace UV-only subgraphs costing at least c (costScore) with textures,
+//                 written next to the shaders as <name>.<sampler>.dds; see subgraph_bake.h
+//   -q            only report failures
+
+#include "graph_io.h"
+#include "graph_binary.h"
+#include "material_generator.h"
+#include "shader_bake.h"
+#include "shader_compiler.h"
+#include "gl_platform.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <cstdio>
+#include <sstream>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct Options {
+    std::vector<std::string> inputs;
+    std::string outputDir = "shaders";
+    unsigned threads = 0;
+    ShaderGraph::MaterialOptions material;
+    bool validate = false;
+    bool writeBinary = false;
+    bool listParameters = false;
+    bool variants = false;
+    bool bake = false;
+    ShaderGraph::BakeOptions bakeOptions;
+    bool bakeSubgraphs = false;
+    ShaderGraph::SubgraphBakeOptions subgraphBake;
+    bool quiet = false;
+    std::string budgetName;
+    std::string budgetFile;
+    const ShaderGraph::CostBudget* budget = nullptr;
+};
+
+// One graph file; written only by the worker that claims it
+struct Job {
+    fs::path input;
+    fs::path relative;    // Output path relative to the output directory, without extension
+    bool generated = false;
+    bool valid = true;
+    std::string error;
+    std::vector<std::string> glsl;  // Kept for --validate, one per distinct output
+    std::string report;   // --params listing and --cost summary
+    bool overBudget = false;
+};
+
+void printUsage() {
+    std::cout << "Usage: shadergraph_cli [-o dir] [-j threads] [--no-glsl] [--no-hlsl] [--ubo] [--validate] [--binary] [--params]"
+                 " [--target desktop|mobile|console] [--cost] [--budget name] [--budgets file] [--variants]"
+                 " [--bake size] [--bake-subgraphs cost] [-q]"
+                 " <graph file or directory>...\n";
+}
+
+bool parseArgs(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        if (!std::strcmp(arg, "-o") && i + 1 < argc) options.outputDir = argv[++i];
+        else if (!std::strcmp(arg, "-j") && i + 1 < argc) options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (!std::strcmp(arg, "--no-glsl")) options.material.glsl = false;
+        else if (!std::strcmp(arg, "--no-hlsl")) options.material.hlsl = false;
+        else if (!std::strcmp(arg, "--ubo")) options.material.useUniformBlock = true;
+        else if (!std::strcmp(arg, "--target") && i + 1 < argc) {
+            ShaderGraph::ShaderTarget target;
+            if (!ShaderGraph::shaderTargetFromName(argv[++i], target)) {
+                std::cerr << "Unknown target " << argv[i] << std::endl;
+                return false;
+            }
+            options.material.precision = ShaderGraph::PrecisionPolicy::forTarget(target);
+        } else if (!std::strcmp(arg, "--validate")) options.validate = true;
+        else if (!std::strcmp(arg, "--binary")) options.writeBinary = true;
+        else if (!std::strcmp(arg, "--params")) options.listParameters = true;
+        else if (!std::strcmp(arg, "--cost")) options.material.estimateCost = true;
+        else if (!std::strcmp(arg, "--budget") && i + 1 < argc) options.budgetName = argv[++i];
+        else if (!std::strcmp(arg, "--budgets") && i + 1 < argc) options.budgetFile = argv[++i];
+        else if (!std::strcmp(arg, "--variants")) options.variants = true;
+        else if (!std::strcmp(arg, "--bake") && i + 1 < argc) {
+            const int size = std::atoi(argv[++i]);
+            if (size <= 0) {
+                std::cerr << "Invalid bake size " << argv[i] << std::endl;
+                return false;
+            }
+            options.bake = true;
+            options.bakeOptions.width = options.bakeOptions.height = static_cast<uint32_t>(size);
+        }
+        else if (!std::strcmp(arg, "--bake-subgraphs") && i + 1 < argc) {
+            options.bakeSubgraphs = true;
+            options.subgraphBake.minCost = static_cast<float>(std::atof(argv[++i]));
+        }
+        else if (!std::strcmp(arg, "-q")) options.quiet = true;
+        else if (!std::strcmp(arg, "-h") || !std::strcmp(arg, "--help")) return false;
+        else if (arg[0] == '-') {
+            std::cerr << "Unknown option " << arg << std::endl;
+            return false;
+        } else {
+            options.inputs.push_back(arg);
+        }
+    }
+    return !options.inputs.empty();
+}
+
+bool isGraphFile(const fs::path& path) {
+    return path.extension() == ShaderGraph::GraphTextExtension || path.extension() == ShaderGraph::GraphBinaryExtension;
+}
+
+// Expand directories into the graph files below them
+std::vector<Job> collectJobs(const std::vector<std::string>& inputs) {
+    std::vector<Job> jobs;
+    for (const auto& input : inputs) {
+        fs::path path(input);
+        std::error_code ec;
+        if (fs::is_directory(path, ec)) {
+            for (auto it = fs::recursive_directory_iterator(path, ec); !ec && it != fs::recursive_directory_iterator();
+                 it.increment(ec)) {
+                if (!it->is_regular_file() || !isGraphFile(it->path())) continue;
+                Job job;
+                job.input = it->path();
+                job.relative = fs::relative(it->path(), path).replace_extension();
+                jobs.push_back(std::move(job));
+            }
+        } else {
+            Job job;
+            job.input = path;
+            job.relative = path.filename().replace_extension();
+            jobs.push_back(std::move(job));
+        }
+    }
+    return jobs;
+}
+
+bool writeText(const fs::path& path, const std::string& text) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+    return static_cast<bool>(file);
+}
+
+const char* typeName(ShaderGraph::ShaderDataType type) {
+    switch (type) {
+        case ShaderGraph::ShaderDataType::Float: return "float";
+        case ShaderGraph::ShaderDataType::Vec2: return "vec2";
+        case ShaderGraph::ShaderDataType::Vec3: return "vec3";
+        case ShaderGraph::ShaderDataType::Vec4: return "vec4";
+        case ShaderGraph::ShaderDataType::Sampler2D: return "sampler2D";
+    }
+    return "float";
+}
+
+void appendParameter(std::string& report, const ShaderGraph::UniformParameter& param) {
+    report += "  " + param.name + " " + typeName(param.type) + "\n";
+}
+
+// Parameter listing; binary graphs are scanned in place and only parameter nodes are copied
+void listJob(Job& job) {
+    ShaderGraph::GraphFileView view;
+    if (ShaderGraph::isGraphBinaryFile(job.input.string())) {
+        if (!view.open(job.input.string(), job.error)) return;
+        for (uint32_t i = 0; i < view.nodeCount(); ++i) {
+            if (!ShaderGraph::nodeKindInfo(view.nodeKind(i)).isParameter) continue;
+            appendParameter(job.report, ShaderGraph::parameterOf(view.toNodeDesc(i)));
+        }
+        job.generated = true;
+        return;
+    }
+
+    ShaderGraph::GraphDesc graph;
+    if (!ShaderGraph::loadGraphFile(job.input.string(), graph, job.error)) return;
+    for (const auto& param : ShaderGraph::parametersOf(graph)) appendParameter(job.report, param);
+    job.generated = true;
+}
+
+// Write the shaders of one material next to base (base.frag.glsl, base.ps.hlsl)
+bool writeSources(Job& job, const Options& options, const std::string& base, const ShaderGraph::MaterialSources& sources) {
+    if (options.material.glsl && !writeText(base + ".frag.glsl", sources.glsl)) {
+        job.error = "cannot write " + base + ".frag.glsl";
+        return false;
+    }
+    if (options.material.hlsl && !writeText(base + ".ps.hlsl", sources.hlsl)) {
+        job.error = "cannot write " + base + ".ps.hlsl";
+        return false;
+    }
+    // Baked subgraph paths are relative to the shaders
+    for (const auto& bake : sources.bakes) {
+        const fs::path path = fs::path(base).parent_path() / bake.path;
+        if (!ShaderGraph::writeSubgraphBake(bake, path.string(), job.error)) {
+            job.error = "bake " + bake.sampler + ": " + job.error;
+            return false;
+        }
+    }
+    if (!sources.bakes.empty()) job.report += "  baked subgraphs: " + std::to_string(sources.bakes.size()) + "\n";
+    return true;
+}
+
+// Cost summary and budget warnings; label names the variant (empty for a plain material)
+void reportCost(Job& job, const Options& options, const ShaderGraph::MaterialSources& sources, const std::string& label) {
+    const ShaderGraph::ShaderCostReport& cost = sources.cost;
+    const std::string prefix = label.empty() ? "  " : "  [" + label + "] ";
+    char line[160];
+    std::snprintf(line, sizeof(line), "cost: %.0f ALU, %d transcendental, %d texture, %d registers\n",
+                  cost.total.alu, cost.total.transcendentals, cost.total.textureFetches, cost.registers);
+    job.report += prefix + line;
+    if (options.budget) {
+        for (const auto& warning : ShaderGraph::checkBudget(cost, *options.budget)) {
+            job.report += prefix + "over budget: " + warning + "\n";
+            job.overBudget = true;
+        }
+    }
+}
+
+// CPU bake of the material into base.bake.dds
+bool bakeJob(Job& job, const Options& options, const ShaderGraph::GraphDesc& graph, const std::string& base) {
+    ShaderGraph::TextureImage image;
+    std::vector<uint8_t> file;
+    if (!ShaderGraph::bakeGraph(graph, options.bakeOptions, image, job.error) ||
+        !ShaderGraph::encodeDDS(image, file, job.error)) {
+        job.error = "bake: " + job.error;
+        return false;
+    }
+    std::ofstream out(base + ".bake.dds", std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+    if (!out) {
+        job.error = "cannot write " + base + ".bake.dds";
+        return false;
+    }
+    job.report += "  baked " + std::to_string(image.width()) + "x" + std::to_string(image.height()) + ", " +
+                  std::to_string(image.levels.size()) + " levels (" + ShaderGraph::bakeKernelName() + ")\n";
+    return true;
+}
+
+// Every permutation of the keywords; identical outputs are written (and validated) once
+void runVariants(Job& job, const Options& options, const ShaderGraph::MaterialOptions& material,
+                 const ShaderGraph::GraphDesc& graph, const std::string& base) {
+    const std::vector<std::string> keywords = ShaderGraph::keywordsOf(graph);
+    const auto keywordSets = ShaderGraph::enumerateVariants(keywords);
+    if (keywordSets.empty()) {
+        job.error = std::to_string(keywords.size()) + " keywords, at most " +
+                    std::to_string(ShaderGraph::MaxVariantKeywords) + " are supported";
+        return;
+    }
+    ShaderGraph::MaterialVariants variants;
+    ShaderGraph::generateVariants(graph, material, keywordSets, variants);
+
+    std::vector<std::string> files(variants.sources.size());
+    std::string manifest;
+    for (const auto& variant : variants.variants) {
+        std::string& file = files[variant.source];
+        if (file.empty()) {
+            file = fs::path(base).filename().string() + "." + variant.name;
+            const ShaderGraph::MaterialSources& sources = variants.sources[variant.source];
+            if (!writeSources(job, options, (fs::path(base).parent_path() / file).string(), sources)) return;
+            if (options.material.estimateCost) reportCost(job, options, sources, variant.name);
+        }
+        manifest += variant.name + " " + file + "\n";
+    }
+    if (!writeText(base + ".variants.txt", manifest)) {
+        job.error = "cannot write " + base + ".variants.txt";
+        return;
+    }
+    job.report = "  variants: " + std::to_string(variants.variants.size()) + " (" +
+                 std::to_string(variants.sources.size()) + " distinct)\n" + job.report;
+    if (options.validate) {
+        for (auto& sources : variants.sources) job.glsl.push_back(std::move(sources.glsl));
+    }
+    job.generated = true;
+}
+
+void runJob(Job& job, const Options& options) {
+    if (options.listParameters) {
+        listJob(job);
+        return;
+    }
+
+    ShaderGraph::GraphDesc graph;
+    if (!ShaderGraph::loadGraphFile(job.input.string(), graph, job.error)) return;
+
+    fs::path base = fs::path(options.outputDir) / job.relative;
+    std::error_code ec;
+    fs::create_directories(base.parent_path(), ec);
+    if (options.writeBinary && job.input.extension() != ShaderGraph::GraphBinaryExtension &&
+        !ShaderGraph::saveGraphBinary(base.string() + ShaderGraph::GraphBinaryExtension, graph, job.error)) {
+        return;
+    }
+    // Bake textures are named after the graph
+    ShaderGraph::MaterialOptions material = options.material;
+    ShaderGraph::SubgraphBakeOptions subgraphBake = options.subgraphBake;
+    subgraphBake.pathPrefix = base.filename().string() + ".";
+    if (options.bakeSubgraphs) material.subgraphBake = &subgraphBake;
+    if (options.variants) {
+        runVariants(job, options, material, graph, base.string());
+        return;
+    }
+
+    ShaderGraph::MaterialSources sources;
+    ShaderGraph::generateMaterial(graph, material, sources);
+    if (!writeSources(job, options, base.string(), sources)) return;
+    if (options.material.estimateCost) reportCost(job, options, sources, std::string());
+    if (options.bake && !bakeJob(job, options, graph, base.string())) return;
+    if (options.validate) job.glsl.push_back(std::move(sources.glsl));
+    job.generated = true;
+}
+
+// Compile and link every generated GLSL shader against the default vertex shader
+bool validateJobs(std::vector<Job>& jobs, const Options& options) {
+    if (!glfwInit()) {
+        std::cerr << "Validation: failed to initialize GLFW" << std::endl;
+        return false;
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+    GLFWwindow* window = glfwCreateWindow(1, 1, "shadergraph_cli", nullptr, nullptr);
+    if (!window) {
+        std::cerr << "Validation: failed to create an offscreen context" << std::endl;
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(window);
+#ifdef _WIN32
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        std::cerr << "Validation: failed to initialize GLEW" << std::endl;
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return false;
+    }
+#endif
+
+    const std::string vertexSource = ShaderGraph::buildVertexShader(options.material.useUniformBlock);
+    for (auto& job : jobs) {
+        if (!job.generated) continue;
+        for (const auto& glsl : job.glsl) {
+            ShaderCompiler::Result result = ShaderCompiler::buildProgram(vertexSource, glsl);
+            if (result.program) glDeleteProgram(result.program);
+            if (!result.success) {
+                job.valid = false;
+                job.error = result.errorLog;
+                break;
+            }
+        }
+        job.glsl.clear();
+        job.glsl.shrink_to_fit();
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArgs(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+    if (!options.material.glsl || options.listParameters) options.validate = false;
+    if (options.validate && options.material.precision.glslES()) {
+        // The offscreen context is desktop GL, which doesn't take GLSL ES sources
+        std::cerr << "--validate is skipped for the mobile target" << std::endl;
+        options.validate = false;
+    }
+
+    std::vector<ShaderGraph::CostBudget> budgets = ShaderGraph::defaultCostBudgets();
+    if (!options.budgetFile.empty()) {
+        std::ifstream file(options.budgetFile, std::ios::binary);
+        std::stringstream text;
+        text << file.rdbuf();
+        std::string error;
+        if (!file || !ShaderGraph::parseCostBudgets(text.str(), budgets, error)) {
+            std::cerr << options.budgetFile << ": " << (file ? error : "cannot open") << std::endl;
+            return 2;
+        }
+    }
+    if (!options.budgetName.empty()) {
+        options.budget = ShaderGraph::findCostBudget(budgets, options.budgetName);
+        if (!options.budget) {
+            std::cerr << "Unknown budget '" << options.budgetName << "'; available:";
+            for (const auto& budget : budgets) std::cerr << " \"" << budget.name << "\"";
+            std::cerr << std::endl;
+            return 2;
+        }
+        options.material.estimateCost = true;
+    }
+
+    std::vector<Job> jobs = collectJobs(options.inputs);
+    if (jobs.empty()) {
+        std::cerr << "No graph files found" << std::endl;
+        return 1;
+    }
+
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min<unsigned>(threads, static_cast<unsigned>(jobs.size()));
+    // Bakes split their rows over the cores the job workers leave
+    options.bakeOptions.threads = std::max(1u, std::max(1u, std::thread::hardware_concurrency()) / threads);
+    options.subgraphBake.threads = options.bakeOptions.threads;
+
+    // Workers claim jobs from a shared counter; each job is only touched by its worker
+    auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> next{0};
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t i = next.fetch_add(1); i < jobs.size(); i = next.fetch_add(1)) {
+                runJob(jobs[i], options);
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+    double generateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    double validateMs = 0.0;
+    if (options.validate) {
+        auto validateStart = std::chrono::steady_clock::now();
+        if (!validateJobs(jobs, options)) return 1;
+        validateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - validateStart).count();
+    }
+
+    size_t failed = 0;
+    size_t overBudget = 0;
+    for (const auto& job : jobs) {
+        if (job.generated && job.valid) {
+            if (job.overBudget) {
+                overBudget++;
+                std::cerr << "BUDGET " << job.input.string() << "\n" << job.report;
+            } else if (options.listParameters) {
+                std::cout << job.input.string() << "\n" << job.report;
+            } else if (!options.quiet) {
+                std::cout << "ok     " << job.input.string() << "\n" << job.report;
+            }
+            continue;
+        }
+        failed++;
+        std::cerr << "FAILED " << job.input.string() << ": " << job.error << "\n";
+    }
+
+    std::cout << jobs.size() - failed << "/" << jobs.size() << " materials generated in " << generateMs << " ms on "
+              << threads << " threads";
+    if (options.validate) std::cout << ", validated in " << validateMs << " ms";
+    if (options.budget) std::cout << ", " << overBudget << " over the " << options.budget->name << " budget";
+    std::cout << std::endl;
+    return failed || overBudget ? 1 : 0;
+}